@@ -0,0 +1,78 @@
+/**
+ * @file bench.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Helpers shared by the benchmarks
+ */
+
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <time.h>          // clock_gettime, CLOCK_PROCESS_CPUTIME_ID
+#include <stdio.h>          // fprintf, stdout
+#include <stdlib.h>          // strtoul
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief      Get the CPU time consumed by the process
+ *
+ * @return     CPU time in nanoseconds
+ */
+static inline double bench_cpu_ns(void)
+{
+    struct timespec     ts;
+
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+    return ( (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec);
+}
+
+
+/**
+ * @brief      Get the number of iterations from the command line
+ *
+ * @param[in]  argc  Number of arguments
+ * @param      argv  The arguments
+ * @param[in]  dft   The default number of iterations
+ *
+ * @return     The number of iterations
+ */
+static inline unsigned long bench_iterations(int    argc,
+                                             char   **argv,
+                                             unsigned long dft
+                                             )
+{
+    unsigned long     n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 0;
+
+
+    return ( (n > 0) ? n : dft);
+}
+
+
+/**
+ * @brief      Print the result of a benchmark
+ *
+ * @param[in]  name  The name of the measured variant
+ * @param[in]  n     The number of iterations
+ * @param[in]  ns    The CPU time spent, in nanoseconds
+ */
+static inline void bench_report(const char      *name,
+                                unsigned long   n,
+                                double          ns
+                                )
+{
+    fprintf(stdout, "%-24s %10lu iterations %12.1f ns/op\n", name, n, ns / (double) n);
+}
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __BENCH_H__
@@ -0,0 +1,247 @@
+/**
+ * @file bench_formats.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Per-row CPU time and bytes of the formats of a read: JSON, NDJSON, CSV and CBOR
+ *
+ * Usage: bench_formats.out [rows]
+ *
+ * The rows are rendered like send_json_row, send_csv_row and send_cbor_row render a reception in the flat view, into
+ * a buffer of DB_EXPORT_CHUNK bytes whose flushes are only counted.
+ */
+
+#include <stdio.h>          // fprintf
+
+#include <jsonw.h>          // jsonw_init, jsonw_literal, jsonw_string, jsonw_integer, jsonw_double, jsonw_bool, jsonw_flush
+#include <csvw.h>          // csvw_string, csvw_double
+#include <cborw.h>          // cborw_map, cborw_key, cborw_text, cborw_integer, cborw_double, cborw_bool, cborw_array
+
+#include "bench.h"
+
+
+/**
+ * @brief Size of the buffer of the writer (DB_EXPORT_CHUNK)
+ */
+#define BENCH_CHUNK     (16 * 1024)
+
+
+/**
+ * @brief The formats
+ */
+#define BENCH_JSON      0
+#define BENCH_NDJSON    1
+#define BENCH_CSV       2
+#define BENCH_CBOR      3
+
+
+/**
+ * @brief      Count the bytes handed out by the writer
+ *
+ * @param      ctx   The byte counter
+ * @param[in]  buf   The content of the buffer
+ * @param[in]  len   Length of the content
+ */
+static void count_bytes(void        *ctx,
+                        const char  *buf __attribute__( (unused) ),
+                        size_t      len
+                        )
+{
+    *(unsigned long long *) ctx += len;
+}
+
+
+
+/**
+ * @brief      Render a row as JSON (the item of a list) or NDJSON (a line)
+ *
+ * @param      w       The writer
+ * @param[in]  i       Number of the row
+ * @param[in]  ndjson  1 for NDJSON
+ */
+static void json_row(jsonw_t        *w,
+                     unsigned long  i,
+                     int            ndjson
+                     )
+{
+    if ( ndjson )
+    {
+        jsonw_literal(w, "{ \"timestamp\": ");
+    }
+    else if ( i == 0 )
+    {
+        jsonw_literal(w, " { \"timestamp\": ");
+    }
+    else
+    {
+        jsonw_literal(w, ", { \"timestamp\": ");
+    }
+
+    jsonw_integer(w, 1476691200LL + (long long) i);
+    jsonw_literal(w, ", \"id_modem\": ");
+    jsonw_string(w, "12FED", 5);
+    jsonw_literal(w, ", \"ack\": ");
+    jsonw_bool(w, 0);
+    jsonw_literal(w, ", \"data_str\": ");
+    jsonw_string(w, "16f000000000000000000000", 24);
+    jsonw_literal(w, ", \"duplicate\": ");
+    jsonw_bool(w, 0);
+    jsonw_literal(w, ", \"avg_signal\": ");
+    jsonw_double(w, 12.5);
+    jsonw_literal(w, ", \"seq_number\": ");
+    jsonw_integer(w, (int) (i & 0xFFF) );
+    jsonw_literal(w, ", \"station\": ");
+    jsonw_string(w, "0F3B", 4);
+    jsonw_literal(w, ", \"snr\": ");
+    jsonw_double(w, 10.23);
+    jsonw_literal(w, ", \"rssi\": ");
+    jsonw_double(w, -120.5);
+    jsonw_literal(w, ", \"latitude\": ");
+    jsonw_integer(w, 43);
+    jsonw_literal(w, ", \"longitude\": ");
+    jsonw_integer(w, 1);
+
+    if ( ndjson )
+    {
+        jsonw_literal(w, " }\n");
+    }
+    else
+    {
+        jsonw_literal(w, " }");
+    }
+}
+
+
+
+/**
+ * @brief      Render a row as a CSV record
+ *
+ * @param      w     The writer
+ * @param[in]  i     Number of the row
+ */
+static void csv_row(jsonw_t         *w,
+                    unsigned long   i
+                    )
+{
+    jsonw_integer(w, 1476691200LL + (long long) i);
+    jsonw_literal(w, ",");
+    csvw_string(w, "12FED", 5);
+    jsonw_literal(w, ",");
+    jsonw_bool(w, 0);
+    jsonw_literal(w, ",");
+    csvw_string(w, "16f000000000000000000000", 24);
+    jsonw_literal(w, ",");
+    jsonw_bool(w, 0);
+    jsonw_literal(w, ",");
+    csvw_double(w, 12.5);
+    jsonw_literal(w, ",");
+    jsonw_integer(w, (int) (i & 0xFFF) );
+    jsonw_literal(w, ",");
+    csvw_string(w, "0F3B", 4);
+    jsonw_literal(w, ",");
+    csvw_double(w, 10.23);
+    jsonw_literal(w, ",");
+    csvw_double(w, -120.5);
+    jsonw_literal(w, ",");
+    jsonw_integer(w, 43);
+    jsonw_literal(w, ",");
+    jsonw_integer(w, 1);
+    jsonw_literal(w, "\r\n");
+}
+
+
+
+/**
+ * @brief      Render a row as a CBOR map
+ *
+ * @param      w     The writer
+ * @param[in]  i     Number of the row
+ */
+static void cbor_row(jsonw_t        *w,
+                     unsigned long  i
+                     )
+{
+    cborw_map(w, 12);
+    cborw_key(w, "timestamp");
+    cborw_integer(w, 1476691200LL + (long long) i);
+    cborw_key(w, "id_modem");
+    cborw_text(w, "12FED", 5);
+    cborw_key(w, "ack");
+    cborw_bool(w, 0);
+    cborw_key(w, "data_str");
+    cborw_text(w, "16f000000000000000000000", 24);
+    cborw_key(w, "duplicate");
+    cborw_bool(w, 0);
+    cborw_key(w, "avg_signal");
+    cborw_double(w, 12.5);
+    cborw_key(w, "seq_number");
+    cborw_integer(w, (int) (i & 0xFFF) );
+    cborw_key(w, "station");
+    cborw_text(w, "0F3B", 4);
+    cborw_key(w, "snr");
+    cborw_double(w, 10.23);
+    cborw_key(w, "rssi");
+    cborw_double(w, -120.5);
+    cborw_key(w, "latitude");
+    cborw_integer(w, 43);
+    cborw_key(w, "longitude");
+    cborw_integer(w, 1);
+}
+
+
+
+/**
+ * @brief The benchmark
+ *
+ * @param argc Number of arguments
+ * @param argv Lists of pointers that points to the arguments
+ *
+ * @return Exit code
+ */
+int main(int    argc,
+         char   **argv
+         )
+{
+    static const char * const   names[] = {"json", "ndjson", "csv", "cbor"};
+    static char                 chunk[BENCH_CHUNK];
+    unsigned long               n       = bench_iterations(argc, argv, 1000000);
+    unsigned long long          bytes   = 0;
+    unsigned long               i       = 0;
+    int                         format  = 0;
+    double                      start   = 0;
+    double                      ns      = 0;
+    jsonw_t                     w;
+
+
+    for ( format = BENCH_JSON; format <= BENCH_CBOR; ++format )
+    {
+        bytes = 0;
+        jsonw_init(&w, chunk, sizeof(chunk), count_bytes, &bytes);
+        start = bench_cpu_ns();
+
+        for ( i = 0; i < n; ++i )
+        {
+            switch ( format )
+            {
+                case BENCH_CSV:
+                    csv_row(&w, i);
+                    break;
+
+                case BENCH_CBOR:
+                    cbor_row(&w, i);
+                    break;
+
+                default:
+                    json_row(&w, i, format == BENCH_NDJSON);
+                    break;
+            }
+        }
+
+        jsonw_flush(&w);
+        ns = bench_cpu_ns() - start;
+        bench_report(names[format], n, ns);
+        fprintf(stdout, "%-24s %10.0f rows/s %10.1f bytes/row\n", "", (double) n * 1e9 / ns, (double) bytes / (double) n);
+    }
+
+    return (0);
+}
@@ -0,0 +1,168 @@
+/**
+ * @file bench_hex.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Conversion of data_str: strtol per pair versus hex_decode and hex_decode_batch
+ *
+ * Usage: bench_hex.out [iterations]
+ */
+
+#include <stdio.h>          // fprintf
+#include <stdlib.h>          // strtol
+#include <string.h>          // memcmp, memset, strlen
+
+#include <hex.h>          // hex_decode, hex_decode_batch
+#include <frames.h>          // SIGFOX_DATA_STR_LENGTH, SIGFOX_DATA_LENGTH
+
+#include "bench.h"
+
+
+/**
+ * @brief Number of frames of a batch
+ */
+#define BENCH_BATCH     64
+
+
+/**
+ * @brief A frame of a batch, laid out like db_batch_item_t
+ */
+typedef struct bench_item_s {
+    unsigned char   data_str[SIGFOX_DATA_STR_LENGTH + 1];          ///< The payload as string
+    unsigned char   data_hex[SIGFOX_DATA_LENGTH];          ///< The payload as bytes
+    unsigned char   error;          ///< Error flag
+} bench_item_t;
+
+
+/**
+ * @brief The payloads (mostly full 12-byte frames, as sent by a fleet of identical devices), the last ones are invalid
+ */
+static const char     *s_payloads[] =
+{
+    "16f000000000000000000000", "0123456789abcdefABCDEF00", "ffffffffffffffffffffffff", "0123456789ABCDEF01234567",
+    "deadbeefdeadbeefdeadbeef", "cafe0000babe", "16F0", "00", "0x0000000000000000000000", "zz"
+};
+
+
+/**
+ * @brief      Convert a data string the way sigfox_json did before hex_decode
+ *
+ * The base is 16 here: the former base 0 decoded the pairs starting with a letter as 0 and the others as octal.
+ *
+ * @param[in]  str   The string
+ * @param[out] out   The bytes
+ */
+static void legacy_convert(const unsigned char  *str,
+                           unsigned char        *out
+                           )
+{
+    size_t      len = strlen( (const char *) str);
+    size_t      i   = 0;
+
+
+    for ( i = 0; i < len; i += 2 )
+    {
+        char     s[] = {str[i], str[i + 1], 0};
+
+        out[i / 2] = (unsigned char) strtol(s, NULL, 16);
+    }
+}
+
+
+
+/**
+ * @brief The benchmark
+ *
+ * @param argc Number of arguments
+ * @param argv Lists of pointers that points to the arguments
+ *
+ * @return Exit code
+ */
+int main(int    argc,
+         char   **argv
+         )
+{
+    const size_t        count   = sizeof(s_payloads) / sizeof(s_payloads[0]);
+    unsigned long       n       = bench_iterations(argc, argv, 200000);
+    unsigned long       i       = 0;
+    size_t              j       = 0;
+    size_t              invalid = 0;
+    double              start   = 0;
+    unsigned long       sink    = 0;
+    bench_item_t        items[BENCH_BATCH];
+    unsigned char       expected[SIGFOX_DATA_LENGTH];
+
+
+    memset(items, 0, sizeof(items) );
+
+    for ( j = 0; j < BENCH_BATCH; ++j )
+    {
+        strcpy( (char *) items[j].data_str, s_payloads[j % count]);
+    }
+
+
+    // hex_decode and hex_decode_batch must agree with strtol on the valid payloads and reject the invalid ones
+    hex_decode_batch(items[0].data_str, items[0].data_hex, &items[0].error, sizeof(bench_item_t),
+                     SIGFOX_DATA_STR_LENGTH, BENCH_BATCH, 1);
+
+    for ( j = 0; j < BENCH_BATCH; ++j )
+    {
+        unsigned char       single[SIGFOX_DATA_LENGTH];
+        const size_t        len     = strlen( (const char *) items[j].data_str);
+        const int           bad     = (j % count) >= count - 2;
+
+
+        memset(expected, 0, sizeof(expected) );
+        legacy_convert(items[j].data_str, expected);
+
+        if ( (hex_decode(items[j].data_str, len, single, &invalid) != -bad) || (items[j].error != bad) ||
+             (! bad && (memcmp(single, expected, len / 2) || memcmp(items[j].data_hex, expected, len / 2) ) ) ||
+             (bad && (invalid != ( (j % count) == count - 2 ? 1u : 0u) ) ) )
+        {
+            fprintf(stderr, "The decoders do not agree on %s\n", items[j].data_str);
+
+            return (1);
+        }
+    }
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        for ( j = 0; j < BENCH_BATCH; ++j )
+        {
+            legacy_convert(items[j].data_str, items[j].data_hex);
+        }
+
+        sink += items[i % BENCH_BATCH].data_hex[0];
+    }
+
+    bench_report("strtol per pair", n * BENCH_BATCH, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        for ( j = 0; j < BENCH_BATCH; ++j )
+        {
+            sink += hex_decode(items[j].data_str, strlen( (const char *) items[j].data_str), items[j].data_hex, NULL);
+        }
+
+        sink += items[i % BENCH_BATCH].data_hex[0];
+    }
+
+    bench_report("hex_decode", n * BENCH_BATCH, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        sink += hex_decode_batch(items[0].data_str, items[0].data_hex, NULL, sizeof(bench_item_t),
+                                 SIGFOX_DATA_STR_LENGTH, BENCH_BATCH, 1);
+        sink += items[i % BENCH_BATCH].data_hex[0];
+    }
+
+    bench_report("hex_decode_batch", n * BENCH_BATCH, bench_cpu_ns() - start);
+
+    return (sink == 0);
+}
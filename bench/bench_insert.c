@@ -0,0 +1,130 @@
+/**
+ * @file bench_insert.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Per-insert CPU time with a statement prepared per frame versus the cached one
+ *
+ * Usage: bench_insert.out [iterations] [database path (dft: /tmp/bench_insert.db)]
+ */
+
+#include <string.h>          // memcpy, strlen
+
+#include <db_plugin_sqlite.h>          // db_open, db_close, db_insert_raws
+#include <sqls.h>          // INSERT_RAWS, SQL_IDX_*
+#include <frames.h>          // sigfox_raws_t
+
+#include "bench.h"
+
+
+/**
+ * @brief      Insert a raws structure the way op_set did before the statements were cached
+ *
+ * @param      db    The database
+ * @param[in]  raws  The raws structure
+ *
+ * @return     The result of sqlite3_step
+ */
+static int insert_prepare_each_time(sqlite3             *db,
+                                    const sigfox_raws_t *raws
+                                    )
+{
+    sqlite3_stmt        *stmt   = NULL;
+    int                 result  = 0;
+
+
+    if ( sqlite3_prepare_v2(db, INSERT_RAWS, -1, &stmt, NULL) == SQLITE_OK )
+    {
+        sqlite3_bind_int(stmt, SQL_IDX_TIMESTAMP, raws->timestamp);
+        sqlite3_bind_text(stmt, SQL_IDX_ID_MODEM, (const char *) raws->id_modem, strlen( (const char *) raws->id_modem),
+                          SQLITE_STATIC);
+        sqlite3_bind_double(stmt, SQL_IDX_SNR, raws->snr);
+        sqlite3_bind_text(stmt, SQL_IDX_STATION, (const char *) raws->station, strlen( (const char *) raws->station),
+                          SQLITE_STATIC);
+        sqlite3_bind_int(stmt, SQL_IDX_ACK, raws->ack);
+        sqlite3_bind_text(stmt, SQL_IDX_DATA_STR, (const char *) raws->data_str, strlen( (const char *) raws->data_str),
+                          SQLITE_STATIC);
+        sqlite3_bind_blob(stmt, SQL_IDX_DATA_HEX, (void *) raws->data_hex, sizeof(raws->data_hex), SQLITE_STATIC);
+        sqlite3_bind_int(stmt, SQL_IDX_DUPLICATE, raws->duplicate);
+        sqlite3_bind_double(stmt, SQL_IDX_AVG_SIGNAL, raws->avg_signal);
+        sqlite3_bind_double(stmt, SQL_IDX_RSSI, raws->rssi);
+        sqlite3_bind_int(stmt, SQL_IDX_LATITUDE, raws->latitude);
+        sqlite3_bind_int(stmt, SQL_IDX_LONGITUDE, raws->longitude);
+        sqlite3_bind_int(stmt, SQL_IDX_SEQ_NUMBER, raws->seq_number);
+        result = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+
+    return (result);
+}
+
+
+
+/**
+ * @brief The benchmark
+ *
+ * @param argc Number of arguments
+ * @param argv Lists of pointers that points to the arguments
+ *
+ * @return Exit code
+ */
+int main(int    argc,
+         char   **argv
+         )
+{
+    unsigned long       n       = bench_iterations(argc, argv, 100000);
+    const char          *path   = (argc > 2) ? argv[2] : "/tmp/bench_insert.db";
+    db_plugin_t         *plugin = NULL;
+    sigfox_raws_t       raws    =
+    {
+        .id_modem = "12FED", .timestamp = 1476691200, .snr = 10.23, .station = "0F3B",
+        .data_str = "16f000000000000000000000", .avg_signal = 12.5, .latitude = 43, .longitude = 1,
+        .rssi = -120.5, .seq_number = 1
+    };
+    unsigned long       i       = 0;
+    double              start   = 0;
+
+
+    if ( (plugin = db_open(path) ) == NULL )
+    {
+        fprintf(stderr, "Cannot open DB [%s]\n", path);
+
+        return (1);
+    }
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        raws.seq_number = i;
+
+        if ( insert_prepare_each_time(plugin->db, &raws) != SQLITE_DONE )
+        {
+            fprintf(stderr, "%s\n", sqlite3_errmsg(plugin->db) );
+
+            return (1);
+        }
+    }
+
+    bench_report("prepare per insert", n, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        raws.seq_number = i;
+
+        if ( db_insert_raws(plugin, &raws) != SQLITE_DONE )
+        {
+            fprintf(stderr, "%s\n", sqlite3_errmsg(plugin->db) );
+
+            return (1);
+        }
+    }
+
+    bench_report("cached statement", n, bench_cpu_ns() - start);
+
+    db_close( (void **) &plugin);
+
+    return (0);
+}
@@ -0,0 +1,227 @@
+/**
+ * @file bench_json.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Decoding of a Sigfox callback body: mongoose tokenizer + find_json_token versus sigfox_json_decode, and the
+ *         same frame url-encoded with sigfox_form_decode and as a binary record with sigfox_binary_decode
+ *
+ * Usage: bench_json.out [iterations]
+ */
+
+#include <string.h>          // memcpy, memset, strlen, strncmp
+
+#include <mongoose.h>          // parse_json2, find_json_token
+#include <sigfox_json.h>          // sigfox_json_decode
+#include <sigfox_form.h>          // sigfox_form_decode
+#include <sigfox_binary.h>          // sigfox_binary_encode, sigfox_binary_decode
+#include <sqls.h>          // SQL_COL_*
+#include <frames.h>          // sigfox_raws_t
+
+#include "bench.h"
+
+
+/**
+ * @brief A callback body as sent by the Sigfox backend
+ */
+static const char     s_body[] =
+    "{\"id_modem\": \"12FED\", \"timestamp\": 1476691200, \"duplicate\": false, \"snr\": 10.23, "
+    "\"station\": \"0F3B\", \"data_str\": \"16f000000000000000000000\", \"avg_signal\": 12.5, "
+    "\"latitude\": 43, \"longitude\": 1, \"rssi\": -120.5, \"seq_number\": 42, \"ack\": true, "
+    "\"long_polling\": false}";
+
+
+/**
+ * @brief The same body sent by a callback configured as application/x-www-form-urlencoded
+ */
+static const char     s_form[] =
+    "id_modem=12FED&timestamp=1476691200&duplicate=false&snr=10.23&station=0F3B&data_str=16f000000000000000000000&"
+    "avg_signal=12.5&latitude=43&longitude=1&rssi=-120.5&seq_number=42&ack=true&long_polling=false";
+
+
+/**
+ * @brief      Get a field the way raws_from_json did: look the token up, copy it into a VLA, then parse it
+ *
+ * @param      root  The tokens
+ * @param[in]  key   The key
+ * @param[out] dst   The copy of the value (NUL-terminated)
+ * @param[in]  size  Size of dst
+ *
+ * @return     0 if the key is missing, 1 otherwise
+ */
+static int legacy_field(struct json_token   *root,
+                        const char          *key,
+                        char                *dst,
+                        size_t              size
+                        )
+{
+    struct json_token     *tmp = find_json_token(root, key);
+
+
+    if ( ! tmp )
+    {
+        return (0);
+    }
+
+    {
+        char     ascii[tmp->len + 1];
+        memset(ascii, 0, sizeof(ascii) );
+        memcpy(ascii, tmp->ptr, tmp->len);
+        strncpy(dst, ascii, size - 1);
+        dst[size - 1] = '\0';
+    }
+
+    return (1);
+}
+
+
+
+/**
+ * @brief      Decode a body the way op_set did before sigfox_json_decode
+ *
+ * @param[in]  body  The body
+ * @param[in]  len   Length of the body
+ * @param[out] raws  The raws structure
+ *
+ * @return     0 on success
+ */
+static int legacy_decode(const char     *body,
+                         size_t         len,
+                         sigfox_raws_t  *raws
+                         )
+{
+    struct json_token       *root = parse_json2(body, len);
+    char                    tmp[64];
+    int                     ok  = 1;
+
+
+    if ( ! root )
+    {
+        return (1);
+    }
+
+    memset(raws, 0, sizeof(*raws) );
+    ok &= legacy_field(root, SQL_COL_ID_MODEM, (char *) raws->id_modem, sizeof(raws->id_modem) );
+    ok &= legacy_field(root, SQL_COL_TIMESTAMP, tmp, sizeof(tmp) );
+    raws->timestamp = strtol(tmp, NULL, 10);
+    ok &= legacy_field(root, SQL_COL_DUPLICATE, tmp, sizeof(tmp) );
+    raws->duplicate = (strncmp(tmp, "true", 4) == 0);
+    ok &= legacy_field(root, SQL_COL_SNR, tmp, sizeof(tmp) );
+    raws->snr = strtod(tmp, NULL);
+    ok &= legacy_field(root, SQL_COL_STATION, (char *) raws->station, sizeof(raws->station) );
+    ok &= legacy_field(root, SQL_COL_DATA_STR, (char *) raws->data_str, sizeof(raws->data_str) );
+    ok &= legacy_field(root, SQL_COL_AVG_SIGNAL, tmp, sizeof(tmp) );
+    raws->avg_signal = strtod(tmp, NULL);
+
+    if ( legacy_field(root, SQL_COL_LATITUDE, tmp, sizeof(tmp) ) )
+    {
+        raws->latitude = strtol(tmp, NULL, 10);
+    }
+
+    if ( legacy_field(root, SQL_COL_LONGITUDE, tmp, sizeof(tmp) ) )
+    {
+        raws->longitude = strtol(tmp, NULL, 10);
+    }
+
+    ok &= legacy_field(root, SQL_COL_RSSI, tmp, sizeof(tmp) );
+    raws->rssi = strtod(tmp, NULL);
+    ok &= legacy_field(root, SQL_COL_SEQ_NUMBER, tmp, sizeof(tmp) );
+    raws->seq_number = strtol(tmp, NULL, 10);
+
+    if ( legacy_field(root, SQL_COL_ACK, tmp, sizeof(tmp) ) )
+    {
+        raws->ack = (strncmp(tmp, "true", 4) == 0);
+    }
+
+    ok &= legacy_field(root, SQL_COL_LONG_POLLING, tmp, sizeof(tmp) );
+    raws->long_polling = (strncmp(tmp, "true", 4) == 0);
+    free(root);
+
+    return (! ok);
+}
+
+
+
+/**
+ * @brief The benchmark
+ *
+ * @param argc Number of arguments
+ * @param argv Lists of pointers that points to the arguments
+ *
+ * @return Exit code
+ */
+int main(int    argc,
+         char   **argv
+         )
+{
+    unsigned long       n       = bench_iterations(argc, argv, 1000000);
+    unsigned long       i       = 0;
+    double              start   = 0;
+    sigfox_raws_t       legacy;
+    sigfox_raws_t       raws;
+    sigfox_raws_t       form;
+    sigfox_raws_t       binary;
+    unsigned char       record[SIGFOX_BINARY_RECORD_LENGTH];
+    unsigned char       error   = 0;
+    unsigned long       sink    = 0;
+
+
+    // Both decoders must agree before being compared
+    if ( legacy_decode(s_body, strlen(s_body), &legacy) || sigfox_json_decode(s_body, strlen(s_body), &raws) ||
+         (legacy.timestamp != raws.timestamp) || (legacy.snr != raws.snr) || (legacy.rssi != raws.rssi) ||
+         (legacy.seq_number != raws.seq_number) || strcmp( (char *) legacy.data_str, (char *) raws.data_str) ||
+         sigfox_form_decode(s_form, strlen(s_form), &form) || memcmp(&form, &raws, sizeof(raws) ) )
+    {
+        fprintf(stderr, "The decoders do not agree\n");
+
+        return (1);
+    }
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        sink += legacy_decode(s_body, sizeof(s_body) - 1, &legacy) + legacy.seq_number;
+    }
+
+    bench_report("parse_json2 + find", n, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        sink += sigfox_json_decode(s_body, sizeof(s_body) - 1, &raws) + raws.seq_number;
+    }
+
+    bench_report("sigfox_json_decode", n, bench_cpu_ns() - start);
+
+    sigfox_binary_encode(record, &raws);
+
+    if ( (sigfox_binary_decode(record, sizeof(record), &binary, &error) != sizeof(record) ) || error ||
+         memcmp(&binary, &raws, sizeof(raws) ) )
+    {
+        fprintf(stderr, "The binary record does not give the same frame\n");
+
+        return (1);
+    }
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        sink += sigfox_form_decode(s_form, sizeof(s_form) - 1, &form) + form.seq_number;
+    }
+
+    bench_report("sigfox_form_decode", n, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        sink += sigfox_binary_decode(record, sizeof(record), &binary, &error) + binary.seq_number;
+    }
+
+    bench_report("sigfox_binary_decode", n, bench_cpu_ns() - start);
+
+    return (sink == 0);
+}
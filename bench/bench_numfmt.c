@@ -0,0 +1,148 @@
+/**
+ * @file bench_numfmt.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Per-number CPU time of numfmt against snprintf
+ *
+ * Usage: bench_numfmt.out [iterations]
+ *
+ * The decimals are hundredths like the stored SNR, RSSI and average signal, the other doubles have every bit random
+ * (the printf path of numfmt_double).
+ */
+
+#include <stdio.h>          // snprintf
+#include <string.h>          // memcpy
+
+#include <numfmt.h>          // numfmt_integer, numfmt_double, NUMFMT_MAX
+
+#include "bench.h"
+
+
+/**
+ * @brief Number of distinct values of a run
+ */
+#define BENCH_VALUES    4096
+
+
+/**
+ * @brief      Pseudo-random numbers (xorshift64)
+ *
+ * @param      state  The state
+ *
+ * @return     The next number
+ */
+static unsigned long long bench_random(unsigned long long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return (*state);
+}
+
+
+
+/**
+ * @brief The benchmark
+ *
+ * @param argc Number of arguments
+ * @param argv Lists of pointers that points to the arguments
+ *
+ * @return Exit code
+ */
+int main(int    argc,
+         char   **argv
+         )
+{
+    static double       decimals[BENCH_VALUES];
+    static double       doubles[BENCH_VALUES];
+    static long long    integers[BENCH_VALUES];
+    unsigned long       n       = bench_iterations(argc, argv, 1000000);
+    unsigned long long  state   = 88172645463325252ULL;
+    unsigned long long  bits    = 0;
+    unsigned long long  bytes   = 0;
+    unsigned long       i       = 0;
+    double              start   = 0;
+    char                buf[NUMFMT_MAX];
+
+
+    for ( i = 0; i < BENCH_VALUES; ++i )
+    {
+        decimals[i] = (double) ( (long long) (bench_random(&state) % 40000) - 20000) / 100.0;
+        integers[i] = (long long) bench_random(&state) >> (bench_random(&state) % 64);
+
+        do
+        {
+            bits = bench_random(&state);
+            memcpy(&doubles[i], &bits, sizeof(doubles[i]) );
+        } while ( doubles[i] != doubles[i] || doubles[i] - doubles[i] != 0);
+    }
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        bytes += snprintf(buf, sizeof(buf), "%.2f", decimals[i % BENCH_VALUES]);
+    }
+
+    bench_report("snprintf %.2f", n, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        bytes += snprintf(buf, sizeof(buf), "%.17g", decimals[i % BENCH_VALUES]);
+    }
+
+    bench_report("snprintf %.17g", n, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        bytes += numfmt_double(buf, decimals[i % BENCH_VALUES]);
+    }
+
+    bench_report("numfmt_double", n, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        bytes += snprintf(buf, sizeof(buf), "%.17g", doubles[i % BENCH_VALUES]);
+    }
+
+    bench_report("snprintf %.17g (any)", n, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        bytes += numfmt_double(buf, doubles[i % BENCH_VALUES]);
+    }
+
+    bench_report("numfmt_double (any)", n, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        bytes += snprintf(buf, sizeof(buf), "%lld", integers[i % BENCH_VALUES]);
+    }
+
+    bench_report("snprintf %lld", n, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        bytes += numfmt_integer(buf, integers[i % BENCH_VALUES]);
+    }
+
+    bench_report("numfmt_integer", n, bench_cpu_ns() - start);
+
+
+    // Keeps the results alive
+    return (bytes == 0);
+}
@@ -0,0 +1,200 @@
+/**
+ * @file bench_numparse.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Numeric fields: VLA copy + strtol/strtod (raws_from_json) versus numparse
+ *
+ * Usage: bench_numparse.out [iterations]
+ */
+
+#include <stdio.h>          // fprintf
+#include <stdlib.h>          // strtol, strtod
+#include <string.h>          // memcpy, memset, strlen
+#include <limits.h>          // LLONG_MIN, LLONG_MAX
+
+#include <numparse.h>          // numparse_integer, numparse_decimal
+
+#include "bench.h"
+
+
+/**
+ * @brief The integers of a frame: timestamp, latitude, longitude, seq_number
+ */
+static const char     *s_integers[] = {"1476691200", "43", "-1", "4095"};
+
+
+/**
+ * @brief The decimals of a frame: snr, avg_signal, rssi
+ */
+static const char     *s_decimals[] = {"10.23", "12.5", "-120.45"};
+
+
+/**
+ * @brief      Parse an integer the way raws_from_json did
+ *
+ * @param[in]  p     The token
+ * @param[in]  len   Length of the token
+ *
+ * @return     The integer
+ */
+static long legacy_integer(const char   *p,
+                           size_t       len
+                           )
+{
+    char     ascii[len + 1];
+
+
+    memset(ascii, 0, sizeof(ascii) );
+    memcpy(ascii, p, len);
+
+    return (strtol(ascii, NULL, 10) );
+}
+
+
+
+/**
+ * @brief      Parse a decimal the way raws_from_json did
+ *
+ * @param[in]  p     The token
+ * @param[in]  len   Length of the token
+ *
+ * @return     The number
+ */
+static double legacy_decimal(const char *p,
+                             size_t     len
+                             )
+{
+    char     ascii[len + 1];
+
+
+    memset(ascii, 0, sizeof(ascii) );
+    memcpy(ascii, p, len);
+
+    return (strtod(ascii, NULL) );
+}
+
+
+
+/**
+ * @brief      Check the results and the errors of numparse
+ *
+ * @return     0 if numparse agrees with strtol/strtod and rejects the invalid numbers
+ */
+static int check(void)
+{
+    long long       integer = 0;
+    double          decimal = 0;
+    size_t          i       = 0;
+
+
+    for ( i = 0; i < sizeof(s_integers) / sizeof(s_integers[0]); ++i )
+    {
+        if ( numparse_integer(s_integers[i], strlen(s_integers[i]), LLONG_MIN, LLONG_MAX, &integer) ||
+             (integer != legacy_integer(s_integers[i], strlen(s_integers[i]) ) ) )
+        {
+            return (1);
+        }
+    }
+
+    for ( i = 0; i < sizeof(s_decimals) / sizeof(s_decimals[0]); ++i )
+    {
+        if ( numparse_decimal(s_decimals[i], strlen(s_decimals[i]), &decimal) ||
+             (decimal != legacy_decimal(s_decimals[i], strlen(s_decimals[i]) ) ) )
+        {
+            return (1);
+        }
+    }
+
+    return ( (numparse_integer("9223372036854775807", 19, LLONG_MIN, LLONG_MAX, &integer) != NUMPARSE_OK) ||
+             (numparse_integer("-9223372036854775808", 20, LLONG_MIN, LLONG_MAX, &integer) != NUMPARSE_OK) ||
+             (integer != LLONG_MIN) ||
+             (numparse_integer("9223372036854775808", 19, LLONG_MIN, LLONG_MAX, &integer) != NUMPARSE_ERR_RANGE) ||
+             (numparse_integer("91", 2, -90, 90, &integer) != NUMPARSE_ERR_RANGE) ||
+             (numparse_integer("12a", 3, 0, 100, &integer) != NUMPARSE_ERR_SYNTAX) ||
+             (numparse_integer("-", 1, -1, 1, &integer) != NUMPARSE_ERR_SYNTAX) ||
+             (numparse_decimal("1.", 2, &decimal) != NUMPARSE_ERR_SYNTAX) ||
+             (numparse_decimal("1e3", 3, &decimal) != NUMPARSE_ERR_SYNTAX) ||
+             (numparse_decimal("99999999999999999999", 20, &decimal) != NUMPARSE_ERR_RANGE) ||
+             (numparse_decimal("-0.125", 6, &decimal) != NUMPARSE_OK) || (decimal != -0.13) );
+}
+
+
+
+/**
+ * @brief The benchmark
+ *
+ * @param argc Number of arguments
+ * @param argv Lists of pointers that points to the arguments
+ *
+ * @return Exit code
+ */
+int main(int    argc,
+         char   **argv
+         )
+{
+    unsigned long       n       = bench_iterations(argc, argv, 1000000);
+    unsigned long       i       = 0;
+    size_t              j       = 0;
+    size_t              lengths[7];
+    double              start   = 0;
+    double              sink    = 0;
+    long long           integer = 0;
+    double              decimal = 0;
+
+
+    if ( check() )
+    {
+        fprintf(stderr, "numparse does not agree with strtol/strtod\n");
+
+        return (1);
+    }
+
+    for ( j = 0; j < 4; ++j )
+    {
+        lengths[j] = strlen(s_integers[j]);
+    }
+
+    for ( j = 0; j < 3; ++j )
+    {
+        lengths[4 + j] = strlen(s_decimals[j]);
+    }
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        for ( j = 0; j < 4; ++j )
+        {
+            sink += legacy_integer(s_integers[j], lengths[j]);
+        }
+
+        for ( j = 0; j < 3; ++j )
+        {
+            sink += legacy_decimal(s_decimals[j], lengths[4 + j]);
+        }
+    }
+
+    bench_report("VLA + strtol/strtod", n, bench_cpu_ns() - start);
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        for ( j = 0; j < 4; ++j )
+        {
+            numparse_integer(s_integers[j], lengths[j], LLONG_MIN, LLONG_MAX, &integer);
+            sink += integer;
+        }
+
+        for ( j = 0; j < 3; ++j )
+        {
+            numparse_decimal(s_decimals[j], lengths[4 + j], &decimal);
+            sink += decimal;
+        }
+    }
+
+    bench_report("numparse", n, bench_cpu_ns() - start);
+
+    return (sink == 0);
+}
@@ -0,0 +1,245 @@
+/**
+ * @file bench_query.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Time range queries by device and by base station, with their composite index versus a full scan
+ *
+ * Usage: bench_query.out [rows (dft: 1000000)] [database path (dft: /tmp/bench_query.db)]
+ *
+ * The table is filled with one message per second, spread over BENCH_DEVICES devices, each received by one of
+ * BENCH_STATIONS base stations. An existing database is queried without being filled again. The reference dataset
+ * has 50000000 rows: bench_query.out 50000000 /tmp/bench_query_50m.db (about 12 GB).
+ */
+
+#include <string.h>          // strlen
+
+#include <db_plugin_sqlite.h>          // db_open, db_close
+#include <sqls.h>          // SELECT_DEVICE_FRAMES, SELECT_STATION_FRAMES, SELECT_FRAMES_COLUMNS
+
+#include "bench.h"
+
+
+/**
+ * @brief Number of devices
+ */
+#define BENCH_DEVICES       1000
+
+
+/**
+ * @brief Number of base stations
+ */
+#define BENCH_STATIONS      250
+
+
+/**
+ * @brief Timestamp of the first message
+ */
+#define BENCH_FIRST_TIMESTAMP   1476691200
+
+
+/**
+ * @brief Time range of a query (about 100 messages of a device, 400 receptions of a station)
+ */
+#define BENCH_WINDOW        (100 * BENCH_DEVICES)
+
+
+/**
+ * @brief Number of queries of each variant
+ */
+#define BENCH_QUERIES       1000
+
+
+/**
+ * @brief Number of full scans of each variant
+ */
+#define BENCH_SCANS         3
+
+
+/**
+ * @brief Stringify the value of a macro
+ */
+#define STR(x)      STR_(x)
+#define STR_(x)     # x
+
+
+/**
+ * @brief SQL command to fill the tables, ?1 being the number of messages
+ */
+#define BENCH_FILL \
+    "WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i + 1 < ?1)" \
+    " INSERT INTO `raws` SELECT i + 1, " STR(BENCH_FIRST_TIMESTAMP) " + i, printf('%08X', i % " STR(BENCH_DEVICES) ")," \
+    " 10.5, printf('%04X', i * 7 % " STR(BENCH_STATIONS) "), 0, '16f000000000000000000000', x'16f000000000000000000000'," \
+    " 0, 10.5, -120.5, 43, 1, i / " STR(BENCH_DEVICES) " FROM n;" \
+    "INSERT INTO `receptions` SELECT id_raws, station, snr, rssi, latitude, longitude, timestamp FROM `raws`;"
+
+
+/**
+ * @brief Same as SELECT_DEVICE_FRAMES, without the index
+ */
+#define BENCH_DEVICE_SCAN \
+    SELECT_FRAMES_COLUMNS \
+    " FROM `raws` r NOT INDEXED LEFT JOIN `receptions` c ON c.id_raws = r.id_raws" \
+    " WHERE r.id_modem = ?1 AND r.timestamp BETWEEN ?2 AND ?4" \
+    " AND (r.timestamp, r.id_raws) > (?2, ?3) AND (r.timestamp, r.id_raws) <= (?4, ?5)" \
+    " ORDER BY r.timestamp, r.id_raws, c.rowid;"
+
+
+/**
+ * @brief Same as SELECT_STATION_FRAMES, without the index
+ */
+#define BENCH_STATION_SCAN \
+    SELECT_FRAMES_COLUMNS \
+    " FROM `receptions` c NOT INDEXED JOIN `raws` r ON r.id_raws = c.id_raws" \
+    " WHERE c.station = ?1 AND c.timestamp BETWEEN ?2 AND ?4" \
+    " AND (c.timestamp, c.id_raws) > (?2, ?3) AND (c.timestamp, c.id_raws) <= (?4, ?5)" \
+    " ORDER BY c.timestamp, c.id_raws;"
+
+
+/**
+ * @brief      Run queries of a statement on random ranges and report their CPU time
+ *
+ * @param      db     The database
+ * @param[in]  name   The name of the variant
+ * @param[in]  sql    The statement (parameters of SELECT_DEVICE_FRAMES)
+ * @param[in]  count  Number of values of the filter (devices or stations)
+ * @param[in]  width  Length of the identifier (8 for a device, 4 for a station)
+ * @param[in]  rows   Number of messages
+ * @param[in]  n      Number of queries
+ *
+ * @return     0 on success, -1 on error
+ */
+static int bench_ranges(sqlite3         *db,
+                        const char      *name,
+                        const char      *sql,
+                        unsigned int    count,
+                        int             width,
+                        unsigned long   rows,
+                        unsigned long   n
+                        )
+{
+    sqlite3_stmt        *stmt   = NULL;
+    char                value[16];
+    unsigned long       found   = 0;
+    unsigned long       i       = 0;
+    long long           from    = 0;
+    double              start   = 0;
+    int                 result  = 0;
+
+
+    if ( sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK )
+    {
+        fprintf(stderr, "%s\n", sqlite3_errmsg(db) );
+
+        return (-1);
+    }
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        from = BENCH_FIRST_TIMESTAMP + (long long) ( (i * 7919) % rows);
+        snprintf(value, sizeof(value), "%0*lX", width, (i * 104729) % count);
+        sqlite3_bind_text(stmt, 1, value, strlen(value), SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, from);
+        sqlite3_bind_int64(stmt, 3, 0);
+        sqlite3_bind_int64(stmt, 4, from + BENCH_WINDOW);
+        sqlite3_bind_int64(stmt, 5, (long long) ( (~0ULL) >> 1) );
+
+        while ( (result = sqlite3_step(stmt) ) == SQLITE_ROW )
+        {
+            found++;
+        }
+
+        sqlite3_reset(stmt);
+
+        if ( result != SQLITE_DONE )
+        {
+            fprintf(stderr, "%s\n", sqlite3_errmsg(db) );
+            sqlite3_finalize(stmt);
+
+            return (-1);
+        }
+    }
+
+    bench_report(name, n, bench_cpu_ns() - start);
+    fprintf(stdout, "%-24s %10lu rows/op\n", "", found / n);
+    sqlite3_finalize(stmt);
+
+    return (0);
+}
+
+
+
+/**
+ * @brief The benchmark
+ *
+ * @param argc Number of arguments
+ * @param argv Lists of pointers that points to the arguments
+ *
+ * @return Exit code
+ */
+int main(int    argc,
+         char   **argv
+         )
+{
+    unsigned long       rows    = bench_iterations(argc, argv, 1000000);
+    const char          *path   = (argc > 2) ? argv[2] : "/tmp/bench_query.db";
+    db_plugin_t         *plugin = NULL;
+    sqlite3_stmt        *stmt   = NULL;
+    const char          *tail   = BENCH_FILL;
+    double              start   = 0;
+    int                 result  = 0;
+
+
+    if ( (plugin = db_open(path) ) == NULL )
+    {
+        fprintf(stderr, "Cannot open DB [%s]\n", path);
+
+        return (1);
+    }
+
+
+    // Fill an empty database only, so a large one is built once and queried again
+    sqlite3_prepare_v2(plugin->db, "SELECT COUNT(*) FROM `raws`;", -1, &stmt, NULL);
+    sqlite3_step(stmt);
+    result = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+
+    start = bench_cpu_ns();
+
+    while ( (result == 0) && *tail )
+    {
+        if ( sqlite3_prepare_v2(plugin->db, tail, -1, &stmt, &tail) != SQLITE_OK )
+        {
+            fprintf(stderr, "%s\n", sqlite3_errmsg(plugin->db) );
+
+            return (1);
+        }
+
+        sqlite3_bind_int64(stmt, 1, (long long) rows);
+
+        if ( sqlite3_step(stmt) != SQLITE_DONE )
+        {
+            fprintf(stderr, "%s\n", sqlite3_errmsg(plugin->db) );
+
+            return (1);
+        }
+
+        sqlite3_finalize(stmt);
+    }
+
+    bench_report("fill", rows, bench_cpu_ns() - start);
+
+    if ( bench_ranges(plugin->db, "device (index)", SELECT_DEVICE_FRAMES, BENCH_DEVICES, 8, rows, BENCH_QUERIES) ||
+         bench_ranges(plugin->db, "device (scan)", BENCH_DEVICE_SCAN, BENCH_DEVICES, 8, rows, BENCH_SCANS) ||
+         bench_ranges(plugin->db, "station (index)", SELECT_STATION_FRAMES, BENCH_STATIONS, 4, rows, BENCH_QUERIES) ||
+         bench_ranges(plugin->db, "station (scan)", BENCH_STATION_SCAN, BENCH_STATIONS, 4, rows, BENCH_SCANS) )
+    {
+        return (1);
+    }
+
+    db_close( (void **) &plugin);
+
+    return (0);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file bench_rows.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Per-row CPU time and bytes on the wire of GET /api, one HTTP chunk per printf versus the JSON writer
+ *
+ * Usage: bench_rows.out [rows]
+ *
+ * The chunks are not sent, their size and their framing (hexadecimal length, two CRLF) are counted like
+ * mg_send_http_chunk writes them.
+ */
+
+#include <stdio.h>          // snprintf
+#include <stdarg.h>          // va_list
+
+#include <jsonw.h>          // jsonw_init, jsonw_raw, jsonw_string, jsonw_integer, jsonw_double, jsonw_bool, jsonw_flush
+
+#include "bench.h"
+
+
+/**
+ * @brief Size of the buffer of the JSON writer (DB_EXPORT_CHUNK)
+ */
+#define BENCH_CHUNK     (16 * 1024)
+
+
+/**
+ * @brief      Count the bytes of an HTTP chunk, with its framing
+ *
+ * @param      ctx   The byte counter
+ * @param[in]  buf   The content of the chunk
+ * @param[in]  len   Length of the content
+ */
+static void count_chunk(void        *ctx,
+                        const char  *buf __attribute__( (unused) ),
+                        size_t      len
+                        )
+{
+    char        size[24];
+    int         digits  = snprintf(size, sizeof(size), "%lX", (unsigned long) len);
+
+
+    *(unsigned long long *) ctx += (unsigned long long) digits + 4 + len;
+}
+
+
+
+/**
+ * @brief      Format a chunk the way mg_printf_http_chunk did for each part of a row
+ *
+ * @param      bytes  The byte counter
+ * @param[in]  fmt    The format
+ */
+static void printf_chunk(unsigned long long     *bytes,
+                         const char             *fmt,
+                         ...
+                         )
+{
+    char        buf[512];
+    va_list     ap;
+    int         len = 0;
+
+
+    va_start(ap, fmt);
+    len = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    count_chunk(bytes, buf, len);
+}
+
+
+
+/**
+ * @brief The benchmark
+ *
+ * @param argc Number of arguments
+ * @param argv Lists of pointers that points to the arguments
+ *
+ * @return Exit code
+ */
+int main(int    argc,
+         char   **argv
+         )
+{
+    unsigned long       n       = bench_iterations(argc, argv, 1000000);
+    unsigned long long  bytes   = 0;
+    unsigned long       i       = 0;
+    double              start   = 0;
+    static char         chunk[BENCH_CHUNK];
+    jsonw_t             w;
+
+
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        printf_chunk(&bytes,
+                     "%s{ \"timestamp\": %lld, \"id_modem\": \"%s\", \"ack\": %s, \"data_str\": \"%s\", "
+                     "\"duplicate\": %s, \"avg_signal\": %.2f, \"seq_number\": %d",
+                     (i == 0) ? " " : ", ", 1476691200LL + (long long) i, "12FED", "false",
+                     "16f000000000000000000000", "false", 12.5, (int) (i & 0xFFF) );
+        printf_chunk(&bytes,
+                     "%s\"station\": \"%s\", \"snr\": %.2f, \"rssi\": %.2f, \"latitude\": %d, \"longitude\": %d }",
+                     ", ", "0F3B", 10.23, -120.5, 43, 1);
+    }
+
+    bench_report("chunk per printf", n, bench_cpu_ns() - start);
+    fprintf(stdout, "%-24s %10.1f bytes/row\n", "", (double) bytes / (double) n);
+
+    bytes = 0;
+    jsonw_init(&w, chunk, sizeof(chunk), count_chunk, &bytes);
+    start = bench_cpu_ns();
+
+    for ( i = 0; i < n; ++i )
+    {
+        if ( i == 0 )
+        {
+            jsonw_literal(&w, " { \"timestamp\": ");
+        }
+        else
+        {
+            jsonw_literal(&w, ", { \"timestamp\": ");
+        }
+
+        jsonw_integer(&w, 1476691200LL + (long long) i);
+        jsonw_literal(&w, ", \"id_modem\": ");
+        jsonw_string(&w, "12FED", 5);
+        jsonw_literal(&w, ", \"ack\": ");
+        jsonw_bool(&w, 0);
+        jsonw_literal(&w, ", \"data_str\": ");
+        jsonw_string(&w, "16f000000000000000000000", 24);
+        jsonw_literal(&w, ", \"duplicate\": ");
+        jsonw_bool(&w, 0);
+        jsonw_literal(&w, ", \"avg_signal\": ");
+        jsonw_double(&w, 12.5);
+        jsonw_literal(&w, ", \"seq_number\": ");
+        jsonw_integer(&w, (int) (i & 0xFFF) );
+        jsonw_literal(&w, ", \"station\": ");
+        jsonw_string(&w, "0F3B", 4);
+        jsonw_literal(&w, ", \"snr\": ");
+        jsonw_double(&w, 10.23);
+        jsonw_literal(&w, ", \"rssi\": ");
+        jsonw_double(&w, -120.5);
+        jsonw_literal(&w, ", \"latitude\": ");
+        jsonw_integer(&w, 43);
+        jsonw_literal(&w, ", \"longitude\": ");
+        jsonw_integer(&w, 1);
+        jsonw_literal(&w, " }");
+    }
+
+    jsonw_flush(&w);
+    bench_report("json writer", n, bench_cpu_ns() - start);
+    fprintf(stdout, "%-24s %10.1f bytes/row\n", "", (double) bytes / (double) n);
+
+    return (0);
+}
@@ -0,0 +1,114 @@
+/**
+ * @file arena.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Bump allocator for the memory that only lives while a request is handled
+ *
+ * The memory is taken from a block allocated once, by moving an offset, and everything is given back at once by
+ * arena_reset at the end of the request. When the block is full, the allocation falls back to the heap and the
+ * overflow blocks are freed by the next arena_reset. It is not thread-safe, it belongs to the event loop.
+ */
+
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>          // size_t
+#include <stdarg.h>          // va_list
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @typedef arena_block_t
+ */
+typedef struct arena_block_s arena_block_t;
+
+
+/**
+ * @typedef arena_t
+ */
+typedef struct arena_s arena_t;
+
+
+/**
+ * @struct     arena_s
+ * @brief      The block and the counters
+ */
+struct arena_s {
+    char *base;          ///< The block
+    size_t size;          ///< Size of the block
+    size_t used;          ///< Bytes of the block in use
+    size_t peak;          ///< Highest number of bytes in use
+    arena_block_t *overflow;          ///< Allocations that did not fit in the block, freed by arena_reset
+    unsigned long overflows;          ///< Number of allocations that did not fit in the block
+};
+
+
+/**
+ * @brief      Allocate the block of an arena
+ *
+ * @param      arena  The arena
+ * @param[in]  size   Size of the block
+ *
+ * @return     0 on success, -1 on error
+ */
+int arena_init(arena_t *arena, size_t size);
+
+
+/**
+ * @brief      Free the block of an arena and its overflow allocations
+ *
+ * @param      arena  The arena
+ */
+void arena_destroy(arena_t *arena);
+
+
+/**
+ * @brief      Allocate memory (aligned on 8 bytes), valid until the next arena_reset
+ *
+ * @param      arena  The arena
+ * @param[in]  size   The size
+ *
+ * @return     The memory, NULL on error
+ */
+void* arena_alloc(arena_t *arena, size_t size);
+
+
+/**
+ * @brief      Format a string in the arena
+ *
+ * @param      arena  The arena
+ * @param[out] len    Length of the string (without the final '\0')
+ * @param[in]  fmt    The format
+ * @param[in]  ap     The arguments
+ *
+ * @return     The string, NULL on error
+ */
+char* arena_vprintf(arena_t *arena, size_t *len, const char *fmt, va_list ap);
+
+
+/**
+ * @brief      Give back the memory of the block allocated since a mark (the overflow allocations are kept)
+ *
+ * @param      arena  The arena
+ * @param[in]  mark   Value of arena->used taken before the allocations
+ */
+void arena_rewind(arena_t *arena, size_t mark);
+
+
+/**
+ * @brief      Give back all the memory (end of a request)
+ *
+ * @param      arena  The arena
+ */
+void arena_reset(arena_t *arena);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __ARENA_H__
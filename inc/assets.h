@@ -0,0 +1,46 @@
+/**
+ * @file assets.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Static files of the document root, compressed once and served from memory
+ *
+ * The text files (HTML, CSS, JavaScript, JSON, SVG...) are compressed at the highest level the first time a client
+ * that accepts gzip or deflate asks for them, and kept until the file changes on the disk (its modification time or
+ * its size). The other files and the clients that do not accept a compressed reply are left to mg_serve_http. It is
+ * not thread-safe, it belongs to the event loop.
+ */
+
+
+#ifndef __ASSETS_H__
+#define __ASSETS_H__
+
+#include <mongoose.h>          // struct mg_connection, struct http_message
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief      Serve a static file compressed, if the client accepts it and the file is worth it
+ *
+ * @param      nc    The connection
+ * @param      hm    The request
+ * @param[in]  root  The document root
+ *
+ * @return     1 if the reply was sent, 0 if the file is to be served by mg_serve_http
+ */
+int assets_serve(struct mg_connection *nc, struct http_message *hm, const char *root);
+
+
+/**
+ * @brief      Free the compressed files
+ */
+void assets_free(void);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __ASSETS_H__
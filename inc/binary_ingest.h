@@ -0,0 +1,75 @@
+/**
+ * @file binary_ingest.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Listeners of the binary records (sigfox_binary.h) sent by the local gateways, over TCP and UDP
+ *
+ * The TCP connections are a stream of records handled by the event loop. The UDP datagrams hold one or more records
+ * each; they are received by batches with recvmmsg on a dedicated thread and handed to the event loop with
+ * mg_broadcast. In both cases the frames go to db_ingest, so they are stored like the ones of POST /api. A reply is
+ * sent back (on the connection, or to the sender of the datagram) for the records that require an acknowledge and for
+ * the refused ones; the other records are not answered.
+ */
+
+
+#ifndef __BINARY_INGEST_H__
+#define __BINARY_INGEST_H__
+
+#include <pthread.h>          // pthread_t
+#include <stdatomic.h>          // atomic_int
+
+#include <mongoose.h>          // struct mg_mgr, struct mg_connection
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @typedef binary_ingest_t
+ */
+typedef struct binary_ingest_s binary_ingest_t;
+
+
+/**
+ * @struct     binary_ingest_s
+ * @brief      The listeners and their counters
+ */
+struct binary_ingest_s {
+    void *db;          ///< The database
+    struct mg_mgr *mgr;          ///< Manager of the event loop
+    struct mg_connection *listener;          ///< TCP listener
+    int udp;          ///< UDP socket
+    pthread_t receiver;          ///< Thread receiving the datagrams
+    atomic_int running;          ///< Cleared to stop the receiver thread
+    atomic_int stopped;          ///< Set by the receiver thread once it is done
+    unsigned long records;          ///< Records received
+    unsigned long refused;          ///< Records invalid or refused by db_ingest
+};
+
+
+/**
+ * @brief      Listen for the binary records on a TCP and a UDP port
+ *
+ * @param      mgr   Manager of the event loop
+ * @param[in]  port  The port (same number for TCP and UDP)
+ * @param      db    The database (its writer thread must be started)
+ *
+ * @return     The listeners, NULL on error
+ */
+binary_ingest_t* binary_ingest_start(struct mg_mgr *mgr, const char *port, void *db);
+
+
+/**
+ * @brief      Stop the listeners (before the writer thread of the database)
+ *
+ * @param      ingest  The listeners, set to NULL
+ */
+void binary_ingest_stop(binary_ingest_t **ingest);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __BINARY_INGEST_H__
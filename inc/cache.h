@@ -0,0 +1,134 @@
+/**
+ * @file cache.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Cache of whole replies, tagged with the version of the data they were read from
+ *
+ * An entry is a key (the normalized request), the version of the database it was read at, extra header lines and the
+ * body. An entry is only returned for the current version: the older ones are freed when they are looked up, and the
+ * least recently used entries are evicted to stay within the number of entries and the bytes of the cache. It is not
+ * thread-safe, it belongs to the event loop.
+ */
+
+
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <stddef.h>          // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @typedef cache_entry_t
+ */
+typedef struct cache_entry_s cache_entry_t;
+
+
+/**
+ * @typedef cache_t
+ */
+typedef struct cache_s cache_t;
+
+
+/**
+ * @struct     cache_entry_s
+ * @brief      A reply (the key, the header lines and the body follow the structure)
+ */
+struct cache_entry_s {
+    cache_entry_t *prev;          ///< More recently used entry
+    cache_entry_t *next;          ///< Less recently used entry
+    unsigned long long version;          ///< Version of the data
+    size_t key_len;          ///< Length of the key
+    size_t headers_len;          ///< Length of the header lines
+    size_t body_len;          ///< Length of the body
+    char data[];          ///< The key, the header lines then the body
+};
+
+
+/**
+ * @struct     cache_s
+ * @brief      The entries, most recently used first, and the counters
+ */
+struct cache_s {
+    cache_entry_t *head;          ///< Most recently used entry
+    cache_entry_t *tail;          ///< Least recently used entry
+    unsigned int count;          ///< Number of entries
+    unsigned int max_count;          ///< Maximum number of entries
+    size_t bytes;          ///< Bytes of the entries
+    size_t max_bytes;          ///< Maximum bytes of the entries
+    unsigned long hits;          ///< Lookups that found an entry of the current version
+    unsigned long misses;          ///< Lookups that did not
+    unsigned long stores;          ///< Entries stored
+    unsigned long evictions;          ///< Entries freed because they were stale or to make room
+};
+
+
+/**
+ * @brief      Header lines of an entry
+ */
+#define cache_headers(entry)    ( (entry)->data + (entry)->key_len)
+
+
+/**
+ * @brief      Body of an entry
+ */
+#define cache_body(entry)       ( (entry)->data + (entry)->key_len + (entry)->headers_len)
+
+
+/**
+ * @brief      Initialize an empty cache
+ *
+ * @param      cache      The cache
+ * @param[in]  max_bytes  Maximum bytes of the entries (structures included)
+ * @param[in]  max_count  Maximum number of entries
+ */
+void cache_init(cache_t *cache, size_t max_bytes, unsigned int max_count);
+
+
+/**
+ * @brief      Free the entries of a cache
+ *
+ * @param      cache  The cache
+ */
+void cache_destroy(cache_t *cache);
+
+
+/**
+ * @brief      Find the entry of a key at a version, and make it the most recently used
+ *
+ * @param      cache    The cache
+ * @param[in]  key      The key
+ * @param[in]  key_len  Length of the key
+ * @param[in]  version  The current version (an entry of another version is freed)
+ *
+ * @return     The entry (valid until the next cache_put), NULL if there is none
+ */
+const cache_entry_t* cache_get(cache_t *cache, const char *key, size_t key_len, unsigned long long version);
+
+
+/**
+ * @brief      Store a reply, replacing the entry of the same key
+ *
+ * @param      cache        The cache
+ * @param[in]  key          The key
+ * @param[in]  key_len      Length of the key
+ * @param[in]  version      Version of the data of the reply
+ * @param[in]  headers      The header lines (each one ending with CRLF)
+ * @param[in]  headers_len  Length of the header lines
+ * @param[in]  body         The body
+ * @param[in]  body_len     Length of the body
+ *
+ * @return     0 on success, -1 if the reply is larger than the cache or on allocation error
+ */
+int cache_put(cache_t *cache, const char *key, size_t key_len, unsigned long long version, const char *headers,
+              size_t headers_len, const char *body, size_t body_len);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __CACHE_H__
@@ -0,0 +1,97 @@
+/**
+ * @file cborw.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  CBOR items (RFC 8949), rendered into the buffer of a JSON writer
+ *
+ * The writer of jsonw.h is only used as a buffer with its flush callback. The heads use the shortest length, a double
+ * is written as a single-precision float when it converts back to the same value, and the lists of unknown length
+ * (the rows of a read) use the indefinite-length array closed by cborw_break.
+ */
+
+
+#ifndef __CBORW_H__
+#define __CBORW_H__
+
+#include <stddef.h>          // size_t
+
+#include <jsonw.h>          // jsonw_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief      Write a text string literal (a key of a map)
+ */
+#define cborw_key(w, s)         cborw_text( (w), (s), sizeof(s) - 1)
+
+
+/**
+ * @brief      Write a signed integer
+ *
+ * @param      w      The writer
+ * @param[in]  value  The value
+ */
+void cborw_integer(jsonw_t *w, long long value);
+
+
+/**
+ * @brief      Write a text string
+ *
+ * @param      w     The writer
+ * @param[in]  s     The string, UTF-8 (can be NULL if len is 0)
+ * @param[in]  len   Length of the string
+ */
+void cborw_text(jsonw_t *w, const char *s, size_t len);
+
+
+/**
+ * @brief      Write a floating-point number
+ *
+ * @param      w      The writer
+ * @param[in]  value  The value
+ */
+void cborw_double(jsonw_t *w, double value);
+
+
+/**
+ * @brief      Write a boolean
+ *
+ * @param      w      The writer
+ * @param[in]  value  0 for false, true otherwise
+ */
+void cborw_bool(jsonw_t *w, int value);
+
+
+/**
+ * @brief      Open a map of a known number of pairs (the keys and the values follow)
+ *
+ * @param      w      The writer
+ * @param[in]  pairs  Number of pairs
+ */
+void cborw_map(jsonw_t *w, size_t pairs);
+
+
+/**
+ * @brief      Open an array of unknown length, closed by cborw_break
+ *
+ * @param      w     The writer
+ */
+void cborw_array(jsonw_t *w);
+
+
+/**
+ * @brief      Close an array of unknown length
+ *
+ * @param      w     The writer
+ */
+void cborw_break(jsonw_t *w);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __CBORW_H__
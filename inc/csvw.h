@@ -0,0 +1,48 @@
+/**
+ * @file csvw.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  CSV fields (RFC 4180), rendered into the buffer of a JSON writer
+ *
+ * The writer of jsonw.h is only used as a buffer with its flush callback: the integers and the booleans are the same
+ * text in both formats (jsonw_integer, jsonw_bool), the separators are written with jsonw_literal ("," and "\r\n").
+ * A string is quoted only if it holds a comma, a quote or a line break.
+ */
+
+
+#ifndef __CSVW_H__
+#define __CSVW_H__
+
+#include <stddef.h>          // size_t
+
+#include <jsonw.h>          // jsonw_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief      Write a string field
+ *
+ * @param      w     The writer
+ * @param[in]  s     The string (can be NULL if len is 0)
+ * @param[in]  len   Length of the string
+ */
+void csvw_string(jsonw_t *w, const char *s, size_t len);
+
+
+/**
+ * @brief      Write a double field (empty if it is not finite)
+ *
+ * @param      w      The writer
+ * @param[in]  value  The value
+ */
+void csvw_double(jsonw_t *w, double value);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __CSVW_H__
@@ -9,7 +9,21 @@
 #ifndef __DB_PLUGIN_SQLITE_H__
 #define __DB_PLUGIN_SQLITE_H__
 
+#include <sqlite3.h>          // sqlite3, sqlite3_stmt
+#include <pthread.h>          // pthread_t
+#include <semaphore.h>          // sem_t
+#include <stdatomic.h>          // atomic_int
+
 #include <mongoose.h>
+#include <frames.h>          // sigfox_raws_t, sigfox_device_t
+#include <mpsc_queue.h>          // mpsc_queue_t
+#include <dedup.h>          // dedup_t
+#include <downlink.h>          // downlink_t
+#include <devstats.h>          // devstats_t
+#include <rollup.h>          // rollup_t
+#include <histogram.h>          // histogram_t
+#include <arena.h>          // arena_t
+#include <cache.h>          // cache_t
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,18 +38,193 @@ typedef enum {
     API_OP_NULL,          ///< Do nothing
     API_OP_GET,          ///< Select * from raws
     API_OP_SET,          ///< Add a raws structure
-    API_OP_DEL          ///< Delete a raws structure (Not Implemented yet)
+    API_OP_DEL,          ///< Delete a raws structure (Not Implemented yet)
+    API_OP_SET_BATCH,          ///< Add several raws structures in one transaction
+    API_OP_DOWNLINK          ///< Queue a downlink payload for a device
 } API_Operation;
 
 
 /**
- * @brief      Open the database and create its tables
+ * @enum DB_Dedup
+ * @brief  What is done with a frame whose (id_modem, seq_number) was seen within the duplicate window
+ */
+typedef enum {
+    DB_DEDUP_OFF,          ///< Store every copy (no lookup)
+    DB_DEDUP_DROP,          ///< Answer the copies without storing them
+    DB_DEDUP_FLAG          ///< Store the copies as receptions and set duplicate on their message
+} DB_Dedup;
+
+
+/**
+ * @enum DB_Admission
+ * @brief  Class of a request, the classes are refused in reverse order when the writer queues fill up
+ *
+ * Each class has its own queue: the writes that require an acknowledge go through their own writer queue, served
+ * ahead of the other writes, and the reads are streamed a slice at a time between the turns of the event loop.
+ */
+typedef enum {
+    DB_ADMIT_ACK,          ///< Frame that requires an acknowledge (only refused when the queue is full)
+    DB_ADMIT_FRAME,          ///< Other writes (refused above the high watermark)
+    DB_ADMIT_QUERY          ///< GET of the frames (refused above the low watermark)
+} DB_Admission;
+
+
+/**
+ * @enum DB_Format
+ * @brief  Format of the rows of a read, chosen with ?format= or the Accept header
+ */
+typedef enum {
+    DB_FORMAT_JSON,          ///< A JSON list (application/json)
+    DB_FORMAT_NDJSON,          ///< One JSON object per line (application/x-ndjson)
+    DB_FORMAT_CSV,          ///< A header line then one record per reception (text/csv, RFC 4180)
+    DB_FORMAT_CBOR          ///< A CBOR array of unknown length of maps (application/cbor)
+} DB_Format;
+
+
+/**
+ * @typedef db_plugin_t
+ */
+typedef struct db_plugin_s db_plugin_t;
+
+
+/**
+ * @typedef db_export_t
+ */
+typedef struct db_export_s db_export_t;
+
+
+/**
+ * @typedef db_batch_item_t
+ */
+typedef struct db_batch_item_s db_batch_item_t;
+
+
+/**
+ * @struct     db_batch_item_s
+ * @brief      One frame of a POST /api/batch request
+ */
+struct db_batch_item_s {
+    sigfox_raws_t raws;          ///< The frame
+    unsigned char error;          ///< Error of the frame validation, 0 if it is valid
+    unsigned char dedup;          ///< DB_DEDUP_DROP if the frame is a copy to drop
+    unsigned char remembered;          ///< 1 if the frame added its (id_modem, seq_number) pair to the dedup set
+    int result;          ///< Result of its insertion
+    unsigned char message;          ///< 1 if the frame was stored as a new message, 0 if as a reception of a stored one
+    sqlite3_int64 downlink_id;          ///< Queued downlink answered to the frame, 0 if there is none
+    char downlink_data[SIGFOX_DOWNLINK_DATA_LENGTH + 1];          ///< Downlink payload answered to the frame
+};
+
+
+/**
+ * @typedef db_pending_t
+ */
+typedef struct db_pending_s db_pending_t;
+
+
+/**
+ * @struct     db_pending_s
+ * @brief      Write operation sent to the writer thread, and sent back to the event loop once committed
+ */
+struct db_pending_s {
+    API_Operation op;          ///< API_OP_SET, API_OP_SET_BATCH, API_OP_DEL or API_OP_DOWNLINK
+    struct mg_connection *nc;          ///< Connection waiting for the reply, NULL if it was already answered
+    unsigned long conn_id;          ///< Identifier stored in nc->user_data, so a reused mg_connection is not answered
+    sigfox_raws_t raws;          ///< The frame to insert (API_OP_SET), or the device of the downlink (API_OP_DOWNLINK)
+    db_batch_item_t *batch;          ///< The frames to insert (API_OP_SET_BATCH), freed once answered
+    unsigned int batch_count;          ///< Number of frames in batch
+    int result;          ///< Result of the operation
+    unsigned char message;          ///< 1 if the frame (API_OP_SET) was stored as a new message
+    unsigned char remembered;          ///< 1 if the frame (API_OP_SET) added its pair to the dedup set
+    sqlite3_int64 downlink_id;          ///< Queued downlink answered to the frame (API_OP_SET) or to insert (API_OP_DOWNLINK)
+    char downlink_data[SIGFOX_DOWNLINK_DATA_LENGTH + 1];          ///< Downlink payload answered to the frame or to insert
+};
+
+
+/**
+ * @struct     db_plugin_s
+ * @brief      Database handle and the statements prepared once for its whole lifetime
+ */
+struct db_plugin_s {
+    sqlite3 *db;          ///< Write connection, owned by the writer thread once it is started
+    sqlite3 *db_read;          ///< Read connection, used by the event loop
+    sqlite3_stmt *insert_raws;          ///< Prepared INSERT_RAWS (write connection)
+    sqlite3_stmt *select_frames;          ///< Prepared SELECT_FRAMES (read connection)
+    sqlite3_stmt *select_page_last;          ///< Prepared SELECT_PAGE_LAST (read connection)
+    sqlite3_stmt *select_page_first;          ///< Prepared SELECT_PAGE_FIRST (read connection)
+    sqlite3_stmt *select_device_frames;          ///< Prepared SELECT_DEVICE_FRAMES (read connection)
+    sqlite3_stmt *select_device_page;          ///< Prepared SELECT_DEVICE_PAGE (read connection)
+    sqlite3_stmt *select_station_frames;          ///< Prepared SELECT_STATION_FRAMES (read connection)
+    sqlite3_stmt *select_station_page;          ///< Prepared SELECT_STATION_PAGE (read connection)
+    sqlite3_stmt *data_version;          ///< Prepared SELECT_DATA_VERSION (read connection)
+    sqlite3_stmt *delete_raws;          ///< Prepared DELETE_RAWS (write connection)
+    sqlite3_stmt *delete_receptions;          ///< Prepared DELETE_RECEPTIONS (write connection)
+    sqlite3_stmt *insert_devices;          ///< Prepared INSERT_DEVICES (write connection)
+    sqlite3_stmt *select_message;          ///< Prepared SELECT_MESSAGE (write connection)
+    sqlite3_stmt *insert_receptions;          ///< Prepared INSERT_RECEPTIONS (write connection)
+    sqlite3_stmt *flag_duplicate;          ///< Prepared FLAG_DUPLICATE (write connection)
+    sqlite3_stmt *insert_downlinks;          ///< Prepared INSERT_DOWNLINKS (write connection)
+    sqlite3_stmt *deliver_downlink;          ///< Prepared DELIVER_DOWNLINK (write connection)
+    sqlite3_stmt *upsert_rollups;          ///< Prepared UPSERT_ROLLUPS (write connection)
+    sqlite3_stmt *delete_rollups;          ///< Prepared DELETE_ROLLUPS (write connection)
+    sqlite3_stmt *savepoint_op;          ///< Prepared SAVEPOINT_OP (write connection)
+    sqlite3_stmt *release_op;          ///< Prepared RELEASE_OP (write connection)
+    sqlite3_stmt *rollback_op;          ///< Prepared ROLLBACK_OP (write connection)
+    sqlite3_stmt *select_rollups;          ///< Prepared SELECT_ROLLUPS (read connection)
+    sqlite3_stmt *select_rollups_page;          ///< Prepared SELECT_ROLLUPS_PAGE (read connection)
+    unsigned int batch_size;          ///< Maximum number of frames committed in one transaction
+    unsigned int batch_wait;          ///< Maximum time a frame waits for its commit (in milliseconds)
+    db_pending_t *pending;          ///< Operations of the batch being committed (batch_size entries)
+    mpsc_queue_t *queue;          ///< Operations sent to the writer thread (NULL if it is not started)
+    mpsc_queue_t *queue_ack;          ///< Frames that require an acknowledge (and downlinks), served ahead of queue
+    sem_t queue_sem;          ///< Posted once for each operation pushed into the queue
+    pthread_t writer;          ///< Writer thread
+    atomic_int running;          ///< Cleared to stop the writer thread
+    atomic_int stopped;          ///< Set by the writer thread when it exits
+    struct mg_mgr *mgr;          ///< Manager the completions are broadcast to
+    unsigned long last_conn_id;          ///< Last identifier given to a connection
+    DB_Dedup dedup_mode;          ///< What is done with the copies of a frame
+    dedup_t *dedup;          ///< Recently seen (id_modem, seq_number) pairs (NULL if dedup_mode is DB_DEDUP_OFF)
+    downlink_t *downlinks;          ///< Downlink payloads set through /api/devices/{id_modem}/downlink(s)
+    sqlite3_int64 last_downlink_id;          ///< Last identifier given to a queued downlink
+    devstats_t *devstats;          ///< Statistics of the frames of each device, served by /api/devices/stats
+    rollup_t *rollups;          ///< Rollups of the frames of the transaction being run, upserted before its commit
+    histogram_t ack_latency;          ///< Time from the reception of a frame that requires an acknowledge to its reply
+    unsigned long ack_lost;          ///< Frames acknowledged before their commit whose insertion failed
+    size_t high_watermark;          ///< Queue depth from which the writes without acknowledge are refused (0 if disabled)
+    size_t low_watermark;          ///< Queue depth below which they are accepted again, and from which the queries are refused
+    int overloaded;          ///< Set from the high watermark until the depth falls back to the low watermark
+    unsigned long shed_queries;          ///< Queries refused with 503
+    unsigned long shed_frames;          ///< Writes without acknowledge refused with 503
+    unsigned long shed_full;          ///< Writes refused with 503 because the queue was full
+    db_export_t *exports;          ///< Reads being streamed, a slice at a time
+    unsigned long export_slices;          ///< Slices of rows sent
+    unsigned long export_timeouts;          ///< Reads dropped because their client stopped reading
+    unsigned long long export_rows;          ///< Rows sent
+    unsigned long long export_bytes;          ///< Bytes of JSON sent by the completed reads
+    unsigned long export_chunks;          ///< HTTP chunks sent by the completed reads
+    cache_t cache;          ///< Replies of the reads, tagged with the data version they were read at
+    unsigned long not_modified;          ///< Reads answered 304 Not Modified
+    unsigned long compressed;          ///< Completed reads sent compressed
+    unsigned long long compressed_in;          ///< Bytes of JSON of the compressed reads
+    unsigned long long compressed_out;          ///< Bytes sent for them once compressed
+    arena_t arena;          ///< Memory of the request being handled (tokens, formatted chunks), reset once it is handled
+    unsigned long requests;          ///< Requests handled
+    unsigned long requests_allocating;          ///< Requests since whose previous one the event loop allocated on the heap
+    unsigned long allocations;          ///< Heap allocations counted when the last request started
+};
+
+
+/**
+ * @brief      Open the database, create its tables and prepare the statements
+ *
+ * Two connections are opened on the database in WAL mode: one for the writes and one for the reads of the event
+ * loop. Each connection is only used by one thread, so SQLite is opened without its mutexes.
  *
  * @param[in]  db_path  The database path
  *
- * @return     Pointer to the database
+ * @return     Pointer to the plugin context, NULL on error
  */
-sqlite3* db_open(const char *db_path);
+db_plugin_t* db_open(const char *db_path);
 
 
 /**
@@ -46,6 +235,172 @@ sqlite3* db_open(const char *db_path);
 void db_close(void **db_handler);
 
 
+/**
+ * @brief      Insert a raws structure using the cached INSERT_RAWS statement
+ *
+ * @param      plugin  The plugin context
+ * @param[in]  raws    The raws structure
+ *
+ * @return     The result of sqlite3_step (SQLITE_DONE on success)
+ */
+int db_insert_raws(db_plugin_t *plugin, const sigfox_raws_t *raws);
+
+
+/**
+ * @brief      Store a frame as a reception of its message, the message being inserted on its first reception
+ *
+ * The copies of a message received by other base stations (same id_modem, seq_number and timestamp) only add a
+ * reception. A copy with duplicate set flags its message.
+ *
+ * @param      plugin   The plugin context
+ * @param[in]  raws     The raws structure
+ * @param[out] message  1 if the frame was stored as a new message, 0 if as a reception of a stored one (can be NULL)
+ *
+ * @return     SQLITE_DONE on success, the failing sqlite3_step result otherwise
+ */
+int db_insert_frame(db_plugin_t *plugin, const sigfox_raws_t *raws, unsigned char *message);
+
+
+/**
+ * @brief      Insert a device structure using the cached INSERT_DEVICES statement
+ *
+ * @param      plugin  The plugin context
+ * @param[in]  device  The device structure
+ *
+ * @return     The result of sqlite3_step (SQLITE_DONE on success)
+ */
+int db_insert_device(db_plugin_t *plugin, const sigfox_device_t *device);
+
+
+/**
+ * @brief      Set the group commit of the frames received through op_set (must be called before db_writer_start)
+ *
+ * The frames accepted within the window are inserted in one transaction, and each HTTP reply is sent only once
+ * that transaction has been committed.
+ *
+ * @param      plugin      The plugin context
+ * @param[in]  batch_size  Number of frames that triggers the commit (1 disables the group commit)
+ * @param[in]  batch_wait  Maximum time a frame waits for its commit (in milliseconds)
+ *
+ * @return     0 on success, -1 on error
+ */
+int db_group_commit(db_plugin_t *plugin, unsigned int batch_size, unsigned int batch_wait);
+
+
+/**
+ * @brief      Rebuild the rollups from the stored frames (must be called before db_writer_start)
+ *
+ * The messages are split into ranges of identifiers, taken in turn by the threads: each one reads its ranges on its
+ * own connection and accumulates their rollups in memory, then upserts them through the write connection, one thread
+ * at a time. The whole rebuild is one transaction, so the rollups are replaced at once. The frames must not be
+ * written by another process meanwhile.
+ *
+ * @param      plugin   The plugin context
+ * @param[in]  threads  Number of threads (0 for one per processor)
+ * @param[out] rows     Number of receptions read (can be NULL)
+ *
+ * @return     0 on success, -1 on error
+ */
+int db_backfill(db_plugin_t *plugin, unsigned int threads, unsigned long long *rows);
+
+
+/**
+ * @brief      Set the suppression of the copies of a frame received by several base stations
+ *
+ * The lookup is done on the event loop before the frame is queued. A dropped copy is answered like a stored one
+ * without reaching the writer thread.
+ *
+ * @param      plugin    The plugin context
+ * @param[in]  mode      What is done with the copies
+ * @param[in]  capacity  Number of (id_modem, seq_number) pairs remembered
+ * @param[in]  window    Time a pair is remembered (in seconds)
+ *
+ * @return     0 on success, -1 on error
+ */
+int db_dedup(db_plugin_t *plugin, DB_Dedup mode, size_t capacity, unsigned int window);
+
+
+/**
+ * @brief      Start the thread that owns the write connection
+ *
+ * Once started, op_set and op_del push their operation into a bounded queue instead of running it on the event
+ * loop. The replies are sent from the event loop through mg_broadcast once the operations are committed, except for
+ * the frames that require an acknowledge: the Sigfox backend only waits a few seconds for the downlink, so they are
+ * answered as soon as they are queued and inserted asynchronously.
+ *
+ * @param      plugin      The plugin context
+ * @param      mgr         The manager of the HTTP connections
+ * @param[in]  queue_size  Maximum number of operations waiting for the writer thread
+ *
+ * @return     0 on success, -1 on error
+ */
+int db_writer_start(db_plugin_t *plugin, struct mg_mgr *mgr, size_t queue_size);
+
+
+/**
+ * @brief      Set the admission control of the requests (must be called after db_writer_start)
+ *
+ * The requests are refused with 503 and Retry-After, and their connection is closed, so the requests and the buffers
+ * of their connections do not pile up while the writer thread is stalled. The queries are refused once the depth of
+ * the writer queue is above the low watermark. From the high watermark, the writes without acknowledge are refused
+ * too, until the depth falls back to the low watermark. The frames that require an acknowledge are only refused when
+ * the queue is full.
+ *
+ * @param      plugin  The plugin context
+ * @param[in]  high    The high watermark (in percent of the queue capacity)
+ * @param[in]  low     The low watermark (in percent of the queue capacity, lower than high)
+ *
+ * @return     0 on success, -1 on error
+ */
+int db_admission(db_plugin_t *plugin, unsigned int high, unsigned int low);
+
+
+/**
+ * @brief      Commit the queued operations and stop the writer thread
+ *
+ * The manager is polled until the thread exits, so the last completions can still be delivered.
+ *
+ * @param      plugin  The plugin context
+ */
+void db_writer_stop(db_plugin_t *plugin);
+
+
+/**
+ * @brief      Send the next slice of each read being streamed (called once per turn of the event loop)
+ *
+ * A slice is only sent while the send buffer of its connection is not full, so a slow client does not make the
+ * server buffer the whole table.
+ *
+ * @param      db    The database
+ *
+ * @return     Number of reads that can send a slice right away (the event loop should not sleep)
+ */
+int db_poll(void *db);
+
+
+/**
+ * @brief      Forget the reads streamed to a connection that is closed
+ *
+ * @param      db    The database
+ * @param      nc    The connection
+ */
+void db_disconnect(void *db, struct mg_connection *nc);
+
+
+/**
+ * @brief      Insert a frame received outside of HTTP (binary records), through the same pipeline as POST /api
+ *
+ * The frame is handed to the writer thread without waiting for its commit; the dedup and the downlinks apply.
+ *
+ * @param      db             The database
+ * @param[in]  raws           The frame (decoded and valid)
+ * @param[out] downlink_data  The downlink payload when the frame requires an acknowledge, empty string otherwise
+ *
+ * @return     0 on success, -1 if the frame is refused (admission, queue full or writer thread not started)
+ */
+int db_ingest(void *db, const sigfox_raws_t *raws, char downlink_data[SIGFOX_DOWNLINK_DATA_LENGTH + 1]);
+
+
 /**
  * \brief      Do an operation on the database
  *
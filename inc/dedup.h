@@ -0,0 +1,109 @@
+/**
+ * @file dedup.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Fixed-memory set of the recently seen (id_modem, seq_number) pairs
+ *
+ * The Sigfox backend sends a message once per base station that received it when «send duplicate» is enabled. The
+ * set remembers the pairs seen within a time window, so the copies can be recognized without querying the database.
+ * It is an open addressing table with a bounded probe: once the probed slots are all in use, the oldest pair is
+ * evicted. It is not thread-safe, it belongs to the event loop.
+ */
+
+
+#ifndef __DEDUP_H__
+#define __DEDUP_H__
+
+#include <stddef.h>          // size_t
+#include <stdint.h>          // uint64_t, uint32_t
+#include <time.h>          // time_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @typedef dedup_entry_t
+ */
+typedef struct dedup_entry_s dedup_entry_t;
+
+
+/**
+ * @struct     dedup_entry_s
+ * @brief      A pair and the time it was last seen
+ */
+struct dedup_entry_s {
+    uint64_t device;          ///< id_modem (up to 8 characters, zero-padded)
+    uint32_t seq_number;          ///< Sequence number
+    uint32_t seen;          ///< Time the pair was seen (in seconds), 0 if the slot was never used
+};
+
+
+/**
+ * @typedef dedup_t
+ */
+typedef struct dedup_s dedup_t;
+
+
+/**
+ * @struct     dedup_s
+ * @brief      The set and its counters
+ */
+struct dedup_s {
+    dedup_entry_t *entries;          ///< The slots
+    size_t mask;          ///< Number of slots minus 1 (power of two)
+    unsigned int window;          ///< Time a pair is remembered (in seconds)
+    unsigned long hits;          ///< Pairs found within the window (duplicates)
+    unsigned long misses;          ///< Pairs not found (first copy of a message)
+    unsigned long evictions;          ///< Pairs still within the window overwritten by a new one
+};
+
+
+/**
+ * @brief      Allocate a set
+ *
+ * @param[in]  capacity  Number of pairs (rounded up to a power of two)
+ * @param[in]  window    Time a pair is remembered (in seconds)
+ *
+ * @return     The set, NULL on error
+ */
+dedup_t* dedup_new(size_t capacity, unsigned int window);
+
+
+/**
+ * @brief      Free a set
+ *
+ * @param      dedup  The set (can be NULL)
+ */
+void dedup_free(dedup_t *dedup);
+
+
+/**
+ * @brief      Look a pair up and remember it
+ *
+ * @param      dedup       The set
+ * @param[in]  id_modem    The device identifier (NUL-terminated, only the first 8 characters are used)
+ * @param[in]  seq_number  The sequence number
+ * @param[in]  now         The current time (in seconds)
+ *
+ * @return     1 if the pair was seen within the window, 0 otherwise
+ */
+int dedup_check(dedup_t *dedup, const unsigned char *id_modem, unsigned int seq_number, time_t now);
+
+
+/**
+ * @brief      Forget a pair, so its next frame is not taken for a copy (the frame that added it was not stored)
+ *
+ * @param      dedup       The set
+ * @param[in]  id_modem    The device identifier (NUL-terminated, only the first 8 characters are used)
+ * @param[in]  seq_number  The sequence number
+ */
+void dedup_forget(dedup_t *dedup, const unsigned char *id_modem, unsigned int seq_number);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __DEDUP_H__
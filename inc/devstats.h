@@ -0,0 +1,148 @@
+/**
+ * @file devstats.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  In-memory statistics of the frames of each device
+ *
+ * The counters of a device are updated in constant time each time one of its frames is committed, so its statistics
+ * are served without reading the database. The minimums, maximums and sums are kept for the receptions (SNR, RSSI) and
+ * the sums of avg_signal for the messages, the averages are computed when they are read. It is an open addressing
+ * table that grows when it is half full. It is not thread-safe, it belongs to the event loop.
+ */
+
+
+#ifndef __DEVSTATS_H__
+#define __DEVSTATS_H__
+
+#include <stddef.h>          // size_t
+#include <stdint.h>          // uint64_t
+
+#include <frames.h>          // sigfox_raws_t, SIGFOX_DEVICE_LENGTH
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @typedef devstats_entry_t
+ */
+typedef struct devstats_entry_s devstats_entry_t;
+
+
+/**
+ * @struct     devstats_entry_s
+ * @brief      The statistics of a device
+ */
+struct devstats_entry_s {
+    uint64_t device;          ///< id_modem (up to 8 characters, zero-padded)
+    unsigned long long messages;          ///< Number of messages
+    unsigned long long receptions;          ///< Number of receptions of the messages (one per base station)
+    long long first_seen;          ///< Timestamp of the oldest message
+    long long last_seen;          ///< Timestamp of the newest message
+    double snr_min;          ///< Lowest SNR of the receptions
+    double snr_max;          ///< Highest SNR of the receptions
+    double snr_sum;          ///< Sum of the SNR of the receptions
+    double rssi_min;          ///< Lowest RSSI of the receptions
+    double rssi_max;          ///< Highest RSSI of the receptions
+    double rssi_sum;          ///< Sum of the RSSI of the receptions
+    double avg_signal_sum;          ///< Sum of the avg_signal of the messages
+    unsigned char used;          ///< 1 if the slot holds a device
+};
+
+
+/**
+ * @typedef devstats_t
+ */
+typedef struct devstats_s devstats_t;
+
+
+/**
+ * @struct     devstats_s
+ * @brief      The table
+ */
+struct devstats_s {
+    devstats_entry_t *entries;          ///< The slots
+    size_t mask;          ///< Number of slots minus 1 (power of two)
+    size_t count;          ///< Number of devices
+};
+
+
+/**
+ * @brief      Allocate a table
+ *
+ * @param[in]  capacity  Number of devices expected (the table grows beyond)
+ *
+ * @return     The table, NULL on error
+ */
+devstats_t* devstats_new(size_t capacity);
+
+
+/**
+ * @brief      Free a table
+ *
+ * @param      table  The table (can be NULL)
+ */
+void devstats_free(devstats_t *table);
+
+
+/**
+ * @brief      Find the statistics of a device, and add the device if it is not in the table
+ *
+ * A device added has no message and no reception, its statistics are only meaningful once one of them is counted.
+ *
+ * @param      table     The table
+ * @param[in]  id_modem  The device identifier (NUL-terminated, only the first 8 characters are used)
+ *
+ * @return     The statistics, NULL if the table cannot grow
+ */
+devstats_entry_t* devstats_slot(devstats_t *table, const unsigned char *id_modem);
+
+
+/**
+ * @brief      Count a committed frame
+ *
+ * @param      table    The table
+ * @param[in]  raws     The frame
+ * @param[in]  message  1 if the frame was stored as a new message, 0 if it is another reception of a stored one
+ *
+ * @return     0 on success, -1 if the table cannot grow
+ */
+int devstats_add(devstats_t *table, const sigfox_raws_t *raws, int message);
+
+
+/**
+ * @brief      Get the statistics of a device
+ *
+ * @param[in]  table     The table
+ * @param[in]  id_modem  The device identifier
+ *
+ * @return     The statistics, NULL if the device has no message
+ */
+const devstats_entry_t* devstats_get(const devstats_t *table, const unsigned char *id_modem);
+
+
+/**
+ * @brief      Write the identifier of a device
+ *
+ * @param[in]  entry     The statistics of the device
+ * @param[out] id_modem  The device identifier (NUL-terminated)
+ *
+ * @return     Length of the identifier
+ */
+size_t devstats_id(const devstats_entry_t *entry, char id_modem[SIGFOX_DEVICE_LENGTH + 1]);
+
+
+/**
+ * @brief      Remove every device (the frames were deleted)
+ *
+ * @param      table  The table
+ */
+void devstats_clear(devstats_t *table);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __DEVSTATS_H__
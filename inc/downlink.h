@@ -0,0 +1,187 @@
+/**
+ * @file downlink.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  In-memory table of the downlink payloads of each device
+ *
+ * The payload answered to a frame that requires an acknowledge is looked up here, so the reply does not wait for the
+ * database. A device has a queue of payloads, each one answered once in order, and a default payload answered when
+ * its queue is empty. It is an open addressing table that grows when it is half full. It is not thread-safe, it
+ * belongs to the event loop.
+ */
+
+
+#ifndef __DOWNLINK_H__
+#define __DOWNLINK_H__
+
+#include <stddef.h>          // size_t
+#include <stdint.h>          // uint64_t
+
+#include <frames.h>          // SIGFOX_DOWNLINK_DATA_LENGTH
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @typedef downlink_queued_t
+ */
+typedef struct downlink_queued_s downlink_queued_t;
+
+
+/**
+ * @struct     downlink_queued_s
+ * @brief      A payload waiting for the next frame of its device that requires an acknowledge
+ */
+struct downlink_queued_s {
+    downlink_queued_t *next;          ///< Next payload of the device
+    int64_t id;          ///< Identifier of the payload (id_downlinks)
+    char data[SIGFOX_DOWNLINK_DATA_LENGTH + 1];          ///< The payload (hexadecimal string)
+};
+
+
+/**
+ * @typedef downlink_entry_t
+ */
+typedef struct downlink_entry_s downlink_entry_t;
+
+
+/**
+ * @struct     downlink_entry_s
+ * @brief      The payloads of a device
+ */
+struct downlink_entry_s {
+    uint64_t device;          ///< id_modem (up to 8 characters, zero-padded)
+    downlink_queued_t *head;          ///< First queued payload (NULL if the queue is empty)
+    downlink_queued_t *tail;          ///< Last queued payload
+    char data[SIGFOX_DOWNLINK_DATA_LENGTH + 1];          ///< The default payload (empty string if there is none)
+    unsigned char state;          ///< 0 if the slot was never used, 1 if it is used, 2 if its device was removed
+};
+
+
+/**
+ * @typedef downlink_t
+ */
+typedef struct downlink_s downlink_t;
+
+
+/**
+ * @struct     downlink_s
+ * @brief      The table
+ */
+struct downlink_s {
+    downlink_entry_t *entries;          ///< The slots
+    size_t mask;          ///< Number of slots minus 1 (power of two)
+    size_t used;          ///< Number of slots that are not empty (removed devices included)
+    size_t count;          ///< Number of devices
+    size_t queued;          ///< Number of queued payloads
+};
+
+
+/**
+ * @brief      Allocate a table
+ *
+ * @param[in]  capacity  Number of devices expected (the table grows beyond)
+ *
+ * @return     The table, NULL on error
+ */
+downlink_t* downlink_new(size_t capacity);
+
+
+/**
+ * @brief      Free a table
+ *
+ * @param      table  The table (can be NULL)
+ */
+void downlink_free(downlink_t *table);
+
+
+/**
+ * @brief      Set the default payload of a device
+ *
+ * @param      table     The table
+ * @param[in]  id_modem  The device identifier (NUL-terminated, only the first 8 characters are used)
+ * @param[in]  data      The payload (SIGFOX_DOWNLINK_DATA_LENGTH hexadecimal characters)
+ *
+ * @return     0 on success, -1 if the table cannot grow
+ */
+int downlink_set(downlink_t *table, const unsigned char *id_modem, const char *data);
+
+
+/**
+ * @brief      Get the default payload of a device
+ *
+ * @param[in]  table     The table
+ * @param[in]  id_modem  The device identifier
+ *
+ * @return     The payload, NULL if the device has none
+ */
+const char* downlink_get(const downlink_t *table, const unsigned char *id_modem);
+
+
+/**
+ * @brief      Remove the default payload of a device
+ *
+ * @param      table     The table
+ * @param[in]  id_modem  The device identifier
+ *
+ * @return     0 on success, -1 if the device has no default payload
+ */
+int downlink_del(downlink_t *table, const unsigned char *id_modem);
+
+
+/**
+ * @brief      Add a payload at the end of the queue of a device
+ *
+ * @param      table     The table
+ * @param[in]  id_modem  The device identifier
+ * @param[in]  id        Identifier of the payload
+ * @param[in]  data      The payload (SIGFOX_DOWNLINK_DATA_LENGTH hexadecimal characters)
+ *
+ * @return     0 on success, -1 on error
+ */
+int downlink_push(downlink_t *table, const unsigned char *id_modem, int64_t id, const char *data);
+
+
+/**
+ * @brief      Put a payload back at the front of the queue of a device (undo downlink_pop)
+ *
+ * @param      table     The table
+ * @param[in]  id_modem  The device identifier
+ * @param[in]  id        Identifier of the payload
+ * @param[in]  data      The payload
+ *
+ * @return     0 on success, -1 on error
+ */
+int downlink_unpop(downlink_t *table, const unsigned char *id_modem, int64_t id, const char *data);
+
+
+/**
+ * @brief      Remove the first payload of the queue of a device
+ *
+ * @param      table     The table
+ * @param[in]  id_modem  The device identifier
+ * @param[out] data      The payload
+ *
+ * @return     Identifier of the payload, 0 if the queue is empty
+ */
+int64_t downlink_pop(downlink_t *table, const unsigned char *id_modem, char data[SIGFOX_DOWNLINK_DATA_LENGTH + 1]);
+
+
+/**
+ * @brief      Get the queue of a device
+ *
+ * @param[in]  table     The table
+ * @param[in]  id_modem  The device identifier
+ *
+ * @return     The first queued payload, NULL if the queue is empty
+ */
+const downlink_queued_t* downlink_queue(const downlink_t *table, const unsigned char *id_modem);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __DOWNLINK_H__
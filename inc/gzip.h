@@ -0,0 +1,136 @@
+/**
+ * @file gzip.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Content-Encoding of the replies: gzip and deflate with zlib
+ *
+ * A stream compresses a reply a piece at a time and hands its output to a callback each time its output buffer is
+ * full, so the memory of a stream is bounded (the zlib state and GZIP_OUT_SIZE bytes) whatever the size of the reply.
+ * "deflate" is the zlib format (RFC 1950), like the browsers expect it.
+ */
+
+
+#ifndef __GZIP_H__
+#define __GZIP_H__
+
+#include <stddef.h>          // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Size of the output buffer of a stream
+ */
+#define GZIP_OUT_SIZE       (16 * 1024)
+
+
+/**
+ * @enum gzip_encoding_e
+ * @brief  The content encodings
+ */
+typedef enum gzip_encoding_e {
+    GZIP_IDENTITY = 0,          ///< Not compressed
+    GZIP_GZIP,          ///< gzip (RFC 1952)
+    GZIP_DEFLATE          ///< deflate (zlib format, RFC 1950)
+} gzip_encoding_t;
+
+
+/**
+ * @typedef gzip_stream_t
+ */
+typedef struct gzip_stream_s gzip_stream_t;
+
+
+/**
+ * @typedef gzip_out_t
+ * @brief   Receive compressed bytes (the buffer is reused once it returns)
+ */
+typedef void (*gzip_out_t)(void *ctx, const char *buf, size_t len);
+
+
+/**
+ * @brief      Choose the encoding of a reply from an Accept-Encoding header (gzip first, then deflate)
+ *
+ * @param[in]  p     The value of the header (can be NULL)
+ * @param[in]  len   Length of the value
+ *
+ * @return     The encoding, GZIP_IDENTITY if neither is accepted (or both have q=0)
+ */
+gzip_encoding_t gzip_accepted(const char *p, size_t len);
+
+
+/**
+ * @brief      Get the name of an encoding, as in a Content-Encoding header
+ *
+ * @param[in]  encoding  The encoding
+ *
+ * @return     The name ("identity", "gzip" or "deflate")
+ */
+const char* gzip_name(gzip_encoding_t encoding);
+
+
+/**
+ * @brief      Allocate a stream
+ *
+ * @param[in]  encoding  GZIP_GZIP or GZIP_DEFLATE
+ * @param[in]  level     Compression level (1 to 9)
+ * @param[in]  out       Receives the compressed bytes
+ * @param      ctx       First argument of out
+ *
+ * @return     The stream, NULL on error
+ */
+gzip_stream_t* gzip_stream_new(gzip_encoding_t encoding, int level, gzip_out_t out, void *ctx);
+
+
+/**
+ * @brief      Compress a piece of a reply
+ *
+ * @param      stream  The stream
+ * @param[in]  buf     The piece (can be NULL if len is 0)
+ * @param[in]  len     Length of the piece
+ * @param[in]  finish  1 for the last piece, which writes the end of the stream
+ *
+ * @return     0 on success, -1 on error
+ */
+int gzip_stream_write(gzip_stream_t *stream, const char *buf, size_t len, int finish);
+
+
+/**
+ * @brief      Get the number of bytes given to a stream and the number of bytes it produced
+ *
+ * @param[in]  stream  The stream
+ * @param[out] in      Bytes given
+ * @param[out] out     Bytes produced
+ */
+void gzip_stream_counts(const gzip_stream_t *stream, unsigned long long *in, unsigned long long *out);
+
+
+/**
+ * @brief      Free a stream
+ *
+ * @param      stream  The stream (can be NULL)
+ */
+void gzip_stream_free(gzip_stream_t *stream);
+
+
+/**
+ * @brief      Compress a whole buffer
+ *
+ * @param[in]  encoding  GZIP_GZIP or GZIP_DEFLATE
+ * @param[in]  level     Compression level (1 to 9)
+ * @param[in]  in        The buffer
+ * @param[in]  len       Length of the buffer
+ * @param[out] out_len   Length of the compressed buffer
+ *
+ * @return     The compressed buffer (to free), NULL on error
+ */
+char* gzip_compress(gzip_encoding_t encoding, int level, const char *in, size_t len, size_t *out_len);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __GZIP_H__
@@ -0,0 +1,108 @@
+/**
+ * @file heap.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Counted allocations of Mongoose, with a pool of receive buffers
+ *
+ * Mongoose allocates through MG_MALLOC, MG_CALLOC, MG_REALLOC and MG_FREE, which mg_locals.h maps to these functions.
+ * Every allocation that reaches the C library is counted, so the allocations done while serving a request can be
+ * checked. Mongoose allocates a receive buffer of HEAP_BLOCK_SIZE bytes on each read of a socket and frees the
+ * previous one: these buffers are taken from a fixed pool, and only go to the C library when the pool is empty or
+ * when a buffer grows beyond a block. A pooled block is recognized by its address, so the other allocations can be
+ * freed with free() like Mongoose does in a few places. It is not thread-safe, it belongs to the event loop.
+ */
+
+
+#ifndef __HEAP_H__
+#define __HEAP_H__
+
+#include <stddef.h>          // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Size of a pooled block (MG_TCP_RECV_BUFFER_SIZE of Mongoose)
+ */
+#define HEAP_BLOCK_SIZE     1024
+
+
+/**
+ * @brief Number of pooled blocks (one per connection that has unread data)
+ */
+#define HEAP_BLOCKS         64
+
+
+/**
+ * @typedef heap_stats_t
+ */
+typedef struct heap_stats_s heap_stats_t;
+
+
+/**
+ * @struct     heap_stats_s
+ * @brief      The counters
+ */
+struct heap_stats_s {
+    unsigned long allocations;          ///< Allocations that reached the C library (malloc, calloc, realloc)
+    unsigned long frees;          ///< Blocks given back to the C library
+    unsigned long pooled;          ///< Allocations served by the pool
+    unsigned int pool_used;          ///< Pooled blocks in use
+};
+
+
+/**
+ * @brief      Allocate memory (MG_MALLOC)
+ *
+ * @param[in]  size  The size
+ *
+ * @return     The memory, NULL on error
+ */
+void* heap_malloc(size_t size);
+
+
+/**
+ * @brief      Allocate zeroed memory (MG_CALLOC)
+ *
+ * @param[in]  count  Number of elements
+ * @param[in]  size   Size of an element
+ *
+ * @return     The memory, NULL on error
+ */
+void* heap_calloc(size_t count, size_t size);
+
+
+/**
+ * @brief      Resize memory (MG_REALLOC)
+ *
+ * @param      ptr   The memory (can be NULL)
+ * @param[in]  size  The new size
+ *
+ * @return     The memory, NULL on error (ptr is left untouched)
+ */
+void* heap_realloc(void *ptr, size_t size);
+
+
+/**
+ * @brief      Free memory (MG_FREE)
+ *
+ * @param      ptr   The memory (can be NULL)
+ */
+void heap_free(void *ptr);
+
+
+/**
+ * @brief      Get the counters
+ *
+ * @return     The counters
+ */
+heap_stats_t heap_stats(void);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __HEAP_H__
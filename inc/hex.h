@@ -0,0 +1,60 @@
+/**
+ * @file hex.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Hexadecimal string decoding
+ *
+ * The strings are decoded 16 characters at a time with SSE2 (32 with AVX2 when the program is built for it), with a
+ * scalar fallback for the tails and the other architectures. Both cases of the letters are accepted.
+ */
+
+
+#ifndef __HEX_H__
+#define __HEX_H__
+
+#include <stddef.h>          // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief      Decode an hexadecimal string
+ *
+ * @param[in]  str      The string
+ * @param[in]  len      Length of the string (must be even)
+ * @param[out] out      The bytes (len / 2)
+ * @param[out] invalid  Position of the first invalid character (can be NULL)
+ *
+ * @return     0 on success, -1 if the string contains an invalid character or has an odd length
+ */
+int hex_decode(const unsigned char *str, size_t len, unsigned char *out, size_t *invalid);
+
+
+/**
+ * @brief      Decode the NUL-terminated hexadecimal strings of an array of structures
+ *
+ * The strings, the outputs and the error flags are members of the same structures, hence a single stride. Two
+ * strings are decoded at once when they have the same length, so bulk inserts amortize the vector work.
+ *
+ * @param[in]  src      The string of the first structure
+ * @param[out] dst      The bytes of the first structure (max_len / 2)
+ * @param[out] errors   The error flag of the first structure, set to error for the invalid strings whose flag is still
+ *                      0 (can be NULL)
+ * @param[in]  stride   Size of a structure
+ * @param[in]  max_len  Maximum length of a string
+ * @param[in]  count    Number of structures
+ * @param[in]  error    Value given to the error flag of an invalid string
+ *
+ * @return     Number of invalid strings
+ */
+size_t hex_decode_batch(const unsigned char *src, unsigned char *dst, unsigned char *errors, size_t stride,
+                        size_t max_len, size_t count, unsigned char error);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __HEX_H__
@@ -0,0 +1,88 @@
+/**
+ * @file histogram.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Latency histogram with power of two buckets
+ *
+ * Bucket 0 counts the latencies below 1 µs, bucket i the latencies in [2^(i-1), 2^i) µs and the last bucket every
+ * latency above. Recording is a few integer operations, so it can be done on every request. It is not thread-safe, it
+ * belongs to the event loop.
+ */
+
+
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <stdint.h>          // uint64_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Number of buckets (the last one starts at about 4 s)
+ */
+#define HISTOGRAM_BUCKETS   24
+
+
+/**
+ * @typedef histogram_t
+ */
+typedef struct histogram_s histogram_t;
+
+
+/**
+ * @struct     histogram_s
+ * @brief      The buckets and the totals
+ */
+struct histogram_s {
+    uint64_t buckets[HISTOGRAM_BUCKETS];          ///< Number of latencies in each bucket
+    uint64_t count;          ///< Number of latencies
+    uint64_t sum;          ///< Sum of the latencies (in µs)
+    uint64_t max;          ///< Highest latency (in µs)
+};
+
+
+/**
+ * @brief      Read the monotonic clock
+ *
+ * @return     The time (in µs)
+ */
+uint64_t histogram_clock_us(void);
+
+
+/**
+ * @brief      Record a latency
+ *
+ * @param      histogram  The histogram
+ * @param[in]  us         The latency (in µs)
+ */
+void histogram_add(histogram_t *histogram, uint64_t us);
+
+
+/**
+ * @brief      Record the time elapsed since a start
+ *
+ * @param      histogram  The histogram
+ * @param[in]  start      The start, read from histogram_clock_us
+ */
+void histogram_add_since(histogram_t *histogram, uint64_t start);
+
+
+/**
+ * @brief      Estimate a percentile
+ *
+ * @param[in]  histogram  The histogram
+ * @param[in]  percent    The percentile (between 0 and 100)
+ *
+ * @return     The upper bound of the bucket holding the percentile, capped to the highest latency (in µs)
+ */
+uint64_t histogram_percentile(const histogram_t *histogram, unsigned int percent);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __HISTOGRAM_H__
@@ -0,0 +1,130 @@
+/**
+ * @file jsonw.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Streaming JSON writer, rendering into a buffer handed out each time it is full
+ *
+ * The values are written with the formatters of numfmt.h (no printf on the common path) into a buffer owned by the
+ * caller, and the flush callback receives the content of the buffer each time it is full and when jsonw_flush is
+ * called. The strings are escaped, the rest of the syntax (commas, brackets, keys) is written as raw text.
+ */
+
+
+#ifndef __JSONW_H__
+#define __JSONW_H__
+
+#include <stddef.h>          // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief      Write a string literal as raw text
+ */
+#define jsonw_literal(w, s)     jsonw_raw( (w), (s), sizeof(s) - 1)
+
+
+/**
+ * @typedef jsonw_flush_t
+ * @brief   Receive the content of the buffer (the buffer is reused once it returns)
+ */
+typedef void (*jsonw_flush_t)(void *ctx, const char *buf, size_t len);
+
+
+/**
+ * @typedef jsonw_t
+ */
+typedef struct jsonw_s jsonw_t;
+
+
+/**
+ * @struct     jsonw_s
+ * @brief      The buffer and the flush callback
+ */
+struct jsonw_s {
+    char *buf;          ///< The buffer
+    size_t size;          ///< Size of the buffer
+    size_t len;          ///< Bytes of the buffer in use
+    jsonw_flush_t flush;          ///< Called with the content of the buffer
+    void *ctx;          ///< First argument of flush
+    unsigned long long bytes;          ///< Bytes handed to flush
+    unsigned long flushes;          ///< Number of calls to flush
+};
+
+
+/**
+ * @brief      Initialize a writer
+ *
+ * @param      w      The writer
+ * @param      buf    The buffer
+ * @param[in]  size   Size of the buffer
+ * @param[in]  flush  Called with the content of the buffer
+ * @param      ctx    First argument of flush
+ */
+void jsonw_init(jsonw_t *w, char *buf, size_t size, jsonw_flush_t flush, void *ctx);
+
+
+/**
+ * @brief      Write raw text
+ *
+ * @param      w     The writer
+ * @param[in]  s     The text
+ * @param[in]  len   Length of the text
+ */
+void jsonw_raw(jsonw_t *w, const char *s, size_t len);
+
+
+/**
+ * @brief      Write a string between quotes, escaping the quotes, the backslashes and the control characters
+ *
+ * The other bytes (UTF-8 included) are written as they are.
+ *
+ * @param      w     The writer
+ * @param[in]  s     The string (can be NULL for an empty string)
+ * @param[in]  len   Length of the string
+ */
+void jsonw_string(jsonw_t *w, const char *s, size_t len);
+
+
+/**
+ * @brief      Write an integer
+ *
+ * @param      w      The writer
+ * @param[in]  value  The value
+ */
+void jsonw_integer(jsonw_t *w, long long value);
+
+
+/**
+ * @brief      Write a double with the shortest text that reads back to it (numfmt_double), null if it is not finite
+ *
+ * @param      w      The writer
+ * @param[in]  value  The value
+ */
+void jsonw_double(jsonw_t *w, double value);
+
+
+/**
+ * @brief      Write true or false
+ *
+ * @param      w      The writer
+ * @param[in]  value  The value
+ */
+void jsonw_bool(jsonw_t *w, int value);
+
+
+/**
+ * @brief      Hand the content of the buffer to the flush callback, if any
+ *
+ * @param      w     The writer
+ */
+void jsonw_flush(jsonw_t *w);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __JSONW_H__
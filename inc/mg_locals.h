@@ -0,0 +1,22 @@
+/**
+ * @file mg_locals.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Local tweaks of Mongoose, included by mongoose.h when MG_LOCALS is defined
+ *
+ * The allocations of Mongoose go through heap.h, so they are counted and its receive buffers are pooled.
+ */
+
+
+#ifndef __MG_LOCALS_H__
+#define __MG_LOCALS_H__
+
+#include <heap.h>          // heap_malloc, heap_calloc, heap_realloc, heap_free
+
+#define MG_MALLOC       heap_malloc
+#define MG_CALLOC       heap_calloc
+#define MG_REALLOC      heap_realloc
+#define MG_FREE         heap_free
+
+#endif          // __MG_LOCALS_H__
@@ -0,0 +1,94 @@
+/**
+ * @file mpsc_queue.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Bounded lock-free multi-producer single-consumer queue
+ *
+ * The elements are copied into a ring of cells, each cell carrying a sequence number that tells whether it is free
+ * for the producers or ready for the consumer (D. Vyukov's bounded queue). No allocation is done once the queue is
+ * created.
+ */
+
+
+#ifndef __MPSC_QUEUE_H__
+#define __MPSC_QUEUE_H__
+
+#include <stddef.h>          // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @typedef mpsc_queue_t
+ */
+typedef struct mpsc_queue_s mpsc_queue_t;
+
+
+/**
+ * @brief      Create a queue
+ *
+ * @param[in]  capacity   Minimum number of elements the queue can hold (rounded up to a power of two)
+ * @param[in]  elem_size  Size of an element
+ *
+ * @return     Pointer to the queue, NULL on error
+ */
+mpsc_queue_t* mpsc_queue_new(size_t capacity, size_t elem_size);
+
+
+/**
+ * @brief      Destroy a queue
+ *
+ * @param      queue  The queue
+ */
+void mpsc_queue_free(mpsc_queue_t *queue);
+
+
+/**
+ * @brief      Copy an element at the end of the queue (can be called from any thread)
+ *
+ * @param      queue  The queue
+ * @param[in]  elem   The element
+ *
+ * @return     0 on success, -1 if the queue is full
+ */
+int mpsc_queue_push(mpsc_queue_t *queue, const void *elem);
+
+
+/**
+ * @brief      Copy the element at the head of the queue and remove it (only called from the consumer thread)
+ *
+ * @param      queue  The queue
+ * @param[out] elem   The element
+ *
+ * @return     0 on success, -1 if the queue is empty
+ */
+int mpsc_queue_pop(mpsc_queue_t *queue, void *elem);
+
+
+/**
+ * @brief      Get the number of elements in the queue (a snapshot, it can be outdated when it returns)
+ *
+ * @param[in]  queue  The queue
+ *
+ * @return     The number of elements
+ */
+size_t mpsc_queue_size(const mpsc_queue_t *queue);
+
+
+/**
+ * @brief      Get the capacity of the queue
+ *
+ * @param[in]  queue  The queue
+ *
+ * @return     The capacity
+ */
+size_t mpsc_queue_capacity(const mpsc_queue_t *queue);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __MPSC_QUEUE_H__
@@ -0,0 +1,76 @@
+/**
+ * @file numfmt.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Locale-free formatting of the numeric fields of the replies
+ *
+ * The integers are written two digits at a time from a table of the pairs 00 to 99. The doubles are written with the
+ * shortest decimal text that reads back to the same double: the stored decimals have a few fraction digits (see
+ * numparse.h), so the text is searched as an integer of hundredths, thousandths... checked by a correctly rounded
+ * division, and printf("%.17g") is only used for the values this search does not find.
+ */
+
+
+#ifndef __NUMFMT_H__
+#define __NUMFMT_H__
+
+#include <stddef.h>          // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Size of a buffer that holds any formatted number
+ */
+#define NUMFMT_MAX                  32
+
+
+/**
+ * @brief Largest number of fraction digits searched by numfmt_double before printf
+ */
+#define NUMFMT_FRACTION_DIGITS      9
+
+
+/**
+ * @brief      Format an integer
+ *
+ * @param[out] buf    The text (NUMFMT_MAX bytes, not NUL-terminated)
+ * @param[in]  value  The value
+ *
+ * @return     Length of the text
+ */
+size_t numfmt_integer(char *buf, long long value);
+
+
+/**
+ * @brief      Format an unsigned integer
+ *
+ * @param[out] buf    The text (NUMFMT_MAX bytes, not NUL-terminated)
+ * @param[in]  value  The value
+ *
+ * @return     Length of the text
+ */
+size_t numfmt_unsigned(char *buf, unsigned long long value);
+
+
+/**
+ * @brief      Format a double with the shortest text that reads back to it
+ *
+ * The integral values keep a ".0" so they read back as decimals. The values beyond 2^53 and the ones with more than
+ * NUMFMT_FRACTION_DIGITS fraction digits are written by printf("%g"), with an exponent when they need one.
+ *
+ * @param[out] buf    The text (NUMFMT_MAX bytes, not NUL-terminated)
+ * @param[in]  value  The value
+ *
+ * @return     Length of the text, 0 if the value is not finite (no JSON text for it)
+ */
+size_t numfmt_double(char *buf, double value);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __NUMFMT_H__
@@ -0,0 +1,79 @@
+/**
+ * @file numparse.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Length-bounded, locale-free parsing of the numeric fields
+ *
+ * The numbers are read in place from the body (no copy, no NUL terminator needed) and the whole text must be a number.
+ * The decimals are kept as hundredths, the precision documented by Sigfox for the SNR, the RSSI and the average signal.
+ */
+
+
+#ifndef __NUMPARSE_H__
+#define __NUMPARSE_H__
+
+#include <stddef.h>          // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief The text is a number in the range
+ */
+#define NUMPARSE_OK                 0
+
+
+/**
+ * @brief The text is empty or is not a number
+ */
+#define NUMPARSE_ERR_SYNTAX         -1
+
+
+/**
+ * @brief The number overflows or is out of the range
+ */
+#define NUMPARSE_ERR_RANGE          -2
+
+
+/**
+ * @brief Number of fraction digits kept by numparse_decimal
+ */
+#define NUMPARSE_FRACTION_DIGITS    2
+
+
+/**
+ * @brief      Parse an integer (optional sign, then digits)
+ *
+ * @param[in]  p      The text
+ * @param[in]  len    Length of the text
+ * @param[in]  min    Smallest accepted value
+ * @param[in]  max    Largest accepted value
+ * @param[out] value  The integer, untouched on error
+ *
+ * @return     NUMPARSE_OK, NUMPARSE_ERR_SYNTAX or NUMPARSE_ERR_RANGE
+ */
+int numparse_integer(const char *p, size_t len, long long min, long long max, long long *value);
+
+
+/**
+ * @brief      Parse a decimal number (optional sign, digits, optional fraction) to the nearest hundredth
+ *
+ * The digits after the second fraction digit only round the result (half away from zero). The value is the hundredths
+ * divided by 100, which is what strtod returns for a text with two fraction digits.
+ *
+ * @param[in]  p      The text
+ * @param[in]  len    Length of the text
+ * @param[out] value  The number, untouched on error
+ *
+ * @return     NUMPARSE_OK, NUMPARSE_ERR_SYNTAX or NUMPARSE_ERR_RANGE (more than 2^53 hundredths)
+ */
+int numparse_decimal(const char *p, size_t len, double *value);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __NUMPARSE_H__
@@ -0,0 +1,156 @@
+/**
+ * @file rollup.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  In-memory accumulators of the rollups of the frames, per device and per minute, hour and day
+ *
+ * A frame is added to the bucket of each granularity its message falls in: the counters, the minimums, maximums and
+ * sums of the SNR and of the RSSI of the receptions and the sum of avg_signal of the messages. The accumulators are
+ * upserted into the rollups table by batches, then cleared. It is an open addressing table that grows when it is half
+ * full. It is not thread-safe, it belongs to the thread that fills it.
+ */
+
+
+#ifndef __ROLLUP_H__
+#define __ROLLUP_H__
+
+#include <stddef.h>          // size_t
+#include <stdint.h>          // uint64_t
+
+#include <frames.h>          // sigfox_raws_t, SIGFOX_DEVICE_LENGTH
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @enum       rollup_granularity_t
+ * @brief      Length of the buckets
+ */
+typedef enum {
+    ROLLUP_MINUTE,          ///< 60 seconds
+    ROLLUP_HOUR,          ///< 3600 seconds
+    ROLLUP_DAY,          ///< 86400 seconds
+    ROLLUP_GRANULARITIES          ///< Number of granularities
+} rollup_granularity_t;
+
+
+/**
+ * @typedef rollup_entry_t
+ */
+typedef struct rollup_entry_s rollup_entry_t;
+
+
+/**
+ * @struct     rollup_entry_s
+ * @brief      The accumulator of a bucket of a device
+ */
+struct rollup_entry_s {
+    uint64_t device;          ///< id_modem (up to 8 characters, zero-padded)
+    long long bucket;          ///< Timestamp of the start of the bucket (a multiple of its length)
+    unsigned char granularity;          ///< Granularity of the bucket (rollup_granularity_t)
+    unsigned char used;          ///< 1 if the slot holds a bucket
+    unsigned long long messages;          ///< Number of messages
+    unsigned long long receptions;          ///< Number of receptions of the messages (one per base station)
+    double snr_min;          ///< Lowest SNR of the receptions
+    double snr_max;          ///< Highest SNR of the receptions
+    double snr_sum;          ///< Sum of the SNR of the receptions
+    double rssi_min;          ///< Lowest RSSI of the receptions
+    double rssi_max;          ///< Highest RSSI of the receptions
+    double rssi_sum;          ///< Sum of the RSSI of the receptions
+    double avg_signal_sum;          ///< Sum of the avg_signal of the messages
+};
+
+
+/**
+ * @typedef rollup_t
+ */
+typedef struct rollup_s rollup_t;
+
+
+/**
+ * @struct     rollup_s
+ * @brief      The table
+ */
+struct rollup_s {
+    rollup_entry_t *entries;          ///< The slots
+    size_t mask;          ///< Number of slots minus 1 (power of two)
+    size_t count;          ///< Number of buckets
+};
+
+
+/**
+ * @brief      Allocate a table
+ *
+ * @param[in]  capacity  Number of buckets expected (the table grows beyond)
+ *
+ * @return     The table, NULL on error
+ */
+rollup_t* rollup_new(size_t capacity);
+
+
+/**
+ * @brief      Free a table
+ *
+ * @param      table  The table (can be NULL)
+ */
+void rollup_free(rollup_t *table);
+
+
+/**
+ * @brief      Add a frame to the buckets of its message, one per granularity
+ *
+ * @param      table    The table
+ * @param[in]  raws     The frame
+ * @param[in]  message  1 if the frame is a new message, 0 if it is another reception of a stored one
+ *
+ * @return     0 on success, -1 if the table cannot grow (the frame is then in none of its buckets)
+ */
+int rollup_add(rollup_t *table, const sigfox_raws_t *raws, int message);
+
+
+/**
+ * @brief      Remove every bucket (once they are upserted)
+ *
+ * @param      table  The table
+ */
+void rollup_clear(rollup_t *table);
+
+
+/**
+ * @brief      Write the identifier of the device of a bucket
+ *
+ * @param[in]  entry     The bucket
+ * @param[out] id_modem  The device identifier (NUL-terminated)
+ *
+ * @return     Length of the identifier
+ */
+size_t rollup_id(const rollup_entry_t *entry, char id_modem[SIGFOX_DEVICE_LENGTH + 1]);
+
+
+/**
+ * @brief      Get the length of the buckets of a granularity
+ *
+ * @param[in]  granularity  The granularity
+ *
+ * @return     The length, in seconds
+ */
+long long rollup_seconds(rollup_granularity_t granularity);
+
+
+/**
+ * @brief      Find a granularity by its name
+ *
+ * @param[in]  name  "minute", "hour" or "day" (NUL-terminated)
+ *
+ * @return     The granularity, -1 if the name is unknown
+ */
+int rollup_granularity(const char *name);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __ROLLUP_H__
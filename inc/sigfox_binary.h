@@ -0,0 +1,139 @@
+/**
+ * @file sigfox_binary.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Fixed-layout binary records of the frames, for the local gateways
+ *
+ * A record is the content of a sigfox_raws_t, little-endian, without padding, prefixed by its length and the version
+ * of its layout. The length allows later versions to append fields: a reader skips what it does not know. The
+ * payload is sent as bytes, so the record needs neither hexadecimal nor decimal decoding.
+ *
+ * | Offset | Size | Field                                                                  |
+ * |--------|------|------------------------------------------------------------------------|
+ * | 0      | 2    | length of the record, this field included                              |
+ * | 2      | 1    | version (SIGFOX_BINARY_VERSION)                                        |
+ * | 3      | 1    | flags (SIGFOX_BINARY_FLAG_*)                                           |
+ * | 4      | 8    | id_modem (ASCII, NUL-padded)                                           |
+ * | 12     | 4    | station (ASCII, NUL-padded)                                            |
+ * | 16     | 8    | timestamp (signed, in seconds)                                         |
+ * | 24     | 4    | snr (signed, in hundredths of dB)                                      |
+ * | 28     | 4    | avg_signal (signed, in hundredths of dB, SIGFOX_BINARY_NOT_AVAILABLE)  |
+ * | 32     | 4    | rssi (signed, in hundredths of dBm, SIGFOX_BINARY_NOT_AVAILABLE)       |
+ * | 36     | 4    | seq_number                                                             |
+ * | 40     | 2    | latitude (signed)                                                      |
+ * | 42     | 2    | longitude (signed)                                                     |
+ * | 44     | 1    | length of the payload (up to SIGFOX_DATA_LENGTH)                       |
+ * | 45     | 12   | payload (bytes, zero-padded)                                           |
+ *
+ * The reply to a record is SIGFOX_BINARY_REPLY_LENGTH bytes: the length, the version, a status (0 or the error of the
+ * record), id_modem, seq_number and the downlink payload (8 bytes, zero if there is none).
+ */
+
+
+#ifndef __SIGFOX_BINARY_H__
+#define __SIGFOX_BINARY_H__
+
+#include <stddef.h>          // size_t
+#include <stdint.h>          // INT32_MIN
+
+#include <frames.h>          // sigfox_raws_t, SIGFOX_*_LENGTH
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Version of the layout
+ */
+#define SIGFOX_BINARY_VERSION           1
+
+
+/**
+ * @brief Length of a record of the current version
+ */
+#define SIGFOX_BINARY_RECORD_LENGTH     57
+
+
+/**
+ * @brief Length of a reply
+ */
+#define SIGFOX_BINARY_REPLY_LENGTH      24
+
+
+/**
+ * @brief Flag of a message already received by another base station
+ */
+#define SIGFOX_BINARY_FLAG_DUPLICATE    0x01
+
+
+/**
+ * @brief Flag of a message that requires an acknowledge
+ */
+#define SIGFOX_BINARY_FLAG_ACK          0x02
+
+
+/**
+ * @brief Flag of the long polling
+ */
+#define SIGFOX_BINARY_FLAG_LONG_POLLING 0x04
+
+
+/**
+ * @brief Value of the average signal or the RSSI when it is not available
+ */
+#define SIGFOX_BINARY_NOT_AVAILABLE     INT32_MIN
+
+
+/**
+ * @brief Status of a record whose version is not supported
+ */
+#define SIGFOX_BINARY_ERR_VERSION       0xFD
+
+
+/**
+ * @brief Status of a record refused because the server is overloaded (the gateway should send it again later)
+ */
+#define SIGFOX_BINARY_ERR_BUSY          0xFE
+
+
+/**
+ * @brief      Decode a record
+ *
+ * @param[in]  buf    The received bytes
+ * @param[in]  len    Number of received bytes
+ * @param[out] raws   The raws structure, data_hex included
+ * @param[out] error  0 if the frame is valid, else the index of the first invalid field (as sigfox_json_decode),
+ *                    SIGFOX_BINARY_ERR_VERSION or SIGFOX_JSON_ERR_SYNTAX if the length is malformed
+ *
+ * @return     Length of the record, 0 if the bytes do not hold a whole record yet
+ */
+size_t sigfox_binary_decode(const unsigned char *buf, size_t len, sigfox_raws_t *raws, unsigned char *error);
+
+
+/**
+ * @brief      Encode a record
+ *
+ * @param[out] buf   The record (SIGFOX_BINARY_RECORD_LENGTH bytes)
+ * @param[in]  raws  The raws structure (data_hex and the length of data_str give the payload)
+ */
+void sigfox_binary_encode(unsigned char buf[SIGFOX_BINARY_RECORD_LENGTH], const sigfox_raws_t *raws);
+
+
+/**
+ * @brief      Encode the reply to a record
+ *
+ * @param[out] buf            The reply (SIGFOX_BINARY_REPLY_LENGTH bytes)
+ * @param[in]  raws           The frame of the record
+ * @param[in]  status         0 or the error of the record
+ * @param[in]  downlink_data  The downlink payload (hexadecimal string), NULL if there is none
+ */
+void sigfox_binary_reply(unsigned char buf[SIGFOX_BINARY_REPLY_LENGTH], const sigfox_raws_t *raws, unsigned char status,
+                         const char *downlink_data);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __SIGFOX_BINARY_H__
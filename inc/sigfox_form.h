@@ -0,0 +1,48 @@
+/**
+ * @file sigfox_form.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Decoder of the url-encoded bodies and query strings sent by the Sigfox callbacks
+ *
+ * A callback can be configured to send its fields as `application/x-www-form-urlencoded` or as the query string of
+ * the URL (`?id_modem={device}&timestamp={time}...`). The pairs are walked once and stored with sigfox_json_field,
+ * in place: a value is only copied when it holds a `%XX` escape or a `+`.
+ */
+
+
+#ifndef __SIGFOX_FORM_H__
+#define __SIGFOX_FORM_H__
+
+#include <stddef.h>          // size_t
+
+#include <frames.h>          // sigfox_raws_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Length above which an escaped key or value is refused (every field of a frame is shorter)
+ */
+#define SIGFOX_FORM_ESCAPED_MAX     64
+
+
+/**
+ * @brief      Decode a url-encoded body or a query string, data_str included
+ *
+ * @param[in]  form  The pairs (`key=value&key=value`)
+ * @param[in]  len   Length of the pairs
+ * @param[out] raws  The raws structure
+ *
+ * @return     0 if the frame is valid, else the error of sigfox_json_error, SIGFOX_JSON_ERR_DATA, or
+ *             SIGFOX_JSON_ERR_SYNTAX if an escape is malformed
+ */
+unsigned char sigfox_form_decode(const char *form, size_t len, sigfox_raws_t *raws);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __SIGFOX_FORM_H__
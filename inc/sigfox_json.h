@@ -0,0 +1,101 @@
+/**
+ * @file sigfox_json.h
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Single-pass decoder of the JSON body sent by the Sigfox callbacks
+ *
+ * The body is walked once: the keys are matched against the column names of sqls.h and the values are parsed in
+ * place, straight into a sigfox_raws_t, without any heap allocation. Unknown keys are skipped. A value can be a JSON
+ * literal or a string (`"snr": 10.23` or `"snr": "10.23"`), as the callback templates allow both.
+ */
+
+
+#ifndef __SIGFOX_JSON_H__
+#define __SIGFOX_JSON_H__
+
+#include <stddef.h>          // size_t
+
+#include <frames.h>          // sigfox_raws_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Error returned when the body is not a well-formed JSON object
+ */
+#define SIGFOX_JSON_ERR_SYNTAX      0xFF
+
+
+/**
+ * @brief Error returned when data_str is missing or is not an hexadecimal string
+ */
+#define SIGFOX_JSON_ERR_DATA        6
+
+
+/**
+ * @brief Error returned when the latitude or the longitude is not an integer in [-90, 90] or [-180, 180]
+ */
+#define SIGFOX_JSON_ERR_COORDINATES 9
+
+
+/**
+ * @brief      Decode one JSON object into a raws structure
+ *
+ * data_hex is left to the caller, so a batch of frames can be converted at once with hex_decode_batch.
+ *
+ * @param[in]  json   Beginning of the object (leading whitespaces are skipped)
+ * @param[in]  end    End of the buffer
+ * @param[out] raws   The raws structure
+ * @param[out] error  0 if the frame is valid, else the index of the first missing field, the index of the first
+ *                    numeric field that is not a number or overflows, or SIGFOX_JSON_ERR_SYNTAX
+ *
+ * @return     Pointer right after the object, NULL on syntax error
+ */
+const char* sigfox_json_decode_object(const char *json, const char *end, sigfox_raws_t *raws, unsigned char *error);
+
+
+/**
+ * @brief      Decode a body that only contains one JSON object, data_str included
+ *
+ * @param[in]  json  The body
+ * @param[in]  len   Length of the body
+ * @param[out] raws  The raws structure
+ *
+ * @return     0 if the frame is valid, else the error of sigfox_json_decode_object or SIGFOX_JSON_ERR_DATA
+ */
+unsigned char sigfox_json_decode(const char *json, size_t len, sigfox_raws_t *raws);
+
+
+/**
+ * @brief      Store one field of a callback body, whatever its encoding (JSON, url-encoded form or query string)
+ *
+ * @param[in]     key      The key
+ * @param[in]     key_len  Length of the key
+ * @param[in]     val      The value (without the quotes of a JSON string)
+ * @param[in]     val_len  Length of the value
+ * @param[out]    raws     The raws structure
+ * @param[in,out] seen     Fields found so far (one bit per field)
+ * @param[in,out] invalid  Index of the first numeric field that is not a number or overflows, 0 if there is none
+ */
+void sigfox_json_field(const char *key, size_t key_len, const char *val, size_t val_len, sigfox_raws_t *raws,
+                       unsigned int *seen, unsigned char *invalid);
+
+
+/**
+ * @brief      Get the error of a frame once all its fields are stored
+ *
+ * @param[in]  seen     Fields found (as set by sigfox_json_field)
+ * @param[in]  invalid  Index of the first invalid numeric field (as set by sigfox_json_field)
+ *
+ * @return     0 if the frame is valid, else the index of the first missing field or invalid
+ */
+unsigned char sigfox_json_error(unsigned int seen, unsigned char invalid);
+
+#ifdef     __cplusplus
+}
+#endif
+
+#endif          // __SIGFOX_JSON_H__
@@ -99,18 +99,74 @@ extern "C" {
     "  `id_modem` TEXT NOT NULL UNIQUE,\n" \
     "  `attribution` INTEGER,\n" \
     "  `timestamp_attribution` INTEGER\n" \
-    ");"
+    ");\n" \
+    "\n" \
+    "\n" \
+    "--\n" \
+    "-- Create 'receptions' table (one row per base station that received a message of 'raws')\n" \
+    "--\n" \
+    "CREATE TABLE IF NOT EXISTS `receptions` (\n" \
+    "  `id_raws` INTEGER NOT NULL REFERENCES `raws` (`id_raws`),\n" \
+    "  `station` TEXT NOT NULL,\n" \
+    "  `snr` REAL NOT NULL,\n" \
+    "  `rssi` REAL NOT NULL,\n" \
+    "  `latitude` INTEGER NOT NULL,\n" \
+    "  `longitude` INTEGER NOT NULL,\n" \
+    "  `timestamp` INTEGER\n" \
+    ");\n" \
+    "\n" \
+    "\n" \
+    "\n" \
+    "--\n" \
+    "-- Create 'downlinks' table (payloads queued for a device, delivered is NULL until one of its frames is answered)\n" \
+    "--\n" \
+    "CREATE TABLE IF NOT EXISTS `downlinks` (\n" \
+    "  `id_downlinks` INTEGER PRIMARY KEY,\n" \
+    "  `id_modem` TEXT NOT NULL,\n" \
+    "  `data` TEXT NOT NULL,\n" \
+    "  `queued` INTEGER NOT NULL,\n" \
+    "  `delivered` INTEGER\n" \
+    ");\n" \
+    "\n" \
+    "\n" \
+    "--\n" \
+    "-- Create 'rollups' table (per device, the messages of each bucket of 60, 3600 or 86400 seconds)\n" \
+    "--\n" \
+    "CREATE TABLE IF NOT EXISTS `rollups` (\n" \
+    "  `id_modem` TEXT NOT NULL,\n" \
+    "  `granularity` INTEGER NOT NULL,\n" \
+    "  `bucket` INTEGER NOT NULL,\n" \
+    "  `messages` INTEGER NOT NULL,\n" \
+    "  `receptions` INTEGER NOT NULL,\n" \
+    "  `snr_min` REAL NOT NULL,\n" \
+    "  `snr_max` REAL NOT NULL,\n" \
+    "  `snr_sum` REAL NOT NULL,\n" \
+    "  `rssi_min` REAL NOT NULL,\n" \
+    "  `rssi_max` REAL NOT NULL,\n" \
+    "  `rssi_sum` REAL NOT NULL,\n" \
+    "  `avg_signal_sum` REAL NOT NULL,\n" \
+    "  PRIMARY KEY (`id_modem`, `granularity`, `bucket`)\n" \
+    ") WITHOUT ROWID;\n" \
+    "\n" \
+    "CREATE INDEX IF NOT EXISTS `raws_message` ON `raws` (`id_modem`, `seq_number`, `timestamp`);\n" \
+    "CREATE INDEX IF NOT EXISTS `receptions_raws` ON `receptions` (`id_raws`);\n" \
+    "CREATE INDEX IF NOT EXISTS `raws_device_time` ON `raws` (`id_modem`, `timestamp`);\n" \
+    "CREATE INDEX IF NOT EXISTS `receptions_station_time` ON `receptions` (`station`, `timestamp`, `id_raws`);\n" \
+    "CREATE INDEX IF NOT EXISTS `downlinks_pending` ON `downlinks` (`id_downlinks`) WHERE `delivered` IS NULL;"
 
 
 /**
- * @brief SQL command to drop 'raws' and 'devices' tables
+ * @brief SQL command to drop the 'raws', 'devices', 'receptions' and 'downlinks' tables
  */
 #define DROP_SIGFOX_TABLES \
     "-- DELETION OF THE SIGFOX TABLES\n" \
     "\n" \
     "-- Delete the tables if they exists\n" \
     "DROP TABLE IF EXISTS `raws`;\n" \
-    "DROP TABLE IF EXISTS `devices`;"
+    "DROP TABLE IF EXISTS `devices`;\n" \
+    "DROP TABLE IF EXISTS `receptions`;\n" \
+    "DROP TABLE IF EXISTS `downlinks`;\n" \
+    "DROP TABLE IF EXISTS `rollups`;"
 
 
 /**
@@ -121,6 +177,124 @@ extern "C" {
     "rssi, latitude, longitude, seq_number FROM `raws`"
 
 
+/**
+ * @defgroup  Frames_col_idx  SELECT_FRAMES column index
+ * @{
+ */
+#define SQL_IDX_FRAME_ID_RAWS       0  ///< ID raws column index
+#define SQL_IDX_FRAME_TIMESTAMP     1  ///< Timestamp column index
+#define SQL_IDX_FRAME_ID_MODEM      2  ///< ID modem column index
+#define SQL_IDX_FRAME_ACK           3  ///< Acknowledge column index
+#define SQL_IDX_FRAME_DATA_STR      4  ///< Data string column index
+#define SQL_IDX_FRAME_DUPLICATE     5  ///< Duplicate column index
+#define SQL_IDX_FRAME_AVG_SIGNAL    6  ///< Average signal column index
+#define SQL_IDX_FRAME_SEQ_NUMBER    7  ///< Sequence number column index
+#define SQL_IDX_FRAME_STATION       8  ///< Station column index (of the reception)
+#define SQL_IDX_FRAME_SNR           9  ///< Signal column index (of the reception)
+#define SQL_IDX_FRAME_RSSI          10  ///< RSSI column index (of the reception)
+#define SQL_IDX_FRAME_LATITUDE      11  ///< Latitude column index (of the reception)
+#define SQL_IDX_FRAME_LONGITUDE     12  ///< Longitude column index (of the reception)
+
+
+/**@}*/
+
+
+/**
+ * @brief Columns of SELECT_FRAMES and of the filtered selections (r is the raws, c the reception)
+ */
+#define SELECT_FRAMES_COLUMNS \
+    "SELECT r.id_raws, r.timestamp, r.id_modem, r.ack, r.data_str, r.duplicate, r.avg_signal, r.seq_number," \
+    " COALESCE(c.station, r.station), COALESCE(c.snr, r.snr), COALESCE(c.rssi, r.rssi)," \
+    " COALESCE(c.latitude, r.latitude), COALESCE(c.longitude, r.longitude)"
+
+
+/**
+ * @brief SQL command to select every reception with its message, grouped by message
+ *
+ * The messages are the ones whose id_raws is strictly between the two parameters (a range scan of the primary key).
+ * The raws stored before the 'receptions' table existed have no reception, their own columns are used instead.
+ */
+#define SELECT_FRAMES \
+    SELECT_FRAMES_COLUMNS \
+    " FROM `raws` r LEFT JOIN `receptions` c ON c.id_raws = r.id_raws WHERE r.id_raws > ? AND r.id_raws < ?" \
+    " ORDER BY r.id_raws, c.rowid;"
+
+
+/**
+ * @brief SQL command to find the last message of a page going forward, and whether there is one after it
+ *
+ * Parameters: the bounds of the range (excluded), then the number of messages of the page minus one.
+ */
+#define SELECT_PAGE_LAST \
+    "SELECT id_raws FROM `raws` WHERE id_raws > ? AND id_raws < ? ORDER BY id_raws LIMIT 2 OFFSET ?;"
+
+
+/**
+ * @brief SQL command to find the first message of a page going backward, and whether there is one before it
+ */
+#define SELECT_PAGE_FIRST \
+    "SELECT id_raws FROM `raws` WHERE id_raws > ? AND id_raws < ? ORDER BY id_raws DESC LIMIT 2 OFFSET ?;"
+
+
+/**
+ * @brief SQL command to select the receptions of the messages of a device, grouped by message
+ *
+ * Parameters: ?1 id_modem, the messages are after (?2 timestamp, ?3 id_raws) and up to (?4 timestamp, ?5 id_raws),
+ * in this order. The range of timestamps is a range scan of the index raws_device_time.
+ */
+#define SELECT_DEVICE_FRAMES \
+    SELECT_FRAMES_COLUMNS \
+    " FROM `raws` r LEFT JOIN `receptions` c ON c.id_raws = r.id_raws" \
+    " WHERE r.id_modem = ?1 AND r.timestamp BETWEEN ?2 AND ?4" \
+    " AND (r.timestamp, r.id_raws) > (?2, ?3) AND (r.timestamp, r.id_raws) <= (?4, ?5)" \
+    " ORDER BY r.timestamp, r.id_raws, c.rowid;"
+
+
+/**
+ * @brief SQL command to find the last message of a page of SELECT_DEVICE_FRAMES, and whether there is one after it
+ *
+ * Parameters: ?1 id_modem, after (?2 timestamp, ?3 id_raws), up to ?4 timestamp, ?5 number of messages minus one.
+ */
+#define SELECT_DEVICE_PAGE \
+    "SELECT timestamp, id_raws FROM `raws` WHERE id_modem = ?1 AND timestamp BETWEEN ?2 AND ?4" \
+    " AND (timestamp, id_raws) > (?2, ?3) ORDER BY timestamp, id_raws LIMIT 2 OFFSET ?5;"
+
+
+/**
+ * @brief SQL command to select the receptions of a base station with their message, in the order of the messages
+ *
+ * Same parameters as SELECT_DEVICE_FRAMES, ?1 being the station. Only the reception of this station is given for
+ * each message, with a range scan of the index receptions_station_time. The raws stored before the 'receptions'
+ * table existed have no reception, so they are not found by station.
+ */
+#define SELECT_STATION_FRAMES \
+    SELECT_FRAMES_COLUMNS \
+    " FROM `receptions` c JOIN `raws` r ON r.id_raws = c.id_raws" \
+    " WHERE c.station = ?1 AND c.timestamp BETWEEN ?2 AND ?4" \
+    " AND (c.timestamp, c.id_raws) > (?2, ?3) AND (c.timestamp, c.id_raws) <= (?4, ?5)" \
+    " ORDER BY c.timestamp, c.id_raws;"
+
+
+/**
+ * @brief SQL command to find the last message of a page of SELECT_STATION_FRAMES, and whether there is one after it
+ */
+#define SELECT_STATION_PAGE \
+    "SELECT timestamp, id_raws FROM `receptions` WHERE station = ?1 AND timestamp BETWEEN ?2 AND ?4" \
+    " AND (timestamp, id_raws) > (?2, ?3) ORDER BY timestamp, id_raws LIMIT 2 OFFSET ?5;"
+
+
+/**
+ * @brief SQL command to get the version of the data, which changes each time another connection commits
+ */
+#define SELECT_DATA_VERSION     "PRAGMA data_version;"
+
+
+/**
+ * @brief SQL command to find the message a raws belongs to (id_modem, seq_number, timestamp)
+ */
+#define SELECT_MESSAGE  "SELECT id_raws FROM `raws` WHERE id_modem = ? AND seq_number = ? AND timestamp = ? LIMIT 1;"
+
+
 /**
  * @brief SQL command to select all the colums in the 'devices' table
  */
@@ -133,6 +307,26 @@ extern "C" {
 #define DELETE_RAWS     "DELETE FROM raws;"
 
 
+/**
+ * @brief SQL command to delete every record from the table receptions
+ */
+#define DELETE_RECEPTIONS   "DELETE FROM receptions;"
+
+
+/**
+ * @brief SQL command to delete every record from the table rollups
+ */
+#define DELETE_ROLLUPS      "DELETE FROM rollups;"
+
+
+/**
+ * @brief SQL commands to open, close and undo the savepoint of one write operation within the transaction of a batch
+ */
+#define SAVEPOINT_OP        "SAVEPOINT op;"
+#define RELEASE_OP          "RELEASE op;"
+#define ROLLBACK_OP         "ROLLBACK TO op;"
+
+
 /**
  * @brief SQL command to insert data from a sigfox_device_t to the database
  */
@@ -144,6 +338,108 @@ extern "C" {
  */
 #define INSERT_RAWS     "INSERT INTO `raws` VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);"
 
+
+/**
+ * @brief SQL command to insert a reception (id_raws, station, snr, rssi, latitude, longitude, timestamp)
+ */
+#define INSERT_RECEPTIONS   "INSERT INTO `receptions` VALUES (?, ?, ?, ?, ?, ?, ?);"
+
+
+/**
+ * @brief SQL command to flag a message received as a duplicate
+ */
+#define FLAG_DUPLICATE  "UPDATE `raws` SET duplicate = 1 WHERE id_raws = ?;"
+
+
+/**
+ * @brief SQL command to insert a queued downlink (id_downlinks, id_modem, data, queued)
+ */
+#define INSERT_DOWNLINKS    "INSERT INTO `downlinks` VALUES (?, ?, ?, ?, NULL);"
+
+
+/**
+ * @brief SQL command to mark a queued downlink as delivered (delivered, id_downlinks)
+ */
+#define DELIVER_DOWNLINK    "UPDATE `downlinks` SET delivered = ? WHERE id_downlinks = ?;"
+
+
+/**
+ * @brief SQL command to select the downlinks not delivered yet (id_downlinks, id_modem, data), in queue order
+ */
+#define SELECT_DOWNLINKS_PENDING \
+    "SELECT id_downlinks, id_modem, data FROM `downlinks` WHERE delivered IS NULL ORDER BY id_downlinks;"
+
+
+/**
+ * @brief SQL command to select the last identifier given to a downlink
+ */
+#define SELECT_DOWNLINKS_LAST   "SELECT COALESCE(MAX(id_downlinks), 0) FROM `downlinks`;"
+
+
+/**
+ * @brief SQL command to aggregate the messages of each device (id_modem, messages, first and last timestamps, sum of
+ *        avg_signal)
+ */
+#define SELECT_DEVSTATS_MESSAGES \
+    "SELECT id_modem, COUNT(*), MIN(timestamp), MAX(timestamp), TOTAL(avg_signal) FROM `raws` GROUP BY id_modem;"
+
+
+/**
+ * @brief SQL command to aggregate the receptions of each device (id_modem, receptions, min, max and sum of the SNR,
+ *        then of the RSSI), a message stored without reception counts as the one of its raws row
+ */
+#define SELECT_DEVSTATS_RECEPTIONS \
+    "SELECT r.id_modem, COUNT(*)," \
+    " MIN(COALESCE(c.snr, r.snr)), MAX(COALESCE(c.snr, r.snr)), TOTAL(COALESCE(c.snr, r.snr))," \
+    " MIN(COALESCE(c.rssi, r.rssi)), MAX(COALESCE(c.rssi, r.rssi)), TOTAL(COALESCE(c.rssi, r.rssi))" \
+    " FROM `raws` r LEFT JOIN `receptions` c ON c.id_raws = r.id_raws GROUP BY r.id_modem;"
+
+
+/**
+ * @brief SQL command to add an accumulator to the rollup of its bucket (id_modem, granularity in seconds, bucket,
+ *        messages, receptions, min, max and sum of the SNR, then of the RSSI, sum of avg_signal)
+ */
+#define UPSERT_ROLLUPS \
+    "INSERT INTO `rollups` VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)" \
+    " ON CONFLICT (id_modem, granularity, bucket) DO UPDATE SET" \
+    " messages = messages + excluded.messages, receptions = receptions + excluded.receptions," \
+    " snr_min = MIN(snr_min, excluded.snr_min), snr_max = MAX(snr_max, excluded.snr_max)," \
+    " snr_sum = snr_sum + excluded.snr_sum," \
+    " rssi_min = MIN(rssi_min, excluded.rssi_min), rssi_max = MAX(rssi_max, excluded.rssi_max)," \
+    " rssi_sum = rssi_sum + excluded.rssi_sum, avg_signal_sum = avg_signal_sum + excluded.avg_signal_sum;"
+
+
+/**
+ * @brief SQL command to select the rollups of a device (id_modem, granularity, first and last bucket, limit)
+ */
+#define SELECT_ROLLUPS \
+    "SELECT bucket, messages, receptions, snr_min, snr_max, snr_sum, rssi_min, rssi_max, rssi_sum, avg_signal_sum" \
+    " FROM `rollups` WHERE id_modem = ?1 AND granularity = ?2 AND bucket BETWEEN ?3 AND ?4 ORDER BY bucket LIMIT ?5;"
+
+
+/**
+ * @brief SQL command to find the first bucket after a page of SELECT_ROLLUPS (same parameters, the limit is the offset)
+ */
+#define SELECT_ROLLUPS_PAGE \
+    "SELECT bucket FROM `rollups` WHERE id_modem = ?1 AND granularity = ?2 AND bucket BETWEEN ?3 AND ?4" \
+    " ORDER BY bucket LIMIT 1 OFFSET ?5;"
+
+
+/**
+ * @brief SQL command to select the bounds of the identifiers of the messages (rebuild of the rollups)
+ */
+#define SELECT_RAWS_BOUNDS  "SELECT COALESCE(MIN(id_raws), 0), COALESCE(MAX(id_raws), -1) FROM `raws`;"
+
+
+/**
+ * @brief SQL command to select the receptions of a range of messages, in message order, to rebuild their rollups
+ *        (id_raws, id_modem, timestamp, avg_signal, snr, rssi), a message stored without reception counts as one
+ */
+#define SELECT_ROLLUPS_BACKFILL \
+    "SELECT r.id_raws, r.id_modem, r.timestamp, r.avg_signal, COALESCE(c.snr, r.snr), COALESCE(c.rssi, r.rssi)" \
+    " FROM `raws` r LEFT JOIN `receptions` c ON c.id_raws = r.id_raws WHERE r.id_raws BETWEEN ? AND ?" \
+    " ORDER BY r.id_raws;"
+
 #ifdef     __cplusplus
 }
 #endif
@@ -0,0 +1,169 @@
+/**
+ * @file arena.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Bump allocator for the memory that only lives while a request is handled
+ */
+
+#include <stdio.h>          // vsnprintf
+#include <stdlib.h>          // malloc, free
+
+#include <arena.h>
+
+
+/**
+ * @brief Alignment of the allocations
+ */
+#define ARENA_ALIGN     8
+
+
+/**
+ * @struct     arena_block_s
+ * @brief      Allocation that did not fit in the block
+ */
+struct arena_block_s {
+    arena_block_t *next;          ///< Next overflow allocation
+    unsigned long long data[];          ///< The memory
+};
+
+
+
+int arena_init(arena_t  *arena,
+               size_t   size
+               )
+{
+    arena->base         = malloc(size);
+    arena->size         = (arena->base) ? size : 0;
+    arena->used         = 0;
+    arena->peak         = 0;
+    arena->overflow     = NULL;
+    arena->overflows    = 0;
+
+    return ( (arena->base) ? 0 : -1);
+}
+
+
+
+void arena_destroy(arena_t *arena)
+{
+    arena_reset(arena);
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+}
+
+
+
+void* arena_alloc(arena_t   *arena,
+                  size_t    size
+                  )
+{
+    size_t              offset  = (arena->used + ARENA_ALIGN - 1) & ~( (size_t) ARENA_ALIGN - 1);
+    arena_block_t       *block  = NULL;
+
+
+    if ( (offset <= arena->size) && (size <= arena->size - offset) )
+    {
+        arena->used = offset + size;
+
+        if ( arena->used > arena->peak )
+        {
+            arena->peak = arena->used;
+        }
+
+        return (arena->base + offset);
+    }
+
+    block = malloc(sizeof(arena_block_t) + size);
+
+    if ( ! block )
+    {
+        return (NULL);
+    }
+
+    block->next     = arena->overflow;
+    arena->overflow = block;
+    arena->overflows++;
+
+    return (block->data);
+}
+
+
+
+char* arena_vprintf(arena_t     *arena,
+                    size_t      *len,
+                    const char  *fmt,
+                    va_list     ap
+                    )
+{
+    size_t      avail   = arena->size - arena->used;
+    char        *str    = arena->base + arena->used;
+    va_list     copy;
+    int         n       = 0;
+
+
+    // Formatted in place at the end of the block, and only copied elsewhere if it did not fit
+    va_copy(copy, ap);
+    n = vsnprintf(str, avail, fmt, copy);
+    va_end(copy);
+
+    if ( n < 0 )
+    {
+        return (NULL);
+    }
+
+    if ( (size_t) n < avail )
+    {
+        arena->used += (size_t) n + 1;
+
+        if ( arena->used > arena->peak )
+        {
+            arena->peak = arena->used;
+        }
+    }
+    else
+    {
+        str = arena_alloc(arena, (size_t) n + 1);
+
+        if ( ! str )
+        {
+            return (NULL);
+        }
+
+        vsnprintf(str, (size_t) n + 1, fmt, ap);
+    }
+
+    *len = (size_t) n;
+
+    return (str);
+}
+
+
+
+void arena_rewind(arena_t   *arena,
+                  size_t    mark
+                  )
+{
+    if ( mark < arena->used )
+    {
+        arena->used = mark;
+    }
+}
+
+
+
+void arena_reset(arena_t *arena)
+{
+    arena_block_t       *block  = NULL;
+
+
+    while ( arena->overflow )
+    {
+        block           = arena->overflow;
+        arena->overflow = block->next;
+        free(block);
+    }
+
+    arena->used = 0;
+}
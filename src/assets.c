@@ -0,0 +1,287 @@
+/**
+ * @file assets.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Static files of the document root, compressed once and served from memory
+ */
+
+#include <stdio.h>          // snprintf, fopen, fread, fclose
+#include <stdlib.h>          // malloc, free
+#include <string.h>          // strcmp, strlen, memcmp, memset
+#include <sys/stat.h>          // stat, S_ISREG
+
+#include <assets.h>
+#include <gzip.h>          // gzip_accepted, gzip_compress, gzip_name
+#include <logging.h>          // eprintf
+
+
+/**
+ * @brief Maximum number of compressed files
+ */
+#define ASSETS_MAX          32
+
+
+/**
+ * @brief Maximum length of the path of a file
+ */
+#define ASSETS_PATH_MAX     256
+
+
+/**
+ * @brief Maximum size of a file compressed in memory (the larger ones are left to mg_serve_http)
+ */
+#define ASSETS_SIZE_MAX     (4 * 1024 * 1024)
+
+
+/**
+ * @brief Compression level of the files, they are compressed once
+ */
+#define ASSETS_LEVEL        9
+
+
+/**
+ * @brief Maximum length of an ETag
+ */
+#define ASSETS_ETAG         64
+
+
+/**
+ * @struct     assets_entry_s
+ * @brief      A compressed file
+ */
+typedef struct assets_entry_s {
+    char path[ASSETS_PATH_MAX];          ///< Path of the file
+    gzip_encoding_t encoding;          ///< Encoding of data
+    time_t mtime;          ///< Modification time of the file when it was compressed
+    off_t size;          ///< Size of the file when it was compressed
+    char *data;          ///< The compressed file
+    size_t len;          ///< Length of the compressed file
+} assets_entry_t;
+
+
+/**
+ * @brief The compressed files
+ */
+static assets_entry_t       s_assets[ASSETS_MAX];
+
+
+/**
+ * @brief Number of compressed files
+ */
+static unsigned int         s_assets_count = 0;
+
+
+/**
+ * @brief      Get the Content-Type of a file compressed in memory, from its extension
+ *
+ * @param[in]  path  The path of the file
+ *
+ * @return     The type, NULL if the file is not compressed (binary files, or already compressed)
+ */
+static const char* assets_type(const char *path);
+
+
+/**
+ * @brief      Find the compressed file of a path, compressing it if it is not yet or if the file changed
+ *
+ * @param[in]  path      The path of the file
+ * @param[in]  encoding  The encoding
+ * @param[in]  st        The status of the file
+ *
+ * @return     The compressed file, NULL on error or when there is no room
+ */
+static const assets_entry_t* assets_load(const char *path, gzip_encoding_t encoding, const struct stat *st);
+
+
+
+int assets_serve(struct mg_connection   *nc,
+                 struct http_message    *hm,
+                 const char             *root
+                 )
+{
+    const struct mg_str     *accept = mg_get_http_header(hm, "Accept-Encoding");
+    const struct mg_str     *match  = mg_get_http_header(hm, "If-None-Match");
+    const assets_entry_t    *entry  = NULL;
+    const char              *type   = NULL;
+    gzip_encoding_t         encoding    = GZIP_IDENTITY;
+    struct stat             st;
+    char                    path[ASSETS_PATH_MAX];
+    char                    etag[ASSETS_ETAG];
+    char                    headers[512];
+    size_t                  i       = 0;
+    int                     len     = 0;
+
+
+    if ( (hm->method.len != 3) || (memcmp(hm->method.p, "GET", 3) != 0) || ! accept ||
+         ( (encoding = gzip_accepted(accept->p, accept->len) ) == GZIP_IDENTITY) )
+    {
+        return (0);
+    }
+
+
+    // The paths that leave the root or that mg_serve_http would decode are left to it
+    for ( i = 0; i < hm->uri.len; ++i )
+    {
+        if ( (hm->uri.p[i] == '%') || (hm->uri.p[i] == '\\') ||
+             ( (hm->uri.p[i] == '.') && (i + 1 < hm->uri.len) && (hm->uri.p[i + 1] == '.') ) )
+        {
+            return (0);
+        }
+    }
+
+    len = snprintf(path, sizeof(path), "%s%.*s%s", root, (int) hm->uri.len, hm->uri.p,
+                   (hm->uri.len && (hm->uri.p[hm->uri.len - 1] == '/') ) ? "index.html" : "");
+
+    if ( (len < 0) || ( (size_t) len >= sizeof(path) ) || ( (type = assets_type(path) ) == NULL) ||
+         (stat(path, &st) != 0) || ! S_ISREG(st.st_mode) || (st.st_size > ASSETS_SIZE_MAX) ||
+         ( (entry = assets_load(path, encoding, &st) ) == NULL) || (entry->len >= (size_t) st.st_size) )
+    {
+        return (0);
+    }
+
+
+    // The tag changes with the file and differs from the one mg_serve_http gives to the file itself
+    snprintf(etag, sizeof(etag), "\"%lx.%lx-%s\"", (unsigned long) st.st_mtime, (unsigned long) st.st_size,
+             gzip_name(encoding) );
+
+    for ( i = 0; match && (i + strlen(etag) <= match->len); ++i )
+    {
+        if ( memcmp(match->p + i, etag, strlen(etag) ) == 0 )
+        {
+            len = snprintf(headers, sizeof(headers), "HTTP/1.1 304 Not Modified\r\nETag: %s\r\n"
+                           "Vary: Accept-Encoding\r\n\r\n", etag);
+            mg_send(nc, headers, len);
+
+            return (1);
+        }
+    }
+
+    len = snprintf(headers, sizeof(headers), "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Encoding: %s\r\n"
+                   "Vary: Accept-Encoding\r\nETag: %s\r\nContent-Length: %zu\r\n\r\n", type, gzip_name(encoding),
+                   etag, entry->len);
+    mg_send(nc, headers, len);
+    mg_send(nc, entry->data, entry->len);
+
+    return (1);
+}
+
+
+
+void assets_free(void)
+{
+    unsigned int        i   = 0;
+
+
+    for ( i = 0; i < s_assets_count; ++i )
+    {
+        free(s_assets[i].data);
+    }
+
+    memset(s_assets, 0, sizeof(s_assets) );
+    s_assets_count = 0;
+}
+
+
+
+static const char* assets_type(const char *path)
+{
+    static const char * const   types[][2] =
+    {
+        {".html", "text/html"},
+        {".htm", "text/html"},
+        {".css", "text/css"},
+        {".js", "application/javascript"},
+        {".json", "application/json"},
+        {".svg", "image/svg+xml"},
+        {".txt", "text/plain"},
+        {".xml", "text/xml"}
+    };
+    const size_t                len     = strlen(path);
+    size_t                      n       = 0;
+    size_t                      i       = 0;
+
+
+    for ( i = 0; i < sizeof(types) / sizeof(types[0]); ++i )
+    {
+        n = strlen(types[i][0]);
+
+        if ( (len > n) && (strcmp(path + len - n, types[i][0]) == 0) )
+        {
+            return (types[i][1]);
+        }
+    }
+
+    return (NULL);
+}
+
+
+
+static const assets_entry_t* assets_load(const char         *path,
+                                         gzip_encoding_t    encoding,
+                                         const struct stat  *st
+                                         )
+{
+    assets_entry_t      *entry  = NULL;
+    FILE                *file   = NULL;
+    char                *raw    = NULL;
+    char                *data   = NULL;
+    size_t              len     = 0;
+    unsigned int        i       = 0;
+
+
+    for ( i = 0; i < s_assets_count; ++i )
+    {
+        if ( (s_assets[i].encoding == encoding) && (strcmp(s_assets[i].path, path) == 0) )
+        {
+            entry = &s_assets[i];
+            break;
+        }
+    }
+
+    if ( entry && (entry->mtime == st->st_mtime) && (entry->size == st->st_size) )
+    {
+        return (entry);
+    }
+
+    if ( ! entry && (s_assets_count == ASSETS_MAX) )
+    {
+        return (NULL);
+    }
+
+
+    // Read and compress the file as it is now
+    if ( ( (raw = malloc(st->st_size + 1) ) == NULL) || ( (file = fopen(path, "rb") ) == NULL) ||
+         (fread(raw, 1, st->st_size, file) != (size_t) st->st_size) ||
+         ( (data = gzip_compress(encoding, ASSETS_LEVEL, raw, st->st_size, &len) ) == NULL) )
+    {
+        eprintf("Can not compress %s\n", path);
+
+        if ( file )
+        {
+            fclose(file);
+        }
+
+        free(raw);
+
+        return (NULL);
+    }
+
+    fclose(file);
+    free(raw);
+
+    if ( ! entry )
+    {
+        entry = &s_assets[s_assets_count++];
+        snprintf(entry->path, sizeof(entry->path), "%s", path);
+        entry->encoding = encoding;
+    }
+
+    free(entry->data);
+    entry->data     = data;
+    entry->len      = len;
+    entry->mtime    = st->st_mtime;
+    entry->size     = st->st_size;
+
+    return (entry);
+}
@@ -0,0 +1,483 @@
+/**
+ * @file binary_ingest.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Listeners of the binary records (sigfox_binary.h) sent by the local gateways, over TCP and UDP
+ */
+
+#define _GNU_SOURCE          // recvmmsg
+
+#include <stdlib.h>          // calloc, free, strtol
+#include <string.h>          // memset
+#include <stddef.h>          // offsetof
+#include <errno.h>          // errno, EAGAIN, EINTR
+#include <unistd.h>          // close
+#include <sys/socket.h>          // socket, bind, setsockopt, recvmmsg, recvmsg, sendto
+#include <netinet/in.h>          // struct sockaddr_in, INADDR_ANY
+
+#include <binary_ingest.h>
+#include <sigfox_binary.h>          // sigfox_binary_decode, sigfox_binary_reply
+#include <sigfox_json.h>          // SIGFOX_JSON_ERR_SYNTAX
+#include <db_plugin_sqlite.h>          // db_ingest
+#include <logging.h>          // iprintf, eprintf
+
+
+/**
+ * @brief Number of datagrams received by one recvmmsg
+ */
+#define BINARY_UDP_BATCH        32
+
+
+/**
+ * @brief Largest datagram (a gateway packs several records in one)
+ */
+#define BINARY_UDP_DATAGRAM     2048
+
+
+/**
+ * @brief Time the receiver thread waits for a datagram before checking if it has to stop (in milliseconds)
+ */
+#define BINARY_UDP_TIMEOUT      100
+
+
+/**
+ * @brief Maximum number of records sent in one mg_broadcast message (it has to fit in 8 kB)
+ */
+#define BINARY_RECORDS_MAX      32
+
+
+#ifndef __linux__
+
+
+/**
+ * @struct     mmsghdr
+ * @brief      A datagram received by binary_recv (the Linux structure of recvmmsg)
+ */
+struct mmsghdr {
+    struct msghdr msg_hdr;          ///< The datagram
+    unsigned int msg_len;          ///< Number of bytes received
+};
+#endif
+
+
+/**
+ * @typedef binary_record_t
+ */
+typedef struct binary_record_s binary_record_t;
+
+
+/**
+ * @struct     binary_record_s
+ * @brief      A record received by UDP
+ */
+struct binary_record_s {
+    sigfox_raws_t raws;          ///< The frame
+    unsigned char error;          ///< 0 or the error of the record
+    struct sockaddr_in from;          ///< Sender of the datagram, the reply is sent there
+};
+
+
+/**
+ * @typedef binary_records_t
+ */
+typedef struct binary_records_s binary_records_t;
+
+
+/**
+ * @struct     binary_records_s
+ * @brief      Message broadcast by the receiver thread to the event loop
+ */
+struct binary_records_s {
+    binary_ingest_t *ingest;          ///< The listeners
+    unsigned int count;          ///< Number of records
+    binary_record_t items[BINARY_RECORDS_MAX];          ///< The records
+};
+
+
+/**
+ * @brief      Handle the events of the TCP connections
+ *
+ * @param      nc       The connection
+ * @param[in]  ev       The event
+ * @param      ev_data  The event data
+ */
+static void binary_tcp_handler(struct mg_connection *nc, int ev, void *ev_data);
+
+
+/**
+ * @brief      Receiver thread: receives the datagrams by batches and broadcasts their records
+ *
+ * @param      arg   The listeners
+ *
+ * @return     NULL
+ */
+static void* binary_receiver(void *arg);
+
+
+/**
+ * @brief      Receive the datagrams already queued on the socket, waiting for the first one
+ *
+ * @param[in]  fd    The UDP socket
+ * @param      msgs  The datagrams
+ * @param[in]  vlen  Maximum number of datagrams
+ *
+ * @return     Number of datagrams received, -1 on error (errno is set)
+ */
+static int binary_recv(int fd, struct mmsghdr *msgs, unsigned int vlen);
+
+
+/**
+ * @brief      Insert the records broadcast by the receiver thread, on the event loop
+ *
+ * @param      nc       A connection of the manager (the message is only handled once)
+ * @param[in]  ev       The event (MG_EV_POLL)
+ * @param      ev_data  The binary_records_t message
+ */
+static void binary_records_handler(struct mg_connection *nc, int ev, void *ev_data);
+
+
+/**
+ * @brief      Insert a record
+ *
+ * @param      ingest  The listeners
+ * @param[in]  raws    The frame
+ * @param[in]  error   0 or the error of the record
+ * @param[out] reply   The reply
+ *
+ * @return     1 if the reply has to be sent, 0 otherwise
+ */
+static int binary_record(binary_ingest_t *ingest, const sigfox_raws_t *raws, unsigned char error,
+                         unsigned char reply[SIGFOX_BINARY_REPLY_LENGTH]);
+
+
+
+binary_ingest_t* binary_ingest_start(struct mg_mgr  *mgr,
+                                     const char     *port,
+                                     void           *db
+                                     )
+{
+    binary_ingest_t         *ingest     = calloc(1, sizeof(binary_ingest_t) );
+    struct sockaddr_in      addr;
+    struct timeval          timeout     = {0, BINARY_UDP_TIMEOUT * 1000};
+    int                     on          = 1;
+
+
+    if ( ! ingest )
+    {
+        return (NULL);
+    }
+
+    ingest->db  = db;
+    ingest->mgr = mgr;
+    ingest->udp = socket(AF_INET, SOCK_DGRAM, 0);
+
+    memset(&addr, 0, sizeof(addr) );
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(INADDR_ANY);
+    addr.sin_port           = htons(strtol(port, NULL, 10) );
+
+    if ( (ingest->udp < 0) || setsockopt(ingest->udp, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on) ) ||
+         setsockopt(ingest->udp, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout) ) ||
+         bind(ingest->udp, (struct sockaddr *) &addr, sizeof(addr) ) )
+    {
+        eprintf("Cannot listen on UDP port %s: %s\n", port, strerror(errno) );
+
+        if ( ingest->udp >= 0 )
+        {
+            close(ingest->udp);
+        }
+
+        free(ingest);
+
+        return (NULL);
+    }
+
+    ingest->listener = mg_bind(mgr, port, binary_tcp_handler);
+
+    if ( ! ingest->listener )
+    {
+        eprintf("Cannot listen on TCP port %s\n", port);
+        close(ingest->udp);
+        free(ingest);
+
+        return (NULL);
+    }
+
+
+    // The accepted connections inherit it
+    ingest->listener->user_data = ingest;
+
+    atomic_store(&ingest->running, 1);
+    atomic_store(&ingest->stopped, 0);
+
+    if ( pthread_create(&ingest->receiver, NULL, binary_receiver, ingest) != 0 )
+    {
+        ingest->listener->flags    |= MG_F_CLOSE_IMMEDIATELY;
+        ingest->listener->user_data = NULL;
+        close(ingest->udp);
+        free(ingest);
+
+        return (NULL);
+    }
+
+    return (ingest);
+}
+
+
+
+void binary_ingest_stop(binary_ingest_t **ingest)
+{
+    binary_ingest_t         *self   = *ingest;
+    struct mg_connection    *c      = NULL;
+
+
+    if ( ! self )
+    {
+        return;
+    }
+
+    atomic_store(&self->running, 0);
+
+
+    // mg_broadcast waits for the event loop, so keep it running until the receiver is done
+    while ( ! atomic_load(&self->stopped) )
+    {
+        mg_mgr_poll(self->mgr, 10);
+    }
+
+    pthread_join(self->receiver, NULL);
+    close(self->udp);
+
+
+    // The listener and the TCP connections are closed by the next poll, they must not use the listeners before
+    for ( c = mg_next(self->mgr, NULL); c != NULL; c = mg_next(self->mgr, c) )
+    {
+        if ( c->user_data == self )
+        {
+            c->user_data    = NULL;
+            c->flags       |= MG_F_CLOSE_IMMEDIATELY;
+        }
+    }
+
+    iprintf("%lu binary records received, %lu refused\n", self->records, self->refused);
+    free(self);
+    *ingest = NULL;
+}
+
+
+
+static void binary_tcp_handler(struct mg_connection *nc,
+                               int                  ev,
+                               void                 *ev_data __attribute__( (unused) )
+                               )
+{
+    binary_ingest_t         *ingest = nc->user_data;
+    struct mbuf             *io     = &nc->recv_mbuf;
+    const unsigned char     *buf    = (const unsigned char *) io->buf;
+    size_t                  offset  = 0;
+    size_t                  len     = 0;
+    sigfox_raws_t           raws;
+    unsigned char           error   = 0;
+    unsigned char           reply[SIGFOX_BINARY_REPLY_LENGTH];
+
+
+    if ( (ev != MG_EV_RECV) || ! ingest )
+    {
+        return;
+    }
+
+
+    // The records are handled as soon as they are whole, the tail waits for the next segment
+    while ( (len = sigfox_binary_decode(buf + offset, io->len - offset, &raws, &error) ) > 0 )
+    {
+        offset += len;
+
+
+        // The framing is lost, the rest of the stream cannot be read
+        if ( error == SIGFOX_JSON_ERR_SYNTAX )
+        {
+            ingest->records++;
+            ingest->refused++;
+            nc->flags |= MG_F_SEND_AND_CLOSE;
+            break;
+        }
+
+        if ( binary_record(ingest, &raws, error, reply) )
+        {
+            mg_send(nc, reply, sizeof(reply) );
+        }
+    }
+
+    mbuf_remove(io, offset);
+}
+
+
+
+static void* binary_receiver(void *arg)
+{
+    binary_ingest_t         *ingest = arg;
+    struct mmsghdr          msgs[BINARY_UDP_BATCH];
+    struct iovec            iovs[BINARY_UDP_BATCH];
+    struct sockaddr_in      from[BINARY_UDP_BATCH];
+    static unsigned char    bufs[BINARY_UDP_BATCH][BINARY_UDP_DATAGRAM];
+    binary_records_t        records;
+    binary_record_t         *record = NULL;
+    size_t                  offset  = 0;
+    size_t                  len     = 0;
+    int                     count   = 0;
+    int                     i       = 0;
+
+
+    records.ingest  = ingest;
+    records.count   = 0;
+
+    while ( atomic_load(&ingest->running) )
+    {
+        memset(msgs, 0, sizeof(msgs) );
+
+        for ( i = 0; i < BINARY_UDP_BATCH; ++i )
+        {
+            iovs[i].iov_base                = bufs[i];
+            iovs[i].iov_len                 = BINARY_UDP_DATAGRAM;
+            msgs[i].msg_hdr.msg_iov         = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen      = 1;
+            msgs[i].msg_hdr.msg_name        = &from[i];
+            msgs[i].msg_hdr.msg_namelen     = sizeof(from[i]);
+        }
+
+
+        count = binary_recv(ingest->udp, msgs, BINARY_UDP_BATCH);
+
+        if ( count < 0 )
+        {
+            if ( (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR) )
+            {
+                eprintf("recvmmsg: %s\n", strerror(errno) );
+            }
+
+            continue;
+        }
+
+        for ( i = 0; i < count; ++i )
+        {
+            for ( offset = 0; offset < msgs[i].msg_len; offset += len )
+            {
+                record  = &records.items[records.count];
+                len     = sigfox_binary_decode(bufs[i] + offset, msgs[i].msg_len - offset, &record->raws,
+                                               &record->error);
+
+
+                // A truncated record ends the datagram
+                if ( len == 0 )
+                {
+                    break;
+                }
+
+                record->from = from[i];
+
+                if ( ++records.count == BINARY_RECORDS_MAX )
+                {
+                    mg_broadcast(ingest->mgr, binary_records_handler, &records,
+                                 offsetof(binary_records_t, items) + records.count * sizeof(binary_record_t) );
+                    records.count = 0;
+                }
+            }
+        }
+
+        if ( records.count )
+        {
+            mg_broadcast(ingest->mgr, binary_records_handler, &records,
+                         offsetof(binary_records_t, items) + records.count * sizeof(binary_record_t) );
+            records.count = 0;
+        }
+    }
+
+    atomic_store(&ingest->stopped, 1);
+
+    return (NULL);
+}
+
+
+
+static int binary_recv(int               fd,
+                       struct mmsghdr    *msgs,
+                       unsigned int      vlen
+                       )
+{
+#ifdef __linux__
+
+    // Blocks for the first datagram only, then takes the ones already received
+    return (recvmmsg(fd, msgs, vlen, MSG_WAITFORONE, NULL) );
+#else
+    ssize_t     len     = recvmsg(fd, &msgs[0].msg_hdr, 0);
+
+
+    // recvmmsg is Linux only, the other systems get one datagram per call
+    (void) vlen;
+    msgs[0].msg_len = (len > 0) ? len : 0;
+
+    return ( (len < 0) ? -1 : 1);
+#endif
+}
+
+
+
+static void binary_records_handler(struct mg_connection *nc __attribute__( (unused) ),
+                                   int                  ev __attribute__( (unused) ),
+                                   void                 *ev_data
+                                   )
+{
+    binary_records_t        *records    = ev_data;
+    binary_record_t         *record     = NULL;
+    unsigned int            i           = 0;
+    unsigned char           reply[SIGFOX_BINARY_REPLY_LENGTH];
+
+
+    for ( i = 0; i < records->count; ++i )
+    {
+        record = &records->items[i];
+
+        if ( binary_record(records->ingest, &record->raws, record->error, reply) )
+        {
+            sendto(records->ingest->udp, reply, sizeof(reply), MSG_DONTWAIT, (struct sockaddr *) &record->from,
+                   sizeof(record->from) );
+        }
+    }
+
+
+    // The message is shared by the calls of this broadcast
+    records->count = 0;
+}
+
+
+
+static int binary_record(binary_ingest_t        *ingest,
+                         const sigfox_raws_t    *raws,
+                         unsigned char          error,
+                         unsigned char          reply[SIGFOX_BINARY_REPLY_LENGTH]
+                         )
+{
+    char        downlink_data[SIGFOX_DOWNLINK_DATA_LENGTH + 1] = "";
+
+
+    ingest->records++;
+
+    if ( (error == 0) && db_ingest(ingest->db, raws, downlink_data) )
+    {
+        error = SIGFOX_BINARY_ERR_BUSY;
+    }
+
+    if ( error )
+    {
+        ingest->refused++;
+    }
+    else if ( ! raws->ack )
+    {
+        return (0);
+    }
+
+    sigfox_binary_reply(reply, raws, error, downlink_data);
+
+    return (1);
+}
@@ -0,0 +1,238 @@
+/**
+ * @file cache.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Cache of whole replies, tagged with the version of the data they were read from
+ */
+
+#include <stdlib.h>          // malloc, free
+#include <string.h>          // memcpy, memcmp
+
+#include <cache.h>
+
+
+/**
+ * @brief      Find the entry of a key, whatever its version
+ *
+ * @param      cache    The cache
+ * @param[in]  key      The key
+ * @param[in]  key_len  Length of the key
+ *
+ * @return     The entry, NULL if there is none
+ */
+static cache_entry_t* cache_find(cache_t *cache, const char *key, size_t key_len);
+
+
+/**
+ * @brief      Unlink an entry from the list
+ *
+ * @param      cache  The cache
+ * @param      entry  The entry
+ */
+static void cache_unlink(cache_t *cache, cache_entry_t *entry);
+
+
+/**
+ * @brief      Link an entry at the head of the list (most recently used)
+ *
+ * @param      cache  The cache
+ * @param      entry  The entry
+ */
+static void cache_link(cache_t *cache, cache_entry_t *entry);
+
+
+/**
+ * @brief      Unlink and free an entry
+ *
+ * @param      cache  The cache
+ * @param      entry  The entry
+ */
+static void cache_evict(cache_t *cache, cache_entry_t *entry);
+
+
+
+void cache_init(cache_t         *cache,
+                size_t          max_bytes,
+                unsigned int    max_count
+                )
+{
+    memset(cache, 0, sizeof(cache_t) );
+    cache->max_bytes    = max_bytes;
+    cache->max_count    = max_count;
+}
+
+
+
+void cache_destroy(cache_t *cache)
+{
+    while ( cache->head )
+    {
+        cache_evict(cache, cache->head);
+    }
+}
+
+
+
+const cache_entry_t* cache_get(cache_t              *cache,
+                               const char           *key,
+                               size_t               key_len,
+                               unsigned long long   version
+                               )
+{
+    cache_entry_t       *entry  = cache_find(cache, key, key_len);
+
+
+    if ( entry && (entry->version != version) )
+    {
+        cache_evict(cache, entry);
+        entry = NULL;
+    }
+
+    if ( ! entry )
+    {
+        cache->misses++;
+
+        return (NULL);
+    }
+
+    cache_unlink(cache, entry);
+    cache_link(cache, entry);
+    cache->hits++;
+
+    return (entry);
+}
+
+
+
+int cache_put(cache_t               *cache,
+              const char            *key,
+              size_t                key_len,
+              unsigned long long    version,
+              const char            *headers,
+              size_t                headers_len,
+              const char            *body,
+              size_t                body_len
+              )
+{
+    const size_t        size    = sizeof(cache_entry_t) + key_len + headers_len + body_len;
+    cache_entry_t       *entry  = cache_find(cache, key, key_len);
+
+
+    if ( entry )
+    {
+        cache_evict(cache, entry);
+    }
+
+    if ( (size > cache->max_bytes) || (cache->max_count == 0) )
+    {
+        return (-1);
+    }
+
+
+    // The least recently used entries make room
+    while ( (cache->count >= cache->max_count) || (cache->bytes + size > cache->max_bytes) )
+    {
+        cache_evict(cache, cache->tail);
+    }
+
+    if ( (entry = malloc(size) ) == NULL )
+    {
+        return (-1);
+    }
+
+    entry->version      = version;
+    entry->key_len      = key_len;
+    entry->headers_len  = headers_len;
+    entry->body_len     = body_len;
+    memcpy(entry->data, key, key_len);
+    memcpy(entry->data + key_len, headers, headers_len);
+    memcpy(entry->data + key_len + headers_len, body, body_len);
+
+    cache_link(cache, entry);
+    cache->count++;
+    cache->bytes += size;
+    cache->stores++;
+
+    return (0);
+}
+
+
+
+static cache_entry_t* cache_find(cache_t    *cache,
+                                 const char *key,
+                                 size_t     key_len
+                                 )
+{
+    cache_entry_t       *entry  = NULL;
+
+
+    for ( entry = cache->head; entry; entry = entry->next )
+    {
+        if ( (entry->key_len == key_len) && (memcmp(entry->data, key, key_len) == 0) )
+        {
+            return (entry);
+        }
+    }
+
+    return (NULL);
+}
+
+
+
+static void cache_unlink(cache_t        *cache,
+                         cache_entry_t  *entry
+                         )
+{
+    if ( entry->prev )
+    {
+        entry->prev->next = entry->next;
+    }
+    else
+    {
+        cache->head = entry->next;
+    }
+
+    if ( entry->next )
+    {
+        entry->next->prev = entry->prev;
+    }
+    else
+    {
+        cache->tail = entry->prev;
+    }
+}
+
+
+
+static void cache_link(cache_t          *cache,
+                       cache_entry_t    *entry
+                       )
+{
+    entry->prev = NULL;
+    entry->next = cache->head;
+
+    if ( cache->head )
+    {
+        cache->head->prev = entry;
+    }
+    else
+    {
+        cache->tail = entry;
+    }
+
+    cache->head = entry;
+}
+
+
+
+static void cache_evict(cache_t         *cache,
+                        cache_entry_t   *entry
+                        )
+{
+    cache_unlink(cache, entry);
+    cache->count--;
+    cache->bytes -= sizeof(cache_entry_t) + entry->key_len + entry->headers_len + entry->body_len;
+    cache->evictions++;
+    free(entry);
+}
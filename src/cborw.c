@@ -0,0 +1,204 @@
+/**
+ * @file cborw.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  CBOR items (RFC 8949), rendered into the buffer of a JSON writer
+ */
+
+#include <stdint.h>          // uint8_t, uint32_t, uint64_t
+#include <string.h>          // memcpy
+
+#include <cborw.h>
+
+
+/**
+ * @brief Major types
+ */
+#define CBORW_UNSIGNED      0
+#define CBORW_NEGATIVE      1
+#define CBORW_TEXT          3
+#define CBORW_MAP           5
+
+
+/**
+ * @brief Simple values and initial bytes
+ */
+#define CBORW_FALSE         0xF4
+#define CBORW_TRUE          0xF5
+#define CBORW_FLOAT32       0xFA
+#define CBORW_FLOAT64       0xFB
+#define CBORW_ARRAY_OPEN    0x9F
+#define CBORW_BREAK         0xFF
+
+
+/**
+ * @brief      Write the head of an item: its major type and its argument, in the shortest length
+ *
+ * @param      w      The writer
+ * @param[in]  major  The major type
+ * @param[in]  value  The argument
+ */
+static void cborw_head(jsonw_t *w, uint8_t major, uint64_t value);
+
+
+/**
+ * @brief      Write an initial byte followed by the big-endian bytes of a value
+ *
+ * @param      w      The writer
+ * @param[in]  first  The initial byte
+ * @param[in]  value  The value
+ * @param[in]  size   Number of bytes of the value (0, 1, 2, 4 or 8)
+ */
+static void cborw_bytes(jsonw_t *w, uint8_t first, uint64_t value, size_t size);
+
+
+
+void cborw_integer(jsonw_t      *w,
+                   long long    value
+                   )
+{
+    // -1 - n is written as n with the negative major type
+    if ( value < 0 )
+    {
+        cborw_head(w, CBORW_NEGATIVE, (uint64_t) (-1 - value) );
+    }
+    else
+    {
+        cborw_head(w, CBORW_UNSIGNED, (uint64_t) value);
+    }
+}
+
+
+
+void cborw_text(jsonw_t     *w,
+                const char  *s,
+                size_t      len
+                )
+{
+    char        buf[24];
+
+
+    // The keys and the short values go out with their head in one write
+    if ( len < sizeof(buf) - 1 )
+    {
+        buf[0] = (char) ( (CBORW_TEXT << 5) | len);
+        memcpy(buf + 1, s, len);
+        jsonw_raw(w, buf, len + 1);
+
+        return;
+    }
+
+    cborw_head(w, CBORW_TEXT, len);
+    jsonw_raw(w, s, len);
+}
+
+
+
+void cborw_double(jsonw_t   *w,
+                  double    value
+                  )
+{
+    const float     single  = (float) value;
+    uint32_t        bits32  = 0;
+    uint64_t        bits64  = 0;
+
+
+    if ( ( (double) single == value) || (value != value) )
+    {
+        memcpy(&bits32, &single, sizeof(bits32) );
+        cborw_bytes(w, CBORW_FLOAT32, bits32, sizeof(bits32) );
+    }
+    else
+    {
+        memcpy(&bits64, &value, sizeof(bits64) );
+        cborw_bytes(w, CBORW_FLOAT64, bits64, sizeof(bits64) );
+    }
+}
+
+
+
+void cborw_bool(jsonw_t *w,
+                int     value
+                )
+{
+    cborw_bytes(w, (value) ? CBORW_TRUE : CBORW_FALSE, 0, 0);
+}
+
+
+
+void cborw_map(jsonw_t  *w,
+               size_t   pairs
+               )
+{
+    cborw_head(w, CBORW_MAP, pairs);
+}
+
+
+
+void cborw_array(jsonw_t *w)
+{
+    cborw_bytes(w, CBORW_ARRAY_OPEN, 0, 0);
+}
+
+
+
+void cborw_break(jsonw_t *w)
+{
+    cborw_bytes(w, CBORW_BREAK, 0, 0);
+}
+
+
+
+static void cborw_head(jsonw_t  *w,
+                       uint8_t  major,
+                       uint64_t value
+                       )
+{
+    const uint8_t       type    = (uint8_t) (major << 5);
+
+
+    // The arguments under 24 are in the initial byte, the others follow it in 1, 2, 4 or 8 bytes
+    if ( value < 24 )
+    {
+        cborw_bytes(w, type | (uint8_t) value, 0, 0);
+    }
+    else if ( value <= UINT8_MAX )
+    {
+        cborw_bytes(w, type | 24, value, 1);
+    }
+    else if ( value <= UINT16_MAX )
+    {
+        cborw_bytes(w, type | 25, value, 2);
+    }
+    else if ( value <= UINT32_MAX )
+    {
+        cborw_bytes(w, type | 26, value, 4);
+    }
+    else
+    {
+        cborw_bytes(w, type | 27, value, 8);
+    }
+}
+
+
+
+static void cborw_bytes(jsonw_t     *w,
+                        uint8_t     first,
+                        uint64_t    value,
+                        size_t      size
+                        )
+{
+    char        buf[9];
+    size_t      i       = 0;
+
+
+    buf[0] = (char) first;
+
+    for ( i = 0; i < size; ++i )
+    {
+        buf[size - i] = (char) (value >> (8 * i) );
+    }
+
+    jsonw_raw(w, buf, size + 1);
+}
@@ -0,0 +1,67 @@
+/**
+ * @file csvw.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  CSV fields (RFC 4180), rendered into the buffer of a JSON writer
+ */
+
+#include <string.h>          // memchr
+
+#include <csvw.h>
+#include <numfmt.h>          // numfmt_double, NUMFMT_MAX
+
+
+
+void csvw_string(jsonw_t        *w,
+                 const char     *s,
+                 size_t         len
+                 )
+{
+    const char          *end    = s + len;
+    const char          *run    = s;
+    const char          *quote  = NULL;
+    size_t              i       = 0;
+
+
+    for ( i = 0; i < len; ++i )
+    {
+        if ( (s[i] == ',') || (s[i] == '"') || (s[i] == '\r') || (s[i] == '\n') )
+        {
+            break;
+        }
+    }
+
+    if ( i == len )
+    {
+        jsonw_raw(w, s, len);
+
+        return;
+    }
+
+
+    // Quoted field, a quote inside it is doubled
+    jsonw_literal(w, "\"");
+
+    while ( (quote = memchr(run, '"', end - run) ) != NULL )
+    {
+        jsonw_raw(w, run, quote + 1 - run);
+        jsonw_literal(w, "\"");
+        run = quote + 1;
+    }
+
+    jsonw_raw(w, run, end - run);
+    jsonw_literal(w, "\"");
+}
+
+
+
+void csvw_double(jsonw_t    *w,
+                 double     value
+                 )
+{
+    char        buf[NUMFMT_MAX];
+
+
+    jsonw_raw(w, buf, numfmt_double(buf, value) );
+}
@@ -7,10 +7,32 @@
  */
 
 #include <sqlite3.h>
+#include <stdint.h>          // uintptr_t
+#include <errno.h>          // errno, EINTR
+#include <time.h>          // time
+#include <ctype.h>          // isspace, isxdigit
+#include <limits.h>          // LLONG_MAX
+#include <math.h>          // NAN
+#include <unistd.h>          // sysconf
 
 #include <db_plugin_sqlite.h>
 #include <sqls.h>
 #include <frames.h>          // sigfox_raws_t
+#include <sigfox_json.h>          // sigfox_json_decode, sigfox_json_decode_object
+#include <sigfox_form.h>          // sigfox_form_decode
+#include <hex.h>          // hex_decode, hex_decode_batch
+#include <downlink.h>          // downlink_new, downlink_free, downlink_get, downlink_set, downlink_push, downlink_pop
+#include <devstats.h>          // devstats_new, devstats_free, devstats_slot, devstats_add, devstats_get, devstats_clear
+#include <rollup.h>          // rollup_new, rollup_free, rollup_add, rollup_clear, rollup_id, rollup_seconds
+#include <histogram.h>          // histogram_clock_us, histogram_add_since, histogram_percentile
+#include <arena.h>          // arena_init, arena_destroy, arena_alloc, arena_vprintf, arena_rewind, arena_reset
+#include <heap.h>          // heap_stats
+#include <numparse.h>          // numparse_integer
+#include <cache.h>          // cache_init, cache_destroy, cache_get, cache_put, cache_headers, cache_body
+#include <jsonw.h>          // jsonw_init, jsonw_raw, jsonw_string, jsonw_integer, jsonw_double, jsonw_bool, jsonw_flush
+#include <gzip.h>          // gzip_accepted, gzip_name, gzip_stream_new, gzip_stream_write, gzip_stream_free
+#include <csvw.h>          // csvw_string, csvw_double
+#include <cborw.h>          // cborw_map, cborw_key, cborw_text, cborw_integer, cborw_double, cborw_bool, cborw_array
 #include <logging.h>          // iprintf, eprintf, gprintf, cprintf
 
 
@@ -20,9 +42,9 @@
  * \param      nc    The non-client
  * \param[in]  hm    The HTTP message
  * \param[in]  key   The key
- * \param      db    The database
+ * \param      plugin  The plugin context
  */
-static void op_set(struct mg_connection *nc, const struct http_message *hm, const struct mg_str *key, void *db);
+static void op_set(struct mg_connection *nc, const struct http_message *hm, const struct mg_str *key, db_plugin_t *plugin);
 
 
 /**
@@ -31,9 +53,33 @@ static void op_set(struct mg_connection *nc, const struct http_message *hm, cons
  * \param      nc    The non-client
  * \param[in]  hm    The HTTP message
  * \param[in]  key   The key
- * \param      db    The database
+ * \param      plugin  The plugin context
  */
-static void op_get(struct mg_connection *nc, const struct http_message *hm, const struct mg_str *key, void *db);
+static void op_get(struct mg_connection *nc, const struct http_message *hm, const struct mg_str *key, db_plugin_t *plugin);
+
+
+/**
+ * @brief      Select the frames of a device or of a base station, ordered by timestamp: ?from=, ?to= and ?limit=
+ *
+ * @param      nc       The non-client
+ * @param[in]  hm       The HTTP message
+ * @param[in]  value    The device identifier or the station identifier
+ * @param[in]  station  1 for the frames received by a base station, 0 for the frames of a device
+ * @param      plugin   The plugin context
+ */
+static void op_frames(struct mg_connection *nc, const struct http_message *hm, const unsigned char *value, int station,
+                      db_plugin_t *plugin);
+
+
+/**
+ * \brief      Add several raws structures (JSON array or NDJSON) into the database in one transaction
+ *
+ * \param      nc    The non-client
+ * \param[in]  hm    The HTTP message
+ * \param[in]  key   The key
+ * \param      plugin  The plugin context
+ */
+static void op_set_batch(struct mg_connection *nc, const struct http_message *hm, const struct mg_str *key, db_plugin_t *plugin);
 
 
 /**
@@ -42,267 +88,4100 @@ static void op_get(struct mg_connection *nc, const struct http_message *hm, cons
  * \param      nc    The non-client
  * \param[in]  hm    The HTTP message
  * \param[in]  key   The key
- * \param      db    The database
+ * \param      plugin  The plugin context
  */
-static void op_del(struct mg_connection *nc, const struct http_message *hm, const struct mg_str *key, void *db);
+static void op_del(struct mg_connection *nc, const struct http_message *hm, const struct mg_str *key, db_plugin_t *plugin);
 
 
 /**
- * @brief      From a JSON structure, we create a raws structure
+ * \brief      Get, set or remove the downlink payload of a device
  *
- * @param      raws  The raws structure
- * @param      jobj  The JSON object
+ * \param      nc        The non-client
+ * \param[in]  hm        The HTTP message
+ * \param[in]  id_modem  The device identifier
+ * \param      plugin    The plugin context
+ * \param[in]  op        The operation
+ */
+static void op_downlink(struct mg_connection *nc, const struct http_message *hm, const unsigned char *id_modem, db_plugin_t *plugin, int op);
+
+
+/**
+ * \brief      List the downlink payloads queued for a device, or queue one
  *
- * @return     0 no error else a number
+ * \param      nc        The non-client
+ * \param[in]  hm        The HTTP message
+ * \param[in]  id_modem  The device identifier
+ * \param      plugin    The plugin context
+ * \param[in]  op        The operation
  */
-static unsigned char raws_from_json(sigfox_raws_t *raws, struct json_token *jobj);
+static void op_downlinks(struct mg_connection *nc, const struct http_message *hm, const unsigned char *id_modem, db_plugin_t *plugin, int op);
+
 
+/**
+ * @brief      Split a /devices/{id_modem}/... or a /stations/{station}/... key
+ *
+ * @param[in]  key     The key
+ * @param[in]  prefix  The part of the key before the identifier ("/devices/" or "/stations/")
+ * @param[in]  max     Maximum length of the identifier (hexadecimal)
+ * @param[out] id      The identifier (NUL-terminated, max + 1 bytes)
+ * @param[out] rest    The part of the key after the identifier
+ *
+ * @return     1 if the key starts with prefix and a valid identifier, 0 otherwise
+ */
+static int path_key(const struct mg_str *key, const char *prefix, size_t max, unsigned char *id, struct mg_str *rest);
 
 
 /**
- * @brief           Convert a data string to an hexadecimal array
+ * @brief      Read the payload of a { "downlinkData": "..." } body, the tokens are allocated in the arena
  *
- * @param[in]       data_str  The data as string
- * @param[out]      data_hex  The data as hexadecimal
+ * @param[in]  hm      The HTTP message
+ * @param[out] data    The payload (string)
+ * @param      plugin  The plugin context
+ *
+ * @return     0 on success, -1 if the body or the payload (8 bytes in hexadecimal) is invalid
  */
-static void convert_data_str_to_data_hex(const unsigned char    data_str[SIGFOX_DATA_STR_LENGTH + 1],
-                                         unsigned char          data_hex[SIGFOX_DATA_LENGTH]);
+static int downlink_body(const struct http_message *hm, char data[SIGFOX_DOWNLINK_DATA_LENGTH + 1], db_plugin_t *plugin);
 
 
-#ifdef __DEBUG__
-    #define MG_PRINTF_200 \
-    mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n"); gprintf("200 OK\n");
-    #define MG_PRINTF_201 \
-    mg_printf(nc, "HTTP/1.1 201 Created\r\nContent-Length: 0\r\n\r\n"); gprintf("201 Created\n");
-    #define MG_PRINTF_204 \
-    mg_printf(nc, "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n"); gprintf("204 No Content\n");
-    #define MG_PRINTF_400 \
-    mg_printf(nc, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n"); eprintf("400 Bad Request\n");
-    #define MG_PRINTF_404 \
-    mg_printf(nc, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n"); eprintf("404 Not Found\n");
-    #define MG_PRINTF_500 \
-    mg_printf(nc, "HTTP/1.1 500 Server Error\r\nContent-Length: 0\r\n\r\n"); eprintf("500 Server Error\n");
-    #define MG_PRINTF_501 \
-    mg_printf(nc, "HTTP/1.1 501 Not Implemented\r\nContent-Length: 0\r\n\r\n"); eprintf("501 Not Implemented\n");
-#else
-    #define MG_PRINTF_200   mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
-    #define MG_PRINTF_201   mg_printf(nc, "HTTP/1.1 201 Created\r\nContent-Length: 0\r\n\r\n");
-    #define MG_PRINTF_204   mg_printf(nc, "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n");
-    #define MG_PRINTF_400   mg_printf(nc, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n");
-    #define MG_PRINTF_404   mg_printf(nc, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
-    #define MG_PRINTF_500   mg_printf(nc, "HTTP/1.1 500 Server Error\r\nContent-Length: 0\r\n\r\n");
-    #define MG_PRINTF_501   mg_printf(nc, "HTTP/1.1 501 Not Implemented\r\nContent-Length: 0\r\n\r\n");
-#endif
+/**
+ * \brief      Send the counters of the server
+ *
+ * \param      nc    The non-client
+ * \param[in]  hm    The HTTP message
+ * \param[in]  key   The key
+ * \param      plugin  The plugin context
+ */
+static void op_stats(struct mg_connection *nc, const struct http_message *hm, const struct mg_str *key, db_plugin_t *plugin);
+
+
+/**
+ * @brief      Look a valid frame up in the recently seen pairs
+ *
+ * A copy is flagged here in DB_DEDUP_FLAG mode, the other modes are left to the caller.
+ *
+ * @param      plugin      The plugin context
+ * @param      raws        The raws structure
+ * @param[out] remembered  1 if the pair was not seen within the window and is now remembered
+ *
+ * @return     DB_DEDUP_DROP if the frame is a copy to drop, DB_DEDUP_OFF otherwise
+ */
+static DB_Dedup dedup_frame(db_plugin_t *plugin, sigfox_raws_t *raws, unsigned char *remembered);
+
+
+/**
+ * @brief      Forget the pairs remembered by the frames of an operation that were not stored
+ *
+ * Otherwise the frame sent again by the backend would be taken for a copy, and dropped with -d drop.
+ *
+ * @param      plugin   The plugin context
+ * @param[in]  pending  The operation (refused by the queue, or completed)
+ */
+static void dedup_restore(db_plugin_t *plugin, const db_pending_t *pending);
+
+
+/**
+ * @brief      Admit a request, or refuse it with 503 according to the depth of the writer queue
+ *
+ * @param      plugin     The plugin context
+ * @param      nc         The non-client
+ * @param[in]  admission  The class of the request
+ *
+ * @return     0 if the request is admitted, -1 if it was refused
+ */
+static int db_admit(db_plugin_t *plugin, struct mg_connection *nc, DB_Admission admission);
+
+
+/**
+ * @brief      Send the next rows of a read, either one object per reception or one object per message with its receptions
+ *
+ * @param      plugin  The plugin context
+ * @param      export  The read
+ * @param[in]  limit   Maximum number of rows sent
+ *
+ * @return     1 once the whole read is sent, 0 otherwise
+ */
+static int send_frames(db_plugin_t *plugin, db_export_t *export, unsigned int limit);
+
+
+/**
+ * @brief      Render a row of a read as JSON or NDJSON
+ *
+ * @param      export   The read
+ * @param      stmt     The statement, on the row
+ * @param[in]  id_raws  The message of the row
+ */
+static void send_json_row(db_export_t *export, sqlite3_stmt *stmt, sqlite3_int64 id_raws);
+
+
+/**
+ * @brief      Render a row of a read as a CSV record (one per reception, whatever the view)
+ *
+ * @param      w     The writer of the read
+ * @param      stmt  The statement, on the row
+ */
+static void send_csv_row(jsonw_t *w, sqlite3_stmt *stmt);
+
+
+/**
+ * @brief      Render a row of a read as CBOR maps
+ *
+ * @param      export   The read
+ * @param      stmt     The statement, on the row
+ * @param[in]  id_raws  The message of the row
+ */
+static void send_cbor_row(db_export_t *export, sqlite3_stmt *stmt, sqlite3_int64 id_raws);
+
+
+/**
+ * @brief      Choose the format of a read: ?format=, else the first type of Accept that is supported, else JSON
+ *
+ * @param[in]  hm      The request
+ * @param[out] format  The format
+ *
+ * @return     0 on success, -1 if ?format= is not a supported format
+ */
+static int db_format(const struct http_message *hm, DB_Format *format);
+
+
+/**
+ * @brief      Send the rows rendered by the writer of a read as one HTTP chunk, and copy them for the cache
+ *             (jsonw_flush_t)
+ *
+ * @param      export  The read
+ * @param[in]  buf     The rows
+ * @param[in]  len     Length of the rows
+ */
+static void send_chunk(void *export, const char *buf, size_t len);
+
+
+/**
+ * @brief      Send bytes of the body of a read as an HTTP chunk, and copy them for the cache
+ *
+ * @param      export  The read
+ * @param[in]  buf     The bytes, compressed or not
+ * @param[in]  len     Number of bytes
+ */
+static void send_body(void *export, const char *buf, size_t len);
+
+
+/**
+ * @brief      Send the header of a read, before the first bytes of its body
+ *
+ * The reply is compressed if the client accepts it and the first bytes are at least DB_GZIP_MIN_SIZE (the first flush
+ * holds the whole body, or fills the buffer of the writer).
+ *
+ * @param      export  The read
+ * @param[in]  len     Number of bytes of the first flush
+ */
+static void send_header(db_export_t *export, size_t len);
+
+
+/**
+ * @brief      Choose the encoding of the reply of a read
+ *
+ * @param[in]  hm     The request
+ * @param[in]  level  Compression level of the endpoint (0 to never compress)
+ *
+ * @return     The encoding the client accepts, GZIP_IDENTITY if none
+ */
+static gzip_encoding_t db_encoding(const struct http_message *hm, int level);
+
+
+/**
+ * @brief      Read an integer parameter of the query string
+ *
+ * @param[in]  hm     The HTTP message
+ * @param[in]  name   Name of the parameter
+ * @param[in]  min    Smallest accepted value
+ * @param[in]  max    Largest accepted value
+ * @param[out] value  The value, untouched if the parameter is not given
+ *
+ * @return     0 on success, -1 if the parameter is not a number in [min, max]
+ */
+static int query_integer(const struct http_message *hm, const char *name, long long min, long long max,
+                         long long *value);
+
+
+/**
+ * @brief      Find the bound of a page: its last message going forward, its first one going backward
+ *
+ * Only the primary key is walked, over the messages of the page, so the cost does not depend on the size of the table.
+ *
+ * @param      stmt       SELECT_PAGE_LAST or SELECT_PAGE_FIRST
+ * @param[in]  after_id   Lower bound of the range (excluded)
+ * @param[in]  before_id  Upper bound of the range (excluded)
+ * @param[in]  limit      Number of messages of the page
+ * @param[out] bound      The bound, 0 if the range holds less than limit messages
+ *
+ * @return     1 if there are more messages beyond the bound, 0 if there are not, -1 on error
+ */
+static int page_bound(sqlite3_stmt *stmt, long long after_id, long long before_id, long long limit, long long *bound);
+
+
+/**
+ * @brief      Find the last message of a page of op_frames, and whether there is one after it
+ *
+ * Only the composite index of the filter is walked, over the messages of the page.
+ *
+ * @param      stmt      SELECT_DEVICE_PAGE or SELECT_STATION_PAGE
+ * @param[in]  value     The device identifier or the station identifier
+ * @param[in]  from      Timestamp of the first message
+ * @param[in]  after_id  The messages of timestamp from are the ones after this id_raws
+ * @param[in]  to        Timestamp of the last message
+ * @param[in]  limit     Number of messages of the page
+ * @param[out] last      Timestamp and id_raws of the last message, untouched if the range holds less than limit
+ *
+ * @return     1 if there are more messages after the last one, 0 if there are not, -1 on error
+ */
+static int frames_bound(sqlite3_stmt *stmt, const unsigned char *value, long long from, long long after_id, long long to,
+                        long long limit, long long last[2]);
+
+
+/**
+ * @brief      Allocate a read with its statement, the cached one if no other read holds it
+ *
+ * @param      plugin  The plugin context
+ * @param      cache   Where the prepared statement is cached
+ * @param[in]  sql     The statement
+ *
+ * @return     The read, NULL on error
+ */
+static db_export_t* db_export_new(db_plugin_t *plugin, sqlite3_stmt **cache, const char *sql);
+
+
+/**
+ * @brief      Send the headers and the first rows of a read whose statement is bound, the rest is sent by db_poll
+ *
+ * @param      plugin   The plugin context
+ * @param      nc       The non-client
+ * @param[in]  hm       The HTTP message
+ * @param      export   The read
+ * @param[in]  next     Query string of the next page, NULL on the last page
+ * @param[in]  version  Data version read before the statements ran (0 if the reply is not cached)
+ * @param[in]  level    Compression level of the endpoint (0 to never compress)
+ * @param[in]  format   Format of the rows
+ */
+static void db_export_start(db_plugin_t *plugin, struct mg_connection *nc, const struct http_message *hm,
+                            db_export_t *export, const char *next, unsigned long long version, int level,
+                            DB_Format format);
+
+
+/**
+ * @brief      Answer a read from the cache: 304 Not Modified if the client has the current reply, else the cached one
+ *
+ * @param      plugin   The plugin context
+ * @param      nc       The non-client
+ * @param[in]  hm       The HTTP message
+ * @param[in]  level    Compression level of the endpoint (0 to never compress)
+ * @param[in]  format   Format of the rows
+ * @param[out] version  The current data version (0 on error)
+ *
+ * @return     1 if the read is answered, 0 if it has to run
+ */
+static int db_cache_reply(db_plugin_t *plugin, struct mg_connection *nc, const struct http_message *hm, int level,
+                          DB_Format format, unsigned long long *version);
+
+
+/**
+ * @brief      Write the key of a read: its path, then the parameters that change its reply, in a fixed order
+ *
+ * @param[in]  hm        The HTTP message
+ * @param[in]  encoding  The encoding accepted by the client, a compressed reply is another entry
+ * @param[in]  format    Format of the rows, another entry too
+ * @param[out] key       The key
+ * @param[in]  size      Size of key
+ *
+ * @return     Length of the key, 0 if it does not fit
+ */
+static size_t db_cache_key(const struct http_message *hm, gzip_encoding_t encoding, DB_Format format, char *key,
+                           size_t size);
+
+
+/**
+ * @brief      Write the entity tag of a reply: the data version and a hash of the key
+ *
+ * @param[out] etag     The tag, quoted (NUL-terminated)
+ * @param[in]  size     Size of etag
+ * @param[in]  version  The data version
+ * @param[in]  key      The key
+ * @param[in]  key_len  Length of the key
+ */
+static void db_cache_etag(char *etag, size_t size, unsigned long long version, const char *key, size_t key_len);
+
+
+/**
+ * @brief      Free a read and give its statement back to its cache
+ *
+ * @param      export  The read (already unlinked)
+ */
+static void db_export_free(db_export_t *export);
+
+
+/**
+ * @brief      Send the reply of a frame received through op_set
+ *
+ * @param      nc             The non-client
+ * @param[in]  raws           The raws structure
+ * @param[in]  downlink_data  The downlink payload answered if the frame requires an acknowledge
+ * @param[in]  result         The result of the insertion
+ * @param      plugin         The plugin context
+ */
+static void send_set_reply(struct mg_connection *nc, const sigfox_raws_t *raws, const char *downlink_data, int result,
+                           db_plugin_t *plugin);
+
+
+/**
+ * @brief      Send the per-frame status array of a POST /api/batch request
+ *
+ * @param      nc       The non-client
+ * @param[in]  pending  The batch operation
+ * @param      plugin   The plugin context
+ */
+static void send_batch_reply(struct mg_connection *nc, const db_pending_t *pending, db_plugin_t *plugin);
+
+
+/**
+ * @brief      Choose the downlink payload answered to a frame that requires an acknowledge
+ *
+ * The first payload queued for the device is taken, then its default payload, and the payload is computed from the
+ * frame when there is none.
+ *
+ * @param      plugin         The plugin context
+ * @param[in]  raws           The raws structure
+ * @param[in]  pop            0 if the frame is a copy, which does not take a queued payload
+ * @param[out] downlink_data  The downlink payload (string)
+ *
+ * @return     Identifier of the queued payload taken, 0 if none was
+ */
+static sqlite3_int64 downlink_next(db_plugin_t *plugin, const sigfox_raws_t *raws, int pop, char downlink_data[SIGFOX_DOWNLINK_DATA_LENGTH + 1]);
+
+
+/**
+ * @brief      Put back the queued payloads taken by an operation that could not be queued
+ *
+ * @param      plugin   The plugin context
+ * @param[in]  pending  The operation
+ */
+static void downlink_restore(db_plugin_t *plugin, const db_pending_t *pending);
+
+
+/**
+ * @brief      Queue a payload for the next frames of its device once its insertion is committed
+ *
+ * @param      plugin   The plugin context
+ * @param[in]  pending  The operation (completed)
+ */
+static void downlink_commit(db_plugin_t *plugin, const db_pending_t *pending);
+
+
+/**
+ * @brief      Load the downlinks not delivered yet into the in-memory queues
+ *
+ * @param      plugin  The plugin context
+ *
+ * @return     0 on success, -1 on error
+ */
+static int downlink_load(db_plugin_t *plugin);
+
+
+/**
+ * @brief      Rebuild the statistics of the devices from the stored frames
+ *
+ * @param      plugin  The plugin context
+ *
+ * @return     0 on success, -1 on error
+ */
+static int devstats_load(db_plugin_t *plugin);
+
+
+/**
+ * @brief      Count the frames of a committed operation in the statistics of their devices
+ *
+ * Called on the event loop once the operation is committed, the statistics are emptied by a successful API_OP_DEL.
+ *
+ * @param      plugin   The plugin context
+ * @param[in]  pending  The operation
+ */
+static void devstats_count(db_plugin_t *plugin, const db_pending_t *pending);
+
+
+/**
+ * @brief      Send the statistics of a device, or of every device, without reading the database
+ *
+ * @param      nc        The non-client
+ * @param[in]  id_modem  The device identifier, NULL for every device
+ * @param      plugin    The plugin context
+ */
+static void op_devstats(struct mg_connection *nc, const unsigned char *id_modem, db_plugin_t *plugin);
+
+
+/**
+ * @brief      Render the statistics of a device as a JSON object
+ *
+ * @param      w      The writer
+ * @param[in]  entry  The statistics of the device
+ */
+static void devstats_json(jsonw_t *w, const devstats_entry_t *entry);
+
+
+/**
+ * @brief      Render the counters, the SNR, the RSSI and avg_signal of statistics as JSON members
+ *
+ * @param      w      The writer
+ * @param[in]  entry  The statistics (of a device, or of a bucket of its rollups)
+ */
+static void stats_json(jsonw_t *w, const devstats_entry_t *entry);
+
+
+/**
+ * @brief      Send the rollups of a device over a range of buckets (?granularity=, ?from=, ?to= and ?limit=)
+ *
+ * @param      nc        The non-client
+ * @param[in]  hm        The HTTP message
+ * @param[in]  id_modem  The device identifier
+ * @param      plugin    The plugin context
+ */
+static void op_rollups(struct mg_connection *nc, const struct http_message *hm, const unsigned char *id_modem,
+                       db_plugin_t *plugin);
+
+
+/**
+ * @brief      Upsert the accumulators of a table of rollups, then clear it
+ *
+ * Called on the write connection, in the transaction of the frames the accumulators come from.
+ *
+ * @param      plugin  The plugin context
+ * @param      table   The accumulators
+ *
+ * @return     SQLITE_DONE on success, the failing sqlite3_step result otherwise
+ */
+static int db_rollup_flush(db_plugin_t *plugin, rollup_t *table);
+
+
+/**
+ * @brief      Thread of db_backfill: rebuilds the rollups of ranges of messages until there is none left
+ *
+ * @param      arg   The db_backfill_t shared by the threads
+ *
+ * @return     NULL
+ */
+static void* db_backfill_worker(void *arg);
+
+
+/**
+ * @brief      Send the rows rendered by a writer as one HTTP chunk (jsonw_flush_t)
+ *
+ * @param      nc    The non-client
+ * @param[in]  buf   The rows
+ * @param[in]  len   Length of the rows
+ */
+static void send_http_chunk(void *nc, const char *buf, size_t len);
+
+
+/**
+ * @brief      Mark a queued downlink as delivered using the cached DELIVER_DOWNLINK statement
+ *
+ * @param      plugin  The plugin context
+ * @param[in]  id      Identifier of the downlink
+ *
+ * @return     The result of sqlite3_step (SQLITE_DONE on success)
+ */
+static int db_deliver_downlink(db_plugin_t *plugin, sqlite3_int64 id);
+
+
+/**
+ * @brief      Compute the downlink payload answered to a frame that requires an acknowledge
+ *
+ * @param[in]  raws           The raws structure
+ * @param[out] downlink_data  The downlink payload (string)
+ */
+static void downlink_from_raws(const sigfox_raws_t *raws, char downlink_data[SIGFOX_DOWNLINK_DATA_LENGTH + 1]);
+
+
+/**
+ * @brief      Send the reply of a write operation once it has been committed
+ *
+ * @param      nc       The non-client
+ * @param[in]  pending  The operation
+ * @param      plugin   The plugin context
+ */
+static void send_pending_reply(struct mg_connection *nc, const db_pending_t *pending, db_plugin_t *plugin);
+
+
+/**
+ * @brief      Format a chunk of the reply in the arena and send it
+ *
+ * The string only lives until it is copied into the send buffer, so its memory is given back to the arena right away.
+ *
+ * @param      plugin  The plugin context
+ * @param      nc      The non-client
+ * @param[in]  fmt     The format
+ * @param[in]  ...     The arguments
+ */
+static void db_printf_chunk(db_plugin_t *plugin, struct mg_connection *nc, const char *fmt, ...)
+__attribute__( (format(printf, 3, 4) ) );
+
+
+/**
+ * @brief      Handle a request (see db_op)
+ *
+ * @param      nc      The non-client
+ * @param[in]  hm      The HTTP message
+ * @param[in]  key     The key
+ * @param      plugin  The plugin context
+ * @param[in]  op      The operation
+ */
+static void db_dispatch(struct mg_connection *nc, const struct http_message *hm, const struct mg_str *key,
+                        db_plugin_t *plugin, int op);
+
+
+/**
+ * @brief      Run a write operation on the event loop, or hand it to the writer thread when it is started
+ *
+ * @param      plugin   The plugin context
+ * @param      nc       The non-client, NULL if the operation is not answered (only when the writer thread is started)
+ * @param      pending  The operation
+ *
+ * @return     0 on success, -1 if the queue of the writer thread is full
+ */
+static int db_write(db_plugin_t *plugin, struct mg_connection *nc, db_pending_t *pending);
+
+
+/**
+ * @brief      Run one write operation on the write connection
+ *
+ * @param      plugin   The plugin context
+ * @param      pending  The operation, its result is filled
+ */
+static void db_run_pending(db_plugin_t *plugin, db_pending_t *pending);
+
+
+/**
+ * @brief      Open the savepoint of one write operation (or of one frame of a batch)
+ *
+ * @param      plugin  The plugin context
+ *
+ * @return     SQLITE_DONE on success, the error otherwise
+ */
+static int db_op_begin(db_plugin_t *plugin);
+
+
+/**
+ * @brief      Close the savepoint of one write operation, undoing its writes if it failed
+ *
+ * The transaction of the batch goes on with the other operations, a failed one leaves nothing in it.
+ *
+ * @param      plugin  The plugin context
+ * @param[in]  result  Result of the operation
+ *
+ * @return     result, or the error of the savepoint
+ */
+static int db_op_end(db_plugin_t *plugin, int result);
+
+
+/**
+ * @brief      Writer thread: commits the queued operations by batches and broadcasts their completions
+ *
+ * @param      arg   The plugin context
+ *
+ * @return     NULL
+ */
+static void* db_writer(void *arg);
+
+
+/**
+ * @brief      Pop the next operation of the writer thread, the frames that require an acknowledge first
+ *
+ * Up to DB_ACK_WEIGHT of them are served for one other write, so the other writes are not starved.
+ *
+ * @param      plugin   The plugin context
+ * @param[out] pending  The operation
+ * @param      acks     Number of frames that require an acknowledge served in a row
+ *
+ * @return     0 on success, -1 if both queues are empty
+ */
+static int db_writer_pop(db_plugin_t *plugin, db_pending_t *pending, unsigned int *acks);
+
+
+/**
+ * @brief      Mongoose broadcast handler answering the operations committed by the writer thread
+ *
+ * Called on the event loop for each connection: the first call answers every completion whose connection is still
+ * open, releases the batches and empties the message, so the other calls have nothing left to do.
+ *
+ * @param      nc       The non-client
+ * @param[in]  ev       The event (MG_EV_POLL)
+ * @param      ev_data  The db_completions_t message
+ */
+static void db_completions_handler(struct mg_connection *nc, int ev, void *ev_data);
+
+
+/**
+ * @brief Maximum number of completions sent in one mg_broadcast message (it has to fit in 8 kB)
+ */
+#define DB_COMPLETIONS_MAX      32
+
+
+/**
+ * @brief Number of messages of a range rebuilt at once by a thread of db_backfill
+ */
+#define DB_BACKFILL_RANGE       16384
+
+
+/**
+ * @typedef db_backfill_t
+ */
+typedef struct db_backfill_s db_backfill_t;
+
+
+/**
+ * @struct     db_backfill_s
+ * @brief      Rebuild of the rollups, shared by its threads
+ */
+struct db_backfill_s {
+    db_plugin_t *plugin;          ///< The plugin context
+    const char *path;          ///< Path of the database, opened by each thread
+    pthread_mutex_t lock;          ///< Serializes the ranges taken and the write connection
+    sqlite3_int64 next;          ///< First message of the next range
+    sqlite3_int64 last;          ///< Last message
+    unsigned long long rows;          ///< Receptions read
+    int result;          ///< 0, or -1 once a thread failed
+};
+
+
+/**
+ * @typedef db_completions_t
+ */
+typedef struct db_completions_s db_completions_t;
+
+
+/**
+ * @struct     db_completions_s
+ * @brief      Message broadcast by the writer thread to the event loop
+ */
+struct db_completions_s {
+    db_plugin_t *plugin;          ///< The plugin context
+    unsigned int count;          ///< Number of completions
+    db_pending_t items[DB_COMPLETIONS_MAX];          ///< The committed operations
+};
+
+
+/**
+ * @brief Number of frames that require an acknowledge written for one other write when both are waiting
+ */
+#define DB_ACK_WEIGHT           4
+
+
+/**
+ * @brief Maximum number of rows sent in one slice of a read
+ */
+#define DB_EXPORT_SLICE         128
+
+
+/**
+ * @brief Size of the send buffer from which a read waits for its client (in bytes)
+ */
+#define DB_EXPORT_BUFFER        (64 * 1024)
+
+
+/**
+ * @brief Time a read waits for its client to read the previous slices before it is dropped (in seconds)
+ */
+#define DB_EXPORT_IDLE          30
+
+
+/**
+ * @brief Size of the buffer the rows of a read are rendered into, sent as one HTTP chunk each time it is full
+ */
+#define DB_EXPORT_CHUNK         (16 * 1024)
+
+
+/**
+ * @brief Size of the buffer the statistics of the devices are rendered into, sent as one HTTP chunk each time it is full
+ */
+#define DB_DEVSTATS_CHUNK       (4 * 1024)
+
+
+/**
+ * @brief Maximum bytes of the cached replies
+ */
+#define DB_CACHE_BYTES          (8 * 1024 * 1024)
+
+
+/**
+ * @brief Maximum number of cached replies
+ */
+#define DB_CACHE_ENTRIES        64
+
+
+/**
+ * @brief Maximum size of a cached reply, the larger reads are only streamed
+ */
+#define DB_CACHE_REPLY_MAX      (1024 * 1024)
+
+
+/**
+ * @brief Maximum length of the key of a cached reply (the path and the parameters of the read)
+ */
+#define DB_CACHE_KEY            256
+
+
+/**
+ * @brief Size of the extra header lines of a read (the Content-Type, Link, Vary and Content-Encoding headers)
+ */
+#define DB_EXPORT_HEADERS       384
+
+
+/**
+ * @brief Room kept in the extra header lines for Vary and Content-Encoding, a longer Link header is dropped
+ */
+#define DB_EXPORT_ENCODING      64
+
+
+/**
+ * @brief Size from which the reply of a read is compressed, a smaller one is sent as it is
+ */
+#define DB_GZIP_MIN_SIZE        1024
+
+
+/**
+ * @brief Compression level of the GET /api pages (the whole table, favors speed)
+ */
+#define DB_GZIP_LEVEL_PAGES     1
+
+
+/**
+ * @brief Compression level of the frames of a device or of a station (smaller replies, cached more often)
+ */
+#define DB_GZIP_LEVEL_FRAMES    6
+
+
+/**
+ * @brief Number of messages of a GET /api page when ?limit= is not given
+ */
+#define DB_PAGE_LIMIT           1000
+
+
+/**
+ * @brief Largest ?limit= of a GET /api page or of the frames of a device or of a station
+ */
+#define DB_PAGE_LIMIT_MAX       100000
+
+
+/**
+ * @brief Largest ?limit= of a page of rollups, read on the event loop rather than streamed
+ */
+#define DB_ROLLUP_LIMIT_MAX     10000
+
+
+/**
+ * @brief Name (of ?format=), media type (of Accept) and Content-Type of each DB_Format
+ */
+static const char * const   s_formats[][3] =
+{
+    {"json", "application/json", "application/json"},
+    {"ndjson", "application/x-ndjson", "application/x-ndjson"},
+    {"csv", "text/csv", "text/csv; charset=utf-8; header=present"},
+    {"cbor", "application/cbor", "application/cbor"}
+};
+
+
+/**
+ * @struct     db_export_s
+ * @brief      A read streamed a slice at a time, between the turns of the event loop
+ */
+struct db_export_s {
+    db_export_t *next;          ///< Next read
+    struct mg_connection *nc;          ///< Connection the rows are sent to
+    sqlite3_stmt *stmt;          ///< SELECT_FRAMES (or of a filter) statement, owned by the read
+    sqlite3_stmt **cache;          ///< Where the statement is given back once the read is done
+    int result;          ///< Result of the last step
+    int merged;          ///< 1 for one object per message
+    DB_Format format;          ///< Format of the rows
+    sqlite3_int64 previous;          ///< id_raws of the last row sent, -1 before the first one
+    sqlite3_int64 previous_time;          ///< Timestamp of the last row sent
+    int resume_id;          ///< Parameter the read restarts after previous from, between two slices
+    int resume_time;          ///< Parameter the read restarts after previous_time from, 0 if it is ordered by id_raws
+    int paused;          ///< 1 once the statement is reset between two slices
+    time_t active;          ///< Time the last slice was sent
+    jsonw_t writer;          ///< Renders the rows into chunk
+    char chunk[DB_EXPORT_CHUNK];          ///< The rows not sent yet
+    unsigned long long version;          ///< Data version the read started at
+    char key[DB_CACHE_KEY];          ///< Key of the reply in the cache
+    size_t key_len;          ///< Length of the key, 0 when the reply is not cached
+    char headers[DB_EXPORT_HEADERS];          ///< Extra header lines of the reply
+    size_t headers_len;          ///< Length of the extra header lines
+    gzip_encoding_t encoding;          ///< Encoding accepted by the client, GZIP_IDENTITY if the endpoint does not compress
+    int level;          ///< Compression level of the endpoint
+    gzip_stream_t *gzip;          ///< Compresses the body, NULL if it is sent as it is
+    int started;          ///< Set once the header is sent
+    char etag[48];          ///< Entity tag of the reply, empty if it is not cached
+    char *copy;          ///< The body sent so far, stored in the cache at the end of the read
+    size_t copy_len;          ///< Length of the body sent so far
+    size_t copy_size;          ///< Allocated size of copy
+};
+
+
+/**
+ * @brief Content-Type of the callbacks that send their fields url-encoded
+ */
+#define DB_FORM_CONTENT_TYPE    "application/x-www-form-urlencoded"
+
+
+/**
+ * @brief Time after which a request refused with 503 can be sent again (in seconds)
+ */
+#define DB_RETRY_AFTER          "1"
+
+
+/**
+ * @brief Size of the arena of the requests (the replies are formatted a chunk at a time)
+ */
+#define DB_ARENA_SIZE           (16 * 1024)
+
+
+/**
+ * @brief Number of JSON tokens first allocated to parse a body (doubled until they are enough)
+ */
+#define DB_JSON_TOKENS          16
+
+
+#ifdef __DEBUG__
+    #define MG_PRINTF_200 \
+    mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n"); gprintf("200 OK\n");
+    #define MG_PRINTF_201 \
+    mg_printf(nc, "HTTP/1.1 201 Created\r\nContent-Length: 0\r\n\r\n"); gprintf("201 Created\n");
+    #define MG_PRINTF_204 \
+    mg_printf(nc, "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n"); gprintf("204 No Content\n");
+    #define MG_PRINTF_400 \
+    mg_printf(nc, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n"); eprintf("400 Bad Request\n");
+    #define MG_PRINTF_404 \
+    mg_printf(nc, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n"); eprintf("404 Not Found\n");
+    #define MG_PRINTF_500 \
+    mg_printf(nc, "HTTP/1.1 500 Server Error\r\nContent-Length: 0\r\n\r\n"); eprintf("500 Server Error\n");
+    #define MG_PRINTF_501 \
+    mg_printf(nc, "HTTP/1.1 501 Not Implemented\r\nContent-Length: 0\r\n\r\n"); eprintf("501 Not Implemented\n");
+    #define MG_PRINTF_503 \
+    mg_printf(nc, "HTTP/1.1 503 Service Unavailable\r\nRetry-After: " DB_RETRY_AFTER "\r\nConnection: close\r\n" \
+              "Content-Length: 0\r\n\r\n"); \
+    nc->flags |= MG_F_SEND_AND_CLOSE; eprintf("503 Service Unavailable\n");
+#else
+    #define MG_PRINTF_200   mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+    #define MG_PRINTF_201   mg_printf(nc, "HTTP/1.1 201 Created\r\nContent-Length: 0\r\n\r\n");
+    #define MG_PRINTF_204   mg_printf(nc, "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n");
+    #define MG_PRINTF_400   mg_printf(nc, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n");
+    #define MG_PRINTF_404   mg_printf(nc, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+    #define MG_PRINTF_500   mg_printf(nc, "HTTP/1.1 500 Server Error\r\nContent-Length: 0\r\n\r\n");
+    #define MG_PRINTF_501   mg_printf(nc, "HTTP/1.1 501 Not Implemented\r\nContent-Length: 0\r\n\r\n");
+    #define MG_PRINTF_503 \
+    mg_printf(nc, "HTTP/1.1 503 Service Unavailable\r\nRetry-After: " DB_RETRY_AFTER "\r\nConnection: close\r\n" \
+              "Content-Length: 0\r\n\r\n"); \
+    nc->flags |= MG_F_SEND_AND_CLOSE;
+#endif
+
+
+db_plugin_t* db_open(const char *db_path)
+{
+    db_plugin_t     *plugin = NULL;
+    const int       flags   = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+
+
+    plugin = calloc(1, sizeof(*plugin) );
+
+    if ( ! plugin )
+    {
+        return (NULL);
+    }
+
+    cache_init(&plugin->cache, DB_CACHE_BYTES, DB_CACHE_ENTRIES);
+
+    if ( arena_init(&plugin->arena, DB_ARENA_SIZE) )
+    {
+        db_close( (void **) &plugin);
+
+        return (NULL);
+    }
+
+    if ( sqlite3_open_v2(db_path, &plugin->db, flags, NULL) != SQLITE_OK )
+    {
+        eprintf("%s\n", sqlite3_errmsg(plugin->db) );
+        db_close( (void **) &plugin);
+
+        return (NULL);
+    }
+
+
+    // WAL lets the event loop read while the writer thread commits
+    sqlite3_exec(plugin->db, "PRAGMA journal_mode=WAL;", 0, 0, 0);
+
+    sqlite3_exec(plugin->db, CREATE_SIGFOX_TABLES, 0, 0, 0);
+
+    if ( sqlite3_open_v2(db_path, &plugin->db_read, flags, NULL) != SQLITE_OK )
+    {
+        eprintf("%s\n", sqlite3_errmsg(plugin->db_read) );
+        db_close( (void **) &plugin);
+
+        return (NULL);
+    }
+
+    sqlite3_busy_timeout(plugin->db_read, 1000);
+
+
+    // Prepare the statements once, they are reset after each use
+    if ( (sqlite3_prepare_v2(plugin->db, INSERT_RAWS, -1, &plugin->insert_raws, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db_read, SELECT_FRAMES, -1, &plugin->select_frames, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db_read, SELECT_PAGE_LAST, -1, &plugin->select_page_last, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db_read, SELECT_PAGE_FIRST, -1, &plugin->select_page_first, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db_read, SELECT_DEVICE_FRAMES, -1, &plugin->select_device_frames, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db_read, SELECT_DEVICE_PAGE, -1, &plugin->select_device_page, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db_read, SELECT_STATION_FRAMES, -1, &plugin->select_station_frames, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db_read, SELECT_STATION_PAGE, -1, &plugin->select_station_page, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db_read, SELECT_DATA_VERSION, -1, &plugin->data_version, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, DELETE_RAWS, -1, &plugin->delete_raws, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, DELETE_RECEPTIONS, -1, &plugin->delete_receptions, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, INSERT_DEVICES, -1, &plugin->insert_devices, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, SELECT_MESSAGE, -1, &plugin->select_message, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, INSERT_RECEPTIONS, -1, &plugin->insert_receptions, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, FLAG_DUPLICATE, -1, &plugin->flag_duplicate, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, INSERT_DOWNLINKS, -1, &plugin->insert_downlinks, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, DELIVER_DOWNLINK, -1, &plugin->deliver_downlink, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, UPSERT_ROLLUPS, -1, &plugin->upsert_rollups, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, DELETE_ROLLUPS, -1, &plugin->delete_rollups, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, SAVEPOINT_OP, -1, &plugin->savepoint_op, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, RELEASE_OP, -1, &plugin->release_op, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db, ROLLBACK_OP, -1, &plugin->rollback_op, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db_read, SELECT_ROLLUPS, -1, &plugin->select_rollups, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(plugin->db_read, SELECT_ROLLUPS_PAGE, -1, &plugin->select_rollups_page, NULL) != SQLITE_OK) )
+    {
+        eprintf("%s\n", sqlite3_errmsg(plugin->db) );
+        db_close( (void **) &plugin);
+
+        return (NULL);
+    }
+
+    plugin->downlinks = downlink_new(64);
+
+    if ( ! plugin->downlinks || downlink_load(plugin) )
+    {
+        db_close( (void **) &plugin);
+
+        return (NULL);
+    }
+
+    plugin->devstats    = devstats_new(64);
+    plugin->rollups     = rollup_new(64);
+
+    if ( ! plugin->devstats || ! plugin->rollups || devstats_load(plugin) )
+    {
+        db_close( (void **) &plugin);
+
+        return (NULL);
+    }
+
+    if ( db_group_commit(plugin, 1, 0) )
+    {
+        db_close( (void **) &plugin);
+
+        return (NULL);
+    }
+
+    return (plugin);
+}
+
+
+
+void db_close(void **db_handler)
+{
+    if ( (db_handler != NULL) && (*db_handler != NULL) )
+    {
+        db_plugin_t     *plugin = *db_handler;
+
+
+        if ( plugin->queue )
+        {
+            db_writer_stop(plugin);
+        }
+
+
+        // The statements of the reads have to be finalized before closing db_read
+        while ( plugin->exports )
+        {
+            db_export_t     *export = plugin->exports;
+
+
+            plugin->exports = export->next;
+            db_export_free(export);
+        }
+
+        // sqlite3_finalize is a no-op on NULL statements
+        sqlite3_finalize(plugin->insert_raws);
+        sqlite3_finalize(plugin->select_frames);
+        sqlite3_finalize(plugin->select_page_last);
+        sqlite3_finalize(plugin->select_page_first);
+        sqlite3_finalize(plugin->select_device_frames);
+        sqlite3_finalize(plugin->select_device_page);
+        sqlite3_finalize(plugin->select_station_frames);
+        sqlite3_finalize(plugin->select_station_page);
+        sqlite3_finalize(plugin->data_version);
+        sqlite3_finalize(plugin->delete_raws);
+        sqlite3_finalize(plugin->delete_receptions);
+        sqlite3_finalize(plugin->insert_devices);
+        sqlite3_finalize(plugin->select_message);
+        sqlite3_finalize(plugin->insert_receptions);
+        sqlite3_finalize(plugin->flag_duplicate);
+        sqlite3_finalize(plugin->insert_downlinks);
+        sqlite3_finalize(plugin->deliver_downlink);
+        sqlite3_finalize(plugin->upsert_rollups);
+        sqlite3_finalize(plugin->delete_rollups);
+        sqlite3_finalize(plugin->savepoint_op);
+        sqlite3_finalize(plugin->release_op);
+        sqlite3_finalize(plugin->rollback_op);
+        sqlite3_finalize(plugin->select_rollups);
+        sqlite3_finalize(plugin->select_rollups_page);
+        sqlite3_close(plugin->db_read);
+        sqlite3_close(plugin->db);
+        free(plugin->pending);
+        dedup_free(plugin->dedup);
+        downlink_free(plugin->downlinks);
+        devstats_free(plugin->devstats);
+        rollup_free(plugin->rollups);
+        arena_destroy(&plugin->arena);
+        cache_destroy(&plugin->cache);
+        free(plugin);
+        *db_handler = NULL;
+    }
+}
+
+
+
+int db_insert_raws(db_plugin_t          *plugin,
+                   const sigfox_raws_t  *raws
+                   )
+{
+    sqlite3_stmt        *stmt   = plugin->insert_raws;
+    int                 result  = 0;
+
+
+    sqlite3_bind_int64(stmt, SQL_IDX_TIMESTAMP, raws->timestamp);
+    sqlite3_bind_text(stmt,
+                      SQL_IDX_ID_MODEM,
+                      (const char *) raws->id_modem,
+                      strlen( (const char *) raws->id_modem),
+                      SQLITE_STATIC);
+    sqlite3_bind_double(stmt, SQL_IDX_SNR, raws->snr);
+    sqlite3_bind_text(stmt,
+                      SQL_IDX_STATION,
+                      (const char *) raws->station,
+                      strlen( (const char *) raws->station),
+                      SQLITE_STATIC);
+    sqlite3_bind_int(stmt, SQL_IDX_ACK, raws->ack);
+    sqlite3_bind_text(stmt,
+                      SQL_IDX_DATA_STR,
+                      (const char *) raws->data_str,
+                      strlen( (const char *) raws->data_str),
+                      SQLITE_STATIC);
+    sqlite3_bind_blob(stmt, SQL_IDX_DATA_HEX, (void *) raws->data_hex, sizeof(raws->data_hex), SQLITE_STATIC);
+    sqlite3_bind_int(stmt, SQL_IDX_DUPLICATE, raws->duplicate);
+    sqlite3_bind_double(stmt, SQL_IDX_AVG_SIGNAL, raws->avg_signal);
+    sqlite3_bind_double(stmt, SQL_IDX_RSSI, raws->rssi);
+    sqlite3_bind_int(stmt, SQL_IDX_LATITUDE, raws->latitude);
+    sqlite3_bind_int(stmt, SQL_IDX_LONGITUDE, raws->longitude);
+    sqlite3_bind_int(stmt, SQL_IDX_SEQ_NUMBER, raws->seq_number);
+    result = sqlite3_step(stmt);
+
+
+    // The bindings are SQLITE_STATIC, so they must not outlive the raws structure
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    return (result);
+}
+
+
+
+int db_insert_frame(db_plugin_t         *plugin,
+                    const sigfox_raws_t *raws,
+                    unsigned char       *message
+                    )
+{
+    sqlite3_stmt        *stmt       = plugin->select_message;
+    sqlite3_int64       id_raws     = 0;
+    int                 result      = 0;
+
+
+    // The writer thread is the only writer, so the message cannot be inserted between the lookup and the insertion
+    sqlite3_bind_text(stmt, 1, (const char *) raws->id_modem, strlen( (const char *) raws->id_modem), SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, raws->seq_number);
+    sqlite3_bind_int64(stmt, 3, raws->timestamp);
+    result = sqlite3_step(stmt);
+
+    if ( result == SQLITE_ROW )
+    {
+        id_raws = sqlite3_column_int64(stmt, 0);
+    }
+
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    if ( (result != SQLITE_ROW) && (result != SQLITE_DONE) )
+    {
+        return (result);
+    }
+
+    if ( message )
+    {
+        *message = (result == SQLITE_DONE);
+    }
+
+    if ( result == SQLITE_DONE )
+    {
+        result = db_insert_raws(plugin, raws);
+
+        if ( result != SQLITE_DONE )
+        {
+            return (result);
+        }
+
+        id_raws = sqlite3_last_insert_rowid(plugin->db);
+    }
+    else if ( raws->duplicate )
+    {
+        stmt = plugin->flag_duplicate;
+        sqlite3_bind_int64(stmt, 1, id_raws);
+        result = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+
+        if ( result != SQLITE_DONE )
+        {
+            return (result);
+        }
+    }
+
+    stmt = plugin->insert_receptions;
+    sqlite3_bind_int64(stmt, 1, id_raws);
+    sqlite3_bind_text(stmt, 2, (const char *) raws->station, strlen( (const char *) raws->station), SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 3, raws->snr);
+    sqlite3_bind_double(stmt, 4, raws->rssi);
+    sqlite3_bind_int(stmt, 5, raws->latitude);
+    sqlite3_bind_int(stmt, 6, raws->longitude);
+    sqlite3_bind_int64(stmt, 7, raws->timestamp);
+    result = sqlite3_step(stmt);
+
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    return (result);
+}
+
+
+
+int db_insert_device(db_plugin_t            *plugin,
+                     const sigfox_device_t  *device
+                     )
+{
+    sqlite3_stmt        *stmt   = plugin->insert_devices;
+    const unsigned char     *end    = memchr(device->id_modem, '\0', SIGFOX_DEVICE_LENGTH);
+    int                 result  = 0;
+
+
+    // id_modem is not NUL-terminated when it uses all of its SIGFOX_DEVICE_LENGTH characters
+    sqlite3_bind_text(stmt,
+                      1,
+                      (const char *) device->id_modem,
+                      (end) ? end - device->id_modem : SIGFOX_DEVICE_LENGTH,
+                      SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, device->attribution);
+    sqlite3_bind_int(stmt, 3, device->timestamp_attribution);
+    result = sqlite3_step(stmt);
+
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    return (result);
+}
+
+
+
+int db_group_commit(db_plugin_t     *plugin,
+                    unsigned int    batch_size,
+                    unsigned int    batch_wait
+                    )
+{
+    db_pending_t     *pending = NULL;
+
+
+    if ( (batch_size == 0) || plugin->queue )
+    {
+        return (-1);
+    }
+
+    pending = calloc(batch_size, sizeof(*pending) );
+
+    if ( ! pending )
+    {
+        return (-1);
+    }
+
+    free(plugin->pending);
+    plugin->pending     = pending;
+    plugin->batch_size  = batch_size;
+    plugin->batch_wait  = batch_wait;
+
+    return (0);
+}
+
+
+
+int db_backfill(db_plugin_t         *plugin,
+                unsigned int        threads,
+                unsigned long long  *rows
+                )
+{
+    db_backfill_t       backfill;
+    pthread_t           *workers    = NULL;
+    sqlite3_stmt        *stmt       = NULL;
+    unsigned int        started     = 0;
+    unsigned int        i           = 0;
+
+
+    if ( plugin->queue )
+    {
+        return (-1);
+    }
+
+    if ( threads == 0 )
+    {
+        threads = (sysconf(_SC_NPROCESSORS_ONLN) > 0) ? (unsigned int) sysconf(_SC_NPROCESSORS_ONLN) : 1;
+    }
+
+    memset(&backfill, 0, sizeof(backfill) );
+    backfill.plugin = plugin;
+    backfill.path   = sqlite3_db_filename(plugin->db, "main");
+
+    if ( sqlite3_prepare_v2(plugin->db, SELECT_RAWS_BOUNDS, -1, &stmt, NULL) != SQLITE_OK )
+    {
+        eprintf("%s\n", sqlite3_errmsg(plugin->db) );
+
+        return (-1);
+    }
+
+    if ( sqlite3_step(stmt) == SQLITE_ROW )
+    {
+        backfill.next   = sqlite3_column_int64(stmt, 0);
+        backfill.last   = sqlite3_column_int64(stmt, 1);
+    }
+
+    sqlite3_finalize(stmt);
+
+    workers = calloc(threads, sizeof(pthread_t) );
+
+    if ( ! workers || pthread_mutex_init(&backfill.lock, NULL) )
+    {
+        free(workers);
+
+        return (-1);
+    }
+
+
+    // The rollups are replaced in one transaction, the readers keep the old ones until it is committed
+    sqlite3_exec(plugin->db, "BEGIN IMMEDIATE;", 0, 0, 0);
+    rollup_clear(plugin->rollups);
+    backfill.result = (sqlite3_step(plugin->delete_rollups) == SQLITE_DONE) ? 0 : -1;
+    sqlite3_reset(plugin->delete_rollups);
+
+    for ( started = 0; (started < threads) && (backfill.result == 0); ++started )
+    {
+        if ( pthread_create(&workers[started], NULL, db_backfill_worker, &backfill) )
+        {
+            backfill.result = -1;
+            break;
+        }
+    }
+
+    for ( i = 0; i < started; ++i )
+    {
+        pthread_join(workers[i], NULL);
+    }
+
+    if ( (backfill.result == 0) && (sqlite3_exec(plugin->db, "COMMIT;", 0, 0, 0) != SQLITE_OK) )
+    {
+        eprintf("%s\n", sqlite3_errmsg(plugin->db) );
+        backfill.result = -1;
+    }
+
+    if ( backfill.result )
+    {
+        sqlite3_exec(plugin->db, "ROLLBACK;", 0, 0, 0);
+    }
+
+    pthread_mutex_destroy(&backfill.lock);
+    free(workers);
+
+    if ( rows )
+    {
+        *rows = backfill.rows;
+    }
+
+    return (backfill.result);
+}
+
+
+
+int db_dedup(db_plugin_t    *plugin,
+             DB_Dedup       mode,
+             size_t         capacity,
+             unsigned int   window
+             )
+{
+    dedup_t     *dedup = NULL;
+
+
+    if ( (mode != DB_DEDUP_OFF) && ( (capacity == 0) || (window == 0) ) )
+    {
+        return (-1);
+    }
+
+    if ( mode != DB_DEDUP_OFF )
+    {
+        dedup = dedup_new(capacity, window);
+
+        if ( ! dedup )
+        {
+            return (-1);
+        }
+    }
+
+    dedup_free(plugin->dedup);
+    plugin->dedup       = dedup;
+    plugin->dedup_mode  = mode;
+
+    return (0);
+}
+
+
+
+static DB_Dedup dedup_frame(db_plugin_t     *plugin,
+                            sigfox_raws_t   *raws,
+                            unsigned char   *remembered
+                            )
+{
+    *remembered = 0;
+
+    if ( ! plugin->dedup )
+    {
+        return (DB_DEDUP_OFF);
+    }
+
+    if ( ! dedup_check(plugin->dedup, raws->id_modem, raws->seq_number, time(NULL) ) )
+    {
+        *remembered = 1;
+
+        return (DB_DEDUP_OFF);
+    }
+
+    if ( plugin->dedup_mode == DB_DEDUP_FLAG )
+    {
+        raws->duplicate = 1;
+
+        return (DB_DEDUP_OFF);
+    }
+
+    return (plugin->dedup_mode);
+}
+
+
+
+static void dedup_restore(db_plugin_t           *plugin,
+                          const db_pending_t    *pending
+                          )
+{
+    unsigned int     i = 0;
+
+
+    if ( (pending->op == API_OP_SET) && pending->remembered && (pending->result != SQLITE_DONE) )
+    {
+        dedup_forget(plugin->dedup, pending->raws.id_modem, pending->raws.seq_number);
+    }
+
+    for ( i = 0; (pending->op == API_OP_SET_BATCH) && (i < pending->batch_count); ++i )
+    {
+        const db_batch_item_t     *item = &pending->batch[i];
+
+
+        if ( item->remembered && ( (pending->result != SQLITE_DONE) || (item->result != SQLITE_DONE) ) )
+        {
+            dedup_forget(plugin->dedup, item->raws.id_modem, item->raws.seq_number);
+        }
+    }
+}
+
+
+
+int db_writer_start(db_plugin_t     *plugin,
+                    struct mg_mgr   *mgr,
+                    size_t          queue_size
+                    )
+{
+    if ( plugin->queue )
+    {
+        return (-1);
+    }
+
+    plugin->queue       = mpsc_queue_new(queue_size, sizeof(db_pending_t) );
+    plugin->queue_ack   = mpsc_queue_new(queue_size, sizeof(db_pending_t) );
+
+    if ( ! plugin->queue || ! plugin->queue_ack )
+    {
+        mpsc_queue_free(plugin->queue);
+        mpsc_queue_free(plugin->queue_ack);
+        plugin->queue       = NULL;
+        plugin->queue_ack   = NULL;
+
+        return (-1);
+    }
+
+    sem_init(&plugin->queue_sem, 0, 0);
+    atomic_store(&plugin->running, 1);
+    atomic_store(&plugin->stopped, 0);
+    plugin->mgr = mgr;
+
+    if ( pthread_create(&plugin->writer, NULL, db_writer, plugin) != 0 )
+    {
+        sem_destroy(&plugin->queue_sem);
+        mpsc_queue_free(plugin->queue);
+        mpsc_queue_free(plugin->queue_ack);
+        plugin->queue       = NULL;
+        plugin->queue_ack   = NULL;
+
+        return (-1);
+    }
+
+    return (0);
+}
+
+
+
+int db_admission(db_plugin_t    *plugin,
+                 unsigned int   high,
+                 unsigned int   low
+                 )
+{
+    size_t     capacity = 0;
+
+
+    if ( ! plugin->queue || (high > 100) || (low >= high) )
+    {
+        return (-1);
+    }
+
+    capacity                = mpsc_queue_capacity(plugin->queue);
+    plugin->high_watermark  = (capacity * high + 99) / 100;
+    plugin->low_watermark   = capacity * low / 100;
+
+    return (0);
+}
+
+
+
+static int db_admit(db_plugin_t             *plugin,
+                    struct mg_connection    *nc,
+                    DB_Admission            admission
+                    )
+{
+    size_t     depth = 0;
+
+
+    if ( ! plugin->high_watermark )
+    {
+        return (0);
+    }
+
+    depth = mpsc_queue_size(plugin->queue);
+
+
+    // Hysteresis, so the writes are not refused and accepted in turn around the high watermark
+    if ( depth >= plugin->high_watermark )
+    {
+        plugin->overloaded = 1;
+    }
+    else if ( depth <= plugin->low_watermark )
+    {
+        plugin->overloaded = 0;
+    }
+
+    if ( (admission == DB_ADMIT_QUERY) && (plugin->overloaded || (depth > plugin->low_watermark) ) )
+    {
+        plugin->shed_queries++;
+    }
+    else if ( (admission == DB_ADMIT_FRAME) && plugin->overloaded )
+    {
+        plugin->shed_frames++;
+    }
+    else
+    {
+        return (0);
+    }
+
+    if ( nc )
+    {
+        MG_PRINTF_503
+    }
+
+    return (-1);
+}
+
+
+
+void db_writer_stop(db_plugin_t *plugin)
+{
+    if ( ! plugin->queue )
+    {
+        return;
+    }
+
+    atomic_store(&plugin->running, 0);
+    sem_post(&plugin->queue_sem);
+
+
+    // mg_broadcast waits for the event loop, so keep it running until the writer is done
+    while ( ! atomic_load(&plugin->stopped) )
+    {
+        mg_mgr_poll(plugin->mgr, 10);
+    }
+
+    pthread_join(plugin->writer, NULL);
+    sem_destroy(&plugin->queue_sem);
+    mpsc_queue_free(plugin->queue);
+    mpsc_queue_free(plugin->queue_ack);
+    plugin->queue       = NULL;
+    plugin->queue_ack   = NULL;
+}
+
+
+
+static void db_run_pending(db_plugin_t  *plugin,
+                           db_pending_t *pending
+                           )
+{
+    unsigned int     i = 0;
+
+
+    if ( pending->op == API_OP_SET )
+    {
+        pending->result = db_op_begin(plugin);
+        pending->result = (pending->result == SQLITE_DONE) ?
+                          db_insert_frame(plugin, &pending->raws, &pending->message) : pending->result;
+
+
+        // The delivery is committed with the frame it was answered to
+        if ( (pending->result == SQLITE_DONE) && pending->downlink_id )
+        {
+            pending->result = db_deliver_downlink(plugin, pending->downlink_id);
+        }
+
+
+        // Last, the accumulators cannot be undone
+        if ( (pending->result == SQLITE_DONE) && rollup_add(plugin->rollups, &pending->raws, pending->message) )
+        {
+            pending->result = SQLITE_NOMEM;
+        }
+
+        pending->result = db_op_end(plugin, pending->result);
+    }
+    else if ( pending->op == API_OP_SET_BATCH )
+    {
+        // Each frame is answered on its own, so each one has its own savepoint
+        for ( i = 0; i < pending->batch_count; ++i )
+        {
+            db_batch_item_t     *item = &pending->batch[i];
+
+
+            // The dropped copies already hold SQLITE_DONE
+            if ( item->error || (item->dedup == DB_DEDUP_DROP) )
+            {
+                continue;
+            }
+
+            item->result = db_op_begin(plugin);
+            item->result = (item->result == SQLITE_DONE) ?
+                           db_insert_frame(plugin, &item->raws, &item->message) : item->result;
+
+            if ( (item->result == SQLITE_DONE) && item->downlink_id )
+            {
+                item->result = db_deliver_downlink(plugin, item->downlink_id);
+            }
+
+            if ( (item->result == SQLITE_DONE) && rollup_add(plugin->rollups, &item->raws, item->message) )
+            {
+                item->result = SQLITE_NOMEM;
+            }
+
+            item->result = db_op_end(plugin, item->result);
+        }
+
+        pending->result = SQLITE_DONE;
+    }
+    else if ( pending->op == API_OP_DOWNLINK )
+    {
+        sqlite3_bind_int64(plugin->insert_downlinks, 1, pending->downlink_id);
+        sqlite3_bind_text(plugin->insert_downlinks, 2, (const char *) pending->raws.id_modem, -1, SQLITE_STATIC);
+        sqlite3_bind_text(plugin->insert_downlinks, 3, pending->downlink_data, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(plugin->insert_downlinks, 4, time(NULL) );
+        pending->result = sqlite3_step(plugin->insert_downlinks);
+        sqlite3_reset(plugin->insert_downlinks);
+    }
+    else
+    {
+        pending->result = db_op_begin(plugin);
+
+        if ( pending->result == SQLITE_DONE )
+        {
+            pending->result = sqlite3_step(plugin->delete_receptions);
+            sqlite3_reset(plugin->delete_receptions);
+        }
+
+        if ( pending->result == SQLITE_DONE )
+        {
+            pending->result = sqlite3_step(plugin->delete_raws);
+            sqlite3_reset(plugin->delete_raws);
+        }
+
+        if ( pending->result == SQLITE_DONE )
+        {
+            pending->result = sqlite3_step(plugin->delete_rollups);
+            sqlite3_reset(plugin->delete_rollups);
+        }
+
+        pending->result = db_op_end(plugin, pending->result);
+
+
+        // The rollups accumulated before the deletion are of deleted frames too
+        if ( pending->result == SQLITE_DONE )
+        {
+            rollup_clear(plugin->rollups);
+        }
+    }
+}
+
+
+
+static int db_op_begin(db_plugin_t *plugin)
+{
+    int     result = sqlite3_step(plugin->savepoint_op);
+
+
+    sqlite3_reset(plugin->savepoint_op);
+
+    return (result);
+}
+
+
+
+static int db_op_end(db_plugin_t    *plugin,
+                     int            result
+                     )
+{
+    int     release = SQLITE_DONE;
+
+
+    // ROLLBACK TO keeps the savepoint open, it is released in both cases
+    if ( result != SQLITE_DONE )
+    {
+        sqlite3_step(plugin->rollback_op);
+        sqlite3_reset(plugin->rollback_op);
+    }
+
+    release = sqlite3_step(plugin->release_op);
+    sqlite3_reset(plugin->release_op);
+
+    return ( (result == SQLITE_DONE) ? release : result);
+}
+
+
+
+static void* db_backfill_worker(void *arg)
+{
+    db_backfill_t           *backfill   = arg;
+    sqlite3                 *db         = NULL;
+    sqlite3_stmt            *stmt       = NULL;
+    rollup_t                *table      = rollup_new(DB_BACKFILL_RANGE);
+    sqlite3_int64           first       = 0;
+    sqlite3_int64           id_raws     = 0;
+    sqlite3_int64           previous    = 0;
+    const unsigned char     *id_modem   = NULL;
+    unsigned long long      rows        = 0;
+    int                     result      = SQLITE_DONE;
+    int                     len         = 0;
+    int                     stop        = 0;
+    sigfox_raws_t           raws;
+
+
+    // A connection per thread, the reads of the ranges run in parallel
+    if ( ! table ||
+         (sqlite3_open_v2(backfill->path, &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK) ||
+         (sqlite3_prepare_v2(db, SELECT_ROLLUPS_BACKFILL, -1, &stmt, NULL) != SQLITE_OK) )
+    {
+        result = SQLITE_ERROR;
+    }
+
+    memset(&raws, 0, sizeof(raws) );
+
+    while ( result == SQLITE_DONE )
+    {
+        // Take the next range, none is left once another thread failed
+        pthread_mutex_lock(&backfill->lock);
+        first           = backfill->next;
+        backfill->next += DB_BACKFILL_RANGE;
+        stop            = (backfill->result != 0) || (first > backfill->last);
+        pthread_mutex_unlock(&backfill->lock);
+
+        if ( stop )
+        {
+            break;
+        }
+
+        sqlite3_bind_int64(stmt, 1, first);
+        sqlite3_bind_int64(stmt, 2, first + DB_BACKFILL_RANGE - 1);
+        previous = first - 1;
+
+        for ( result = sqlite3_step(stmt); result == SQLITE_ROW; result = sqlite3_step(stmt) )
+        {
+            id_raws     = sqlite3_column_int64(stmt, 0);
+            id_modem    = sqlite3_column_text(stmt, 1);
+            len         = sqlite3_column_bytes(stmt, 1);
+            len         = (len > SIGFOX_DEVICE_LENGTH) ? SIGFOX_DEVICE_LENGTH : len;
+            memcpy(raws.id_modem, id_modem, len);
+            raws.id_modem[len] = '\0';
+            raws.timestamp  = sqlite3_column_int64(stmt, 2);
+            raws.avg_signal = sqlite3_column_double(stmt, 3);
+            raws.snr        = sqlite3_column_double(stmt, 4);
+            raws.rssi       = sqlite3_column_double(stmt, 5);
+            rows++;
+
+
+            // The receptions of a message follow each other, the first one counts the message
+            if ( rollup_add(table, &raws, id_raws != previous) )
+            {
+                result = SQLITE_NOMEM;
+                break;
+            }
+
+            previous = id_raws;
+        }
+
+        sqlite3_reset(stmt);
+
+        if ( result == SQLITE_DONE )
+        {
+            pthread_mutex_lock(&backfill->lock);
+            result = db_rollup_flush(backfill->plugin, table);
+            pthread_mutex_unlock(&backfill->lock);
+        }
+    }
+
+    if ( result != SQLITE_DONE )
+    {
+        eprintf("Cannot rebuild the rollups: %s\n", sqlite3_errstr(result) );
+    }
+
+    pthread_mutex_lock(&backfill->lock);
+    backfill->rows     += rows;
+    backfill->result    = (result == SQLITE_DONE) ? backfill->result : -1;
+    pthread_mutex_unlock(&backfill->lock);
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    rollup_free(table);
+
+    return (NULL);
+}
+
+
+
+static void* db_writer(void *arg)
+{
+    db_plugin_t         *plugin     = arg;
+    db_completions_t    completions;
+    struct timespec     deadline;
+    unsigned int        count       = 0;
+    unsigned int        i           = 0;
+    unsigned int        acks        = 0;
+    int                 commit      = SQLITE_OK;
+
+
+    completions.plugin = plugin;
+
+    for ( ; ; )
+    {
+        // Wait for the first operation of the batch
+        if ( db_writer_pop(plugin, &plugin->pending[0], &acks) )
+        {
+            if ( ! atomic_load(&plugin->running) )
+            {
+                break;
+            }
+
+            sem_wait(&plugin->queue_sem);
+            continue;
+        }
+
+
+        // Gather the operations received within the window
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec     += plugin->batch_wait / 1000;
+        deadline.tv_nsec    += (plugin->batch_wait % 1000) * 1000000L;
+
+        if ( deadline.tv_nsec >= 1000000000L )
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        for ( count = 1; count < plugin->batch_size; )
+        {
+            if ( db_writer_pop(plugin, &plugin->pending[count], &acks) == 0 )
+            {
+                count++;
+            }
+            else if ( (plugin->batch_wait == 0) || ! atomic_load(&plugin->running) )
+            {
+                break;
+            }
+            else if ( (sem_timedwait(&plugin->queue_sem, &deadline) != 0) && (errno != EINTR) )
+            {
+                break;
+            }
+        }
+
+
+        // One transaction, so one journal sync, for the whole batch
+        sqlite3_exec(plugin->db, "BEGIN;", 0, 0, 0);
+
+        for ( i = 0; i < count; ++i )
+        {
+            db_run_pending(plugin, &plugin->pending[i]);
+        }
+
+        // The rollups of the frames go in the same transaction, so they cannot drift from the frames
+        commit = db_rollup_flush(plugin, plugin->rollups);
+        commit = (commit == SQLITE_DONE) ? sqlite3_exec(plugin->db, "COMMIT;", 0, 0, 0) : commit;
+
+        if ( commit != SQLITE_OK )
+        {
+            eprintf("%s\n", sqlite3_errmsg(plugin->db) );
+            sqlite3_exec(plugin->db, "ROLLBACK;", 0, 0, 0);
+        }
+
+
+        // The operations are durable (or lost), the event loop can answer
+        for ( i = 0, completions.count = 0; i < count; ++i )
+        {
+            completions.items[completions.count] = plugin->pending[i];
+
+            if ( commit != SQLITE_OK )
+            {
+                completions.items[completions.count].result = commit;
+            }
+
+            if ( (++completions.count == DB_COMPLETIONS_MAX) || (i + 1 == count) )
+            {
+                mg_broadcast(plugin->mgr, db_completions_handler, &completions,
+                             offsetof(db_completions_t, items) + completions.count * sizeof(db_pending_t) );
+                completions.count = 0;
+            }
+        }
+    }
+
+    atomic_store(&plugin->stopped, 1);
+
+    return (NULL);
+}
+
+
+
+static int db_writer_pop(db_plugin_t     *plugin,
+                         db_pending_t    *pending,
+                         unsigned int    *acks
+                         )
+{
+    if ( (*acks < DB_ACK_WEIGHT) && (mpsc_queue_pop(plugin->queue_ack, pending) == 0) )
+    {
+        (*acks)++;
+
+        return (0);
+    }
+
+    if ( mpsc_queue_pop(plugin->queue, pending) == 0 )
+    {
+        *acks = 0;
+
+        return (0);
+    }
+
+
+    // No other write is waiting, the weight does not apply
+    return (mpsc_queue_pop(plugin->queue_ack, pending) );
+}
+
+
+
+static void db_completions_handler(struct mg_connection *nc,
+                                   int                  ev __attribute__( (unused) ),
+                                   void                 *ev_data
+                                   )
+{
+    db_completions_t            *completions    = ev_data;
+    db_pending_t                *pending        = NULL;
+    struct mg_connection        *c              = NULL;
+    unsigned int                i               = 0;
+
+
+    for ( i = 0; i < completions->count; ++i )
+    {
+        pending = &completions->items[i];
+
+
+        // The acknowledged frames were answered before their commit, a failure can only be logged
+        if ( ! pending->nc && (pending->result != SQLITE_DONE) )
+        {
+            eprintf("Frame %s/%u acknowledged but not stored\n", pending->raws.id_modem, pending->raws.seq_number);
+            completions->plugin->ack_lost++;
+        }
+
+        dedup_restore(completions->plugin, pending);
+        devstats_count(completions->plugin, pending);
+        downlink_commit(completions->plugin, pending);
+
+        for ( c = mg_next(nc->mgr, NULL); pending->nc && (c != NULL); c = mg_next(nc->mgr, c) )
+        {
+            if ( (c == pending->nc) && ( (uintptr_t) c->user_data == pending->conn_id) )
+            {
+                send_pending_reply(c, pending, completions->plugin);
+                break;
+            }
+        }
+
+        free(pending->batch);
+    }
+
+    arena_reset(&completions->plugin->arena);
+
+
+    // The message is shared by the calls of this broadcast
+    completions->count = 0;
+}
+
+
+
+static int db_write(db_plugin_t             *plugin,
+                    struct mg_connection    *nc,
+                    db_pending_t            *pending
+                    )
+{
+    mpsc_queue_t        *queue  = plugin->queue;
+
+
+    if ( ! queue )
+    {
+        sqlite3_exec(plugin->db, "BEGIN;", 0, 0, 0);
+        db_run_pending(plugin, pending);
+
+        if ( (db_rollup_flush(plugin, plugin->rollups) != SQLITE_DONE) ||
+             (sqlite3_exec(plugin->db, "COMMIT;", 0, 0, 0) != SQLITE_OK) )
+        {
+            sqlite3_exec(plugin->db, "ROLLBACK;", 0, 0, 0);
+            pending->result = SQLITE_ERROR;
+        }
+
+        dedup_restore(plugin, pending);
+        devstats_count(plugin, pending);
+        downlink_commit(plugin, pending);
+        send_pending_reply(nc, pending, plugin);
+        free(pending->batch);
+
+        return (0);
+    }
+
+
+    // The completion is matched against this identifier, a new connection can reuse the same address
+    if ( nc && ! nc->user_data )
+    {
+        nc->user_data = (void *) (uintptr_t) ++plugin->last_conn_id;
+    }
+
+    pending->nc         = nc;
+    pending->conn_id    = (nc) ? (uintptr_t) nc->user_data : 0;
+
+
+    // A queued downlink goes with the frames it is answered to, so it is inserted before its delivery, and a deletion
+    // with the acknowledged frames, so it does not delete the ones acknowledged after it
+    if ( (pending->op == API_OP_DOWNLINK) || (pending->op == API_OP_DEL) ||
+         ( (pending->op == API_OP_SET) && pending->raws.ack) )
+    {
+        queue = plugin->queue_ack;
+    }
+
+    if ( mpsc_queue_push(queue, pending) )
+    {
+        plugin->shed_full++;
+
+        if ( nc )
+        {
+            MG_PRINTF_503
+        }
+
+        pending->result = SQLITE_FULL;
+        downlink_restore(plugin, pending);
+        dedup_restore(plugin, pending);
+        free(pending->batch);
+
+        return (-1);
+    }
+
+    sem_post(&plugin->queue_sem);
+
+    return (0);
+}
+
+
+
+static void send_pending_reply(struct mg_connection *nc,
+                               const db_pending_t   *pending,
+                               db_plugin_t          *plugin
+                               )
+{
+    if ( pending->op == API_OP_SET )
+    {
+        send_set_reply(nc, &pending->raws, pending->downlink_data, pending->result, plugin);
+    }
+    else if ( pending->op == API_OP_SET_BATCH )
+    {
+        send_batch_reply(nc, pending, plugin);
+    }
+    else if ( (pending->op == API_OP_DOWNLINK) && (pending->result == SQLITE_DONE) )
+    {
+        mg_printf(nc, "HTTP/1.1 201 Created\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+        db_printf_chunk(plugin, nc, "{ \"id\": %lld, \"downlinkData\": \"%s\" }", (long long) pending->downlink_id,
+                        pending->downlink_data);
+        mg_send_http_chunk(nc, "", 0);
+
+#ifdef __DEBUG__
+        gprintf("201 Created\n");
+#endif
+    }
+    else if ( pending->result == SQLITE_DONE )
+    {
+        MG_PRINTF_200
+    }
+    else
+    {
+        MG_PRINTF_500
+    }
+}
+
+
+
+static void db_printf_chunk(db_plugin_t             *plugin,
+                            struct mg_connection    *nc,
+                            const char              *fmt,
+                            ...
+                            )
+{
+    const size_t        mark    = plugin->arena.used;
+    char                *chunk  = NULL;
+    size_t              len     = 0;
+    va_list             ap;
+
+
+    va_start(ap, fmt);
+    chunk = arena_vprintf(&plugin->arena, &len, fmt, ap);
+    va_end(ap);
+
+    if ( chunk )
+    {
+        mg_send_http_chunk(nc, chunk, len);
+    }
+
+    arena_rewind(&plugin->arena, mark);
+}
+
+
+
+void db_op(struct mg_connection         *nc,
+           const struct http_message    *hm,
+           const struct mg_str          *key,
+           void                         *db,
+           int                          op
+           )
+{
+    db_plugin_t         *plugin = db;
+    heap_stats_t        heap    = heap_stats();
+
+
+    // The allocations since the previous request: the read of this one, and the reply of the previous one
+    plugin->requests++;
+    plugin->requests_allocating    += (heap.allocations != plugin->allocations);
+    plugin->allocations             = heap.allocations;
+
+    db_dispatch(nc, hm, key, plugin, op);
+    arena_reset(&plugin->arena);
+}
+
+
+
+static void db_dispatch(struct mg_connection        *nc,
+                        const struct http_message   *hm,
+                        const struct mg_str         *key,
+                        db_plugin_t                 *plugin,
+                        int                         op
+                        )
+{
+    unsigned char       id_modem[SIGFOX_DEVICE_LENGTH + 1];
+    unsigned char       station[SIGFOX_STATION_LENGTH + 1];
+    struct mg_str       rest;
+
+
+    if ( mg_vcmp(key, "/devices/stats") == 0 )
+    {
+        if ( op != API_OP_GET )
+        {
+            MG_PRINTF_501
+        }
+        else
+        {
+            op_devstats(nc, NULL, plugin);
+        }
+
+        return;
+    }
+
+    if ( path_key(key, "/devices/", SIGFOX_DEVICE_LENGTH, id_modem, &rest) )
+    {
+        if ( mg_vcmp(&rest, "/stats") == 0 )
+        {
+            if ( op != API_OP_GET )
+            {
+                MG_PRINTF_501
+            }
+            else
+            {
+                op_devstats(nc, id_modem, plugin);
+            }
+        }
+        else if ( mg_vcmp(&rest, "/rollups") == 0 )
+        {
+            if ( op != API_OP_GET )
+            {
+                MG_PRINTF_501
+            }
+            else if ( db_admit(plugin, nc, DB_ADMIT_QUERY) == 0 )
+            {
+                op_rollups(nc, hm, id_modem, plugin);
+            }
+        }
+        else if ( mg_vcmp(&rest, "/downlink") == 0 )
+        {
+            op_downlink(nc, hm, id_modem, plugin, op);
+        }
+        else if ( mg_vcmp(&rest, "/downlinks") == 0 )
+        {
+            op_downlinks(nc, hm, id_modem, plugin, op);
+        }
+        else if ( mg_vcmp(&rest, "/frames") != 0 )
+        {
+            MG_PRINTF_404
+        }
+        else if ( op != API_OP_GET )
+        {
+            MG_PRINTF_501
+        }
+        else if ( db_admit(plugin, nc, DB_ADMIT_QUERY) == 0 )
+        {
+            op_frames(nc, hm, id_modem, 0, plugin);
+        }
+
+        return;
+    }
+
+    if ( path_key(key, "/stations/", SIGFOX_STATION_LENGTH, station, &rest) )
+    {
+        if ( mg_vcmp(&rest, "/frames") != 0 )
+        {
+            MG_PRINTF_404
+        }
+        else if ( op != API_OP_GET )
+        {
+            MG_PRINTF_501
+        }
+        else if ( db_admit(plugin, nc, DB_ADMIT_QUERY) == 0 )
+        {
+            op_frames(nc, hm, station, 1, plugin);
+        }
+
+        return;
+    }
+
+    switch ( op )
+    {
+        case API_OP_GET:
+
+            if ( mg_vcmp(key, "/stats") == 0 )
+            {
+                op_stats(nc, hm, key, plugin);
+            }
+            else if ( (key->len == 0) && (mg_get_http_var(&hm->query_string, SQL_COL_ID_MODEM, (char *) id_modem,
+                                                            sizeof(id_modem) ) != -1) )
+            {
+                // A callback configured with the GET method sends its fields in the query string (-1: no id_modem)
+                op_set(nc, hm, key, plugin);
+            }
+            else if ( db_admit(plugin, nc, DB_ADMIT_QUERY) == 0 )
+            {
+                op_get(nc, hm, key, plugin);
+            }
+
+            break;
+
+        case API_OP_SET:
+
+            if ( mg_vcmp(key, "/batch") == 0 )
+            {
+                // The acknowledges of a batch are answered after its commit, it is not worth a slot of the ack class
+                if ( db_admit(plugin, nc, DB_ADMIT_FRAME) == 0 )
+                {
+                    op_set_batch(nc, hm, key, plugin);
+                }
+            }
+            else
+            {
+                op_set(nc, hm, key, plugin);
+            }
+
+            break;
+
+        case API_OP_DEL:
+
+            if ( db_admit(plugin, nc, DB_ADMIT_FRAME) == 0 )
+            {
+                op_del(nc, hm, key, plugin);
+            }
+
+            break;
+
+        default:
+            MG_PRINTF_501
+            break;
+    }
+}
+
+
+
+static void op_set(struct mg_connection         *nc,
+                   const struct http_message    *hm,
+                   const struct mg_str          *key __attribute__( (unused) ),
+                   db_plugin_t                  *plugin
+                   )
+{
+    const struct mg_str     *body   = (hm->query_string.len > 0) ? &hm->query_string : &hm->body;
+    const struct mg_str     *type   = mg_get_http_header( (struct http_message *) hm, "Content-Type");
+    const uint64_t          start   = histogram_clock_us();
+    db_pending_t            pending;
+    DB_Dedup                dedup   = DB_DEDUP_OFF;
+    int                     form    = 0;
+
+
+    memset(&pending, 0, sizeof(pending) );
+    pending.op = API_OP_SET;
+
+
+    // A query string is url-encoded unless it is a JSON object (legacy), a body is url-encoded when its type says so
+    if ( body == &hm->query_string )
+    {
+        form = (body->p[0] != '{');
+    }
+    else
+    {
+        form = type && (type->len >= sizeof(DB_FORM_CONTENT_TYPE) - 1) &&
+               (mg_ncasecmp(type->p, DB_FORM_CONTENT_TYPE, sizeof(DB_FORM_CONTENT_TYPE) - 1) == 0);
+    }
+
+    if ( (form) ? sigfox_form_decode(body->p, body->len, &pending.raws) : sigfox_json_decode(body->p, body->len, &pending.raws) )
+    {
+        MG_PRINTF_400
+
+        return;
+    }
+
+
+    // Before the dedup lookup, so the frame sent again by the backend is not taken for a copy
+    if ( db_admit(plugin, nc, (pending.raws.ack) ? DB_ADMIT_ACK : DB_ADMIT_FRAME) )
+    {
+        return;
+    }
+
+    dedup = dedup_frame(plugin, &pending.raws, &pending.remembered);
+
+    if ( pending.raws.ack )
+    {
+        pending.downlink_id = downlink_next(plugin, &pending.raws, dedup != DB_DEDUP_DROP, pending.downlink_data);
+    }
+
+
+    // A dropped copy gets the reply of the stored one without reaching the writer
+    if ( dedup == DB_DEDUP_DROP )
+    {
+        send_set_reply(nc, &pending.raws, pending.downlink_data, SQLITE_DONE, plugin);
+    }
+    else if ( pending.raws.ack && plugin->queue )
+    {
+        // The downlink does not depend on the insertion, so it does not wait for the commit
+        if ( db_write(plugin, NULL, &pending) )
+        {
+            MG_PRINTF_503
+
+            return;
+        }
+
+        send_set_reply(nc, &pending.raws, pending.downlink_data, SQLITE_DONE, plugin);
+    }
+    else
+    {
+        db_write(plugin, nc, &pending);
+    }
+
+    if ( pending.raws.ack )
+    {
+        histogram_add_since(&plugin->ack_latency, start);
+    }
+}
+
+
+
+int db_ingest(void                 *db,
+              const sigfox_raws_t  *raws,
+              char                 downlink_data[SIGFOX_DOWNLINK_DATA_LENGTH + 1]
+              )
+{
+    db_plugin_t             *plugin = db;
+    const uint64_t          start   = histogram_clock_us();
+    db_pending_t            pending;
+    DB_Dedup                dedup   = DB_DEDUP_OFF;
+
+
+    memset(&pending, 0, sizeof(pending) );
+    pending.op          = API_OP_SET;
+    pending.raws        = *raws;
+    downlink_data[0]    = '\0';
+
+
+    // Nobody waits for the commit, the frame has to be handed to the writer thread
+    if ( ! plugin->queue || db_admit(plugin, NULL, (raws->ack) ? DB_ADMIT_ACK : DB_ADMIT_FRAME) )
+    {
+        return (-1);
+    }
+
+    dedup = dedup_frame(plugin, &pending.raws, &pending.remembered);
+
+    if ( raws->ack )
+    {
+        pending.downlink_id = downlink_next(plugin, &pending.raws, dedup != DB_DEDUP_DROP, pending.downlink_data);
+    }
+
+    if ( (dedup != DB_DEDUP_DROP) && db_write(plugin, NULL, &pending) )
+    {
+        return (-1);
+    }
+
+    if ( raws->ack )
+    {
+        memcpy(downlink_data, pending.downlink_data, SIGFOX_DOWNLINK_DATA_LENGTH + 1);
+        histogram_add_since(&plugin->ack_latency, start);
+    }
+
+    return (0);
+}
+
+
+
+static void op_set_batch(struct mg_connection       *nc,
+                         const struct http_message  *hm,
+                         const struct mg_str        *key __attribute__( (unused) ),
+                         db_plugin_t                *plugin
+                         )
+{
+    const char              *p          = hm->body.p;
+    const char              *end        = hm->body.p + hm->body.len;
+    const char              *eol        = NULL;
+    db_pending_t            pending;
+    unsigned int            capacity    = 0;
+    unsigned int            i           = 0;
+    int                     array       = 0;
+
+
+    memset(&pending, 0, sizeof(pending) );
+    pending.op = API_OP_SET_BATCH;
+
+    while ( (p < end) && isspace( (unsigned char) *p) )
+    {
+        p++;
+    }
+
+
+    // Either a JSON array of objects, or NDJSON (one object per line, the empty lines are skipped)
+    if ( (p < end) && (*p == '[') )
+    {
+        array = 1;
+        p++;
+    }
+
+    while ( p < end )
+    {
+        db_batch_item_t     *item = NULL;
+
+
+        while ( (p < end) && isspace( (unsigned char) *p) )
+        {
+            p++;
+        }
+
+        if ( (p == end) || (array && (*p == ']') ) )
+        {
+            break;
+        }
+
+        if ( pending.batch_count == capacity )
+        {
+            db_batch_item_t     *batch = NULL;
+
+
+            capacity    = (capacity) ? capacity * 2 : 16;
+            batch       = realloc(pending.batch, capacity * sizeof(db_batch_item_t) );
+
+
+            // A partial batch would drop the rest of the body without a status for its frames
+            if ( ! batch )
+            {
+                free(pending.batch);
+                MG_PRINTF_500
+
+                return;
+            }
+
+            pending.batch = batch;
+        }
+
+        item = &pending.batch[pending.batch_count++];
+        memset(item, 0, sizeof(*item) );
+
+        if ( array )
+        {
+            p = sigfox_json_decode_object(p, end, &item->raws, &item->error);
+
+
+            // The array cannot be walked any further after a syntax error
+            if ( ! p )
+            {
+                break;
+            }
+
+            while ( (p < end) && isspace( (unsigned char) *p) )
+            {
+                p++;
+            }
+
+            if ( (p < end) && (*p == ',') )
+            {
+                p++;
+            }
+        }
+        else
+        {
+            const char      *q = NULL;
+
+
+            eol = memchr(p, '\n', end - p);
+            eol = (eol) ? eol : end;
+            q   = sigfox_json_decode_object(p, eol, &item->raws, &item->error);
+
+            while ( q && (q < eol) && isspace( (unsigned char) *q) )
+            {
+                q++;
+            }
+
+            if ( q != eol )
+            {
+                item->error = SIGFOX_JSON_ERR_SYNTAX;
+            }
+
+            p = eol;
+        }
+    }
+
+    if ( (pending.batch == NULL) || (pending.batch_count == 0) || (array && ! p) )
+    {
+        free(pending.batch);
+        MG_PRINTF_400
+
+        return;
+    }
+
+
+    // The payloads are converted all at once, the frames already in error keep their error
+    hex_decode_batch(pending.batch[0].raws.data_str, pending.batch[0].raws.data_hex, &pending.batch[0].error,
+                     sizeof(db_batch_item_t), SIGFOX_DATA_STR_LENGTH, pending.batch_count, SIGFOX_JSON_ERR_DATA);
+
+    for ( i = 0; i < pending.batch_count; ++i )
+    {
+        db_batch_item_t     *item = &pending.batch[i];
+
+
+        if ( ! item->error )
+        {
+            item->dedup     = dedup_frame(plugin, &item->raws, &item->remembered);
+            item->result    = SQLITE_DONE;
+        }
+
+        if ( ! item->error && item->raws.ack )
+        {
+            item->downlink_id = downlink_next(plugin, &item->raws, item->dedup != DB_DEDUP_DROP, item->downlink_data);
+        }
+    }
+
+    db_write(plugin, nc, &pending);
+}
+
+
+
+static void send_set_reply(struct mg_connection *nc,
+                           const sigfox_raws_t  *raws,
+                           const char           *downlink_data,
+                           int                  result,
+                           db_plugin_t          *plugin
+                           )
+{
+    if ( raws->ack && (result == SQLITE_DONE) )
+    {
+        // Send headers
+        mg_printf(nc, "HTTP/1.1 201 Created\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+        db_printf_chunk(plugin, nc, "{ \"%s\": { \"downlinkData\": \"%s\" } }", raws->id_modem, downlink_data);
+        mg_send_http_chunk(nc, "", 0);
+
+#ifdef __DEBUG__
+        gprintf("201 Created\n");
+#endif
+    }
+    else if ( result == SQLITE_DONE )
+    {
+        MG_PRINTF_204
+    }
+    else
+    {
+        MG_PRINTF_500
+    }
+}
+
+
+
+static void send_batch_reply(struct mg_connection   *nc,
+                             const db_pending_t     *pending,
+                             db_plugin_t            *plugin
+                             )
+{
+    const db_batch_item_t       *item   = NULL;
+    unsigned int                i       = 0;
+
+
+    mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+    db_printf_chunk(plugin, nc, "[ ");
+
+
+    // Same status as the one a single POST /api would have received
+    for ( i = 0; i < pending->batch_count; ++i )
+    {
+        item = &pending->batch[i];
+
+        if ( item->error )
+        {
+            db_printf_chunk(plugin, nc, "%s{ \"status\": 400, \"error\": %u }", (i) ? ", " : "", item->error);
+        }
+        else if ( item->raws.ack && (item->result == SQLITE_DONE) && (pending->result == SQLITE_DONE) )
+        {
+            db_printf_chunk(plugin, nc, "%s{ \"status\": 201, \"%s\": { \"downlinkData\": \"%s\" } }", (i) ? ", " : "",
+                            item->raws.id_modem, item->downlink_data);
+        }
+        else if ( (item->result == SQLITE_DONE) && (pending->result == SQLITE_DONE) )
+        {
+            db_printf_chunk(plugin, nc, "%s{ \"status\": 204 }", (i) ? ", " : "");
+        }
+        else
+        {
+            db_printf_chunk(plugin, nc, "%s{ \"status\": 500 }", (i) ? ", " : "");
+        }
+    }
+
+    db_printf_chunk(plugin, nc, " ]");
+    mg_send_http_chunk(nc, "", 0);
+
+#ifdef __DEBUG__
+    gprintf("200 OK\n");
+#endif
+}
+
+
+
+static sqlite3_int64 downlink_next(db_plugin_t            *plugin,
+                                   const sigfox_raws_t    *raws,
+                                   int                    pop,
+                                   char                   downlink_data[SIGFOX_DOWNLINK_DATA_LENGTH + 1]
+                                   )
+{
+    sqlite3_int64       id      = 0;
+    const char          *data   = NULL;
+
+
+    // The backend only takes the reply of one copy, so a copy does not consume a queued payload
+    if ( pop && ! raws->duplicate )
+    {
+        id = downlink_pop(plugin->downlinks, raws->id_modem, downlink_data);
+
+        if ( id )
+        {
+            return (id);
+        }
+    }
+
+    data = downlink_get(plugin->downlinks, raws->id_modem);
+
+    if ( data )
+    {
+        memcpy(downlink_data, data, SIGFOX_DOWNLINK_DATA_LENGTH + 1);
+    }
+    else
+    {
+        downlink_from_raws(raws, downlink_data);
+    }
+
+    return (0);
+}
+
+
+
+static void downlink_restore(db_plugin_t        *plugin,
+                             const db_pending_t *pending
+                             )
+{
+    unsigned int     i = 0;
+
+
+    if ( (pending->op == API_OP_SET) && pending->downlink_id )
+    {
+        downlink_unpop(plugin->downlinks, pending->raws.id_modem, pending->downlink_id, pending->downlink_data);
+    }
+
+
+    // In reverse, so the payloads taken from the same device go back in their order
+    for ( i = pending->batch_count; (pending->op == API_OP_SET_BATCH) && (i > 0); --i )
+    {
+        const db_batch_item_t     *item = &pending->batch[i - 1];
+
+
+        if ( item->downlink_id )
+        {
+            downlink_unpop(plugin->downlinks, item->raws.id_modem, item->downlink_id, item->downlink_data);
+        }
+    }
+}
+
+
+
+static void downlink_commit(db_plugin_t          *plugin,
+                            const db_pending_t   *pending
+                            )
+{
+    if ( (pending->op == API_OP_DOWNLINK) && (pending->result == SQLITE_DONE) &&
+         downlink_push(plugin->downlinks, pending->raws.id_modem, pending->downlink_id, pending->downlink_data) )
+    {
+        eprintf("Downlink %lld of %s not queued\n", (long long) pending->downlink_id, pending->raws.id_modem);
+    }
+}
+
+
+
+static int downlink_load(db_plugin_t *plugin)
+{
+    sqlite3_stmt        *stmt   = NULL;
+    int                 result  = SQLITE_DONE;
+
+
+    if ( sqlite3_prepare_v2(plugin->db, SELECT_DOWNLINKS_LAST, -1, &stmt, NULL) != SQLITE_OK )
+    {
+        eprintf("%s\n", sqlite3_errmsg(plugin->db) );
+
+        return (-1);
+    }
+
+    if ( sqlite3_step(stmt) == SQLITE_ROW )
+    {
+        plugin->last_downlink_id = sqlite3_column_int64(stmt, 0);
+    }
+
+    sqlite3_finalize(stmt);
+
+    if ( sqlite3_prepare_v2(plugin->db, SELECT_DOWNLINKS_PENDING, -1, &stmt, NULL) != SQLITE_OK )
+    {
+        eprintf("%s\n", sqlite3_errmsg(plugin->db) );
+
+        return (-1);
+    }
+
+    for ( result = sqlite3_step(stmt); result == SQLITE_ROW; result = sqlite3_step(stmt) )
+    {
+        if ( (sqlite3_column_bytes(stmt, 2) != SIGFOX_DOWNLINK_DATA_LENGTH) ||
+             downlink_push(plugin->downlinks, sqlite3_column_text(stmt, 1), sqlite3_column_int64(stmt, 0),
+                           (const char *) sqlite3_column_text(stmt, 2) ) )
+        {
+            result = SQLITE_ERROR;
+            break;
+        }
+    }
+
+    sqlite3_finalize(stmt);
+
+    return ( (result == SQLITE_DONE) ? 0 : -1);
+}
+
+
+
+static int devstats_load(db_plugin_t *plugin)
+{
+    sqlite3_stmt            *stmt   = NULL;
+    devstats_entry_t        *entry  = NULL;
+    int                     result  = SQLITE_DONE;
+
+
+    if ( sqlite3_prepare_v2(plugin->db, SELECT_DEVSTATS_MESSAGES, -1, &stmt, NULL) != SQLITE_OK )
+    {
+        eprintf("%s\n", sqlite3_errmsg(plugin->db) );
+
+        return (-1);
+    }
+
+    for ( result = sqlite3_step(stmt); result == SQLITE_ROW; result = sqlite3_step(stmt) )
+    {
+        if ( (entry = devstats_slot(plugin->devstats, sqlite3_column_text(stmt, 0) ) ) == NULL )
+        {
+            result = SQLITE_ERROR;
+            break;
+        }
+
+        entry->messages         = sqlite3_column_int64(stmt, 1);
+        entry->first_seen       = sqlite3_column_int64(stmt, 2);
+        entry->last_seen        = sqlite3_column_int64(stmt, 3);
+        entry->avg_signal_sum   = sqlite3_column_double(stmt, 4);
+    }
+
+    sqlite3_finalize(stmt);
+
+    if ( result != SQLITE_DONE )
+    {
+        return (-1);
+    }
+
+    if ( sqlite3_prepare_v2(plugin->db, SELECT_DEVSTATS_RECEPTIONS, -1, &stmt, NULL) != SQLITE_OK )
+    {
+        eprintf("%s\n", sqlite3_errmsg(plugin->db) );
+
+        return (-1);
+    }
+
+    for ( result = sqlite3_step(stmt); result == SQLITE_ROW; result = sqlite3_step(stmt) )
+    {
+        if ( (entry = devstats_slot(plugin->devstats, sqlite3_column_text(stmt, 0) ) ) == NULL )
+        {
+            result = SQLITE_ERROR;
+            break;
+        }
+
+        entry->receptions   = sqlite3_column_int64(stmt, 1);
+        entry->snr_min      = sqlite3_column_double(stmt, 2);
+        entry->snr_max      = sqlite3_column_double(stmt, 3);
+        entry->snr_sum      = sqlite3_column_double(stmt, 4);
+        entry->rssi_min     = sqlite3_column_double(stmt, 5);
+        entry->rssi_max     = sqlite3_column_double(stmt, 6);
+        entry->rssi_sum     = sqlite3_column_double(stmt, 7);
+    }
+
+    sqlite3_finalize(stmt);
+
+    return ( (result == SQLITE_DONE) ? 0 : -1);
+}
+
+
+
+static void devstats_count(db_plugin_t          *plugin,
+                           const db_pending_t   *pending
+                           )
+{
+    unsigned int        i   = 0;
+
+
+    // A batch that failed to commit holds its error in pending->result, its items are left as they were run
+    if ( pending->result != SQLITE_DONE )
+    {
+        return;
+    }
+
+    if ( pending->op == API_OP_SET )
+    {
+        devstats_add(plugin->devstats, &pending->raws, pending->message);
+    }
+    else if ( pending->op == API_OP_SET_BATCH )
+    {
+        for ( i = 0; i < pending->batch_count; ++i )
+        {
+            const db_batch_item_t       *item = &pending->batch[i];
+
+
+            if ( ! item->error && (item->dedup != DB_DEDUP_DROP) && (item->result == SQLITE_DONE) )
+            {
+                devstats_add(plugin->devstats, &item->raws, item->message);
+            }
+        }
+    }
+    else if ( pending->op == API_OP_DEL )
+    {
+        devstats_clear(plugin->devstats);
+    }
+}
+
+
+
+static int db_rollup_flush(db_plugin_t  *plugin,
+                           rollup_t     *table
+                           )
+{
+    sqlite3_stmt            *stmt   = plugin->upsert_rollups;
+    const rollup_entry_t    *entry  = NULL;
+    char                    id_modem[SIGFOX_DEVICE_LENGTH + 1];
+    size_t                  i       = 0;
+    int                     result  = SQLITE_DONE;
+
+
+    for ( i = 0; (i <= table->mask) && table->count && (result == SQLITE_DONE); ++i )
+    {
+        entry = &table->entries[i];
+
+        if ( ! entry->used )
+        {
+            continue;
+        }
+
+        sqlite3_bind_text(stmt, 1, id_modem, rollup_id(entry, id_modem), SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, rollup_seconds(entry->granularity) );
+        sqlite3_bind_int64(stmt, 3, entry->bucket);
+        sqlite3_bind_int64(stmt, 4, (sqlite3_int64) entry->messages);
+        sqlite3_bind_int64(stmt, 5, (sqlite3_int64) entry->receptions);
+        sqlite3_bind_double(stmt, 6, entry->snr_min);
+        sqlite3_bind_double(stmt, 7, entry->snr_max);
+        sqlite3_bind_double(stmt, 8, entry->snr_sum);
+        sqlite3_bind_double(stmt, 9, entry->rssi_min);
+        sqlite3_bind_double(stmt, 10, entry->rssi_max);
+        sqlite3_bind_double(stmt, 11, entry->rssi_sum);
+        sqlite3_bind_double(stmt, 12, entry->avg_signal_sum);
+        result = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+
+    sqlite3_clear_bindings(stmt);
+    rollup_clear(table);
+
+    return (result);
+}
+
+
+
+static int db_deliver_downlink(db_plugin_t      *plugin,
+                               sqlite3_int64    id
+                               )
+{
+    int     result = SQLITE_DONE;
+
+
+    sqlite3_bind_int64(plugin->deliver_downlink, 1, time(NULL) );
+    sqlite3_bind_int64(plugin->deliver_downlink, 2, id);
+    result = sqlite3_step(plugin->deliver_downlink);
+    sqlite3_reset(plugin->deliver_downlink);
+
+    return (result);
+}
+
+
+
+static void downlink_from_raws(const sigfox_raws_t  *raws,
+                               char                 downlink_data[SIGFOX_DOWNLINK_DATA_LENGTH + 1]
+                               )
+{
+    // Copy the first 16 bytes of data_str
+    memset(downlink_data, 0, SIGFOX_DOWNLINK_DATA_LENGTH + 1);
+    strncpy(downlink_data, (const char *) raws->data_str, SIGFOX_DOWNLINK_DATA_LENGTH);
+    downlink_data[0] += 1;
+}
+
+
+
+static void op_get(struct mg_connection         *nc,
+                   const struct http_message    *hm,
+                   const struct mg_str          *key __attribute__( (unused) ),
+                   db_plugin_t                  *plugin
+                   )
+{
+    db_export_t         *export     = NULL;
+    char                next[64];
+    long long           limit       = DB_PAGE_LIMIT;
+    long long           after_id    = 0;
+    long long           before_id   = LLONG_MAX;
+    long long           bound       = 0;
+    unsigned long long  version     = 0;
+    DB_Format           format      = DB_FORMAT_JSON;
+    int                 backward    = 0;
+    int                 more        = 0;
+
+
+    if ( query_integer(hm, "limit", 1, DB_PAGE_LIMIT_MAX, &limit) ||
+         query_integer(hm, "after_id", 0, LLONG_MAX, &after_id) ||
+         query_integer(hm, "before_id", 1, LLONG_MAX, &before_id) || db_format(hm, &format) )
+    {
+        MG_PRINTF_400
+
+        return;
+    }
+
+    if ( db_cache_reply(plugin, nc, hm, DB_GZIP_LEVEL_PAGES, format, &version) )
+    {
+        return;
+    }
+
+
+    // Only ?before_id= pages backward, from the messages just before it
+    backward    = (before_id != LLONG_MAX) && (after_id == 0);
+    more        = page_bound( (backward) ? plugin->select_page_first : plugin->select_page_last, after_id, before_id,
+                              limit, &bound);
+    export      = (more >= 0) ? db_export_new(plugin, &plugin->select_frames, SELECT_FRAMES) : NULL;
+
+    if ( ! export )
+    {
+        MG_PRINTF_500
+
+        return;
+    }
+
+
+    // The page is the range strictly between the two bounds
+    if ( bound )
+    {
+        after_id    = (backward) ? bound - 1 : after_id;
+        before_id   = (backward) ? before_id : bound + 1;
+    }
+
+    sqlite3_bind_int64(export->stmt, 1, after_id);
+    sqlite3_bind_int64(export->stmt, 2, before_id);
+    export->resume_id = 1;
+    snprintf(next, sizeof(next), "%s=%lld&limit=%lld", (backward) ? "before_id" : "after_id", bound, limit);
+    db_export_start(plugin, nc, hm, export, (more > 0) ? next : NULL, version, DB_GZIP_LEVEL_PAGES, format);
+}
+
+
+
+static void op_frames(struct mg_connection          *nc,
+                      const struct http_message     *hm,
+                      const unsigned char           *value,
+                      int                           station,
+                      db_plugin_t                   *plugin
+                      )
+{
+    db_export_t         *export     = NULL;
+    char                next[128];
+    long long           limit       = DB_PAGE_LIMIT;
+    long long           from        = 0;
+    long long           to          = LLONG_MAX;
+    long long           after_id    = 0;
+    long long           last[2]     = {0, 0};
+    unsigned long long  version     = 0;
+    DB_Format           format      = DB_FORMAT_JSON;
+    int                 more        = 0;
+    int                 len         = 0;
+
+
+    if ( query_integer(hm, "limit", 1, DB_PAGE_LIMIT_MAX, &limit) || query_integer(hm, "from", 0, LLONG_MAX, &from) ||
+         query_integer(hm, "to", 0, LLONG_MAX, &to) || query_integer(hm, "after_id", 0, LLONG_MAX, &after_id) ||
+         db_format(hm, &format) )
+    {
+        MG_PRINTF_400
+
+        return;
+    }
+
+    if ( db_cache_reply(plugin, nc, hm, DB_GZIP_LEVEL_FRAMES, format, &version) )
+    {
+        return;
+    }
+
+    last[0] = to;
+    last[1] = LLONG_MAX;
+    more    = frames_bound( (station) ? plugin->select_station_page : plugin->select_device_page, value, from, after_id,
+                            to, limit, last);
+    export  = (more < 0) ? NULL :
+              (station) ? db_export_new(plugin, &plugin->select_station_frames, SELECT_STATION_FRAMES) :
+              db_export_new(plugin, &plugin->select_device_frames, SELECT_DEVICE_FRAMES);
+
+    if ( ! export )
+    {
+        MG_PRINTF_500
+
+        return;
+    }
+
+
+    // (timestamp, id_raws) in ]from, after_id] .. [last] of the page
+    sqlite3_bind_text(export->stmt, 1, (const char *) value, strlen( (const char *) value), SQLITE_TRANSIENT);
+    sqlite3_bind_int64(export->stmt, 2, from);
+    sqlite3_bind_int64(export->stmt, 3, after_id);
+    sqlite3_bind_int64(export->stmt, 4, last[0]);
+    sqlite3_bind_int64(export->stmt, 5, last[1]);
+    export->resume_time = 2;
+    export->resume_id   = 3;
+
+    len = snprintf(next, sizeof(next), "from=%lld&after_id=%lld&limit=%lld", last[0], last[1], limit);
+
+    if ( to != LLONG_MAX )
+    {
+        snprintf(next + len, sizeof(next) - len, "&to=%lld", to);
+    }
+
+    db_export_start(plugin, nc, hm, export, (more > 0) ? next : NULL, version, DB_GZIP_LEVEL_FRAMES, format);
+}
+
+
+
+static db_export_t* db_export_new(db_plugin_t   *plugin,
+                                  sqlite3_stmt  **cache,
+                                  const char    *sql
+                                  )
+{
+    db_export_t         *export = calloc(1, sizeof(db_export_t) );
+
+
+    if ( ! export )
+    {
+        return (NULL);
+    }
+
+
+    // The cached statement goes to the first read, the concurrent ones prepare their own
+    export->cache   = cache;
+    export->stmt    = *cache;
+    *cache          = NULL;
+
+    if ( ! export->stmt && (sqlite3_prepare_v2(plugin->db_read, sql, -1, &export->stmt, NULL) != SQLITE_OK) )
+    {
+        eprintf("%s\n", sqlite3_errmsg(plugin->db_read) );
+        free(export);
+
+        return (NULL);
+    }
+
+    return (export);
+}
+
+
+
+static void db_export_start(db_plugin_t                 *plugin,
+                            struct mg_connection        *nc,
+                            const struct http_message   *hm,
+                            db_export_t                 *export,
+                            const char                  *next,
+                            unsigned long long          version,
+                            int                         level,
+                            DB_Format                   format
+                            )
+{
+    char                view[8] = "";
+    int                 len     = 0;
+
+
+    export->result = sqlite3_step(export->stmt);
+
+    if ( (export->result != SQLITE_ROW) && (export->result != SQLITE_DONE) )
+    {
+        db_export_free(export);
+        MG_PRINTF_500
+
+        return;
+    }
+
+
+    // ?view=merged gives one object per message, the flat view (one object per reception) is the legacy one
+    mg_get_http_var(&hm->query_string, "view", view, sizeof(view) );
+    export->nc          = nc;
+    export->format      = format;
+    export->merged      = (strcmp(view, "merged") == 0) && (format != DB_FORMAT_CSV);
+    export->previous    = -1;
+    export->active      = time(NULL);
+    export->headers_len = snprintf(export->headers, sizeof(export->headers), "Content-Type: %s\r\n",
+                                   s_formats[format][2]);
+
+
+    // The cursor of the next page goes in a Link header so the body stays a list
+    if ( next )
+    {
+        len = snprintf(export->headers + export->headers_len,
+                       sizeof(export->headers) - export->headers_len - DB_EXPORT_ENCODING,
+                       "Link: <%.*s?%s%s%s%s>; rel=\"next\"\r\n", (int) hm->uri.len, hm->uri.p, next,
+                       (export->merged) ? "&view=merged" : "", (format) ? "&format=" : "",
+                       (format) ? s_formats[format][0] : "");
+        export->headers_len += ( (len > 0) &&
+                                 ( (size_t) len < sizeof(export->headers) - export->headers_len - DB_EXPORT_ENCODING) ) ?
+                               (size_t) len : 0;
+    }
+
+
+    // The reply of an endpoint that compresses depends on Accept-Encoding
+    export->level       = level;
+    export->encoding    = db_encoding(hm, level);
+
+    if ( level )
+    {
+        len = snprintf(export->headers + export->headers_len, sizeof(export->headers) - export->headers_len,
+                       "Vary: Accept-Encoding\r\n");
+        export->headers_len += len;
+    }
+
+
+    // The reply is copied for the cache while it is sent, if the data version is known
+    export->version = version;
+    export->key_len = (version) ? db_cache_key(hm, export->encoding, format, export->key, sizeof(export->key) ) : 0;
+
+    if ( export->key_len )
+    {
+        db_cache_etag(export->etag, sizeof(export->etag), version, export->key, export->key_len);
+    }
+
+
+    // Open the list, the rows are sent DB_EXPORT_CHUNK bytes at a time and the header with the first ones
+    jsonw_init(&export->writer, export->chunk, sizeof(export->chunk), send_chunk, export);
+
+    switch ( format )
+    {
+        case DB_FORMAT_CSV:
+            jsonw_literal(&export->writer, "timestamp,id_modem,ack,data_str,duplicate,avg_signal,seq_number,station,"
+                          "snr,rssi,latitude,longitude\r\n");
+            break;
+
+        case DB_FORMAT_CBOR:
+            cborw_array(&export->writer);
+            break;
+
+        case DB_FORMAT_NDJSON:
+            break;
+
+        default:
+            jsonw_literal(&export->writer, "[");
+            break;
+    }
+
+
+    // The rest of the rows is sent by db_poll, between the other requests
+    if ( send_frames(plugin, export, DB_EXPORT_SLICE) )
+    {
+        db_export_free(export);
+    }
+    else
+    {
+        export->next    = plugin->exports;
+        plugin->exports = export;
+    }
+
+#ifdef __DEBUG__
+    gprintf("200 OK\n");
+#endif
+}
+
+
+
+static int send_frames(db_plugin_t     *plugin,
+                       db_export_t     *export,
+                       unsigned int    limit
+                       )
+{
+    jsonw_t                 *w          = &export->writer;
+    sqlite3_stmt            *stmt       = export->stmt;
+    sqlite3_int64           id_raws     = 0;
+    unsigned int            rows        = 0;
+    unsigned long long      in          = 0;
+    unsigned long long      out         = 0;
+
+
+    // The read restarts after the last message sent, in a new snapshot
+    if ( export->paused )
+    {
+        export->paused  = 0;
+        export->result  = sqlite3_step(stmt);
+    }
+
+
+    // The rows are ordered by message, each format renders them from the same cursor
+    for ( ; export->result == SQLITE_ROW; export->result = sqlite3_step(stmt), ++rows )
+    {
+        id_raws = sqlite3_column_int64(stmt, SQL_IDX_FRAME_ID_RAWS);
+
+
+        // A slice ends between two messages, so the read can restart after the last one sent
+        if ( (rows >= limit) && (id_raws != export->previous) )
+        {
+            break;
+        }
+
+        switch ( export->format )
+        {
+            case DB_FORMAT_CSV:
+                send_csv_row(w, stmt);
+                break;
+
+            case DB_FORMAT_CBOR:
+                send_cbor_row(export, stmt, id_raws);
+                break;
+
+            default:
+                send_json_row(export, stmt, id_raws);
+                break;
+        }
+
+        export->previous        = id_raws;
+        export->previous_time   = sqlite3_column_int64(stmt, SQL_IDX_FRAME_TIMESTAMP);
+    }
+
+    plugin->export_rows += rows;
+
+
+    // Resetting the statement ends its read transaction, so the read does not hold a snapshot of db_read (and the
+    // checkpoints) while its client is slow
+    if ( export->result == SQLITE_ROW )
+    {
+        sqlite3_reset(stmt);
+        sqlite3_bind_int64(stmt, export->resume_id, export->previous);
+
+        if ( export->resume_time )
+        {
+            sqlite3_bind_int64(stmt, export->resume_time, export->previous_time);
+        }
+
+        export->paused = 1;
+
+        return (0);
+    }
+
+
+    // A body cut by an error is not closed (nor cached), so the client sees it is truncated
+    if ( export->result != SQLITE_DONE )
+    {
+        eprintf("Read interrupted: %s\n", sqlite3_errstr(export->result) );
+        export->nc->flags |= MG_F_CLOSE_IMMEDIATELY;
+
+        return (1);
+    }
+
+
+    // Close the last message and the list
+    switch ( export->format )
+    {
+        case DB_FORMAT_CSV:
+            break;
+
+        case DB_FORMAT_CBOR:
+            if ( export->merged && (export->previous >= 0) )
+            {
+                cborw_break(w);
+            }
+
+            cborw_break(w);
+            break;
+
+        case DB_FORMAT_NDJSON:
+            if ( export->merged && (export->previous >= 0) )
+            {
+                jsonw_literal(w, " ] }\n");
+            }
+            else if ( export->previous >= 0 )
+            {
+                jsonw_literal(w, "\n");
+            }
+
+            break;
+
+        default:
+            if ( export->previous < 0 )
+            {
+                jsonw_literal(w, "]");
+            }
+            else if ( export->merged )
+            {
+                jsonw_literal(w, " ] } ]");
+            }
+            else
+            {
+                jsonw_literal(w, " ]");
+            }
+
+            break;
+    }
+
+    jsonw_flush(w);
+    plugin->export_bytes    += w->bytes;
+    plugin->export_chunks   += w->flushes;
+
+    if ( export->gzip )
+    {
+        if ( gzip_stream_write(export->gzip, NULL, 0, 1) )
+        {
+            eprintf("Can not compress the reply\n");
+        }
+
+        plugin->compressed++;
+        plugin->compressed_in   += w->bytes;
+        gzip_stream_counts(export->gzip, &in, &out);
+        plugin->compressed_out  += out;
+    }
+
+    if ( export->key_len )
+    {
+        cache_put(&plugin->cache, export->key, export->key_len, export->version, export->headers,
+                  export->headers_len, export->copy, export->copy_len);
+    }
+
+
+    // Send empty chunk, the end of response
+    mg_send_http_chunk(export->nc, "", 0);
+
+    return (1);
+}
+
+
+
+static void send_json_row(db_export_t      *export,
+                          sqlite3_stmt     *stmt,
+                          sqlite3_int64    id_raws
+                          )
+{
+    jsonw_t                 *w          = &export->writer;
+    const int               merged      = export->merged;
+    const int               ndjson      = (export->format == DB_FORMAT_NDJSON);
+
+
+    // A message is opened on its first reception, NDJSON has one per line instead of the items of a list
+    if ( ! merged || (id_raws != export->previous) )
+    {
+        if ( export->previous >= 0 )
+        {
+            if ( merged )
+            {
+                jsonw_literal(w, " ] }");
+            }
+
+            if ( ndjson )
+            {
+                jsonw_literal(w, "\n{ \"timestamp\": ");
+            }
+            else
+            {
+                jsonw_literal(w, ", { \"timestamp\": ");
+            }
+        }
+        else if ( ndjson )
+        {
+            jsonw_literal(w, "{ \"timestamp\": ");
+        }
+        else
+        {
+            jsonw_literal(w, " { \"timestamp\": ");
+        }
+
+        jsonw_integer(w, sqlite3_column_int64(stmt, SQL_IDX_FRAME_TIMESTAMP) );
+        jsonw_literal(w, ", \"id_modem\": ");
+        jsonw_string(w, (const char *) sqlite3_column_text(stmt, SQL_IDX_FRAME_ID_MODEM),
+                     sqlite3_column_bytes(stmt, SQL_IDX_FRAME_ID_MODEM) );
+        jsonw_literal(w, ", \"ack\": ");
+        jsonw_bool(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_ACK) );
+        jsonw_literal(w, ", \"data_str\": ");
+        jsonw_string(w, (const char *) sqlite3_column_text(stmt, SQL_IDX_FRAME_DATA_STR),
+                     sqlite3_column_bytes(stmt, SQL_IDX_FRAME_DATA_STR) );
+        jsonw_literal(w, ", \"duplicate\": ");
+        jsonw_bool(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_DUPLICATE) );
+        jsonw_literal(w, ", \"avg_signal\": ");
+        jsonw_double(w, sqlite3_column_double(stmt, SQL_IDX_FRAME_AVG_SIGNAL) );
+        jsonw_literal(w, ", \"seq_number\": ");
+        jsonw_integer(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_SEQ_NUMBER) );
+    }
+
+    if ( ! merged )
+    {
+        jsonw_literal(w, ", \"station\": ");
+    }
+    else if ( id_raws != export->previous )
+    {
+        jsonw_literal(w, ", \"receptions\": [ { \"station\": ");
+    }
+    else
+    {
+        jsonw_literal(w, ", { \"station\": ");
+    }
+
+    jsonw_string(w, (const char *) sqlite3_column_text(stmt, SQL_IDX_FRAME_STATION),
+                 sqlite3_column_bytes(stmt, SQL_IDX_FRAME_STATION) );
+    jsonw_literal(w, ", \"snr\": ");
+    jsonw_double(w, sqlite3_column_double(stmt, SQL_IDX_FRAME_SNR) );
+    jsonw_literal(w, ", \"rssi\": ");
+    jsonw_double(w, sqlite3_column_double(stmt, SQL_IDX_FRAME_RSSI) );
+    jsonw_literal(w, ", \"latitude\": ");
+    jsonw_integer(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_LATITUDE) );
+    jsonw_literal(w, ", \"longitude\": ");
+    jsonw_integer(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_LONGITUDE) );
+    jsonw_literal(w, " }");
+}
+
+
+
+static void send_csv_row(jsonw_t           *w,
+                         sqlite3_stmt      *stmt
+                         )
+{
+    jsonw_integer(w, sqlite3_column_int64(stmt, SQL_IDX_FRAME_TIMESTAMP) );
+    jsonw_literal(w, ",");
+    csvw_string(w, (const char *) sqlite3_column_text(stmt, SQL_IDX_FRAME_ID_MODEM),
+                sqlite3_column_bytes(stmt, SQL_IDX_FRAME_ID_MODEM) );
+    jsonw_literal(w, ",");
+    jsonw_bool(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_ACK) );
+    jsonw_literal(w, ",");
+    csvw_string(w, (const char *) sqlite3_column_text(stmt, SQL_IDX_FRAME_DATA_STR),
+                sqlite3_column_bytes(stmt, SQL_IDX_FRAME_DATA_STR) );
+    jsonw_literal(w, ",");
+    jsonw_bool(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_DUPLICATE) );
+    jsonw_literal(w, ",");
+    csvw_double(w, sqlite3_column_double(stmt, SQL_IDX_FRAME_AVG_SIGNAL) );
+    jsonw_literal(w, ",");
+    jsonw_integer(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_SEQ_NUMBER) );
+    jsonw_literal(w, ",");
+    csvw_string(w, (const char *) sqlite3_column_text(stmt, SQL_IDX_FRAME_STATION),
+                sqlite3_column_bytes(stmt, SQL_IDX_FRAME_STATION) );
+    jsonw_literal(w, ",");
+    csvw_double(w, sqlite3_column_double(stmt, SQL_IDX_FRAME_SNR) );
+    jsonw_literal(w, ",");
+    csvw_double(w, sqlite3_column_double(stmt, SQL_IDX_FRAME_RSSI) );
+    jsonw_literal(w, ",");
+    jsonw_integer(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_LATITUDE) );
+    jsonw_literal(w, ",");
+    jsonw_integer(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_LONGITUDE) );
+    jsonw_literal(w, "\r\n");
+}
+
+
+
+static void send_cbor_row(db_export_t      *export,
+                          sqlite3_stmt     *stmt,
+                          sqlite3_int64    id_raws
+                          )
+{
+    jsonw_t                 *w          = &export->writer;
+    const int               merged      = export->merged;
+
+
+    // The fields of the message, then its receptions in a list of unknown length in the merged view
+    if ( ! merged || (id_raws != export->previous) )
+    {
+        if ( merged && (export->previous >= 0) )
+        {
+            cborw_break(w);
+        }
+
+        cborw_map(w, (merged) ? 8 : 12);
+        cborw_key(w, "timestamp");
+        cborw_integer(w, sqlite3_column_int64(stmt, SQL_IDX_FRAME_TIMESTAMP) );
+        cborw_key(w, "id_modem");
+        cborw_text(w, (const char *) sqlite3_column_text(stmt, SQL_IDX_FRAME_ID_MODEM),
+                   sqlite3_column_bytes(stmt, SQL_IDX_FRAME_ID_MODEM) );
+        cborw_key(w, "ack");
+        cborw_bool(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_ACK) );
+        cborw_key(w, "data_str");
+        cborw_text(w, (const char *) sqlite3_column_text(stmt, SQL_IDX_FRAME_DATA_STR),
+                   sqlite3_column_bytes(stmt, SQL_IDX_FRAME_DATA_STR) );
+        cborw_key(w, "duplicate");
+        cborw_bool(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_DUPLICATE) );
+        cborw_key(w, "avg_signal");
+        cborw_double(w, sqlite3_column_double(stmt, SQL_IDX_FRAME_AVG_SIGNAL) );
+        cborw_key(w, "seq_number");
+        cborw_integer(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_SEQ_NUMBER) );
+
+        if ( merged )
+        {
+            cborw_key(w, "receptions");
+            cborw_array(w);
+        }
+    }
+
+    if ( merged )
+    {
+        cborw_map(w, 5);
+    }
+
+    cborw_key(w, "station");
+    cborw_text(w, (const char *) sqlite3_column_text(stmt, SQL_IDX_FRAME_STATION),
+               sqlite3_column_bytes(stmt, SQL_IDX_FRAME_STATION) );
+    cborw_key(w, "snr");
+    cborw_double(w, sqlite3_column_double(stmt, SQL_IDX_FRAME_SNR) );
+    cborw_key(w, "rssi");
+    cborw_double(w, sqlite3_column_double(stmt, SQL_IDX_FRAME_RSSI) );
+    cborw_key(w, "latitude");
+    cborw_integer(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_LATITUDE) );
+    cborw_key(w, "longitude");
+    cborw_integer(w, sqlite3_column_int(stmt, SQL_IDX_FRAME_LONGITUDE) );
+}
+
+
+
+static void send_chunk(void         *ctx,
+                       const char   *buf,
+                       size_t       len
+                       )
+{
+    db_export_t         *export = ctx;
+
+
+    if ( ! export->started )
+    {
+        send_header(export, len);
+    }
+
+
+    // The compressed bytes reach send_body each time the output buffer of the stream is full
+    if ( ! export->gzip )
+    {
+        send_body(export, buf, len);
+    }
+    else if ( gzip_stream_write(export->gzip, buf, len, 0) )
+    {
+        eprintf("Can not compress the reply\n");
+    }
+}
+
+
+
+static void send_header(db_export_t     *export,
+                        size_t          len
+                        )
+{
+    char                headers[512];
+    int                 n       = 0;
+
+
+    if ( export->encoding && (len >= DB_GZIP_MIN_SIZE) )
+    {
+        export->gzip = gzip_stream_new(export->encoding, export->level, send_body, export);
+    }
+
+
+    // Content-Encoding goes with the other extra lines, the cached reply is the compressed one
+    if ( export->gzip )
+    {
+        n = snprintf(export->headers + export->headers_len, sizeof(export->headers) - export->headers_len,
+                     "Content-Encoding: %s\r\n", gzip_name(export->encoding) );
+        export->headers_len += n;
+    }
+
+    n = snprintf(headers, sizeof(headers),
+                 "HTTP/1.1 200 OK\r\n%s%s%s%.*sTransfer-Encoding: chunked\r\n\r\n",
+                 (export->etag[0]) ? "ETag: " : "", export->etag, (export->etag[0]) ? "\r\n" : "",
+                 (int) export->headers_len, export->headers);
+    mg_send(export->nc, headers, n);
+    export->started = 1;
+}
+
+
+
+static void send_body(void          *ctx,
+                      const char    *buf,
+                      size_t        len
+                      )
+{
+    db_export_t         *export = ctx;
+    size_t              size    = 0;
+    char                *copy   = NULL;
+
+
+    mg_send_http_chunk(export->nc, buf, len);
+
+    if ( ! export->key_len )
+    {
+        return;
+    }
+
+
+    // A reply too large for the cache is only streamed
+    size = (export->copy_size) ? export->copy_size : DB_EXPORT_CHUNK;
+
+    while ( size < export->copy_len + len )
+    {
+        size *= 2;
+    }
+
+    if ( size > export->copy_size )
+    {
+        copy = (size <= DB_CACHE_REPLY_MAX) ? realloc(export->copy, size) : NULL;
+
+        if ( ! copy )
+        {
+            free(export->copy);
+            export->copy        = NULL;
+            export->copy_len    = 0;
+            export->copy_size   = 0;
+            export->key_len     = 0;
+
+            return;
+        }
+
+        export->copy        = copy;
+        export->copy_size   = size;
+    }
+
+    memcpy(export->copy + export->copy_len, buf, len);
+    export->copy_len += len;
+}
+
+
+
+static int db_cache_reply(db_plugin_t                   *plugin,
+                          struct mg_connection          *nc,
+                          const struct http_message     *hm,
+                          int                           level,
+                          DB_Format                     format,
+                          unsigned long long            *version
+                          )
+{
+    char                    key[DB_CACHE_KEY];
+    char                    etag[48];
+    char                    headers[512];
+    const struct mg_str     *match  = mg_get_http_header( (struct http_message *) hm, "If-None-Match");
+    const cache_entry_t     *entry  = NULL;
+    size_t                  key_len = 0;
+    size_t                  i       = 0;
+    int                     len     = 0;
+
+
+    // The version changes with each commit of the writer, the statements of a read see at least this version
+    *version = 0;
+
+    if ( sqlite3_step(plugin->data_version) == SQLITE_ROW )
+    {
+        *version = (unsigned long long) sqlite3_column_int64(plugin->data_version, 0);
+    }
+
+    sqlite3_reset(plugin->data_version);
+
+    if ( ! *version || ( (key_len = db_cache_key(hm, db_encoding(hm, level), format, key, sizeof(key) ) ) == 0) )
+    {
+        return (0);
+    }
+
+    db_cache_etag(etag, sizeof(etag), *version, key, key_len);
+
+
+    // If-None-Match holds one or more tags, the client has the reply if one of them is the current one
+    for ( i = 0; match && (i + strlen(etag) <= match->len); ++i )
+    {
+        if ( memcmp(match->p + i, etag, strlen(etag) ) == 0 )
+        {
+            plugin->not_modified++;
+            len = snprintf(headers, sizeof(headers), "HTTP/1.1 304 Not Modified\r\nETag: %s\r\n\r\n", etag);
+            mg_send(nc, headers, len);
+
+            return (1);
+        }
+    }
+
+    if ( (entry = cache_get(&plugin->cache, key, key_len, *version) ) == NULL )
+    {
+        return (0);
+    }
+
+    len = snprintf(headers, sizeof(headers),
+                   "HTTP/1.1 200 OK\r\nETag: %s\r\n%.*sContent-Length: %zu\r\n\r\n",
+                   etag, (int) entry->headers_len, cache_headers(entry), entry->body_len);
+    mg_send(nc, headers, len);
+    mg_send(nc, cache_body(entry), entry->body_len);
+
+#ifdef __DEBUG__
+    gprintf("200 OK (cached)\n");
+#endif
+
+    return (1);
+}
+
+
+
+static size_t db_cache_key(const struct http_message    *hm,
+                           gzip_encoding_t              encoding,
+                           DB_Format                    format,
+                           char                         *key,
+                           size_t                       size
+                           )
+{
+    static const char * const   params[] = {"after_id", "before_id", "from", "limit", "to", "view"};
+    char                        value[32];
+    size_t                      len     = 0;
+    size_t                      i       = 0;
+    int                         n       = 0;
+
+
+    if ( hm->uri.len >= size )
+    {
+        return (0);
+    }
+
+    memcpy(key, hm->uri.p, hm->uri.len);
+    len = hm->uri.len;
+
+
+    // The other parameters do not change the reply, the order of the query string does not matter
+    for ( i = 0; i < sizeof(params) / sizeof(params[0]); ++i )
+    {
+        n = mg_get_http_var(&hm->query_string, params[i], value, sizeof(value) );
+
+        if ( n == -1 )
+        {
+            continue;
+        }
+
+        n = (n < 0) ? -1 : snprintf(key + len, size - len, "&%s=%s", params[i], value);
+
+        if ( (n < 0) || ( (size_t) n >= size - len) )
+        {
+            return (0);
+        }
+
+        len += n;
+    }
+
+    if ( format )
+    {
+        n = snprintf(key + len, size - len, "&format=%s", s_formats[format][0]);
+
+        if ( (n < 0) || ( (size_t) n >= size - len) )
+        {
+            return (0);
+        }
+
+        len += n;
+    }
+
+    if ( encoding )
+    {
+        n = snprintf(key + len, size - len, "&encoding=%s", gzip_name(encoding) );
+
+        if ( (n < 0) || ( (size_t) n >= size - len) )
+        {
+            return (0);
+        }
+
+        len += n;
+    }
+
+    return (len);
+}
+
+
+
+static gzip_encoding_t db_encoding(const struct http_message    *hm,
+                                   int                          level
+                                   )
+{
+    const struct mg_str     *accept = mg_get_http_header( (struct http_message *) hm, "Accept-Encoding");
+
+
+    return ( (level && accept) ? gzip_accepted(accept->p, accept->len) : GZIP_IDENTITY);
+}
+
+
+
+static int db_format(const struct http_message    *hm,
+                     DB_Format                    *format
+                     )
+{
+    const struct mg_str     *accept = mg_get_http_header( (struct http_message *) hm, "Accept");
+    const char              *p      = (accept) ? accept->p : NULL;
+    const char              *end    = (accept) ? accept->p + accept->len : NULL;
+    const char              *type   = NULL;
+    char                    name[8];
+    size_t                  i       = 0;
+    int                     len     = mg_get_http_var(&hm->query_string, "format", name, sizeof(name) );
+
+
+    *format = DB_FORMAT_JSON;
+
+    if ( len != -1 )
+    {
+        for ( i = 0; (len >= 0) && (i < sizeof(s_formats) / sizeof(s_formats[0]) ); ++i )
+        {
+            if ( strcmp(name, s_formats[i][0]) == 0 )
+            {
+                *format = (DB_Format) i;
+
+                return (0);
+            }
+        }
+
+        return (-1);
+    }
+
+
+    // The media types of Accept in order, */* and the types that are not supported are skipped
+    while ( p && (p < end) )
+    {
+        while ( (p < end) && ( (*p == ' ') || (*p == ',') ) )
+        {
+            ++p;
+        }
+
+        for ( type = p; (p < end) && (*p != ',') && (*p != ';') && (*p != ' '); ++p )
+        {
+        }
+
+        for ( i = 0; i < sizeof(s_formats) / sizeof(s_formats[0]); ++i )
+        {
+            if ( (strlen(s_formats[i][1]) == (size_t) (p - type) ) && (mg_ncasecmp(type, s_formats[i][1], p - type) == 0) )
+            {
+                *format = (DB_Format) i;
+
+                return (0);
+            }
+        }
+
+        while ( (p < end) && (*p != ',') )
+        {
+            ++p;
+        }
+    }
+
+    return (0);
+}
+
 
 
-sqlite3* db_open(const char *db_path)
+static void db_cache_etag(char                  *etag,
+                          size_t                size,
+                          unsigned long long    version,
+                          const char            *key,
+                          size_t                key_len
+                          )
 {
-    sqlite3     *db = NULL;
+    unsigned int        hash    = 2166136261U;
+    size_t              i       = 0;
 
 
-    if ( sqlite3_open_v2(db_path, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX,
-                         NULL) == SQLITE_OK )
+    // FNV-1a
+    for ( i = 0; i < key_len; ++i )
     {
-        sqlite3_exec(db, CREATE_SIGFOX_TABLES, 0, 0, 0);
+        hash = (hash ^ (unsigned char) key[i]) * 16777619U;
     }
 
-    return (db);
+    snprintf(etag, size, "\"%llx-%08x\"", version, hash);
 }
 
 
 
-void db_close(void **db_handler)
+static int query_integer(const struct http_message    *hm,
+                         const char                   *name,
+                         long long                    min,
+                         long long                    max,
+                         long long                    *value
+                         )
 {
-    if ( (db_handler != NULL) && (*db_handler != NULL) )
+    char        buf[24];
+    int         len     = mg_get_http_var(&hm->query_string, name, buf, sizeof(buf) );
+
+
+    // -1: the parameter is not given, -2: it does not fit in buf
+    if ( len == -1 )
     {
-        sqlite3_close(*db_handler);
-        *db_handler = NULL;
+        return (0);
     }
+
+    return ( ( (len < 0) || (numparse_integer(buf, len, min, max, value) != NUMPARSE_OK) ) ? -1 : 0);
 }
 
 
 
-void db_op(struct mg_connection         *nc,
-           const struct http_message    *hm,
-           const struct mg_str          *key,
-           void                         *db,
-           int                          op
-           )
+static int page_bound(sqlite3_stmt     *stmt,
+                      long long        after_id,
+                      long long        before_id,
+                      long long        limit,
+                      long long        *bound
+                      )
 {
-    switch ( op )
-    {
-        case API_OP_GET:
-            op_get(nc, hm, key, db);
-            break;
+    int         result  = SQLITE_DONE;
+    int         more    = 0;
 
-        case API_OP_SET:
-            op_set(nc, hm, key, db);
-            break;
 
-        case API_OP_DEL:
-            op_del(nc, hm, key, db);
-            break;
+    sqlite3_bind_int64(stmt, 1, after_id);
+    sqlite3_bind_int64(stmt, 2, before_id);
+    sqlite3_bind_int64(stmt, 3, limit - 1);
 
-        default:
-            MG_PRINTF_501
-            break;
+    *bound = 0;
+    result = sqlite3_step(stmt);
+
+    if ( result == SQLITE_ROW )
+    {
+        *bound  = sqlite3_column_int64(stmt, 0);
+        result  = sqlite3_step(stmt);
+        more    = (result == SQLITE_ROW);
     }
-}
 
+    sqlite3_reset(stmt);
 
+    return ( ( (result == SQLITE_ROW) || (result == SQLITE_DONE) ) ? more : -1);
+}
 
-static void op_set(struct mg_connection         *nc,
-                   const struct http_message    *hm,
-                   const struct mg_str          *key __attribute__( (unused) ),
-                   void                         *db
-                   )
-{
-    sqlite3_stmt        *stmt       = NULL;
-    const struct mg_str     *body   = (hm->query_string.len > 0) ? &hm->query_string : &hm->body;
-    struct json_token       *root   = NULL;
-    sigfox_raws_t           raws;
-    int                 result      = 0;
 
 
-    root = parse_json2(body->p, body->len);
+static int frames_bound(sqlite3_stmt           *stmt,
+                        const unsigned char    *value,
+                        long long              from,
+                        long long              after_id,
+                        long long              to,
+                        long long              limit,
+                        long long              last[2]
+                        )
+{
+    int         result  = SQLITE_DONE;
+    int         more    = 0;
 
-    if ( ! root )
-    {
-        MG_PRINTF_400
 
-        return;
-    }
+    sqlite3_bind_text(stmt, 1, (const char *) value, strlen( (const char *) value), SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, from);
+    sqlite3_bind_int64(stmt, 3, after_id);
+    sqlite3_bind_int64(stmt, 4, to);
+    sqlite3_bind_int64(stmt, 5, limit - 1);
+    result = sqlite3_step(stmt);
 
-    if ( raws_from_json(&raws, root) )
+    if ( result == SQLITE_ROW )
     {
-        MG_PRINTF_400
-
-        return;
+        last[0] = sqlite3_column_int64(stmt, 0);
+        last[1] = sqlite3_column_int64(stmt, 1);
+        result  = sqlite3_step(stmt);
+        more    = (result == SQLITE_ROW);
     }
 
-    // Prepare the SQLite statement
-    if ( sqlite3_prepare_v2(db, INSERT_RAWS, -1, &stmt, NULL) == SQLITE_OK )
-    {
-        sqlite3_bind_int(stmt, SQL_IDX_TIMESTAMP, raws.timestamp);
-        sqlite3_bind_text(stmt,
-                          SQL_IDX_ID_MODEM,
-                          (const char *) raws.id_modem,
-                          strlen( (const char *) raws.id_modem),
-                          SQLITE_STATIC);
-        sqlite3_bind_double(stmt, SQL_IDX_SNR, raws.snr);
-        sqlite3_bind_text(stmt,
-                          SQL_IDX_STATION,
-                          (const char *) raws.station,
-                          strlen( (const char *) raws.station),
-                          SQLITE_STATIC);
-        sqlite3_bind_int(stmt, SQL_IDX_ACK, raws.ack);
-        sqlite3_bind_text(stmt,
-                          SQL_IDX_DATA_STR,
-                          (const char *) raws.data_str,
-                          strlen( (const char *) raws.data_str),
-                          SQLITE_STATIC);
-        sqlite3_bind_blob(stmt, SQL_IDX_DATA_HEX, (void *) raws.data_hex, sizeof(raws.data_hex), SQLITE_STATIC);
-        sqlite3_bind_int(stmt, SQL_IDX_DUPLICATE, raws.duplicate);
-        sqlite3_bind_double(stmt, SQL_IDX_AVG_SIGNAL, raws.avg_signal);
-        sqlite3_bind_double(stmt, SQL_IDX_RSSI, raws.rssi);
-        sqlite3_bind_int(stmt, SQL_IDX_LATITUDE, raws.latitude);
-        sqlite3_bind_int(stmt, SQL_IDX_LONGITUDE, raws.longitude);
-        sqlite3_bind_int(stmt, SQL_IDX_SEQ_NUMBER, raws.seq_number);
-        result = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
 
-    if ( raws.ack && (result == SQLITE_DONE) )
-    {
-        char     downlink_data[SIGFOX_DOWNLINK_DATA_LENGTH + 1];
+    return ( ( (result == SQLITE_ROW) || (result == SQLITE_DONE) ) ? more : -1);
+}
 
 
-        // Copy the first 16 bytes of data_str
-        memset(downlink_data, 0, sizeof(downlink_data) );
-        strncpy(downlink_data, (const char *) raws.data_str, SIGFOX_DOWNLINK_DATA_LENGTH);
-        downlink_data[0] += 1;
 
+static void db_export_free(db_export_t *export)
+{
+    sqlite3_reset(export->stmt);
+    gzip_stream_free(export->gzip);
+    free(export->copy);
 
-        // Send headers
-        mg_printf(nc, "HTTP/1.1 201 Created\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
-        mg_printf_http_chunk(nc, "{ \"%s\": { \"downlinkData\": \"%s\" } }", raws.id_modem, downlink_data);
-        mg_send_http_chunk(nc, "", 0);
 
-#ifdef __DEBUG__
-        gprintf("201 Created\n");
-#endif
-    }
-    else if ( result == SQLITE_DONE )
+    // Keep one statement prepared, the others were only needed by concurrent reads
+    if ( ! *export->cache )
     {
-        MG_PRINTF_204
+        *export->cache = export->stmt;
     }
     else
     {
-        MG_PRINTF_500
+        sqlite3_finalize(export->stmt);
     }
+
+    free(export);
 }
 
 
 
-static void op_get(struct mg_connection         *nc,
-                   const struct http_message    *hm __attribute__( (unused) ),
-                   const struct mg_str          *key __attribute__( (unused) ),
-                   void                         *db
-                   )
+int db_poll(void *db)
 {
-    sqlite3_stmt     *stmt = NULL;
+    db_plugin_t         *plugin = db;
+    db_export_t         **link  = &plugin->exports;
+    db_export_t         *export = NULL;
+    const time_t        now     = time(NULL);
+    int                 ready   = 0;
 
 
-    if ( sqlite3_prepare_v2(db, SELECT_RAWS, -1, &stmt, NULL) == SQLITE_OK )
+    while ( *link )
     {
-        sqlite3_step(stmt);
+        export = *link;
 
 
-        // Send headers
-        mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+        // The client has not read the previous slices yet, it is dropped once it stops reading for too long
+        if ( (export->nc->send_mbuf.len >= DB_EXPORT_BUFFER) && (now - export->active >= DB_EXPORT_IDLE) )
+        {
+            eprintf("Read dropped, its client did not read for %d seconds\n", DB_EXPORT_IDLE);
+            export->nc->flags  |= MG_F_CLOSE_IMMEDIATELY;
+            *link               = export->next;
+            plugin->export_timeouts++;
+            db_export_free(export);
+            continue;
+        }
 
+        if ( export->nc->send_mbuf.len >= DB_EXPORT_BUFFER )
+        {
+            link = &export->next;
+            continue;
+        }
 
-        // Open the JSON list
-        mg_printf_http_chunk(nc, "[ ");
+        plugin->export_slices++;
+        export->active = now;
 
-        // While there is a SQLite row being returned, we process it
-        // The final step returns a SQLITE_DONE
-        for ( ; sqlite3_step(stmt) == SQLITE_ROW; )
+        if ( send_frames(plugin, export, DB_EXPORT_SLICE) )
         {
-            mg_printf_http_chunk(nc, "{ ");
-            mg_printf_http_chunk(nc, "\"timestamp\": %lu, ", sqlite3_column_int(stmt, SQL_IDX_TIMESTAMP) );
-            mg_printf_http_chunk(nc, "\"id_modem\": \"%s\", ", sqlite3_column_text(stmt, SQL_IDX_ID_MODEM) );
-            mg_printf_http_chunk(nc, "\"snr\": %f, ", sqlite3_column_double(stmt, SQL_IDX_SNR) );
-            mg_printf_http_chunk(nc, "\"station\": \"%s\", ", sqlite3_column_text(stmt, SQL_IDX_STATION) );
-            mg_printf_http_chunk(nc, "\"ack\": %u, ", (sqlite3_column_int(stmt, SQL_IDX_ACK) ) ? "true" : "false");
-            mg_printf_http_chunk(nc, "\"data_str\": \"%s\", ", sqlite3_column_text(stmt, SQL_IDX_DATA_STR) );
-            mg_printf_http_chunk(nc, "\"duplicate\": %u, ", (sqlite3_column_int(stmt,
-                                                                                SQL_IDX_DUPLICATE) ) ? "true" : "false");
-            mg_printf_http_chunk(nc, "\"avg_signal\": %f, ", sqlite3_column_double(stmt, SQL_IDX_AVG_SIGNAL) );
-            mg_printf_http_chunk(nc, "\"rssi\": %f, ", sqlite3_column_double(stmt, SQL_IDX_RSSI) );
-            mg_printf_http_chunk(nc, "\"latitude\": %lu, ", sqlite3_column_int(stmt, SQL_IDX_LATITUDE) );
-            mg_printf_http_chunk(nc, "\"longitude\": %lu, ", sqlite3_column_int(stmt, SQL_IDX_LONGITUDE) );
-            mg_printf_http_chunk(nc, "\"seq_number\": %lu ", sqlite3_column_int(stmt, SQL_IDX_SEQ_NUMBER) );
-            mg_printf_http_chunk(nc, "}, ");
+            *link = export->next;
+            db_export_free(export);
+            continue;
         }
 
-        sqlite3_finalize(stmt);
+        ready  += (export->nc->send_mbuf.len < DB_EXPORT_BUFFER);
+        link    = &export->next;
+    }
 
+    arena_reset(&plugin->arena);
 
-        // Close the JSON list
-        mg_printf_http_chunk(nc, "]");
+    return (ready);
+}
 
 
-        // Send empty chunk, the end of response
-        mg_send_http_chunk(nc, "", 0);
 
-#ifdef __DEBUG__
-        gprintf("200 OK\n");
-#endif
-    }
-    else
+void db_disconnect(void                 *db,
+                   struct mg_connection *nc
+                   )
+{
+    db_plugin_t         *plugin = db;
+    db_export_t         **link  = &plugin->exports;
+    db_export_t         *export = NULL;
+
+
+    while ( *link )
     {
-        MG_PRINTF_500
+        export = *link;
+
+        if ( export->nc == nc )
+        {
+            *link = export->next;
+            db_export_free(export);
+        }
+        else
+        {
+            link = &export->next;
+        }
     }
 }
 
@@ -311,318 +4190,601 @@ static void op_get(struct mg_connection         *nc,
 static void op_del(struct mg_connection         *nc,
                    const struct http_message    *hm __attribute__( (unused) ),
                    const struct mg_str          *key __attribute__( (unused) ),
-                   void                         *db
+                   db_plugin_t                  *plugin
                    )
 {
-    if ( sqlite3_exec(db, DELETE_RAWS, 0, 0, 0) == SQLITE_OK )
-    {
-        MG_PRINTF_200
-    }
-    else
-    {
-        MG_PRINTF_500
-    }
-}
+    db_pending_t     pending;
 
 
-
-static unsigned char raws_from_json(sigfox_raws_t       *raws,
-                                    struct json_token   *jobj
-                                    )
-{
-    struct json_token     *tmp = NULL; // Temporary JSON struct
+    memset(&pending, 0, sizeof(pending) );
+    pending.op = API_OP_DEL;
+    db_write(plugin, nc, &pending);
+}
 
 
-    memset(raws, 0, sizeof(*raws) );
 
+static void op_downlink(struct mg_connection        *nc,
+                        const struct http_message   *hm,
+                        const unsigned char         *id_modem,
+                        db_plugin_t                 *plugin,
+                        int                         op
+                        )
+{
+    const char      *data = NULL;
+    char            payload[SIGFOX_DOWNLINK_DATA_LENGTH + 1];
 
-    // Get the modem
-    tmp = find_json_token(jobj, SQL_COL_ID_MODEM);          // Get the JSON object
 
-    if ( tmp )
+    switch ( op )
     {
-        unsigned short      length = (tmp->len > SIGFOX_DEVICE_LENGTH) ? SIGFOX_DEVICE_LENGTH : tmp->len;
-        char                modem_ascii[length + 1];
-        memset(modem_ascii, 0, sizeof(modem_ascii) );
+        case API_OP_GET:
+            data = downlink_get(plugin->downlinks, id_modem);
 
-        memcpy(raws->id_modem, tmp->ptr, length);
+            if ( ! data )
+            {
+                MG_PRINTF_404
+                break;
+            }
+
+            mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+            db_printf_chunk(plugin, nc, "{ \"%s\": { \"downlinkData\": \"%s\" } }", id_modem, data);
+            mg_send_http_chunk(nc, "", 0);
 
 #ifdef __DEBUG__
-        iprintf("raws->id_modem : %s (%hu)\n", raws->id_modem, length);
+            gprintf("200 OK\n");
 #endif
-    }
-    else
-    {
-        return (1);
-    }
+            break;
+
+        case API_OP_SET:
 
-    // Get the timestamp
-    tmp = find_json_token(jobj, SQL_COL_TIMESTAMP);          // Get the JSON object
+            if ( downlink_body(hm, payload, plugin) )
+            {
+                MG_PRINTF_400
+            }
+            else if ( downlink_set(plugin->downlinks, id_modem, payload) )
+            {
+                MG_PRINTF_500
+            }
+            else
+            {
+                MG_PRINTF_204
+            }
 
-    if ( tmp )
-    {
-        char     timestamp_ascii[tmp->len + 1];
-        memset(timestamp_ascii, 0, sizeof(timestamp_ascii) );
+            break;
 
-        memcpy(timestamp_ascii, tmp->ptr, tmp->len);          // Fill the string
-        raws->timestamp = strtol(timestamp_ascii, NULL, 10);          // Transform the string into a time_t
+        case API_OP_DEL:
 
-#ifdef __DEBUG__
-        iprintf("raws->timestamp : %ld (%lu)\n", raws->timestamp, sizeof(raws->timestamp) );
-#endif
-    }
-    else
-    {
-        return (2);
+            if ( downlink_del(plugin->downlinks, id_modem) )
+            {
+                MG_PRINTF_404
+            }
+            else
+            {
+                MG_PRINTF_204
+            }
+
+            break;
+
+        default:
+            MG_PRINTF_501
+            break;
     }
+}
+
+
+
+static void op_downlinks(struct mg_connection       *nc,
+                         const struct http_message  *hm,
+                         const unsigned char        *id_modem,
+                         db_plugin_t                *plugin,
+                         int                        op
+                         )
+{
+    const downlink_queued_t     *head   = NULL;
+    const downlink_queued_t     *queued = NULL;
+    db_pending_t                pending;
 
-    // Get the duplicate
-    tmp = find_json_token(jobj, SQL_COL_DUPLICATE);          // Get the JSON object
 
-    if ( tmp )
+    switch ( op )
     {
-        char     duplicate_ascii[tmp->len + 1];
-        memset(duplicate_ascii, 0, sizeof(duplicate_ascii) );
+        case API_OP_GET:
+            head = downlink_queue(plugin->downlinks, id_modem);
+            mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+            db_printf_chunk(plugin, nc, "[");
 
-        memcpy(duplicate_ascii, tmp->ptr, tmp->len);          // Fill the string$
+            for ( queued = head; queued; queued = queued->next )
+            {
+                db_printf_chunk(plugin, nc, "%s{ \"id\": %lld, \"downlinkData\": \"%s\" }", (queued == head) ? " " : ", ",
+                                (long long) queued->id, queued->data);
+            }
 
-        if ( strncmp(duplicate_ascii, "true", 4) == 0 )
-        {
-            raws->duplicate = 1;
-        }
+            db_printf_chunk(plugin, nc, " ]");
+            mg_send_http_chunk(nc, "", 0);
 
 #ifdef __DEBUG__
-        iprintf("raws->duplicate : %u (%lu)\n", raws->duplicate, sizeof(raws->duplicate) );
+            gprintf("200 OK\n");
 #endif
-    }
-    else
-    {
-        return (3);
-    }
+            break;
 
-    // Get the modem
-    tmp = find_json_token(jobj, SQL_COL_SNR);          // Get the JSON object
+        case API_OP_SET:
+            memset(&pending, 0, sizeof(pending) );
+            pending.op = API_OP_DOWNLINK;
 
-    if ( tmp )
-    {
-        char     snr_ascii[tmp->len + 1];
-        memset(snr_ascii, 0, sizeof(snr_ascii) );
+            if ( downlink_body(hm, pending.downlink_data, plugin) )
+            {
+                MG_PRINTF_400
+                break;
+            }
 
-        memcpy(snr_ascii, tmp->ptr, tmp->len);          // Fill the string
-        raws->snr = strtod(snr_ascii, NULL);          // Transform the string into a double
+            memcpy(pending.raws.id_modem, id_modem, SIGFOX_DEVICE_LENGTH + 1);
+            pending.downlink_id = ++plugin->last_downlink_id;
 
-#ifdef __DEBUG__
-        iprintf("raws->snr : %f (%lu)\n", raws->snr, sizeof(raws->snr) );
-#endif
-    }
-    else
-    {
-        return (4);
+
+            // The payload is answered to the frames once its row is committed (downlink_commit)
+            db_write(plugin, nc, &pending);
+            break;
+
+        default:
+            MG_PRINTF_501
+            break;
     }
+}
 
-    // Get the station
-    tmp = find_json_token(jobj, SQL_COL_STATION);          // Get the JSON object
 
-    if ( tmp )
-    {
-        unsigned short      length = (tmp->len > SIGFOX_STATION_LENGTH) ? SIGFOX_STATION_LENGTH : tmp->len;
-        char                station_ascii[length + 1];
-        memset(station_ascii, 0, sizeof(station_ascii) );
 
-        memcpy(raws->station, tmp->ptr, length);
+static int path_key(const struct mg_str   *key,
+                    const char            *prefix,
+                    size_t                max,
+                    unsigned char         *id,
+                    struct mg_str         *rest
+                    )
+{
+    const size_t        prefix_len  = strlen(prefix);
+    size_t              len         = 0;
 
-#ifdef __DEBUG__
-        iprintf("raws->station : %s (%hu)\n", raws->station, length);
-#endif
+
+    if ( (key->len <= prefix_len) || memcmp(key->p, prefix, prefix_len) )
+    {
+        return (0);
     }
-    else
+
+    for ( len = 0; (prefix_len + len < key->len) && (key->p[prefix_len + len] != '/'); ++len )
     {
-        return (5);
+        if ( (len == max) || ! isxdigit( (unsigned char) key->p[prefix_len + len]) )
+        {
+            return (0);
+        }
+
+        id[len] = key->p[prefix_len + len];
     }
 
-    // Get the datas
-    tmp = find_json_token(jobj, SQL_COL_DATA_STR);          // Get the JSON object
+    id[len]     = '\0';
+    rest->p     = key->p + prefix_len + len;
+    rest->len   = key->len - prefix_len - len;
 
-    if ( tmp )
-    {
-        unsigned short      length = (tmp->len > SIGFOX_DATA_STR_LENGTH) ? SIGFOX_DATA_STR_LENGTH : tmp->len;
-        char                data_ascii[length + 1];
-        memset(data_ascii, 0, sizeof(data_ascii) );
+    return (len > 0);
+}
 
-        memcpy(raws->data_str, tmp->ptr, length);
-        convert_data_str_to_data_hex(raws->data_str, raws->data_hex);
 
-#ifdef __DEBUG__
-        iprintf("raws->data_str : %s (%hu)\n", raws->data_str, length);
-        iprintf("raws->data_hex : %s (%hu)\n", raws->data_hex, length);
-#endif
-    }
-    else
-    {
-        return (6);
-    }
 
-    // Get the modem
-    tmp = find_json_token(jobj, SQL_COL_AVG_SIGNAL);          // Get the JSON object
+static int downlink_body(const struct http_message  *hm,
+                         char                       data[SIGFOX_DOWNLINK_DATA_LENGTH + 1],
+                         db_plugin_t                *plugin
+                         )
+{
+    const size_t            mark    = plugin->arena.used;
+    struct json_token       *tokens = NULL;
+    struct json_token       *token  = NULL;
+    unsigned char           payload[SIGFOX_DOWNLINK_DATA_LENGTH / 2];
+    int                     count   = DB_JSON_TOKENS;
+    int                     result  = JSON_TOKEN_ARRAY_TOO_SMALL;
+
 
-    if ( tmp )
+    // A token takes at least one character of the body, so there is no need to go beyond its length
+    while ( (result == JSON_TOKEN_ARRAY_TOO_SMALL) && (count / 2 <= (int) hm->body.len) )
     {
-        char     avg_signal_ascii[tmp->len + 1];
-        memset(avg_signal_ascii, 0, sizeof(avg_signal_ascii) );
+        arena_rewind(&plugin->arena, mark);
+        tokens  = arena_alloc(&plugin->arena, count * sizeof(struct json_token) );
+        result  = (tokens) ? parse_json(hm->body.p, hm->body.len, tokens, count) : JSON_STRING_INVALID;
+        count  *= 2;
+    }
 
-        memcpy(avg_signal_ascii, tmp->ptr, tmp->len);          // Fill the string
-        raws->avg_signal = strtod(avg_signal_ascii, NULL);          // Transform the string into a double
+    token   = (result >= 0) ? find_json_token(tokens, "downlinkData") : NULL;
+    result  = -1;
 
-#ifdef __DEBUG__
-        iprintf("raws->avg_signal : %f (%lu)\n", raws->avg_signal, sizeof(raws->avg_signal) );
-#endif
-    }
-    else
+
+    // The payload is 8 bytes, written as 16 hexadecimal characters
+    if ( token && (token->type == JSON_TYPE_STRING) && (token->len == SIGFOX_DOWNLINK_DATA_LENGTH) &&
+         (hex_decode( (const unsigned char *) token->ptr, token->len, payload, NULL) == 0) )
     {
-        return (7);
+        memcpy(data, token->ptr, SIGFOX_DOWNLINK_DATA_LENGTH);
+        data[SIGFOX_DOWNLINK_DATA_LENGTH]   = '\0';
+        result                              = 0;
     }
 
-    // Get the duplicate
-    tmp = find_json_token(jobj, SQL_COL_LATITUDE);          // Get the JSON object
+    return (result);
+}
 
-    if ( tmp )
-    {
-        char     latitude_ascii[tmp->len + 1];
-        memset(latitude_ascii, 0, sizeof(latitude_ascii) );
 
-        memcpy(latitude_ascii, tmp->ptr, tmp->len);          // Fill the string$
-        raws->latitude = strtol(latitude_ascii, NULL, 10);          // Transform the string into a number
 
-#ifdef __DEBUG__
-        iprintf("raws->latitude : %u (%lu)\n", raws->latitude, sizeof(raws->latitude) );
-#endif
+static void op_stats(struct mg_connection       *nc,
+                     const struct http_message  *hm __attribute__( (unused) ),
+                     const struct mg_str        *key __attribute__( (unused) ),
+                     db_plugin_t                *plugin
+                     )
+{
+    static const char       *modes[]    = {"off", "drop", "flag"};
+    const dedup_t           *dedup      = plugin->dedup;
+    const histogram_t       *latency    = &plugin->ack_latency;
+    const db_export_t       *export     = NULL;
+    const heap_stats_t      heap        = heap_stats();
+    unsigned int            active      = 0;
+    unsigned int            i           = 0;
+
+
+    mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+    db_printf_chunk(plugin, nc,
+                    "{ \"dedup\": { \"mode\": \"%s\", \"capacity\": %zu, \"window\": %u, \"hits\": %lu, "
+                    "\"misses\": %lu, \"evictions\": %lu }, ",
+                    modes[plugin->dedup_mode],
+                    (dedup) ? dedup->mask + 1 : 0,
+                    (dedup) ? dedup->window : 0,
+                    (dedup) ? dedup->hits : 0,
+                    (dedup) ? dedup->misses : 0,
+                    (dedup) ? dedup->evictions : 0);
+
+
+    // Latencies in µs, bucket i counts the ones below 2^i
+    db_printf_chunk(plugin, nc,
+                    "\"downlinks\": { \"devices\": %zu, \"queued\": %zu }, \"ack_lost\": %lu, "
+                    "\"ack_latency_us\": { \"count\": %llu, \"mean\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, "
+                    "\"max\": %llu, \"buckets\": [",
+                    plugin->downlinks->count,
+                    plugin->downlinks->queued,
+                    plugin->ack_lost,
+                    (unsigned long long) latency->count,
+                    (unsigned long long) ( (latency->count) ? latency->sum / latency->count : 0),
+                    (unsigned long long) histogram_percentile(latency, 50),
+                    (unsigned long long) histogram_percentile(latency, 90),
+                    (unsigned long long) histogram_percentile(latency, 99),
+                    (unsigned long long) latency->max);
+
+    for ( i = 0; i < HISTOGRAM_BUCKETS; ++i )
+    {
+        db_printf_chunk(plugin, nc, "%s%llu", (i) ? ", " : " ", (unsigned long long) latency->buckets[i]);
     }
 
-    // Get the duplicate
-    tmp = find_json_token(jobj, SQL_COL_LONGITUDE);          // Get the JSON object
-
-    if ( tmp )
+    db_printf_chunk(plugin, nc, " ] }, ");
+    db_printf_chunk(plugin, nc,
+                    "\"admission\": { \"queue_depth\": %zu, \"queue_capacity\": %zu, \"high_watermark\": %zu, "
+                    "\"low_watermark\": %zu, \"overloaded\": %s, \"shed_queries\": %lu, \"shed_frames\": %lu, "
+                    "\"shed_full\": %lu, \"ack_queue_depth\": %zu }, ",
+                    (plugin->queue) ? mpsc_queue_size(plugin->queue) : 0,
+                    (plugin->queue) ? mpsc_queue_capacity(plugin->queue) : 0,
+                    plugin->high_watermark,
+                    plugin->low_watermark,
+                    (plugin->overloaded) ? "true" : "false",
+                    plugin->shed_queries,
+                    plugin->shed_frames,
+                    plugin->shed_full,
+                    (plugin->queue_ack) ? mpsc_queue_size(plugin->queue_ack) : 0);
+
+    for ( export = plugin->exports; export; export = export->next )
     {
-        char     longitude_ascii[tmp->len + 1];
-        memset(longitude_ascii, 0, sizeof(longitude_ascii) );
+        active++;
+    }
 
-        memcpy(longitude_ascii, tmp->ptr, tmp->len);          // Fill the string$
-        raws->longitude = strtol(longitude_ascii, NULL, 10);          // Transform the string into a number
+    db_printf_chunk(plugin, nc,
+                    "\"exports\": { \"active\": %u, \"slices\": %lu, \"rows\": %llu, \"bytes\": %llu, \"chunks\": %lu, "
+                    "\"timeouts\": %lu }, ",
+                    active, plugin->export_slices, plugin->export_rows, plugin->export_bytes, plugin->export_chunks,
+                    plugin->export_timeouts);
+
+
+    // Replies of the reads served from the cache, and the memory they hold
+    db_printf_chunk(plugin, nc,
+                    "\"cache\": { \"entries\": %u, \"bytes\": %zu, \"hits\": %lu, \"misses\": %lu, "
+                    "\"hit_ratio\": %.3f, \"not_modified\": %lu, \"stores\": %lu, \"evictions\": %lu }, ",
+                    plugin->cache.count, plugin->cache.bytes, plugin->cache.hits, plugin->cache.misses,
+                    (plugin->cache.hits + plugin->cache.misses) ?
+                    (double) plugin->cache.hits / (double) (plugin->cache.hits + plugin->cache.misses) : 0.0,
+                    plugin->not_modified, plugin->cache.stores, plugin->cache.evictions);
+
+
+    // Reads sent compressed, and the bytes of their JSON against the bytes sent
+    db_printf_chunk(plugin, nc,
+                    "\"compression\": { \"replies\": %lu, \"bytes_in\": %llu, \"bytes_out\": %llu, \"ratio\": %.3f }, ",
+                    plugin->compressed, plugin->compressed_in, plugin->compressed_out,
+                    (plugin->compressed_in) ? (double) plugin->compressed_out / (double) plugin->compressed_in : 0.0);
+
+
+    // Allocations that reached the C library, the pooled receive buffers of Mongoose are not part of them
+    db_printf_chunk(plugin, nc,
+                    "\"allocations\": { \"heap\": %lu, \"frees\": %lu, \"pooled\": %lu, \"pool_used\": %u, "
+                    "\"requests\": %lu, \"requests_allocating\": %lu, \"arena_peak\": %zu, \"arena_overflows\": %lu } }",
+                    heap.allocations,
+                    heap.frees,
+                    heap.pooled,
+                    heap.pool_used,
+                    plugin->requests,
+                    plugin->requests_allocating,
+                    plugin->arena.peak,
+                    plugin->arena.overflows);
+    mg_send_http_chunk(nc, "", 0);
 
 #ifdef __DEBUG__
-        iprintf("raws->longitude : %u (%lu)\n", raws->longitude, sizeof(raws->longitude) );
+    gprintf("200 OK\n");
 #endif
-    }
+}
+
+
+
+static void op_devstats(struct mg_connection    *nc,
+                        const unsigned char     *id_modem,
+                        db_plugin_t             *plugin
+                        )
+{
+    const devstats_t            *table  = plugin->devstats;
+    const devstats_entry_t      *entry  = NULL;
+    char                        buf[DB_DEVSTATS_CHUNK];
+    jsonw_t                     w;
+    size_t                      i       = 0;
+    int                         first   = 1;
 
-    // Get the modem
-    tmp = find_json_token(jobj, SQL_COL_RSSI);          // Get the JSON object
 
-    if ( tmp )
+    if ( id_modem && ( (entry = devstats_get(table, id_modem) ) == NULL) )
     {
-        char     rssi_ascii[tmp->len + 1];
-        memset(rssi_ascii, 0, sizeof(rssi_ascii) );
+        MG_PRINTF_404
+
+        return;
+    }
 
-        memcpy(rssi_ascii, tmp->ptr, tmp->len);          // Fill the string
-        raws->rssi = strtod(rssi_ascii, NULL);          // Transform the string into a double
+    mg_printf(nc, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+    jsonw_init(&w, buf, sizeof(buf), send_http_chunk, nc);
 
-#ifdef __DEBUG__
-        iprintf("raws->rssi : %f (%lu)\n", raws->rssi, sizeof(raws->rssi) );
-#endif
+    if ( entry )
+    {
+        devstats_json(&w, entry);
     }
     else
     {
-        return (7);
-    }
+        // In the order of the slots, the table has no other order
+        jsonw_literal(&w, "[");
 
-    // Get the timestamp
-    tmp = find_json_token(jobj, SQL_COL_SEQ_NUMBER);          // Get the JSON object
+        for ( i = 0; i <= table->mask; ++i )
+        {
+            if ( ! table->entries[i].used || ! table->entries[i].messages )
+            {
+                continue;
+            }
+
+            if ( first )
+            {
+                jsonw_literal(&w, " ");
+            }
+            else
+            {
+                jsonw_literal(&w, ", ");
+            }
+
+            devstats_json(&w, &table->entries[i]);
+            first = 0;
+        }
 
-    if ( tmp )
-    {
-        char     seq_number_ascii[tmp->len + 1];
-        memset(seq_number_ascii, 0, sizeof(seq_number_ascii) );
+        jsonw_literal(&w, " ]");
+    }
 
-        memcpy(seq_number_ascii, tmp->ptr, tmp->len);          // Fill the string
-        raws->seq_number = strtol(seq_number_ascii, NULL, 10);          // Transform the string into a time_t
+    jsonw_flush(&w);
+    mg_send_http_chunk(nc, "", 0);
 
 #ifdef __DEBUG__
-        iprintf("raws->seq_number : %u (%lu)\n", raws->seq_number, sizeof(raws->seq_number) );
+    gprintf("200 OK\n");
 #endif
+}
+
+
+
+static void op_rollups(struct mg_connection     *nc,
+                       const struct http_message    *hm,
+                       const unsigned char          *id_modem,
+                       db_plugin_t                  *plugin
+                       )
+{
+    sqlite3_stmt            *stmt           = plugin->select_rollups_page;
+    char                    name[16];
+    char                    headers[256];
+    char                    buf[DB_DEVSTATS_CHUNK];
+    long long               limit           = DB_PAGE_LIMIT;
+    long long               from            = 0;
+    long long               to              = LLONG_MAX;
+    long long               next            = 0;
+    int                     granularity     = ROLLUP_HOUR;
+    int                     len             = mg_get_http_var(&hm->query_string, "granularity", name, sizeof(name) );
+    int                     result          = 0;
+    unsigned long           rows            = 0;
+    devstats_entry_t        entry;
+    jsonw_t                 w;
+
+
+    if ( len == -1 )
+    {
+        memcpy(name, "hour", sizeof("hour") );
     }
-    else
+
+    if ( (len < -1) || ( (granularity = rollup_granularity(name) ) < 0) ||
+         query_integer(hm, "limit", 1, DB_ROLLUP_LIMIT_MAX, &limit) || query_integer(hm, "from", 0, LLONG_MAX, &from) ||
+         query_integer(hm, "to", 0, LLONG_MAX, &to) )
     {
-        return (8);
+        MG_PRINTF_400
+
+        return;
     }
 
-    // Get the duplicate
-    tmp = find_json_token(jobj, SQL_COL_ACK);          // Get the JSON object
 
-    if ( tmp )
+    // The first bucket after the page, if any, is where the next page starts
+    sqlite3_bind_text(stmt, 1, (const char *) id_modem, strlen( (const char *) id_modem), SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, rollup_seconds(granularity) );
+    sqlite3_bind_int64(stmt, 3, from);
+    sqlite3_bind_int64(stmt, 4, to);
+    sqlite3_bind_int64(stmt, 5, limit);
+    result  = sqlite3_step(stmt);
+    next    = (result == SQLITE_ROW) ? sqlite3_column_int64(stmt, 0) : 0;
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    if ( (result != SQLITE_ROW) && (result != SQLITE_DONE) )
     {
-        char     ack_ascii[tmp->len + 1];
-        memset(ack_ascii, 0, sizeof(ack_ascii) );
+        MG_PRINTF_500
+
+        return;
+    }
+
+    len = snprintf(headers, sizeof(headers), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                   "Transfer-Encoding: chunked\r\n");
 
-        memcpy(ack_ascii, tmp->ptr, tmp->len);          // Fill the string$
+    if ( result == SQLITE_ROW )
+    {
+        len += snprintf(headers + len, sizeof(headers) - len,
+                        "Link: <%.*s?granularity=%s&from=%lld&limit=%lld", (int) hm->uri.len, hm->uri.p, name, next,
+                        limit);
 
-        if ( strncmp(ack_ascii, "true", 4) == 0 )
+        if ( (size_t) len < sizeof(headers) )
         {
-            raws->ack = 1;
+            len += (to != LLONG_MAX) ? snprintf(headers + len, sizeof(headers) - len, "&to=%lld", to) : 0;
         }
 
-#ifdef __DEBUG__
-        iprintf("raws->ack : %u (%lu)\n", raws->ack, sizeof(raws->ack) );
-#endif
+        if ( (size_t) len < sizeof(headers) )
+        {
+            len += snprintf(headers + len, sizeof(headers) - len, ">; rel=\"next\"\r\n");
+        }
     }
-    else
+
+
+    // The URI was matched as /api/devices/{id_modem}/rollups, so the header always fits
+    if ( (size_t) len >= sizeof(headers) - 2 )
     {
-        raws->ack = 0;
+        MG_PRINTF_500
+
+        return;
     }
 
-    // Get the duplicate
-    tmp = find_json_token(jobj, SQL_COL_LONG_POLLING);          // Get the JSON object
+    memcpy(headers + len, "\r\n", 2);
+    mg_send(nc, headers, len + 2);
 
-    if ( tmp )
-    {
-        char     long_polling_ascii[tmp->len + 1];
-        memset(long_polling_ascii, 0, sizeof(long_polling_ascii) );
+    stmt = plugin->select_rollups;
+    sqlite3_bind_text(stmt, 1, (const char *) id_modem, strlen( (const char *) id_modem), SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, rollup_seconds(granularity) );
+    sqlite3_bind_int64(stmt, 3, from);
+    sqlite3_bind_int64(stmt, 4, to);
+    sqlite3_bind_int64(stmt, 5, limit);
 
-        memcpy(long_polling_ascii, tmp->ptr, tmp->len);          // Fill the string$
+    jsonw_init(&w, buf, sizeof(buf), send_http_chunk, nc);
+    jsonw_literal(&w, "[");
+    memset(&entry, 0, sizeof(entry) );
 
-        if ( strncmp(long_polling_ascii, "true", 4) == 0 )
+    for ( result = sqlite3_step(stmt); result == SQLITE_ROW; result = sqlite3_step(stmt) )
+    {
+        entry.messages          = sqlite3_column_int64(stmt, 1);
+        entry.receptions        = sqlite3_column_int64(stmt, 2);
+        entry.snr_min           = sqlite3_column_double(stmt, 3);
+        entry.snr_max           = sqlite3_column_double(stmt, 4);
+        entry.snr_sum           = sqlite3_column_double(stmt, 5);
+        entry.rssi_min          = sqlite3_column_double(stmt, 6);
+        entry.rssi_max          = sqlite3_column_double(stmt, 7);
+        entry.rssi_sum          = sqlite3_column_double(stmt, 8);
+        entry.avg_signal_sum    = sqlite3_column_double(stmt, 9);
+
+        if ( rows++ )
+        {
+            jsonw_literal(&w, ", { \"bucket\": ");
+        }
+        else
         {
-            raws->long_polling = 1;
+            jsonw_literal(&w, " { \"bucket\": ");
         }
 
-#ifdef __DEBUG__
-        iprintf("raws->long_polling : %u (%lu)\n", raws->long_polling, sizeof(raws->long_polling) );
-#endif
+        jsonw_integer(&w, sqlite3_column_int64(stmt, 0) );
+        jsonw_literal(&w, ", ");
+        stats_json(&w, &entry);
+        jsonw_literal(&w, " }");
     }
-    else
+
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+
+    // The header is sent, an error can only cut the list short
+    if ( result != SQLITE_DONE )
     {
-        return (10);
+        eprintf("%s\n", sqlite3_errmsg(plugin->db_read) );
     }
 
-    return (0);
+    jsonw_literal(&w, " ]");
+    jsonw_flush(&w);
+    mg_send_http_chunk(nc, "", 0);
+
+#ifdef __DEBUG__
+    gprintf("200 OK\n");
+#endif
 }
 
 
 
-static void convert_data_str_to_data_hex(const unsigned char    data_str[SIGFOX_DATA_STR_LENGTH + 1],
-                                         unsigned char          data_hex[SIGFOX_DATA_LENGTH]
-                                         )
+static void devstats_json(jsonw_t                   *w,
+                          const devstats_entry_t    *entry
+                          )
 {
-    unsigned char       i   = 0;
-    unsigned char       j   = 0;
-    size_t              len = 0;
+    char        id_modem[SIGFOX_DEVICE_LENGTH + 1];
+
+
+    jsonw_literal(w, "{ \"id_modem\": ");
+    jsonw_string(w, id_modem, devstats_id(entry, id_modem) );
+    jsonw_literal(w, ", \"first_seen\": ");
+    jsonw_integer(w, entry->first_seen);
+    jsonw_literal(w, ", \"last_seen\": ");
+    jsonw_integer(w, entry->last_seen);
+    jsonw_literal(w, ", ");
+    stats_json(w, entry);
+    jsonw_literal(w, " }");
+}
 
 
-    // Get the length of the string
-    len = strlen( (const char *) data_str);
 
-    for ( i = 0, j = 0; i < len; i += 2, ++j )
-    {
-        unsigned char     s[] = {data_str[i], data_str[i + 1], 0};
+static void stats_json(jsonw_t                  *w,
+                       const devstats_entry_t   *entry
+                       )
+{
+    const double        receptions  = (double) entry->receptions;
+    const int           received    = (entry->receptions != 0);
+
+
+    // A bucket can hold receptions of a message counted in an earlier one, its average of avg_signal is then null, and
+    // the SNR and RSSI of an entry without receptions are null rather than divided by zero
+    jsonw_literal(w, "\"messages\": ");
+    jsonw_integer(w, (long long) entry->messages);
+    jsonw_literal(w, ", \"receptions\": ");
+    jsonw_integer(w, (long long) entry->receptions);
+    jsonw_literal(w, ", \"snr\": { \"min\": ");
+    jsonw_double(w, (received) ? entry->snr_min : NAN);
+    jsonw_literal(w, ", \"avg\": ");
+    jsonw_double(w, (received) ? entry->snr_sum / receptions : NAN);
+    jsonw_literal(w, ", \"max\": ");
+    jsonw_double(w, (received) ? entry->snr_max : NAN);
+    jsonw_literal(w, " }, \"rssi\": { \"min\": ");
+    jsonw_double(w, (received) ? entry->rssi_min : NAN);
+    jsonw_literal(w, ", \"avg\": ");
+    jsonw_double(w, (received) ? entry->rssi_sum / receptions : NAN);
+    jsonw_literal(w, ", \"max\": ");
+    jsonw_double(w, (received) ? entry->rssi_max : NAN);
+    jsonw_literal(w, " }, \"avg_signal\": ");
+    jsonw_double(w, (entry->messages) ? entry->avg_signal_sum / (double) entry->messages : NAN);
+}
 
-        data_hex[j] = (unsigned char) strtol( (const char *) s, NULL, 0);
-    }
-}
\ No newline at end of file
+
+
+static void send_http_chunk(void        *nc,
+                            const char  *buf,
+                            size_t      len
+                            )
+{
+    mg_send_http_chunk(nc, buf, len);
+}
@@ -0,0 +1,197 @@
+/**
+ * @file dedup.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Fixed-memory set of the recently seen (id_modem, seq_number) pairs
+ */
+
+#include <stdlib.h>          // calloc, free
+#include <string.h>          // memchr, memcpy
+
+#include <dedup.h>
+
+
+/**
+ * @brief Number of slots probed before evicting the oldest pair
+ */
+#define DEDUP_PROBE     8
+
+
+/**
+ * @brief      Pack a pair and compute its first slot
+ *
+ * @param[in]  id_modem    The device identifier
+ * @param[in]  seq_number  The sequence number
+ * @param[out] device      The packed identifier
+ *
+ * @return     The hash of the pair
+ */
+static uint64_t dedup_hash(const unsigned char *id_modem, unsigned int seq_number, uint64_t *device);
+
+
+
+dedup_t* dedup_new(size_t       capacity,
+                   unsigned int window
+                   )
+{
+    dedup_t     *dedup  = NULL;
+    size_t      size    = DEDUP_PROBE;
+
+
+    while ( size < capacity )
+    {
+        size <<= 1;
+    }
+
+    dedup = calloc(1, sizeof(dedup_t) );
+
+    if ( ! dedup )
+    {
+        return (NULL);
+    }
+
+    dedup->entries = calloc(size, sizeof(dedup_entry_t) );
+
+    if ( ! dedup->entries )
+    {
+        free(dedup);
+
+        return (NULL);
+    }
+
+    dedup->mask     = size - 1;
+    dedup->window   = window;
+
+    return (dedup);
+}
+
+
+
+void dedup_free(dedup_t *dedup)
+{
+    if ( dedup )
+    {
+        free(dedup->entries);
+        free(dedup);
+    }
+}
+
+
+
+int dedup_check(dedup_t             *dedup,
+                const unsigned char *id_modem,
+                unsigned int        seq_number,
+                time_t              now
+                )
+{
+    const uint32_t          seen    = (uint32_t) now;
+    uint64_t                device  = 0;
+    uint64_t                hash    = dedup_hash(id_modem, seq_number, &device);
+    dedup_entry_t           *entry  = NULL;
+    dedup_entry_t           *victim = NULL;
+    unsigned int            i       = 0;
+
+
+    for ( i = 0; i < DEDUP_PROBE; ++i )
+    {
+        entry = &dedup->entries[(hash + i) & dedup->mask];
+
+
+        // A slot never used ends the probe: the pair cannot be further
+        if ( entry->seen == 0 )
+        {
+            victim = entry;
+            break;
+        }
+
+        if ( (entry->device == device) && (entry->seq_number == seq_number) )
+        {
+            if ( seen - entry->seen < dedup->window )
+            {
+                dedup->hits++;
+
+                return (1);
+            }
+
+            entry->seen = seen;
+            dedup->misses++;
+
+            return (0);
+        }
+
+
+        // The oldest pair is replaced, which is one that left the window if there is any
+        if ( ! victim || (entry->seen < victim->seen) )
+        {
+            victim = entry;
+        }
+    }
+
+    if ( (victim->seen != 0) && (seen - victim->seen < dedup->window) )
+    {
+        dedup->evictions++;
+    }
+
+    victim->device      = device;
+    victim->seq_number  = seq_number;
+    victim->seen        = seen;
+    dedup->misses++;
+
+    return (0);
+}
+
+
+
+void dedup_forget(dedup_t               *dedup,
+                  const unsigned char   *id_modem,
+                  unsigned int          seq_number
+                  )
+{
+    uint64_t            device  = 0;
+    uint64_t            hash    = dedup_hash(id_modem, seq_number, &device);
+    dedup_entry_t       *entry  = NULL;
+    unsigned int        i       = 0;
+
+
+    for ( i = 0; i < DEDUP_PROBE; ++i )
+    {
+        entry = &dedup->entries[(hash + i) & dedup->mask];
+
+        if ( entry->seen == 0 )
+        {
+            return;
+        }
+
+
+        // Not emptied, a probe has to go on past the slot: its time leaves the window and it is the next one replaced
+        if ( (entry->device == device) && (entry->seq_number == seq_number) )
+        {
+            entry->seen = 1;
+
+            return;
+        }
+    }
+}
+
+
+
+static uint64_t dedup_hash(const unsigned char  *id_modem,
+                           unsigned int         seq_number,
+                           uint64_t             *device
+                           )
+{
+    const unsigned char     *end    = memchr(id_modem, '\0', sizeof(uint64_t) );
+    uint64_t                hash    = 0;
+
+
+    *device = 0;
+    memcpy(device, id_modem, (end) ? (size_t) (end - id_modem) : sizeof(uint64_t) );
+
+
+    // Mix the pair so the consecutive sequence numbers of a device spread over the table
+    hash    = (*device ^ (seq_number * 0x9E3779B97F4A7C15ULL) ) * 0xFF51AFD7ED558CCDULL;
+    hash   ^= hash >> 32;
+
+    return (hash);
+}
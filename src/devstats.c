@@ -0,0 +1,278 @@
+/**
+ * @file devstats.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  In-memory statistics of the frames of each device
+ */
+
+#include <stdlib.h>          // calloc, free
+#include <string.h>          // memchr, memcpy, memset
+
+#include <devstats.h>
+
+
+/**
+ * @brief      Pack an identifier and compute its first slot
+ *
+ * @param[in]  id_modem  The device identifier
+ * @param[out] device    The packed identifier
+ *
+ * @return     The hash of the identifier
+ */
+static uint64_t devstats_hash(const unsigned char *id_modem, uint64_t *device);
+
+
+/**
+ * @brief      Double the number of slots
+ *
+ * @param      table  The table
+ *
+ * @return     0 on success, -1 on error
+ */
+static int devstats_grow(devstats_t *table);
+
+
+
+devstats_t* devstats_new(size_t capacity)
+{
+    devstats_t      *table  = NULL;
+    size_t          size    = 16;
+
+
+    while ( size < capacity * 2 )
+    {
+        size <<= 1;
+    }
+
+    table = calloc(1, sizeof(devstats_t) );
+
+    if ( ! table )
+    {
+        return (NULL);
+    }
+
+    table->entries = calloc(size, sizeof(devstats_entry_t) );
+
+    if ( ! table->entries )
+    {
+        free(table);
+
+        return (NULL);
+    }
+
+    table->mask = size - 1;
+
+    return (table);
+}
+
+
+
+void devstats_free(devstats_t *table)
+{
+    if ( table )
+    {
+        free(table->entries);
+        free(table);
+    }
+}
+
+
+
+devstats_entry_t* devstats_slot(devstats_t          *table,
+                                const unsigned char *id_modem
+                                )
+{
+    uint64_t                device  = 0;
+    uint64_t                hash    = devstats_hash(id_modem, &device);
+    devstats_entry_t        *entry  = NULL;
+
+
+    for ( entry = &table->entries[hash & table->mask]; entry->used; entry = &table->entries[++hash & table->mask] )
+    {
+        if ( entry->device == device )
+        {
+            return (entry);
+        }
+    }
+
+
+    // The devices are never removed one by one, so the probe only ends on an empty slot
+    if ( (table->count + 1) * 2 > table->mask + 1 )
+    {
+        if ( devstats_grow(table) )
+        {
+            return (NULL);
+        }
+
+        for ( hash = devstats_hash(id_modem, &device), entry = &table->entries[hash & table->mask]; entry->used; )
+        {
+            entry = &table->entries[++hash & table->mask];
+        }
+    }
+
+    table->count++;
+    memset(entry, 0, sizeof(*entry) );
+    entry->device   = device;
+    entry->used     = 1;
+
+    return (entry);
+}
+
+
+
+int devstats_add(devstats_t             *table,
+                 const sigfox_raws_t    *raws,
+                 int                    message
+                 )
+{
+    devstats_entry_t        *entry  = devstats_slot(table, raws->id_modem);
+
+
+    if ( ! entry )
+    {
+        return (-1);
+    }
+
+    if ( message )
+    {
+        if ( ! entry->messages || (raws->timestamp < entry->first_seen) )
+        {
+            entry->first_seen = raws->timestamp;
+        }
+
+        if ( ! entry->messages || (raws->timestamp > entry->last_seen) )
+        {
+            entry->last_seen = raws->timestamp;
+        }
+
+        entry->messages++;
+        entry->avg_signal_sum += raws->avg_signal;
+    }
+
+    if ( ! entry->receptions )
+    {
+        entry->snr_min  = entry->snr_max = raws->snr;
+        entry->rssi_min = entry->rssi_max = raws->rssi;
+    }
+
+    entry->snr_min  = (raws->snr < entry->snr_min) ? raws->snr : entry->snr_min;
+    entry->snr_max  = (raws->snr > entry->snr_max) ? raws->snr : entry->snr_max;
+    entry->rssi_min = (raws->rssi < entry->rssi_min) ? raws->rssi : entry->rssi_min;
+    entry->rssi_max = (raws->rssi > entry->rssi_max) ? raws->rssi : entry->rssi_max;
+    entry->snr_sum  += raws->snr;
+    entry->rssi_sum += raws->rssi;
+    entry->receptions++;
+
+    return (0);
+}
+
+
+
+const devstats_entry_t* devstats_get(const devstats_t       *table,
+                                     const unsigned char    *id_modem
+                                     )
+{
+    uint64_t                device  = 0;
+    uint64_t                hash    = devstats_hash(id_modem, &device);
+    devstats_entry_t        *entry  = NULL;
+
+
+    for ( entry = &table->entries[hash & table->mask]; entry->used; entry = &table->entries[++hash & table->mask] )
+    {
+        if ( entry->device == device )
+        {
+            return ( (entry->messages) ? entry : NULL);
+        }
+    }
+
+    return (NULL);
+}
+
+
+
+size_t devstats_id(const devstats_entry_t   *entry,
+                   char                     id_modem[SIGFOX_DEVICE_LENGTH + 1]
+                   )
+{
+    const char      *end    = NULL;
+
+
+    memcpy(id_modem, &entry->device, sizeof(entry->device) );
+    id_modem[SIGFOX_DEVICE_LENGTH] = '\0';
+    end = memchr(id_modem, '\0', SIGFOX_DEVICE_LENGTH + 1);
+
+    return (end - id_modem);
+}
+
+
+
+void devstats_clear(devstats_t *table)
+{
+    memset(table->entries, 0, (table->mask + 1) * sizeof(devstats_entry_t) );
+    table->count = 0;
+}
+
+
+
+static uint64_t devstats_hash(const unsigned char   *id_modem,
+                              uint64_t              *device
+                              )
+{
+    const unsigned char     *end    = memchr(id_modem, '\0', sizeof(uint64_t) );
+    uint64_t                hash    = 0;
+
+
+    *device = 0;
+    memcpy(device, id_modem, (end) ? (size_t) (end - id_modem) : sizeof(uint64_t) );
+
+    hash    = *device * 0xFF51AFD7ED558CCDULL;
+    hash   ^= hash >> 32;
+
+    return (hash);
+}
+
+
+
+static int devstats_grow(devstats_t *table)
+{
+    devstats_entry_t        *old    = table->entries;
+    size_t                  size    = (table->mask + 1) * 2;
+    size_t                  i       = 0;
+    uint64_t                hash    = 0;
+    devstats_entry_t        *entry  = NULL;
+
+
+    table->entries = calloc(size, sizeof(devstats_entry_t) );
+
+    if ( ! table->entries )
+    {
+        table->entries = old;
+
+        return (-1);
+    }
+
+    for ( i = 0; i <= table->mask; ++i )
+    {
+        if ( ! old[i].used )
+        {
+            continue;
+        }
+
+        hash    = old[i].device * 0xFF51AFD7ED558CCDULL;
+        hash   ^= hash >> 32;
+
+        for ( entry = &table->entries[hash & (size - 1)]; entry->used; )
+        {
+            hash++;
+            entry = &table->entries[hash & (size - 1)];
+        }
+
+        *entry = old[i];
+    }
+
+    free(old);
+    table->mask = size - 1;
+
+    return (0);
+}
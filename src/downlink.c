@@ -0,0 +1,458 @@
+/**
+ * @file downlink.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  In-memory table of the downlink payloads of each device
+ */
+
+#include <stdlib.h>          // calloc, malloc, free
+#include <string.h>          // memchr, memcpy, memset
+
+#include <downlink.h>
+
+
+/**
+ * @brief Slot never used
+ */
+#define DOWNLINK_EMPTY      0
+
+
+/**
+ * @brief Slot holding a device
+ */
+#define DOWNLINK_USED       1
+
+
+/**
+ * @brief Slot whose device was removed (the probe goes on)
+ */
+#define DOWNLINK_REMOVED    2
+
+
+/**
+ * @brief      Pack an identifier and compute its first slot
+ *
+ * @param[in]  id_modem  The device identifier
+ * @param[out] device    The packed identifier
+ *
+ * @return     The hash of the identifier
+ */
+static uint64_t downlink_hash(const unsigned char *id_modem, uint64_t *device);
+
+
+/**
+ * @brief      Find the slot of a device
+ *
+ * @param[in]  table   The table
+ * @param[in]  device  The packed identifier
+ * @param[in]  hash    Its hash
+ *
+ * @return     The slot, NULL if the device is not in the table
+ */
+static downlink_entry_t* downlink_find(const downlink_t *table, uint64_t device, uint64_t hash);
+
+
+/**
+ * @brief      Find the slot of a device, and add the device if it is not in the table
+ *
+ * @param      table     The table
+ * @param[in]  id_modem  The device identifier
+ *
+ * @return     The slot, NULL if the table cannot grow
+ */
+static downlink_entry_t* downlink_slot(downlink_t *table, const unsigned char *id_modem);
+
+
+/**
+ * @brief      Remove a device that has neither a default payload nor a queued one
+ *
+ * @param      table  The table
+ * @param      entry  The slot of the device
+ */
+static void downlink_release(downlink_t *table, downlink_entry_t *entry);
+
+
+/**
+ * @brief      Double the number of slots and drop the removed devices
+ *
+ * @param      table  The table
+ *
+ * @return     0 on success, -1 on error
+ */
+static int downlink_grow(downlink_t *table);
+
+
+
+downlink_t* downlink_new(size_t capacity)
+{
+    downlink_t      *table  = NULL;
+    size_t          size    = 16;
+
+
+    while ( size < capacity * 2 )
+    {
+        size <<= 1;
+    }
+
+    table = calloc(1, sizeof(downlink_t) );
+
+    if ( ! table )
+    {
+        return (NULL);
+    }
+
+    table->entries = calloc(size, sizeof(downlink_entry_t) );
+
+    if ( ! table->entries )
+    {
+        free(table);
+
+        return (NULL);
+    }
+
+    table->mask = size - 1;
+
+    return (table);
+}
+
+
+
+void downlink_free(downlink_t *table)
+{
+    downlink_queued_t       *queued = NULL;
+    size_t                  i       = 0;
+
+
+    if ( table )
+    {
+        for ( i = 0; i <= table->mask; ++i )
+        {
+            while ( (table->entries[i].state == DOWNLINK_USED) && table->entries[i].head )
+            {
+                queued                  = table->entries[i].head;
+                table->entries[i].head  = queued->next;
+                free(queued);
+            }
+        }
+
+        free(table->entries);
+        free(table);
+    }
+}
+
+
+
+int downlink_set(downlink_t             *table,
+                 const unsigned char    *id_modem,
+                 const char             *data
+                 )
+{
+    downlink_entry_t     *entry = downlink_slot(table, id_modem);
+
+
+    if ( ! entry )
+    {
+        return (-1);
+    }
+
+    memcpy(entry->data, data, SIGFOX_DOWNLINK_DATA_LENGTH);
+    entry->data[SIGFOX_DOWNLINK_DATA_LENGTH] = '\0';
+
+    return (0);
+}
+
+
+
+const char* downlink_get(const downlink_t       *table,
+                         const unsigned char    *id_modem
+                         )
+{
+    uint64_t                device  = 0;
+    uint64_t                hash    = downlink_hash(id_modem, &device);
+    downlink_entry_t        *entry  = downlink_find(table, device, hash);
+
+
+    return ( (entry && entry->data[0]) ? entry->data : NULL);
+}
+
+
+
+int downlink_del(downlink_t             *table,
+                 const unsigned char    *id_modem
+                 )
+{
+    uint64_t                device  = 0;
+    uint64_t                hash    = downlink_hash(id_modem, &device);
+    downlink_entry_t        *entry  = downlink_find(table, device, hash);
+
+
+    if ( ! entry || ! entry->data[0] )
+    {
+        return (-1);
+    }
+
+    entry->data[0] = '\0';
+    downlink_release(table, entry);
+
+    return (0);
+}
+
+
+
+int downlink_push(downlink_t            *table,
+                  const unsigned char   *id_modem,
+                  int64_t               id,
+                  const char            *data
+                  )
+{
+    downlink_entry_t        *entry  = downlink_slot(table, id_modem);
+    downlink_queued_t       *queued = malloc(sizeof(downlink_queued_t) );
+
+
+    if ( ! entry || ! queued )
+    {
+        free(queued);
+
+        return (-1);
+    }
+
+    queued->next    = NULL;
+    queued->id      = id;
+    memcpy(queued->data, data, SIGFOX_DOWNLINK_DATA_LENGTH);
+    queued->data[SIGFOX_DOWNLINK_DATA_LENGTH] = '\0';
+
+    if ( entry->head )
+    {
+        entry->tail->next = queued;
+    }
+    else
+    {
+        entry->head = queued;
+    }
+
+    entry->tail = queued;
+    table->queued++;
+
+    return (0);
+}
+
+
+
+int downlink_unpop(downlink_t           *table,
+                   const unsigned char  *id_modem,
+                   int64_t              id,
+                   const char           *data
+                   )
+{
+    downlink_entry_t        *entry  = downlink_slot(table, id_modem);
+    downlink_queued_t       *queued = malloc(sizeof(downlink_queued_t) );
+
+
+    if ( ! entry || ! queued )
+    {
+        free(queued);
+
+        return (-1);
+    }
+
+    queued->next    = entry->head;
+    queued->id      = id;
+    memcpy(queued->data, data, SIGFOX_DOWNLINK_DATA_LENGTH + 1);
+
+    if ( ! entry->head )
+    {
+        entry->tail = queued;
+    }
+
+    entry->head = queued;
+    table->queued++;
+
+    return (0);
+}
+
+
+
+int64_t downlink_pop(downlink_t             *table,
+                     const unsigned char    *id_modem,
+                     char                   data[SIGFOX_DOWNLINK_DATA_LENGTH + 1]
+                     )
+{
+    uint64_t                device  = 0;
+    uint64_t                hash    = downlink_hash(id_modem, &device);
+    downlink_entry_t        *entry  = downlink_find(table, device, hash);
+    downlink_queued_t       *queued = (entry) ? entry->head : NULL;
+    int64_t                 id      = 0;
+
+
+    if ( ! queued )
+    {
+        return (0);
+    }
+
+    entry->head = queued->next;
+    table->queued--;
+    id          = queued->id;
+    memcpy(data, queued->data, SIGFOX_DOWNLINK_DATA_LENGTH + 1);
+    free(queued);
+    downlink_release(table, entry);
+
+    return (id);
+}
+
+
+
+const downlink_queued_t* downlink_queue(const downlink_t    *table,
+                                        const unsigned char *id_modem
+                                        )
+{
+    uint64_t                device  = 0;
+    uint64_t                hash    = downlink_hash(id_modem, &device);
+    downlink_entry_t        *entry  = downlink_find(table, device, hash);
+
+
+    return ( (entry) ? entry->head : NULL);
+}
+
+
+
+static uint64_t downlink_hash(const unsigned char   *id_modem,
+                              uint64_t              *device
+                              )
+{
+    const unsigned char     *end    = memchr(id_modem, '\0', sizeof(uint64_t) );
+    uint64_t                hash    = 0;
+
+
+    *device = 0;
+    memcpy(device, id_modem, (end) ? (size_t) (end - id_modem) : sizeof(uint64_t) );
+
+    hash    = *device * 0xFF51AFD7ED558CCDULL;
+    hash   ^= hash >> 32;
+
+    return (hash);
+}
+
+
+
+static downlink_entry_t* downlink_find(const downlink_t *table,
+                                       uint64_t         device,
+                                       uint64_t         hash
+                                       )
+{
+    downlink_entry_t     *entry = &table->entries[hash & table->mask];
+
+
+    for ( ; entry->state != DOWNLINK_EMPTY; entry = &table->entries[++hash & table->mask] )
+    {
+        if ( (entry->state == DOWNLINK_USED) && (entry->device == device) )
+        {
+            return (entry);
+        }
+    }
+
+    return (NULL);
+}
+
+
+
+static downlink_entry_t* downlink_slot(downlink_t            *table,
+                                       const unsigned char   *id_modem
+                                       )
+{
+    uint64_t                device  = 0;
+    uint64_t                hash    = downlink_hash(id_modem, &device);
+    downlink_entry_t        *entry  = downlink_find(table, device, hash);
+
+
+    if ( entry )
+    {
+        return (entry);
+    }
+
+
+    // Half full, counting the removed devices that lengthen the probes
+    if ( ( (table->used + 1) * 2 > table->mask + 1) && downlink_grow(table) )
+    {
+        return (NULL);
+    }
+
+    for ( entry = &table->entries[hash & table->mask]; entry->state == DOWNLINK_USED; )
+    {
+        hash++;
+        entry = &table->entries[hash & table->mask];
+    }
+
+    table->used += (entry->state == DOWNLINK_EMPTY);
+    table->count++;
+    memset(entry, 0, sizeof(*entry) );
+    entry->device   = device;
+    entry->state    = DOWNLINK_USED;
+
+    return (entry);
+}
+
+
+
+static void downlink_release(downlink_t         *table,
+                             downlink_entry_t   *entry
+                             )
+{
+    if ( ! entry->data[0] && ! entry->head )
+    {
+        entry->state = DOWNLINK_REMOVED;
+        table->count--;
+    }
+}
+
+
+
+static int downlink_grow(downlink_t *table)
+{
+    downlink_entry_t        *old    = table->entries;
+    size_t                  size    = (table->mask + 1) * 2;
+    size_t                  i       = 0;
+    uint64_t                hash    = 0;
+    downlink_entry_t        *entry  = NULL;
+
+
+    // Only the devices still in the table count, the table may not need to grow
+    while ( (size > 16) && (table->count * 4 < size) )
+    {
+        size >>= 1;
+    }
+
+    table->entries = calloc(size, sizeof(downlink_entry_t) );
+
+    if ( ! table->entries )
+    {
+        table->entries = old;
+
+        return (-1);
+    }
+
+    for ( i = 0; i <= table->mask; ++i )
+    {
+        if ( old[i].state != DOWNLINK_USED )
+        {
+            continue;
+        }
+
+        hash    = old[i].device * 0xFF51AFD7ED558CCDULL;
+        hash   ^= hash >> 32;
+
+        for ( entry = &table->entries[hash & (size - 1)]; entry->state != DOWNLINK_EMPTY; )
+        {
+            hash++;
+            entry = &table->entries[hash & (size - 1)];
+        }
+
+        *entry = old[i];
+    }
+
+    free(old);
+    table->mask = size - 1;
+    table->used = table->count;
+
+    return (0);
+}
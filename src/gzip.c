@@ -0,0 +1,308 @@
+/**
+ * @file gzip.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Content-Encoding of the replies: gzip and deflate with zlib
+ */
+
+#include <stdlib.h>          // malloc, calloc, free
+#include <string.h>          // memset
+#include <ctype.h>          // tolower
+#include <zlib.h>          // deflateInit2, deflate, deflateEnd, deflateBound
+
+#include <gzip.h>
+
+
+/**
+ * @brief Window of zlib (32 KB), plus 16 for the gzip header and trailer
+ */
+#define GZIP_WINDOW_BITS    15
+
+
+/**
+ * @brief Memory level of zlib (the default, about 128 KB of state)
+ */
+#define GZIP_MEM_LEVEL      8
+
+
+/**
+ * @struct     gzip_stream_s
+ * @brief      The zlib state and the output buffer
+ */
+struct gzip_stream_s {
+    z_stream z;          ///< The zlib state
+    gzip_out_t out;          ///< Receives the compressed bytes
+    void *ctx;          ///< First argument of out
+    unsigned long long in;          ///< Bytes given
+    unsigned long long produced;          ///< Bytes produced
+    unsigned char buf[GZIP_OUT_SIZE];          ///< The output buffer
+};
+
+
+/**
+ * @brief      Initialize the zlib state of an encoding
+ *
+ * @param      z         The zlib state
+ * @param[in]  encoding  GZIP_GZIP or GZIP_DEFLATE
+ * @param[in]  level     Compression level
+ *
+ * @return     0 on success, -1 on error
+ */
+static int gzip_init(z_stream *z, gzip_encoding_t encoding, int level);
+
+
+/**
+ * @brief      Tell whether a token of Accept-Encoding is a name, case-insensitively
+ *
+ * @param[in]  p     The token
+ * @param[in]  len   Length of the token
+ * @param[in]  name  The name
+ *
+ * @return     1 if it is, 0 otherwise
+ */
+static int gzip_token_is(const char *p, size_t len, const char *name);
+
+
+
+gzip_encoding_t gzip_accepted(const char    *p,
+                              size_t        len
+                              )
+{
+    const char          *end    = p + len;
+    const char          *token  = NULL;
+    const char          *q      = NULL;
+    size_t              n       = 0;
+    int                 gzip    = 0;
+    int                 deflate = 0;
+    int                 zero    = 0;
+
+
+    while ( p && (p < end) )
+    {
+        // Token, up to ';' (the parameters) or ','
+        while ( (p < end) && ( (*p == ' ') || (*p == ',') ) )
+        {
+            ++p;
+        }
+
+        for ( token = p; (p < end) && (*p != ',') && (*p != ';') && (*p != ' '); ++p )
+        {
+        }
+
+        n = p - token;
+
+
+        // q=0 (or 0.0, 0.00...) refuses the encoding
+        for ( zero = 0; (p < end) && (*p != ','); ++p )
+        {
+            if ( (*p == 'q') && (p + 2 < end) && (p[1] == '=') && (p[2] == '0') )
+            {
+                for ( q = p + 3, zero = 1; (q < end) && (*q != ','); ++q )
+                {
+                    zero &= (*q == '.') || (*q == '0') || (*q == ' ');
+                }
+            }
+        }
+
+        gzip    |= ! zero && (gzip_token_is(token, n, "gzip") || gzip_token_is(token, n, "x-gzip") ||
+                              gzip_token_is(token, n, "*") );
+        deflate |= ! zero && gzip_token_is(token, n, "deflate");
+    }
+
+    return ( (gzip) ? GZIP_GZIP : (deflate) ? GZIP_DEFLATE : GZIP_IDENTITY);
+}
+
+
+
+const char* gzip_name(gzip_encoding_t encoding)
+{
+    switch ( encoding )
+    {
+        case GZIP_GZIP:
+            return ("gzip");
+
+        case GZIP_DEFLATE:
+            return ("deflate");
+
+        default:
+            return ("identity");
+    }
+}
+
+
+
+gzip_stream_t* gzip_stream_new(gzip_encoding_t  encoding,
+                               int              level,
+                               gzip_out_t       out,
+                               void             *ctx
+                               )
+{
+    gzip_stream_t       *stream = calloc(1, sizeof(gzip_stream_t) );
+
+
+    if ( ! stream )
+    {
+        return (NULL);
+    }
+
+    if ( gzip_init(&stream->z, encoding, level) )
+    {
+        free(stream);
+
+        return (NULL);
+    }
+
+    stream->out = out;
+    stream->ctx = ctx;
+
+    return (stream);
+}
+
+
+
+int gzip_stream_write(gzip_stream_t     *stream,
+                      const char        *buf,
+                      size_t            len,
+                      int               finish
+                      )
+{
+    z_stream            *z      = &stream->z;
+    int                 result  = Z_OK;
+
+
+    z->next_in  = (Bytef *) buf;
+    z->avail_in = (uInt) len;
+    stream->in += len;
+
+
+    // The output is handed out each time the buffer is full, and what is left once the input is consumed
+    do
+    {
+        z->next_out     = stream->buf;
+        z->avail_out    = sizeof(stream->buf);
+        result          = deflate(z, (finish) ? Z_FINISH : Z_NO_FLUSH);
+
+        if ( result == Z_STREAM_ERROR )
+        {
+            return (-1);
+        }
+
+        if ( z->avail_out < sizeof(stream->buf) )
+        {
+            stream->out(stream->ctx, (const char *) stream->buf, sizeof(stream->buf) - z->avail_out);
+            stream->produced += sizeof(stream->buf) - z->avail_out;
+        }
+    } while ( (z->avail_out == 0) || (finish && (result != Z_STREAM_END) ) );
+
+    return (0);
+}
+
+
+
+void gzip_stream_counts(const gzip_stream_t     *stream,
+                        unsigned long long      *in,
+                        unsigned long long      *out
+                        )
+{
+    *in     = stream->in;
+    *out    = stream->produced;
+}
+
+
+
+void gzip_stream_free(gzip_stream_t *stream)
+{
+    if ( stream )
+    {
+        deflateEnd(&stream->z);
+        free(stream);
+    }
+}
+
+
+
+char* gzip_compress(gzip_encoding_t encoding,
+                    int             level,
+                    const char      *in,
+                    size_t          len,
+                    size_t          *out_len
+                    )
+{
+    z_stream            z;
+    char                *out    = NULL;
+    uLong               bound   = 0;
+
+
+    memset(&z, 0, sizeof(z) );
+
+    if ( gzip_init(&z, encoding, level) )
+    {
+        return (NULL);
+    }
+
+
+    // deflateBound does not count the gzip header and trailer (18 bytes)
+    bound = deflateBound(&z, len) + 18;
+
+    if ( (out = malloc(bound) ) != NULL )
+    {
+        z.next_in   = (Bytef *) in;
+        z.avail_in  = (uInt) len;
+        z.next_out  = (Bytef *) out;
+        z.avail_out = (uInt) bound;
+
+        if ( deflate(&z, Z_FINISH) == Z_STREAM_END )
+        {
+            *out_len = z.total_out;
+        }
+        else
+        {
+            free(out);
+            out = NULL;
+        }
+    }
+
+    deflateEnd(&z);
+
+    return (out);
+}
+
+
+
+static int gzip_init(z_stream           *z,
+                     gzip_encoding_t    encoding,
+                     int                level
+                     )
+{
+    const int       bits    = (encoding == GZIP_GZIP) ? GZIP_WINDOW_BITS + 16 : GZIP_WINDOW_BITS;
+
+
+    if ( (encoding != GZIP_GZIP) && (encoding != GZIP_DEFLATE) )
+    {
+        return (-1);
+    }
+
+    return ( (deflateInit2(z, level, Z_DEFLATED, bits, GZIP_MEM_LEVEL, Z_DEFAULT_STRATEGY) == Z_OK) ? 0 : -1);
+}
+
+
+
+static int gzip_token_is(const char     *p,
+                         size_t         len,
+                         const char     *name
+                         )
+{
+    size_t      i   = 0;
+
+
+    for ( i = 0; (i < len) && name[i]; ++i )
+    {
+        if ( tolower( (unsigned char) p[i]) != name[i] )
+        {
+            return (0);
+        }
+    }
+
+    return ( (i == len) && (name[i] == '\0') );
+}
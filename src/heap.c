@@ -0,0 +1,205 @@
+/**
+ * @file heap.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Counted allocations of Mongoose, with a pool of receive buffers
+ */
+
+#include <stdlib.h>          // malloc, calloc, realloc, free
+#include <string.h>          // memcpy
+
+#include <heap.h>
+
+
+/**
+ * @brief The pooled blocks (unsigned long long for the alignment)
+ */
+static unsigned long long s_blocks[HEAP_BLOCKS][HEAP_BLOCK_SIZE / sizeof(unsigned long long)];
+
+
+/**
+ * @brief Blocks given back to the pool
+ */
+static void *s_free[HEAP_BLOCKS];
+
+
+/**
+ * @brief Number of blocks in s_free
+ */
+static unsigned int s_free_count = 0;
+
+
+/**
+ * @brief Number of blocks never taken (the first ones of s_blocks)
+ */
+static unsigned int s_taken = 0;
+
+
+/**
+ * @brief The counters
+ */
+static heap_stats_t s_stats;
+
+
+/**
+ * @brief      Tell whether memory is a pooled block
+ *
+ * @param[in]  ptr   The memory
+ *
+ * @return     1 if it is, 0 otherwise
+ */
+static int heap_pooled(const void *ptr);
+
+
+/**
+ * @brief      Take a block from the pool
+ *
+ * @return     The block, NULL if the pool is empty
+ */
+static void* heap_take(void);
+
+
+/**
+ * @brief      Give a block back to the pool
+ *
+ * @param      ptr   The block
+ */
+static void heap_give(void *ptr);
+
+
+
+void* heap_malloc(size_t size)
+{
+    void        *ptr    = (size == HEAP_BLOCK_SIZE) ? heap_take() : NULL;
+
+
+    if ( ptr )
+    {
+        return (ptr);
+    }
+
+    s_stats.allocations++;
+
+    return (malloc(size) );
+}
+
+
+
+void* heap_calloc(size_t    count,
+                  size_t    size
+                  )
+{
+    s_stats.allocations++;
+
+    return (calloc(count, size) );
+}
+
+
+
+void* heap_realloc(void     *ptr,
+                   size_t   size
+                   )
+{
+    void        *moved  = NULL;
+
+
+    if ( ! heap_pooled(ptr) )
+    {
+        s_stats.allocations += (size > 0);
+
+        return ( (ptr) ? realloc(ptr, size) : heap_malloc(size) );
+    }
+
+
+    // A block holds HEAP_BLOCK_SIZE bytes whatever size it was asked for
+    if ( size == 0 )
+    {
+        heap_give(ptr);
+
+        return (NULL);
+    }
+
+    if ( size <= HEAP_BLOCK_SIZE )
+    {
+        return (ptr);
+    }
+
+    s_stats.allocations++;
+    moved = malloc(size);
+
+    if ( moved )
+    {
+        memcpy(moved, ptr, HEAP_BLOCK_SIZE);
+        heap_give(ptr);
+    }
+
+    return (moved);
+}
+
+
+
+void heap_free(void *ptr)
+{
+    if ( heap_pooled(ptr) )
+    {
+        heap_give(ptr);
+    }
+    else if ( ptr )
+    {
+        s_stats.frees++;
+        free(ptr);
+    }
+}
+
+
+
+heap_stats_t heap_stats(void)
+{
+    return (s_stats);
+}
+
+
+
+static int heap_pooled(const void *ptr)
+{
+    const char      *p      = ptr;
+    const char      *first  = (const char *) s_blocks;
+
+
+    return ( (p >= first) && (p < first + sizeof(s_blocks) ) );
+}
+
+
+
+static void* heap_take(void)
+{
+    void        *ptr    = NULL;
+
+
+    if ( s_free_count > 0 )
+    {
+        ptr = s_free[--s_free_count];
+    }
+    else if ( s_taken < HEAP_BLOCKS )
+    {
+        ptr = s_blocks[s_taken++];
+    }
+    else
+    {
+        return (NULL);
+    }
+
+    s_stats.pooled++;
+    s_stats.pool_used++;
+
+    return (ptr);
+}
+
+
+
+static void heap_give(void *ptr)
+{
+    s_free[s_free_count++] = ptr;
+    s_stats.pool_used--;
+}
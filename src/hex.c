@@ -0,0 +1,413 @@
+/**
+ * @file hex.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Hexadecimal string decoding
+ */
+
+#include <string.h>          // memchr, memcpy
+
+#if defined(__AVX2__)
+    #include <immintrin.h>          // _mm256_*
+#endif
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>          // _mm_*
+#endif
+
+#include <hex.h>
+
+
+/**
+ * @brief      Decode one hexadecimal character
+ *
+ * @param[in]  c     The character
+ *
+ * @return     Its value, -1 if it is not an hexadecimal digit
+ */
+static inline int hex_nibble(unsigned char c)
+{
+    if ( (unsigned char) (c - '0') < 10 )
+    {
+        return (c - '0');
+    }
+
+    c |= 0x20;
+
+    if ( (unsigned char) (c - 'a') < 6 )
+    {
+        return (c - 'a' + 10);
+    }
+
+    return (-1);
+}
+
+
+#if defined(__SSE2__)
+
+
+/**
+ * @brief      Decode 16 hexadecimal characters
+ *
+ * @param[in]  v      The characters
+ * @param[out] bytes  The 8 bytes, in the low half of the register
+ *
+ * @return     Mask of the invalid characters (bit i for character i)
+ */
+static inline unsigned int hex_block_sse2(__m128i   v,
+                                          __m128i   *bytes
+                                          )
+{
+    // 0-9 and a-f (the case bit is forced) are unsigned ranges once shifted, min() checks the upper bound
+    const __m128i       digit   = _mm_sub_epi8(v, _mm_set1_epi8('0') );
+    const __m128i       letter  = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20) ), _mm_set1_epi8('a') );
+    const __m128i       is_dig  = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9) ), digit);
+    const __m128i       is_let  = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5) ), letter);
+    const __m128i       nibbles = _mm_or_si128(_mm_and_si128(is_dig, digit),
+                                               _mm_and_si128(is_let, _mm_add_epi8(letter, _mm_set1_epi8(10) ) ) );
+
+
+    // The even characters are the high nibbles, they are the low bytes of the 16-bit lanes
+    const __m128i       high    = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00FF) ), 4);
+    const __m128i       low     = _mm_srli_epi16(nibbles, 8);
+
+
+    *bytes = _mm_packus_epi16(_mm_or_si128(high, low), _mm_setzero_si128() );
+
+    return (~_mm_movemask_epi8(_mm_or_si128(is_dig, is_let) ) & 0xFFFF);
+}
+#endif
+
+
+#if defined(__AVX2__)
+
+
+/**
+ * @brief      Decode 2 x 16 hexadecimal characters
+ *
+ * @param[in]  v      The characters
+ * @param[out] bytes  The 8 bytes of each half, in the low half of each 128-bit lane
+ *
+ * @return     Mask of the invalid characters (bit i for character i)
+ */
+static inline unsigned int hex_block_avx2(__m256i   v,
+                                          __m256i   *bytes
+                                          )
+{
+    const __m256i       digit   = _mm256_sub_epi8(v, _mm256_set1_epi8('0') );
+    const __m256i       letter  = _mm256_sub_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20) ), _mm256_set1_epi8('a') );
+    const __m256i       is_dig  = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9) ), digit);
+    const __m256i       is_let  = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5) ), letter);
+    const __m256i       nibbles = _mm256_or_si256(_mm256_and_si256(is_dig, digit),
+                                                  _mm256_and_si256(is_let,
+                                                                   _mm256_add_epi8(letter, _mm256_set1_epi8(10) ) ) );
+    const __m256i       high    = _mm256_slli_epi16(_mm256_and_si256(nibbles, _mm256_set1_epi16(0x00FF) ), 4);
+    const __m256i       low     = _mm256_srli_epi16(nibbles, 8);
+
+
+    *bytes = _mm256_packus_epi16(_mm256_or_si256(high, low), _mm256_setzero_si256() );
+
+    return (~ (unsigned int) _mm256_movemask_epi8(_mm256_or_si256(is_dig, is_let) ) );
+}
+#endif
+
+
+
+/**
+ * @brief      Decode the characters left after the vector loops
+ *
+ * @param[in]  str      The string
+ * @param[in]  pos      First character to decode
+ * @param[in]  len      Length of the string (even)
+ * @param[out] out      The bytes
+ * @param[out] invalid  Position of the first invalid character (can be NULL)
+ *
+ * @return     0 on success, -1 on invalid character
+ */
+static int hex_decode_tail(const unsigned char  *str,
+                           size_t               pos,
+                           size_t               len,
+                           unsigned char        *out,
+                           size_t               *invalid
+                           )
+{
+    int     high    = 0;
+    int     low     = 0;
+
+
+    for ( ; pos < len; pos += 2 )
+    {
+        high    = hex_nibble(str[pos]);
+        low     = hex_nibble(str[pos + 1]);
+
+        if ( (high < 0) || (low < 0) )
+        {
+            if ( invalid )
+            {
+                *invalid = (high < 0) ? pos : pos + 1;
+            }
+
+            return (-1);
+        }
+
+        out[pos / 2] = (unsigned char) ( (high << 4) | low);
+    }
+
+    return (0);
+}
+
+
+
+/**
+ * @brief      Decode two strings of the same length at once
+ *
+ * @param[in]  a     The first string
+ * @param[in]  b     The second string
+ * @param[in]  len   Length of both strings (even)
+ * @param[out] da    The bytes of the first string
+ * @param[out] db    The bytes of the second string
+ *
+ * @return     Bit 0 set if the first string is invalid, bit 1 if the second one is
+ */
+static unsigned int hex_decode_pair(const unsigned char *a,
+                                    const unsigned char *b,
+                                    size_t              len,
+                                    unsigned char       *da,
+                                    unsigned char       *db
+                                    )
+{
+    unsigned int        failed  = 0;
+    size_t              pos     = 0;
+
+
+#if defined(__AVX2__)
+
+    // 16 characters of each string in one register
+    for ( ; pos + 16 <= len; pos += 16 )
+    {
+        __m256i             bytes;
+        const __m256i       v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128( (const __m128i *) (a + pos) ) ),
+                                                        _mm_loadu_si128( (const __m128i *) (b + pos) ), 1);
+        const unsigned int  mask = hex_block_avx2(v, &bytes);
+
+
+        failed |= ( (mask & 0xFFFF) ? 1 : 0) | ( (mask >> 16) ? 2 : 0);
+        _mm_storel_epi64( (__m128i *) (da + pos / 2), _mm256_castsi256_si128(bytes) );
+        _mm_storel_epi64( (__m128i *) (db + pos / 2), _mm256_extracti128_si256(bytes, 1) );
+    }
+
+#elif defined(__SSE2__)
+
+    for ( ; pos + 16 <= len; pos += 16 )
+    {
+        __m128i     bytes;
+
+
+        failed |= (hex_block_sse2(_mm_loadu_si128( (const __m128i *) (a + pos) ), &bytes) ) ? 1 : 0;
+        _mm_storel_epi64( (__m128i *) (da + pos / 2), bytes);
+        failed |= (hex_block_sse2(_mm_loadu_si128( (const __m128i *) (b + pos) ), &bytes) ) ? 2 : 0;
+        _mm_storel_epi64( (__m128i *) (db + pos / 2), bytes);
+    }
+
+#endif
+
+#if defined(__SSE2__)
+
+    // 8 characters of each string in one register
+    if ( pos + 8 <= len )
+    {
+        __m128i             bytes;
+        const __m128i       v = _mm_unpacklo_epi64(_mm_loadl_epi64( (const __m128i *) (a + pos) ),
+                                                   _mm_loadl_epi64( (const __m128i *) (b + pos) ) );
+        const unsigned int  mask = hex_block_sse2(v, &bytes);
+        unsigned int        word = (unsigned int) _mm_cvtsi128_si32(bytes);
+
+
+        failed |= ( (mask & 0xFF) ? 1 : 0) | ( (mask >> 8) ? 2 : 0);
+        memcpy(da + pos / 2, &word, 4);
+        word = (unsigned int) _mm_cvtsi128_si32(_mm_srli_si128(bytes, 4) );
+        memcpy(db + pos / 2, &word, 4);
+        pos += 8;
+    }
+
+#endif
+
+    if ( pos < len )
+    {
+        failed |= (hex_decode_tail(a, pos, len, da, NULL) ) ? 1 : 0;
+        failed |= (hex_decode_tail(b, pos, len, db, NULL) ) ? 2 : 0;
+    }
+
+    return (failed);
+}
+
+
+
+int hex_decode(const unsigned char  *str,
+               size_t               len,
+               unsigned char        *out,
+               size_t               *invalid
+               )
+{
+    const size_t        even    = len & ~ (size_t) 1;
+    size_t              pos     = 0;
+    unsigned int        mask    = 0;
+
+
+#if defined(__AVX2__)
+
+    for ( ; pos + 32 <= even; pos += 32 )
+    {
+        __m256i     bytes;
+
+
+        mask = hex_block_avx2(_mm256_loadu_si256( (const __m256i *) (str + pos) ), &bytes);
+
+        if ( mask )
+        {
+            break;
+        }
+
+        // The 8 bytes of each lane are the quadwords 0 and 2
+        _mm_storeu_si128( (__m128i *) (out + pos / 2), _mm256_castsi256_si128(_mm256_permute4x64_epi64(bytes, 0x08) ) );
+    }
+
+#endif
+
+#if defined(__SSE2__)
+
+    for ( ; (mask == 0) && (pos + 16 <= even); pos += 16 )
+    {
+        __m128i     bytes;
+
+
+        mask = hex_block_sse2(_mm_loadu_si128( (const __m128i *) (str + pos) ), &bytes);
+
+        if ( mask )
+        {
+            break;
+        }
+
+        _mm_storel_epi64( (__m128i *) (out + pos / 2), bytes);
+    }
+
+    if ( (mask == 0) && (pos + 8 <= even) )
+    {
+        __m128i         bytes;
+        unsigned int    word    = 0;
+
+
+        mask = hex_block_sse2(_mm_loadl_epi64( (const __m128i *) (str + pos) ), &bytes) & 0xFF;
+
+        if ( mask == 0 )
+        {
+            word = (unsigned int) _mm_cvtsi128_si32(bytes);
+            memcpy(out + pos / 2, &word, 4);
+            pos += 8;
+        }
+    }
+
+#endif
+
+    if ( mask )
+    {
+        if ( invalid )
+        {
+            *invalid = pos + __builtin_ctz(mask);
+        }
+
+        return (-1);
+    }
+
+    if ( hex_decode_tail(str, pos, even, out, invalid) )
+    {
+        return (-1);
+    }
+
+
+    // A byte is always two characters
+    if ( even != len )
+    {
+        if ( invalid )
+        {
+            *invalid = even;
+        }
+
+        return (-1);
+    }
+
+    return (0);
+}
+
+
+
+size_t hex_decode_batch(const unsigned char *src,
+                        unsigned char       *dst,
+                        unsigned char       *errors,
+                        size_t              stride,
+                        size_t              max_len,
+                        size_t              count,
+                        unsigned char       error
+                        )
+{
+    const unsigned char     *end    = NULL;
+    size_t                  len[2]  = {0, 0};
+    size_t                  failed  = 0;
+    size_t                  i       = 0;
+    size_t                  j       = 0;
+    size_t                  decoded = 0;
+    unsigned int            bad     = 0;
+
+
+    for ( i = 0; i < count; i += decoded )
+    {
+        // The length of a string left alone by the previous iteration is already known
+        if ( decoded != 1 )
+        {
+            end     = memchr(src + i * stride, '\0', max_len);
+            len[0]  = (end) ? (size_t) (end - (src + i * stride) ) : max_len;
+        }
+        else
+        {
+            len[0] = len[1];
+        }
+
+        len[1] = len[0] + 1;
+
+        if ( i + 1 < count )
+        {
+            end     = memchr(src + (i + 1) * stride, '\0', max_len);
+            len[1]  = (end) ? (size_t) (end - (src + (i + 1) * stride) ) : max_len;
+        }
+
+
+        // Two strings of the same length share the vector registers, otherwise they are decoded alone
+        if ( (len[0] == len[1]) && ! (len[0] & 1) )
+        {
+            bad     = hex_decode_pair(src + i * stride, src + (i + 1) * stride, len[0], dst + i * stride,
+                                      dst + (i + 1) * stride);
+            decoded = 2;
+        }
+        else
+        {
+            bad     = (hex_decode(src + i * stride, len[0], dst + i * stride, NULL) ) ? 1 : 0;
+            decoded = 1;
+        }
+
+        for ( j = 0; j < decoded; ++j )
+        {
+            if ( bad & (1u << j) )
+            {
+                failed++;
+
+                if ( errors && (errors[ (i + j) * stride] == 0) )
+                {
+                    errors[ (i + j) * stride] = error;
+                }
+            }
+        }
+    }
+
+    return (failed);
+}
@@ -0,0 +1,92 @@
+/**
+ * @file histogram.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Latency histogram with power of two buckets
+ */
+
+#include <time.h>          // clock_gettime, CLOCK_MONOTONIC
+
+#include <histogram.h>
+
+
+
+uint64_t histogram_clock_us(void)
+{
+    struct timespec     ts;
+
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ( (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000);
+}
+
+
+
+void histogram_add(histogram_t  *histogram,
+                   uint64_t     us
+                   )
+{
+    // Number of significant bits, which is the bucket index
+    unsigned int     bucket = (us) ? 64 - __builtin_clzll(us) : 0;
+
+
+    histogram->buckets[(bucket < HISTOGRAM_BUCKETS) ? bucket : HISTOGRAM_BUCKETS - 1]++;
+    histogram->count++;
+    histogram->sum += us;
+
+    if ( us > histogram->max )
+    {
+        histogram->max = us;
+    }
+}
+
+
+
+void histogram_add_since(histogram_t    *histogram,
+                         uint64_t       start
+                         )
+{
+    histogram_add(histogram, histogram_clock_us() - start);
+}
+
+
+
+uint64_t histogram_percentile(const histogram_t *histogram,
+                              unsigned int      percent
+                              )
+{
+    uint64_t            rank    = 0;
+    uint64_t            seen    = 0;
+    unsigned int        i       = 0;
+
+
+    if ( histogram->count == 0 )
+    {
+        return (0);
+    }
+
+
+    // Rank of the percentile, rounded up so p100 is the last latency
+    rank = (histogram->count * percent + 99) / 100;
+    rank = (rank) ? rank : 1;
+
+    for ( i = 0; i < HISTOGRAM_BUCKETS - 1; ++i )
+    {
+        seen += histogram->buckets[i];
+
+        if ( seen >= rank )
+        {
+            break;
+        }
+    }
+
+    // The last bucket has no upper bound
+    if ( (i == HISTOGRAM_BUCKETS - 1) || ( (1ULL << i) - 1 > histogram->max) )
+    {
+        return (histogram->max);
+    }
+
+    return ( (1ULL << i) - 1);
+}
@@ -0,0 +1,211 @@
+/**
+ * @file jsonw.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Streaming JSON writer, rendering into a buffer handed out each time it is full
+ */
+
+#include <string.h>          // memcpy
+
+#include <jsonw.h>
+#include <numfmt.h>          // numfmt_integer, numfmt_double
+
+
+/**
+ * @brief      Make room in the buffer, flushing it if needed
+ *
+ * @param      w     The writer
+ * @param[in]  len   Number of bytes needed (at most the size of the buffer)
+ *
+ * @return     Where to write
+ */
+static char* jsonw_reserve(jsonw_t *w, size_t len);
+
+
+
+void jsonw_init(jsonw_t         *w,
+                char            *buf,
+                size_t          size,
+                jsonw_flush_t   flush,
+                void            *ctx
+                )
+{
+    w->buf      = buf;
+    w->size     = size;
+    w->len      = 0;
+    w->flush    = flush;
+    w->ctx      = ctx;
+    w->bytes    = 0;
+    w->flushes  = 0;
+}
+
+
+
+void jsonw_raw(jsonw_t      *w,
+               const char   *s,
+               size_t       len
+               )
+{
+    size_t      n   = 0;
+
+
+    while ( len > 0 )
+    {
+        if ( w->len == w->size )
+        {
+            jsonw_flush(w);
+        }
+
+        n = (len < w->size - w->len) ? len : w->size - w->len;
+        memcpy(w->buf + w->len, s, n);
+        w->len  += n;
+        s       += n;
+        len     -= n;
+    }
+}
+
+
+
+void jsonw_string(jsonw_t       *w,
+                  const char    *s,
+                  size_t        len
+                  )
+{
+    static const char   hex[]   = "0123456789abcdef";
+    const char          *run    = s;
+    const char          *end    = s + len;
+    char                *out    = NULL;
+    unsigned char       c       = 0;
+
+
+    jsonw_literal(w, "\"");
+
+    for ( ; s < end; ++s )
+    {
+        c = (unsigned char) *s;
+
+        if ( (c >= 0x20) && (c != '"') && (c != '\\') )
+        {
+            continue;
+        }
+
+
+        // The characters that need no escape are copied by runs
+        jsonw_raw(w, run, s - run);
+        run = s + 1;
+        out = jsonw_reserve(w, 6);
+
+        switch ( c )
+        {
+            case '"':
+            case '\\':
+                out[0]  = '\\';
+                out[1]  = c;
+                w->len += 2;
+                break;
+
+            case '\n':
+                memcpy(out, "\\n", 2);
+                w->len += 2;
+                break;
+
+            case '\r':
+                memcpy(out, "\\r", 2);
+                w->len += 2;
+                break;
+
+            case '\t':
+                memcpy(out, "\\t", 2);
+                w->len += 2;
+                break;
+
+            default:
+                memcpy(out, "\\u00", 4);
+                out[4]  = hex[c >> 4];
+                out[5]  = hex[c & 0xF];
+                w->len += 6;
+                break;
+        }
+    }
+
+    jsonw_raw(w, run, s - run);
+    jsonw_literal(w, "\"");
+}
+
+
+
+void jsonw_integer(jsonw_t      *w,
+                   long long    value
+                   )
+{
+    char        tmp[NUMFMT_MAX];
+
+
+    jsonw_raw(w, tmp, numfmt_integer(tmp, value) );
+}
+
+
+
+void jsonw_double(jsonw_t   *w,
+                  double    value
+                  )
+{
+    char        tmp[NUMFMT_MAX];
+    size_t      len     = numfmt_double(tmp, value);
+
+
+    if ( len )
+    {
+        jsonw_raw(w, tmp, len);
+    }
+    else
+    {
+        jsonw_literal(w, "null");
+    }
+}
+
+
+
+void jsonw_bool(jsonw_t     *w,
+                int         value
+                )
+{
+    if ( value )
+    {
+        jsonw_literal(w, "true");
+    }
+    else
+    {
+        jsonw_literal(w, "false");
+    }
+}
+
+
+
+void jsonw_flush(jsonw_t *w)
+{
+    if ( w->len == 0 )
+    {
+        return;
+    }
+
+    w->flush(w->ctx, w->buf, w->len);
+    w->bytes += w->len;
+    w->flushes++;
+    w->len = 0;
+}
+
+
+
+static char* jsonw_reserve(jsonw_t  *w,
+                           size_t   len
+                           )
+{
+    if ( w->size - w->len < len )
+    {
+        jsonw_flush(w);
+    }
+
+    return (w->buf + w->len);
+}
@@ -9,6 +9,8 @@
 
 
 #include <db_plugin_sqlite.h>          // db_open, db_close, db_op
+#include <binary_ingest.h>          // binary_ingest_start, binary_ingest_stop
+#include <assets.h>          // assets_serve, assets_free
 #include <logging.h>            // gprintf, iprintf, eprintf, cprintf
 #include <frames.h>             // sigfox_device_t
 #include <mongoose.h>           // struct mg_str, struct mg_connection, struct mg_serve_http_opts, mg_printf, mg_serve_http, mg_mgr_init, mg_bind,
@@ -42,6 +44,54 @@
 #define HTTP_PORT       "8000"
 
 
+/**
+ * @brief  Number of frames committed in one transaction (1 disables the group commit)
+ */
+#define BATCH_SIZE      "1"
+
+
+/**
+ * @brief  Maximum time a frame waits for its group commit (in milliseconds)
+ */
+#define BATCH_WAIT      "10"
+
+
+/**
+ * @brief  Maximum number of write operations waiting for the writer thread
+ */
+#define QUEUE_SIZE      "1024"
+
+
+/**
+ * @brief  What is done with the copies of a frame received by several base stations (off, drop or flag)
+ */
+#define DEDUP_MODE      "off"
+
+
+/**
+ * @brief  Number of (id_modem, seq_number) pairs remembered to recognize the copies
+ */
+#define DEDUP_SIZE      "65536"
+
+
+/**
+ * @brief  Time a (id_modem, seq_number) pair is remembered (in seconds)
+ */
+#define DEDUP_WINDOW    "60"
+
+
+/**
+ * @brief  Depth of the writer queue from which the writes without acknowledge are refused (in percent)
+ */
+#define HIGH_WATERMARK  "75"
+
+
+/**
+ * @brief  Depth of the writer queue from which the queries are refused, and below which the writes are accepted again
+ */
+#define LOW_WATERMARK   "50"
+
+
 /**
  * @brief  Path to the database
  */
@@ -78,6 +128,12 @@ static struct mg_serve_http_opts     s_http_server_opts;
 static void     *s_db_handle = NULL;
 
 
+/**
+ * @brief Listeners of the binary records (NULL if they are not enabled)
+ */
+static binary_ingest_t      *s_binary_ingest = NULL;
+
+
 /**
  * @brief Mongoose string for the GET method
  */
@@ -167,10 +223,32 @@ int main(int    argc,
     int         opt         = 0;
     int         long_index  = 0;
     char        *port       = NULL;
+    char        *batch_size = BATCH_SIZE;
+    char        *batch_wait = BATCH_WAIT;
+    char        *queue_size = QUEUE_SIZE;
+    char        *dedup_mode = DEDUP_MODE;
+    char        *dedup_size = DEDUP_SIZE;
+    char        *dedup_wait = DEDUP_WINDOW;
+    char        *high_mark  = HIGH_WATERMARK;
+    char        *low_mark   = LOW_WATERMARK;
+    char        *binary     = NULL;
+    char        *backfill   = NULL;
+    int         dedup       = -1;
+    static const char           *dedup_modes[] = {"off", "drop", "flag"};
     static struct option        long_options[] =
     {
         {"help", no_argument, 0, 'h'},
         {"port", optional_argument, 0, 'p'},
+        {"batch-size", required_argument, 0, 'b'},
+        {"batch-wait", required_argument, 0, 'w'},
+        {"queue-size", required_argument, 0, 'q'},
+        {"dedup", required_argument, 0, 'd'},
+        {"dedup-size", required_argument, 0, 's'},
+        {"dedup-window", required_argument, 0, 't'},
+        {"high-watermark", required_argument, 0, 'H'},
+        {"low-watermark", required_argument, 0, 'L'},
+        {"binary-port", required_argument, 0, 'B'},
+        {"backfill", required_argument, 0, 'R'},
         {0, 0, 0, 0}
     };
 
@@ -185,7 +263,7 @@ int main(int    argc,
      * argument. If an option character is followed by two colons (‘::’), its argument is optional; this is a GNU
      * extension.
      */
-    while ( (opt = getopt_long(argc, argv, "hp", long_options, &long_index) ) != -1 )
+    while ( (opt = getopt_long(argc, argv, "hpb:w:q:d:s:t:H:L:B:R:", long_options, &long_index) ) != -1 )
     {
         switch ( opt )
         {
@@ -195,6 +273,66 @@ int main(int    argc,
                     break;
                 }
 
+            case 'b':
+                {
+                    batch_size = optarg;
+                    break;
+                }
+
+            case 'w':
+                {
+                    batch_wait = optarg;
+                    break;
+                }
+
+            case 'q':
+                {
+                    queue_size = optarg;
+                    break;
+                }
+
+            case 'd':
+                {
+                    dedup_mode = optarg;
+                    break;
+                }
+
+            case 's':
+                {
+                    dedup_size = optarg;
+                    break;
+                }
+
+            case 't':
+                {
+                    dedup_wait = optarg;
+                    break;
+                }
+
+            case 'H':
+                {
+                    high_mark = optarg;
+                    break;
+                }
+
+            case 'L':
+                {
+                    low_mark = optarg;
+                    break;
+                }
+
+            case 'B':
+                {
+                    binary = optarg;
+                    break;
+                }
+
+            case 'R':
+                {
+                    backfill = optarg;
+                    break;
+                }
+
 
             case 'h':
                 {
@@ -204,7 +342,9 @@ int main(int    argc,
 
             case '?':
                 {
-                    if ( optopt == 'p' )
+                    if ( (optopt == 'p') || (optopt == 'b') || (optopt == 'w') || (optopt == 'q') || (optopt == 'd') ||
+                         (optopt == 's') || (optopt == 't') || (optopt == 'H') || (optopt == 'L') || (optopt == 'B') ||
+                         (optopt == 'R') )
                     {
                         eprintf("Option -%c requires an argument.\n", optopt);
                     }
@@ -229,6 +369,76 @@ int main(int    argc,
         exit(EXIT_FAILURE);
     }
 
+    if ( (strtol(batch_size, NULL, 10) <= 0L) || (strtol(batch_wait, NULL, 10) < 0L) ||
+         (strtol(queue_size, NULL, 10) <= 0L) )
+    {
+        eprintf("Batch and queue sizes must be positive and batch wait cannot be negative...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for ( opt = 0; opt < (int) (sizeof(dedup_modes) / sizeof(dedup_modes[0]) ); ++opt )
+    {
+        if ( strcmp(dedup_mode, dedup_modes[opt]) == 0 )
+        {
+            dedup = opt;
+        }
+    }
+
+    if ( (dedup < 0) || (strtol(dedup_size, NULL, 10) <= 0L) || (strtol(dedup_wait, NULL, 10) <= 0L) )
+    {
+        eprintf("Duplicate mode must be off, drop or flag and its size and window must be positive...\n");
+        exit(EXIT_FAILURE);
+    }
+
+
+    if ( (strtol(low_mark, NULL, 10) < 0L) || (strtol(high_mark, NULL, 10) > 100L) ||
+         (strtol(low_mark, NULL, 10) >= strtol(high_mark, NULL, 10) ) )
+    {
+        eprintf("Watermarks must be percentages and the low one must be lower than the high one...\n");
+        exit(EXIT_FAILURE);
+    }
+
+
+    if ( binary && (strtol(binary, NULL, 10) == 0L) )
+    {
+        eprintf("%s is not a good port for the binary records...\n", binary);
+        exit(EXIT_FAILURE);
+    }
+
+
+    if ( backfill && (strtol(backfill, NULL, 10) < 0L) )
+    {
+        eprintf("The number of threads of the backfill cannot be negative...\n");
+        exit(EXIT_FAILURE);
+    }
+
+
+    // Rebuild the rollups and exit, before the server takes the database
+    if ( backfill )
+    {
+        unsigned long long      rows    = 0;
+
+
+        if ( (s_db_handle = db_open(DATABASE_PATH) ) == NULL )
+        {
+            eprintf("Cannot open DB [%s]\n", DATABASE_PATH);
+            exit(EXIT_FAILURE);
+        }
+
+        opt = db_backfill(s_db_handle, strtol(backfill, NULL, 10), &rows);
+        db_close(&s_db_handle);
+
+        if ( opt )
+        {
+            eprintf("Cannot rebuild the rollups\n");
+            exit(EXIT_FAILURE);
+        }
+
+        iprintf("Rollups rebuilt from %llu receptions\n", rows);
+
+        return (0);
+    }
+
 
     // Initiate the manager
     mg_mgr_init(&mgr, NULL);
@@ -269,6 +479,35 @@ int main(int    argc,
         exit(EXIT_FAILURE);
     }
 
+    if ( db_group_commit(s_db_handle, strtol(batch_size, NULL, 10), strtol(batch_wait, NULL, 10) ) )
+    {
+        eprintf("Cannot allocate a batch of %s frames\n", batch_size);
+        exit(EXIT_FAILURE);
+    }
+
+
+    if ( db_dedup(s_db_handle, dedup, strtol(dedup_size, NULL, 10), strtol(dedup_wait, NULL, 10) ) )
+    {
+        eprintf("Cannot allocate %s duplicate pairs\n", dedup_size);
+        exit(EXIT_FAILURE);
+    }
+
+
+    // The write connection now belongs to the writer thread
+    if ( db_writer_start(s_db_handle, &mgr, strtol(queue_size, NULL, 10) ) )
+    {
+        eprintf("Cannot start the writer thread\n");
+        exit(EXIT_FAILURE);
+    }
+
+    db_admission(s_db_handle, strtol(high_mark, NULL, 10), strtol(low_mark, NULL, 10) );
+
+    if ( binary && ( (s_binary_ingest = binary_ingest_start(&mgr, binary, s_db_handle) ) == NULL) )
+    {
+        eprintf("Cannot listen for the binary records on port %s\n", binary);
+        exit(EXIT_FAILURE);
+    }
+
 
     // Run event loop until signal is received
     gprintf("Starting RESTful server on port %s\n", port);
@@ -282,13 +521,17 @@ int main(int    argc,
          * `mg_mgr_poll()` checks all connection for IO readiness. If at least one
          * of the connections is IO-ready, `mg_mgr_poll()` triggers respective
          * event handlers and returns.
+         * It does not sleep while a read still has rows to send.
          */
-        mg_mgr_poll(&mgr, 1000);
+        mg_mgr_poll(&mgr, (db_poll(s_db_handle) > 0) ? 0 : 1000);
     }
 
 
-    // Clean up the manager and the database connection
+    // Commit the queued frames, clean up the manager and the database connection
+    binary_ingest_stop(&s_binary_ingest);
+    db_writer_stop(s_db_handle);
     mg_mgr_free(&mgr);
+    assets_free();
     db_close(&s_db_handle);
 
     iprintf("Exiting on signal %d\n", s_sig_num);
@@ -300,9 +543,20 @@ int main(int    argc,
 
 static void usage(char *program_name)
 {
-    fprintf(stdout, "Usage: %s [-h] -p port\n", program_name);
+    fprintf(stdout, "Usage: %s [-h] -p port [-b size] [-w ms] [-q size] [-d mode] [-s size] [-t s] [-H %%] [-L %%] [-B port] "
+            "[-R threads]\n", program_name);
     fprintf(stdout, "\t-h | --help              Display this help.\n");
     fprintf(stdout, "\t-p | --port=PORT         RESTful server port.\n");
+    fprintf(stdout, "\t-b | --batch-size=SIZE   Frames committed in one transaction (dft: %s).\n", BATCH_SIZE);
+    fprintf(stdout, "\t-w | --batch-wait=MS     Maximum time a frame waits for its commit (dft: %s ms).\n", BATCH_WAIT);
+    fprintf(stdout, "\t-q | --queue-size=SIZE   Write operations waiting for the writer thread (dft: %s).\n", QUEUE_SIZE);
+    fprintf(stdout, "\t-d | --dedup=MODE        Copies of a frame: off, drop or flag (dft: %s).\n", DEDUP_MODE);
+    fprintf(stdout, "\t-s | --dedup-size=SIZE   (id_modem, seq_number) pairs remembered (dft: %s).\n", DEDUP_SIZE);
+    fprintf(stdout, "\t-t | --dedup-window=S    Time a pair is remembered (dft: %s s).\n", DEDUP_WINDOW);
+    fprintf(stdout, "\t-H | --high-watermark=%%  Queue depth refusing the writes without ack (dft: %s %%).\n", HIGH_WATERMARK);
+    fprintf(stdout, "\t-L | --low-watermark=%%   Queue depth refusing the queries (dft: %s %%).\n", LOW_WATERMARK);
+    fprintf(stdout, "\t-B | --binary-port=PORT  TCP and UDP port of the binary records (dft: disabled).\n");
+    fprintf(stdout, "\t-R | --backfill=THREADS  Rebuild the rollups from the frames and exit (0: one thread per CPU).\n");
 }
 
 
@@ -355,9 +609,10 @@ static void ev_handler(struct mg_connection *nc,
                 char        uri[URI_MAX_LENGTH];
                 char        method[METHOD_MAX_LENGTH];
 
-                snprintf(body, hm->body.len + sizeof(char), "%s", hm->body.p);
-                snprintf(uri, hm->uri.len + sizeof(char), "%s", hm->uri.p);
-                snprintf(method, hm->method.len + sizeof(char), "%s", hm->method.p);
+                // The chunks are not NUL-terminated and can be longer than the buffers (batches)
+                snprintf(body, sizeof(body), "%.*s", (int) hm->body.len, hm->body.p);
+                snprintf(uri, sizeof(uri), "%.*s", (int) hm->uri.len, hm->uri.p);
+                snprintf(method, sizeof(method), "%.*s", (int) hm->method.len, hm->method.p);
 
                 iprintf("%s %s %zu %s\n", method, uri, hm->body.len, body);
 #endif
@@ -393,7 +648,10 @@ static void ev_handler(struct mg_connection *nc,
                 }
                 else
                 {
-                    mg_serve_http(nc, hm, s_http_server_opts);      /* Serve static content */
+                    if ( ! assets_serve(nc, hm, s_http_server_opts.document_root) )
+                    {
+                        mg_serve_http(nc, hm, s_http_server_opts);      /* Serve static content */
+                    }
 
                     if ( is_equal(&hm->uri, &root_prefix) )
                     {
@@ -408,6 +666,13 @@ static void ev_handler(struct mg_connection *nc,
                 break;
             }
 
+        case MG_EV_CLOSE:
+            {
+                db_disconnect(s_db_handle, nc);
+
+                break;
+            }
+
         default:
             {
                 break;
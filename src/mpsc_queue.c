@@ -0,0 +1,206 @@
+/**
+ * @file mpsc_queue.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Bounded lock-free multi-producer single-consumer queue
+ */
+
+#include <stdlib.h>          // aligned_alloc, free
+#include <string.h>          // memcpy, memset
+#include <stdint.h>          // intptr_t
+#include <stdatomic.h>          // atomic_size_t, atomic_*
+
+#include <mpsc_queue.h>
+
+
+/**
+ * @brief Size of a cache line, the cells and the indexes are aligned on it to avoid false sharing
+ */
+#define CACHE_LINE_SIZE     64
+
+
+/**
+ * @struct     mpsc_cell_s
+ * @brief      Header of a cell, the element is stored right after it
+ */
+struct mpsc_cell_s {
+    atomic_size_t seq;          ///< Position at which the cell can be written (seq == pos) or read (seq == pos + 1)
+};
+
+
+/**
+ * @struct     mpsc_queue_s
+ * @brief      Queue
+ */
+struct mpsc_queue_s {
+    size_t mask;          ///< Capacity - 1
+    size_t elem_size;          ///< Size of an element
+    size_t cell_size;          ///< Size of a cell (header + element, aligned)
+    unsigned char *cells;          ///< The ring of cells
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t enqueue_pos;          ///< Next position written by the producers
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t dequeue_pos;          ///< Next position read by the consumer
+};
+
+
+/**
+ * @brief      Get a cell from a position
+ *
+ * @param[in]  queue  The queue
+ * @param[in]  pos    The position
+ *
+ * @return     The cell
+ */
+static inline struct mpsc_cell_s* mpsc_cell(const mpsc_queue_t *queue, size_t pos)
+{
+    return ( (struct mpsc_cell_s *) (queue->cells + (pos & queue->mask) * queue->cell_size) );
+}
+
+
+
+mpsc_queue_t* mpsc_queue_new(size_t capacity,
+                             size_t elem_size
+                             )
+{
+    mpsc_queue_t        *queue  = NULL;
+    size_t              size    = 2;
+    size_t              i       = 0;
+
+
+    if ( (capacity == 0) || (elem_size == 0) )
+    {
+        return (NULL);
+    }
+
+    while ( size < capacity )
+    {
+        size <<= 1;
+    }
+
+    queue = aligned_alloc(CACHE_LINE_SIZE, sizeof(*queue) );
+
+    if ( ! queue )
+    {
+        return (NULL);
+    }
+
+    memset(queue, 0, sizeof(*queue) );
+    queue->mask         = size - 1;
+    queue->elem_size    = elem_size;
+    queue->cell_size    = (sizeof(struct mpsc_cell_s) + elem_size + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+    queue->cells        = aligned_alloc(CACHE_LINE_SIZE, size * queue->cell_size);
+
+    if ( ! queue->cells )
+    {
+        free(queue);
+
+        return (NULL);
+    }
+
+    for ( i = 0; i < size; ++i )
+    {
+        atomic_init(&mpsc_cell(queue, i)->seq, i);
+    }
+
+    atomic_init(&queue->enqueue_pos, 0);
+    atomic_init(&queue->dequeue_pos, 0);
+
+    return (queue);
+}
+
+
+
+void mpsc_queue_free(mpsc_queue_t *queue)
+{
+    if ( queue )
+    {
+        free(queue->cells);
+        free(queue);
+    }
+}
+
+
+
+int mpsc_queue_push(mpsc_queue_t    *queue,
+                    const void      *elem
+                    )
+{
+    struct mpsc_cell_s      *cell   = NULL;
+    size_t                  pos     = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    intptr_t                dif     = 0;
+
+
+    for ( ; ; )
+    {
+        cell    = mpsc_cell(queue, pos);
+        dif     = (intptr_t) atomic_load_explicit(&cell->seq, memory_order_acquire) - (intptr_t) pos;
+
+        if ( dif == 0 )
+        {
+            // The cell is free, try to reserve it
+            if ( atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1, memory_order_relaxed,
+                                                       memory_order_relaxed) )
+            {
+                break;
+            }
+        }
+        else if ( dif < 0 )
+        {
+            // The cell has not been read yet since the last lap: the queue is full
+            return (-1);
+        }
+        else
+        {
+            // Another producer took the cell
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(cell + 1, elem, queue->elem_size);
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+    return (0);
+}
+
+
+
+int mpsc_queue_pop(mpsc_queue_t *queue,
+                   void         *elem
+                   )
+{
+    size_t                  pos     = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    struct mpsc_cell_s      *cell   = mpsc_cell(queue, pos);
+
+
+    if ( atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1 )
+    {
+        return (-1);
+    }
+
+    memcpy(elem, cell + 1, queue->elem_size);
+
+
+    // Hand the cell back to the producers for the next lap
+    atomic_store_explicit(&cell->seq, pos + queue->mask + 1, memory_order_release);
+    atomic_store_explicit(&queue->dequeue_pos, pos + 1, memory_order_relaxed);
+
+    return (0);
+}
+
+
+
+size_t mpsc_queue_size(const mpsc_queue_t *queue)
+{
+    size_t      dequeue = atomic_load_explicit(&( (mpsc_queue_t *) queue)->dequeue_pos, memory_order_relaxed);
+    size_t      enqueue = atomic_load_explicit(&( (mpsc_queue_t *) queue)->enqueue_pos, memory_order_relaxed);
+
+
+    return ( (enqueue > dequeue) ? enqueue - dequeue : 0);
+}
+
+
+
+size_t mpsc_queue_capacity(const mpsc_queue_t *queue)
+{
+    return (queue->mask + 1);
+}
@@ -0,0 +1,254 @@
+/**
+ * @file numfmt.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Locale-free formatting of the numeric fields of the replies
+ */
+
+#include <stdio.h>          // snprintf
+#include <stdlib.h>          // strtod
+#include <string.h>          // memcpy
+#include <math.h>          // isfinite, signbit, fabs
+
+#include <numfmt.h>
+
+
+/**
+ * @brief Largest integer a double holds exactly (2^53)
+ */
+#define NUMFMT_EXACT_MAX    9007199254740992.0
+
+
+/**
+ * @brief The pairs of digits 00 to 99
+ */
+static const char s_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+
+/**
+ * @brief Powers of ten up to NUMFMT_FRACTION_DIGITS (exact in a double)
+ */
+static const double s_scales[NUMFMT_FRACTION_DIGITS + 1] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+
+/**
+ * @brief      Write the digits of an unsigned integer at the end of a buffer, two at a time
+ *
+ * @param[in]  value  The value
+ * @param      end    End of the buffer
+ *
+ * @return     The first digit
+ */
+static char* numfmt_digits(unsigned long long value, char *end);
+
+
+/**
+ * @brief      Write exactly a number of digits of an unsigned integer at the end of a buffer, with leading zeros
+ *
+ * @param[in]  value   The value (less than 10^count)
+ * @param[in]  count   Number of digits
+ * @param      end     End of the buffer
+ *
+ * @return     The first digit
+ */
+static char* numfmt_padded(unsigned long long value, unsigned int count, char *end);
+
+
+/**
+ * @brief      Format a positive double with printf, with the fewest significant digits that read back to it
+ *
+ * @param[out] buf        The text (NUMFMT_MAX bytes)
+ * @param[in]  magnitude  The value
+ *
+ * @return     Length of the text
+ */
+static size_t numfmt_printf(char *buf, double magnitude);
+
+
+
+size_t numfmt_integer(char          *buf,
+                      long long     value
+                      )
+{
+    if ( value >= 0 )
+    {
+        return (numfmt_unsigned(buf, (unsigned long long) value) );
+    }
+
+
+    // The magnitude is taken as unsigned, so LLONG_MIN has one
+    buf[0] = '-';
+
+    return (1 + numfmt_unsigned(buf + 1, 0ULL - (unsigned long long) value) );
+}
+
+
+
+size_t numfmt_unsigned(char                 *buf,
+                       unsigned long long   value
+                       )
+{
+    char        tmp[NUMFMT_MAX];
+    char        *end    = tmp + sizeof(tmp);
+    char        *p      = numfmt_digits(value, end);
+
+
+    memcpy(buf, p, end - p);
+
+    return (end - p);
+}
+
+
+
+size_t numfmt_double(char   *buf,
+                     double value
+                     )
+{
+    char                tmp[NUMFMT_MAX];
+    char                *end        = tmp + sizeof(tmp);
+    char                *p          = end;
+    double              magnitude   = fabs(value);
+    double              scaled      = 0;
+    unsigned long long  digits      = 0;
+    unsigned int        fraction    = 0;
+    size_t              sign        = signbit(value) ? 1 : 0;
+
+
+    if ( ! isfinite(value) )
+    {
+        return (0);
+    }
+
+    if ( sign )
+    {
+        buf[0] = '-';
+    }
+
+
+    // The first number of fraction digits whose integer reads back to the value gives the shortest text
+    for ( fraction = 0; fraction <= NUMFMT_FRACTION_DIGITS; ++fraction )
+    {
+        scaled = magnitude * s_scales[fraction];
+
+        if ( scaled >= NUMFMT_EXACT_MAX )
+        {
+            break;
+        }
+
+        digits = (unsigned long long) (scaled + 0.5);
+
+        if ( (double) digits / s_scales[fraction] != magnitude )
+        {
+            continue;
+        }
+
+        if ( fraction == 0 )
+        {
+            *--p    = '0';
+            *--p    = '.';
+            p       = numfmt_digits(digits, p);
+        }
+        else
+        {
+            p       = numfmt_padded(digits % (unsigned long long) s_scales[fraction], fraction, p);
+            *--p    = '.';
+            p       = numfmt_digits(digits / (unsigned long long) s_scales[fraction], p);
+        }
+
+        memcpy(buf + sign, p, end - p);
+
+        return (sign + (end - p) );
+    }
+
+    return (sign + numfmt_printf(buf + sign, magnitude) );
+}
+
+
+
+static char* numfmt_digits(unsigned long long   value,
+                           char                 *end
+                           )
+{
+    while ( value >= 100 )
+    {
+        end    -= 2;
+        memcpy(end, s_pairs + (value % 100) * 2, 2);
+        value  /= 100;
+    }
+
+    if ( value >= 10 )
+    {
+        end -= 2;
+        memcpy(end, s_pairs + value * 2, 2);
+    }
+    else
+    {
+        *--end = '0' + value;
+    }
+
+    return (end);
+}
+
+
+
+static char* numfmt_padded(unsigned long long   value,
+                           unsigned int         count,
+                           char                 *end
+                           )
+{
+    for ( ; count >= 2; count -= 2 )
+    {
+        end    -= 2;
+        memcpy(end, s_pairs + (value % 100) * 2, 2);
+        value  /= 100;
+    }
+
+    if ( count )
+    {
+        *--end = '0' + value % 10;
+    }
+
+    return (end);
+}
+
+
+
+static size_t numfmt_printf(char    *buf,
+                            double  magnitude
+                            )
+{
+    int         low     = 1;
+    int         high    = 17;
+    int         middle  = 0;
+
+
+    // 17 significant digits always read back to the same double, and so does any precision above one that does
+    while ( low < high )
+    {
+        middle = (low + high) / 2;
+
+
+        // A %g text never reaches NUMFMT_MAX, a truncated one would not read back anyway
+        if ( snprintf(buf, NUMFMT_MAX, "%.*g", middle, magnitude) >= NUMFMT_MAX )
+        {
+            low = middle + 1;
+        }
+        else if ( strtod(buf, NULL) == magnitude )
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+
+    return ( (size_t) snprintf(buf, NUMFMT_MAX, "%.*g", low, magnitude) );
+}
@@ -0,0 +1,203 @@
+/**
+ * @file numparse.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Length-bounded, locale-free parsing of the numeric fields
+ */
+
+#include <limits.h>          // LLONG_MAX
+
+#include <numparse.h>
+
+
+/**
+ * @brief Largest number of hundredths converted exactly to a double
+ */
+#define NUMPARSE_CENTI_MAX      (1ULL << 53)
+
+
+/**
+ * @brief      Read the sign
+ *
+ * @param      p     The text, moved after the sign
+ * @param[in]  end   End of the text
+ *
+ * @return     1 if the number is negative, 0 otherwise
+ */
+static int parse_sign(const char **p, const char *end);
+
+
+/**
+ * @brief      Accumulate digits, checking the overflow
+ *
+ * @param      p          The text, moved after the digits
+ * @param[in]  end        End of the text
+ * @param      value      The accumulated value
+ * @param[in]  limit      Largest value
+ * @param      overflow   Set to 1 if the value exceeds limit (the digits are still consumed)
+ *
+ * @return     Number of digits read
+ */
+static size_t parse_digits(const char **p, const char *end, unsigned long long *value, unsigned long long limit,
+                           int *overflow);
+
+
+
+int numparse_integer(const char *p,
+                     size_t     len,
+                     long long  min,
+                     long long  max,
+                     long long  *value
+                     )
+{
+    const char              *end        = p + len;
+    unsigned long long      magnitude   = 0;
+    long long               result      = 0;
+    int                     negative    = 0;
+    int                     overflow    = 0;
+
+
+    negative = parse_sign(&p, end);
+
+    if ( (parse_digits(&p, end, &magnitude, (negative) ? (unsigned long long) LLONG_MAX + 1 : LLONG_MAX, &overflow) == 0) ||
+         (p != end) )
+    {
+        return (NUMPARSE_ERR_SYNTAX);
+    }
+
+    if ( overflow )
+    {
+        return (NUMPARSE_ERR_RANGE);
+    }
+
+
+    // -LLONG_MIN does not fit, the magnitude is negated as an unsigned value
+    result = (negative) ? (long long) (0ULL - magnitude) : (long long) magnitude;
+
+    if ( (result < min) || (result > max) )
+    {
+        return (NUMPARSE_ERR_RANGE);
+    }
+
+    *value = result;
+
+    return (NUMPARSE_OK);
+}
+
+
+
+int numparse_decimal(const char *p,
+                     size_t     len,
+                     double     *value
+                     )
+{
+    const char              *end        = p + len;
+    unsigned long long      centi       = 0;
+    unsigned int            fraction    = 0;
+    int                     negative    = 0;
+    int                     overflow    = 0;
+    int                     round_up    = 0;
+
+
+    negative = parse_sign(&p, end);
+
+    if ( parse_digits(&p, end, &centi, NUMPARSE_CENTI_MAX / 100, &overflow) == 0 )
+    {
+        return (NUMPARSE_ERR_SYNTAX);
+    }
+
+    if ( (p < end) && (*p == '.') )
+    {
+        if ( (++p == end) || (*p < '0') || (*p > '9') )
+        {
+            return (NUMPARSE_ERR_SYNTAX);
+        }
+
+        for ( ; (p < end) && (*p >= '0') && (*p <= '9'); ++p, ++fraction )
+        {
+            if ( fraction < NUMPARSE_FRACTION_DIGITS )
+            {
+                centi = centi * 10 + (*p - '0');
+            }
+            else if ( fraction == NUMPARSE_FRACTION_DIGITS )
+            {
+                round_up = (*p >= '5');
+            }
+        }
+    }
+
+    if ( p != end )
+    {
+        return (NUMPARSE_ERR_SYNTAX);
+    }
+
+    if ( overflow )
+    {
+        return (NUMPARSE_ERR_RANGE);
+    }
+
+
+    // Scale the missing fraction digits ("12" and "12.5" are 1200 and 1250 hundredths)
+    for ( ; fraction < NUMPARSE_FRACTION_DIGITS; ++fraction )
+    {
+        centi *= 10;
+    }
+
+    centi += round_up;
+
+    if ( centi > NUMPARSE_CENTI_MAX )
+    {
+        return (NUMPARSE_ERR_RANGE);
+    }
+
+
+    // Both operands are exact, so the division is correctly rounded like strtod
+    *value = ( (negative) ? - (double) centi : (double) centi) / 100;
+
+    return (NUMPARSE_OK);
+}
+
+
+
+static int parse_sign(const char    **p,
+                      const char    *end
+                      )
+{
+    if ( (*p < end) && ( (**p == '-') || (**p == '+') ) )
+    {
+        return (*(*p)++ == '-');
+    }
+
+    return (0);
+}
+
+
+
+static size_t parse_digits(const char           **p,
+                           const char           *end,
+                           unsigned long long   *value,
+                           unsigned long long   limit,
+                           int                  *overflow
+                           )
+{
+    const char          *start  = *p;
+    unsigned int        digit   = 0;
+
+
+    for ( ; (*p < end) && (**p >= '0') && (**p <= '9'); ++*p )
+    {
+        digit = **p - '0';
+
+        if ( *value > (limit - digit) / 10 )
+        {
+            *overflow = 1;
+        }
+        else
+        {
+            *value = *value * 10 + digit;
+        }
+    }
+
+    return (*p - start);
+}
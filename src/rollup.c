@@ -0,0 +1,305 @@
+/**
+ * @file rollup.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  In-memory accumulators of the rollups of the frames, per device and per minute, hour and day
+ */
+
+#include <stdlib.h>          // calloc, free
+#include <string.h>          // memchr, memcpy, memset, strcmp
+
+#include <rollup.h>
+
+
+/**
+ * @brief Names and lengths (in seconds) of the granularities
+ */
+static const struct {
+    const char *name;          ///< Name, as given to the query endpoint
+    long long seconds;          ///< Length of the buckets
+} s_granularities[ROLLUP_GRANULARITIES] =
+{
+    {"minute", 60},
+    {"hour", 3600},
+    {"day", 86400},
+};
+
+
+/**
+ * @brief      Compute the first slot of a bucket
+ *
+ * @param[in]  device       The packed identifier
+ * @param[in]  granularity  The granularity
+ * @param[in]  bucket       Timestamp of the start of the bucket
+ *
+ * @return     The hash of the bucket
+ */
+static uint64_t rollup_hash(uint64_t device, unsigned char granularity, long long bucket);
+
+
+/**
+ * @brief      Find the accumulator of a bucket, and add the bucket if it is not in the table (which has room for it)
+ *
+ * @param      table        The table
+ * @param[in]  device       The packed identifier
+ * @param[in]  granularity  The granularity
+ * @param[in]  bucket       Timestamp of the start of the bucket
+ *
+ * @return     The accumulator
+ */
+static rollup_entry_t* rollup_slot(rollup_t *table, uint64_t device, unsigned char granularity, long long bucket);
+
+
+/**
+ * @brief      Double the number of slots
+ *
+ * @param      table  The table
+ *
+ * @return     0 on success, -1 on error
+ */
+static int rollup_grow(rollup_t *table);
+
+
+
+rollup_t* rollup_new(size_t capacity)
+{
+    rollup_t        *table  = NULL;
+    size_t          size    = 16;
+
+
+    while ( size < capacity * 2 )
+    {
+        size <<= 1;
+    }
+
+    table = calloc(1, sizeof(rollup_t) );
+
+    if ( ! table )
+    {
+        return (NULL);
+    }
+
+    table->entries = calloc(size, sizeof(rollup_entry_t) );
+
+    if ( ! table->entries )
+    {
+        free(table);
+
+        return (NULL);
+    }
+
+    table->mask = size - 1;
+
+    return (table);
+}
+
+
+
+void rollup_free(rollup_t *table)
+{
+    if ( table )
+    {
+        free(table->entries);
+        free(table);
+    }
+}
+
+
+
+int rollup_add(rollup_t             *table,
+               const sigfox_raws_t  *raws,
+               int                  message
+               )
+{
+    const unsigned char     *end        = memchr(raws->id_modem, '\0', sizeof(uint64_t) );
+    const long long         timestamp   = raws->timestamp;
+    uint64_t                device      = 0;
+    rollup_entry_t          *entry      = NULL;
+    long long               seconds     = 0;
+    long long               bucket      = 0;
+    unsigned char           g           = 0;
+
+
+    memcpy(&device, raws->id_modem, (end) ? (size_t) (end - raws->id_modem) : sizeof(uint64_t) );
+
+
+    // Room for a new bucket of each granularity, so the frame is added to all its buckets or to none
+    if ( ( (table->count + ROLLUP_GRANULARITIES) * 2 > table->mask + 1) && rollup_grow(table) )
+    {
+        return (-1);
+    }
+
+    for ( g = 0; g < ROLLUP_GRANULARITIES; ++g )
+    {
+        // Rounded down, the timestamps before the Epoch included
+        seconds = s_granularities[g].seconds;
+        bucket  = timestamp - ( (timestamp % seconds) + seconds) % seconds;
+        entry   = rollup_slot(table, device, g, bucket);
+
+        if ( message )
+        {
+            entry->messages++;
+            entry->avg_signal_sum += raws->avg_signal;
+        }
+
+        if ( ! entry->receptions )
+        {
+            entry->snr_min  = entry->snr_max = raws->snr;
+            entry->rssi_min = entry->rssi_max = raws->rssi;
+        }
+
+        entry->snr_min  = (raws->snr < entry->snr_min) ? raws->snr : entry->snr_min;
+        entry->snr_max  = (raws->snr > entry->snr_max) ? raws->snr : entry->snr_max;
+        entry->rssi_min = (raws->rssi < entry->rssi_min) ? raws->rssi : entry->rssi_min;
+        entry->rssi_max = (raws->rssi > entry->rssi_max) ? raws->rssi : entry->rssi_max;
+        entry->snr_sum  += raws->snr;
+        entry->rssi_sum += raws->rssi;
+        entry->receptions++;
+    }
+
+    return (0);
+}
+
+
+
+void rollup_clear(rollup_t *table)
+{
+    if ( table->count )
+    {
+        memset(table->entries, 0, (table->mask + 1) * sizeof(rollup_entry_t) );
+        table->count = 0;
+    }
+}
+
+
+
+size_t rollup_id(const rollup_entry_t   *entry,
+                 char                   id_modem[SIGFOX_DEVICE_LENGTH + 1]
+                 )
+{
+    const char      *end    = NULL;
+
+
+    memcpy(id_modem, &entry->device, sizeof(entry->device) );
+    id_modem[SIGFOX_DEVICE_LENGTH] = '\0';
+    end = memchr(id_modem, '\0', SIGFOX_DEVICE_LENGTH + 1);
+
+    return (end - id_modem);
+}
+
+
+
+long long rollup_seconds(rollup_granularity_t granularity)
+{
+    return (s_granularities[granularity].seconds);
+}
+
+
+
+int rollup_granularity(const char *name)
+{
+    int     g   = 0;
+
+
+    for ( g = 0; g < ROLLUP_GRANULARITIES; ++g )
+    {
+        if ( strcmp(name, s_granularities[g].name) == 0 )
+        {
+            return (g);
+        }
+    }
+
+    return (-1);
+}
+
+
+
+static uint64_t rollup_hash(uint64_t        device,
+                            unsigned char   granularity,
+                            long long       bucket
+                            )
+{
+    uint64_t        hash    = device ^ ( (uint64_t) bucket * 0x9E3779B97F4A7C15ULL) ^ granularity;
+
+
+    hash   *= 0xFF51AFD7ED558CCDULL;
+    hash   ^= hash >> 32;
+
+    return (hash);
+}
+
+
+
+static rollup_entry_t* rollup_slot(rollup_t         *table,
+                                   uint64_t         device,
+                                   unsigned char    granularity,
+                                   long long        bucket
+                                   )
+{
+    uint64_t            hash    = rollup_hash(device, granularity, bucket);
+    rollup_entry_t      *entry  = NULL;
+
+
+    for ( entry = &table->entries[hash & table->mask]; entry->used; entry = &table->entries[++hash & table->mask] )
+    {
+        if ( (entry->device == device) && (entry->bucket == bucket) && (entry->granularity == granularity) )
+        {
+            return (entry);
+        }
+    }
+
+
+    // The buckets are only removed all at once, so the probe only ends on an empty slot
+    table->count++;
+    memset(entry, 0, sizeof(*entry) );
+    entry->device       = device;
+    entry->bucket       = bucket;
+    entry->granularity  = granularity;
+    entry->used         = 1;
+
+    return (entry);
+}
+
+
+
+static int rollup_grow(rollup_t *table)
+{
+    rollup_entry_t      *old    = table->entries;
+    size_t              size    = (table->mask + 1) * 2;
+    size_t              i       = 0;
+    uint64_t            hash    = 0;
+    rollup_entry_t      *entry  = NULL;
+
+
+    table->entries = calloc(size, sizeof(rollup_entry_t) );
+
+    if ( ! table->entries )
+    {
+        table->entries = old;
+
+        return (-1);
+    }
+
+    for ( i = 0; i <= table->mask; ++i )
+    {
+        if ( ! old[i].used )
+        {
+            continue;
+        }
+
+        for ( hash = rollup_hash(old[i].device, old[i].granularity, old[i].bucket),
+              entry = &table->entries[hash & (size - 1)]; entry->used; )
+        {
+            hash++;
+            entry = &table->entries[hash & (size - 1)];
+        }
+
+        *entry = old[i];
+    }
+
+    free(old);
+    table->mask = size - 1;
+
+    return (0);
+}
@@ -0,0 +1,255 @@
+/**
+ * @file sigfox_binary.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Fixed-layout binary records of the frames, for the local gateways
+ */
+
+#include <string.h>          // memcpy, memset, strlen, strnlen
+
+#include <sigfox_binary.h>
+#include <sigfox_json.h>          // SIGFOX_JSON_ERR_*
+#include <hex.h>          // hex_decode
+
+
+/**
+ * @brief      Read a little-endian integer
+ *
+ * @param[in]  p     The bytes
+ * @param[in]  size  Number of bytes
+ *
+ * @return     The integer
+ */
+static uint64_t get_le(const unsigned char *p, unsigned int size);
+
+
+/**
+ * @brief      Write a little-endian integer
+ *
+ * @param[out] p      The bytes
+ * @param[in]  value  The integer
+ * @param[in]  size   Number of bytes
+ */
+static void put_le(unsigned char *p, uint64_t value, unsigned int size);
+
+
+/**
+ * @brief      Convert a number of hundredths, or SIGFOX_BINARY_NOT_AVAILABLE, to the value stored in a raws structure
+ *
+ * @param[in]  p     The bytes of the number
+ *
+ * @return     The value (0 if it is not available, as the JSON decoder does)
+ */
+static double get_hundredths(const unsigned char *p);
+
+
+/**
+ * @brief      Convert a value to a number of hundredths, rounded half away from zero
+ *
+ * @param[in]  value  The value
+ *
+ * @return     The number of hundredths
+ */
+static int32_t to_hundredths(double value);
+
+
+
+size_t sigfox_binary_decode(const unsigned char *buf,
+                            size_t              len,
+                            sigfox_raws_t       *raws,
+                            unsigned char       *error
+                            )
+{
+    static const char       digits[]    = "0123456789abcdef";
+    size_t                  length      = 0;
+    unsigned int            data_len    = 0;
+    unsigned int            i           = 0;
+    int64_t                 timestamp   = 0;
+
+
+    memset(raws, 0, sizeof(*raws) );
+    *error = SIGFOX_JSON_ERR_SYNTAX;
+
+    if ( len < 2 )
+    {
+        return (0);
+    }
+
+    length = get_le(buf, 2);
+
+
+    // A length that cannot hold the header loses the framing, the rest of the bytes is given up
+    if ( length < 3 )
+    {
+        return (len);
+    }
+
+    if ( len < length )
+    {
+        return (0);
+    }
+
+    if ( buf[2] != SIGFOX_BINARY_VERSION )
+    {
+        *error = SIGFOX_BINARY_ERR_VERSION;
+
+        return (length);
+    }
+
+    if ( length < SIGFOX_BINARY_RECORD_LENGTH )
+    {
+        return (length);
+    }
+
+    memcpy(raws->id_modem, buf + 4, SIGFOX_DEVICE_LENGTH);
+    memcpy(raws->station, buf + 12, SIGFOX_STATION_LENGTH);
+    timestamp           = (int64_t) get_le(buf + 16, 8);
+    raws->timestamp     = timestamp;
+    raws->snr           = get_hundredths(buf + 24);
+    raws->avg_signal    = get_hundredths(buf + 28);
+    raws->rssi          = get_hundredths(buf + 32);
+    raws->seq_number    = get_le(buf + 36, 4);
+    raws->latitude      = (int16_t) get_le(buf + 40, 2);
+    raws->longitude     = (int16_t) get_le(buf + 42, 2);
+    raws->duplicate     = (buf[3] & SIGFOX_BINARY_FLAG_DUPLICATE) != 0;
+    raws->ack           = (buf[3] & SIGFOX_BINARY_FLAG_ACK) != 0;
+    raws->long_polling  = (buf[3] & SIGFOX_BINARY_FLAG_LONG_POLLING) != 0;
+    data_len            = buf[44];
+
+
+    // The payload is already in bytes, only its string is built
+    for ( i = 0; (i < data_len) && (i < SIGFOX_DATA_LENGTH); ++i )
+    {
+        raws->data_hex[i]           = buf[45 + i];
+        raws->data_str[2 * i]       = digits[buf[45 + i] >> 4];
+        raws->data_str[2 * i + 1]   = digits[buf[45 + i] & 0x0F];
+    }
+
+
+    // Same errors as the JSON decoder, in the same order
+    if ( ! raws->id_modem[0] )
+    {
+        *error = 1;
+    }
+    else if ( timestamp < 0 )
+    {
+        *error = 2;
+    }
+    else if ( ! raws->station[0] )
+    {
+        *error = 5;
+    }
+    else if ( (data_len == 0) || (data_len > SIGFOX_DATA_LENGTH) )
+    {
+        *error = SIGFOX_JSON_ERR_DATA;
+    }
+    else if ( (raws->latitude < -90) || (raws->latitude > 90) || (raws->longitude < -180) || (raws->longitude > 180) )
+    {
+        *error = SIGFOX_JSON_ERR_COORDINATES;
+    }
+    else
+    {
+        *error = 0;
+    }
+
+    return (length);
+}
+
+
+
+void sigfox_binary_encode(unsigned char         buf[SIGFOX_BINARY_RECORD_LENGTH],
+                          const sigfox_raws_t   *raws
+                          )
+{
+    size_t      data_len = strnlen( (const char *) raws->data_str, SIGFOX_DATA_STR_LENGTH) / 2;
+
+
+    memset(buf, 0, SIGFOX_BINARY_RECORD_LENGTH);
+    put_le(buf, SIGFOX_BINARY_RECORD_LENGTH, 2);
+    buf[2] = SIGFOX_BINARY_VERSION;
+    buf[3] = ( (raws->duplicate) ? SIGFOX_BINARY_FLAG_DUPLICATE : 0) | ( (raws->ack) ? SIGFOX_BINARY_FLAG_ACK : 0) |
+             ( (raws->long_polling) ? SIGFOX_BINARY_FLAG_LONG_POLLING : 0);
+    memcpy(buf + 4, raws->id_modem, strnlen( (const char *) raws->id_modem, SIGFOX_DEVICE_LENGTH) );
+    memcpy(buf + 12, raws->station, strnlen( (const char *) raws->station, SIGFOX_STATION_LENGTH) );
+    put_le(buf + 16, (uint64_t) raws->timestamp, 8);
+    put_le(buf + 24, (uint32_t) to_hundredths(raws->snr), 4);
+    put_le(buf + 28, (uint32_t) to_hundredths(raws->avg_signal), 4);
+    put_le(buf + 32, (uint32_t) to_hundredths(raws->rssi), 4);
+    put_le(buf + 36, raws->seq_number, 4);
+    put_le(buf + 40, (uint16_t) raws->latitude, 2);
+    put_le(buf + 42, (uint16_t) raws->longitude, 2);
+    buf[44] = data_len;
+    memcpy(buf + 45, raws->data_hex, data_len);
+}
+
+
+
+void sigfox_binary_reply(unsigned char          buf[SIGFOX_BINARY_REPLY_LENGTH],
+                         const sigfox_raws_t    *raws,
+                         unsigned char          status,
+                         const char             *downlink_data
+                         )
+{
+    memset(buf, 0, SIGFOX_BINARY_REPLY_LENGTH);
+    put_le(buf, SIGFOX_BINARY_REPLY_LENGTH, 2);
+    buf[2] = SIGFOX_BINARY_VERSION;
+    buf[3] = status;
+    memcpy(buf + 4, raws->id_modem, strnlen( (const char *) raws->id_modem, SIGFOX_DEVICE_LENGTH) );
+    put_le(buf + 12, raws->seq_number, 4);
+
+    if ( downlink_data && downlink_data[0] )
+    {
+        hex_decode( (const unsigned char *) downlink_data, SIGFOX_DOWNLINK_DATA_LENGTH, buf + 16, NULL);
+    }
+}
+
+
+
+static uint64_t get_le(const unsigned char  *p,
+                       unsigned int         size
+                       )
+{
+    uint64_t        value   = 0;
+
+
+    while ( size-- > 0 )
+    {
+        value = (value << 8) | p[size];
+    }
+
+    return (value);
+}
+
+
+
+static void put_le(unsigned char    *p,
+                   uint64_t         value,
+                   unsigned int     size
+                   )
+{
+    unsigned int        i       = 0;
+
+
+    for ( i = 0; i < size; ++i, value >>= 8 )
+    {
+        p[i] = value & 0xFF;
+    }
+}
+
+
+
+static double get_hundredths(const unsigned char *p)
+{
+    const int32_t       value   = (int32_t) get_le(p, 4);
+
+
+    return ( (value == SIGFOX_BINARY_NOT_AVAILABLE) ? 0 : value / 100.0);
+}
+
+
+
+static int32_t to_hundredths(double value)
+{
+    return ( (int32_t) (value * 100 + ( (value < 0) ? -0.5 : 0.5) ) );
+}
@@ -0,0 +1,170 @@
+/**
+ * @file sigfox_form.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Decoder of the url-encoded bodies and query strings sent by the Sigfox callbacks
+ */
+
+#include <string.h>          // memchr, memset, strlen
+
+#include <sigfox_form.h>
+#include <sigfox_json.h>          // sigfox_json_field, sigfox_json_error, SIGFOX_JSON_ERR_*
+#include <hex.h>          // hex_decode
+
+
+/**
+ * @brief      Decode the escapes of a key or a value, if it has any
+ *
+ * @param[in,out] p    The text, replaced by buf if it is decoded
+ * @param[in,out] len  Its length
+ * @param[out]    buf  The decoded text (SIGFOX_FORM_ESCAPED_MAX bytes)
+ *
+ * @return     0 on success, -1 if an escape is malformed or the text is too long
+ */
+static int unescape(const char **p, size_t *len, char *buf);
+
+
+/**
+ * @brief      Get the value of an hexadecimal digit
+ *
+ * @param[in]  c     The character
+ *
+ * @return     The value, -1 if the character is not an hexadecimal digit
+ */
+static int hex_digit(char c);
+
+
+
+unsigned char sigfox_form_decode(const char     *form,
+                                 size_t         len,
+                                 sigfox_raws_t  *raws
+                                 )
+{
+    const char          *end        = form + len;
+    const char          *p          = form;
+    const char          *pair_end   = NULL;
+    const char          *key        = NULL;
+    const char          *val        = NULL;
+    size_t              key_len     = 0;
+    size_t              val_len     = 0;
+    unsigned int        seen        = 0;
+    unsigned char       invalid     = 0;
+    unsigned char       error       = 0;
+    char                key_buf[SIGFOX_FORM_ESCAPED_MAX];
+    char                val_buf[SIGFOX_FORM_ESCAPED_MAX];
+
+
+    memset(raws, 0, sizeof(*raws) );
+
+    for ( ; p < end; p = pair_end + 1 )
+    {
+        pair_end = memchr(p, '&', end - p);
+        pair_end = (pair_end) ? pair_end : end;
+
+
+        // Empty pairs (`a=1&&b=2`, trailing `&`) are skipped like the unknown keys
+        if ( pair_end == p )
+        {
+            continue;
+        }
+
+        // A key without `=` has an empty value
+        key     = p;
+        val     = memchr(p, '=', pair_end - p);
+        key_len = ( (val) ? val : pair_end) - key;
+        val     = (val) ? val + 1 : pair_end;
+        val_len = pair_end - val;
+
+        if ( unescape(&key, &key_len, key_buf) || unescape(&val, &val_len, val_buf) )
+        {
+            return (SIGFOX_JSON_ERR_SYNTAX);
+        }
+
+        sigfox_json_field(key, key_len, val, val_len, raws, &seen, &invalid);
+    }
+
+    error = sigfox_json_error(seen, invalid);
+
+    if ( (error == 0) && hex_decode(raws->data_str, strlen( (const char *) raws->data_str), raws->data_hex, NULL) )
+    {
+        error = SIGFOX_JSON_ERR_DATA;
+    }
+
+    return (error);
+}
+
+
+
+static int unescape(const char  **p,
+                    size_t      *len,
+                    char        *buf
+                    )
+{
+    const char      *src    = *p;
+    size_t          i       = 0;
+    size_t          n       = 0;
+    int             hi      = 0;
+    int             lo      = 0;
+
+
+    // The fields of a frame are hexadecimal strings and numbers, they are sent as they are
+    if ( ! memchr(src, '%', *len) && ! memchr(src, '+', *len) )
+    {
+        return (0);
+    }
+
+    for ( i = 0; i < *len; ++i, ++n )
+    {
+        if ( n == SIGFOX_FORM_ESCAPED_MAX )
+        {
+            return (-1);
+        }
+
+        if ( src[i] == '+' )
+        {
+            buf[n] = ' ';
+        }
+        else if ( src[i] == '%' )
+        {
+            if ( i + 2 >= *len )
+            {
+                return (-1);
+            }
+
+            hi = hex_digit(src[i + 1]);
+            lo = hex_digit(src[i + 2]);
+
+            if ( (hi < 0) || (lo < 0) )
+            {
+                return (-1);
+            }
+
+            buf[n]  = (char) ( (hi << 4) | lo);
+            i      += 2;
+        }
+        else
+        {
+            buf[n] = src[i];
+        }
+    }
+
+    *p      = buf;
+    *len    = n;
+
+    return (0);
+}
+
+
+
+static int hex_digit(char c)
+{
+    if ( (c >= '0') && (c <= '9') )
+    {
+        return (c - '0');
+    }
+
+    c |= 0x20;
+
+    return ( ( (c >= 'a') && (c <= 'f') ) ? c - 'a' + 10 : -1);
+}
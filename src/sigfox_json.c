@@ -0,0 +1,595 @@
+/**
+ * @file sigfox_json.c
+ * @author hbuyse
+ * @date 17/10/2026
+ *
+ * @brief  Single-pass decoder of the JSON body sent by the Sigfox callbacks
+ */
+
+#include <string.h>          // memcpy, memcmp, memset, strlen
+#include <limits.h>          // LLONG_MAX, UINT_MAX
+
+#include <sigfox_json.h>
+#include <sqls.h>          // SQL_COL_*
+#include <hex.h>          // hex_decode
+#include <numparse.h>          // numparse_integer, numparse_decimal
+
+
+/**
+ * @enum sigfox_field_e
+ * @brief  Fields of the callback body, in the order they are checked
+ */
+typedef enum sigfox_field_e {
+    FIELD_ID_MODEM,          ///< id_modem
+    FIELD_TIMESTAMP,          ///< timestamp
+    FIELD_DUPLICATE,          ///< duplicate
+    FIELD_SNR,          ///< snr
+    FIELD_STATION,          ///< station
+    FIELD_DATA_STR,          ///< data_str
+    FIELD_AVG_SIGNAL,          ///< avg_signal
+    FIELD_LATITUDE,          ///< latitude
+    FIELD_LONGITUDE,          ///< longitude
+    FIELD_RSSI,          ///< rssi
+    FIELD_SEQ_NUMBER,          ///< seq_number
+    FIELD_ACK,          ///< ack
+    FIELD_LONG_POLLING,          ///< long_polling
+    FIELD_UNKNOWN          ///< Any other key
+} sigfox_field_t;
+
+
+/**
+ * @brief      Check if a key of a given length is a given column name
+ */
+#define KEY_IS(key, len, col)   ( ( (len) == sizeof(col) - 1) && (memcmp( (key), (col), sizeof(col) - 1) == 0) )
+
+
+/**
+ * @brief      Find the field of a key with a switch on its length then its first character
+ *
+ * @param[in]  key   The key
+ * @param[in]  len   Length of the key
+ *
+ * @return     The field
+ */
+static sigfox_field_t field_from_key(const char *key, size_t len);
+
+
+/**
+ * @brief      Skip the whitespaces
+ *
+ * @param[in]  p     Current position
+ * @param[in]  end   End of the buffer
+ *
+ * @return     First non-whitespace position
+ */
+static const char* skip_ws(const char *p, const char *end);
+
+
+/**
+ * @brief      Scan a JSON string
+ *
+ * @param[in]  p     Position of the opening quote
+ * @param[in]  end   End of the buffer
+ * @param[out] len   Length of the content (without the quotes, escapes are kept as they are)
+ *
+ * @return     Position after the closing quote, NULL if the string is not terminated
+ */
+static const char* scan_string(const char *p, const char *end, size_t *len);
+
+
+/**
+ * @brief      Scan any JSON value
+ *
+ * @param[in]  p     Beginning of the value
+ * @param[in]  end   End of the buffer
+ * @param[out] val   Beginning of the content (inside the quotes for a string)
+ * @param[out] len   Length of the content
+ *
+ * @return     Position after the value, NULL on syntax error
+ */
+static const char* scan_value(const char *p, const char *end, const char **val, size_t *len);
+
+
+/**
+ * @brief      Tell if a value is «null» or «N/A» (the RSSI and the average signal can be unavailable)
+ *
+ * @param[in]  val   The value
+ * @param[in]  len   Length of the value
+ *
+ * @return     1 if the value is not available, 0 otherwise
+ */
+static int is_not_available(const char *val, size_t len);
+
+
+/**
+ * @brief      Copy a string field, truncated to its maximum length
+ *
+ * @param[out] dst      The field (max + 1 bytes)
+ * @param[in]  max      Maximum length of the field
+ * @param[in]  val      The value
+ * @param[in]  len      Length of the value
+ */
+static void copy_field(unsigned char *dst, size_t max, const char *val, size_t len);
+
+
+
+const char* sigfox_json_decode_object(const char    *json,
+                                      const char    *end,
+                                      sigfox_raws_t *raws,
+                                      unsigned char *error
+                                      )
+{
+    const char          *p      = skip_ws(json, end);
+    const char          *key    = NULL;
+    const char          *val    = NULL;
+    size_t              key_len = 0;
+    size_t              val_len = 0;
+    unsigned int        seen    = 0;
+    unsigned char       invalid = 0;
+
+
+    memset(raws, 0, sizeof(*raws) );
+    *error = SIGFOX_JSON_ERR_SYNTAX;
+
+    if ( (p >= end) || (*p != '{') )
+    {
+        return (NULL);
+    }
+
+    p = skip_ws(p + 1, end);
+
+    if ( (p < end) && (*p == '}') )
+    {
+        p++;
+    }
+    else
+    {
+        for ( ; ; )
+        {
+            // "key"
+            if ( (p >= end) || (*p != '"') )
+            {
+                return (NULL);
+            }
+
+            key = p + 1;
+            p   = scan_string(p, end, &key_len);
+
+            if ( ! p )
+            {
+                return (NULL);
+            }
+
+            // :
+            p = skip_ws(p, end);
+
+            if ( (p >= end) || (*p != ':') )
+            {
+                return (NULL);
+            }
+
+            // value
+            p = scan_value(skip_ws(p + 1, end), end, &val, &val_len);
+
+            if ( ! p )
+            {
+                return (NULL);
+            }
+
+            sigfox_json_field(key, key_len, val, val_len, raws, &seen, &invalid);
+
+
+            // , or }
+            p = skip_ws(p, end);
+
+            if ( (p < end) && (*p == ',') )
+            {
+                p = skip_ws(p + 1, end);
+            }
+            else if ( (p < end) && (*p == '}') )
+            {
+                p++;
+                break;
+            }
+            else
+            {
+                return (NULL);
+            }
+        }
+    }
+
+    *error = sigfox_json_error(seen, invalid);
+
+    return (p);
+}
+
+
+
+unsigned char sigfox_json_decode(const char     *json,
+                                 size_t         len,
+                                 sigfox_raws_t  *raws
+                                 )
+{
+    const char          *end    = json + len;
+    const char          *p      = NULL;
+    unsigned char       error   = 0;
+
+
+    p = sigfox_json_decode_object(json, end, raws, &error);
+
+    if ( ! p || (skip_ws(p, end) != end) )
+    {
+        return (SIGFOX_JSON_ERR_SYNTAX);
+    }
+
+    if ( (error == 0) && hex_decode(raws->data_str, strlen( (const char *) raws->data_str), raws->data_hex, NULL) )
+    {
+        error = SIGFOX_JSON_ERR_DATA;
+    }
+
+    return (error);
+}
+
+
+
+void sigfox_json_field(const char       *key,
+                       size_t           key_len,
+                       const char       *val,
+                       size_t           val_len,
+                       sigfox_raws_t    *raws,
+                       unsigned int     *seen,
+                       unsigned char    *invalid
+                       )
+{
+    sigfox_field_t      field   = field_from_key(key, key_len);
+    long long           integer = 0;
+    int                 status  = NUMPARSE_OK;
+    unsigned char       code    = 0;
+
+
+    switch ( field )
+    {
+        case FIELD_ID_MODEM:
+            copy_field(raws->id_modem, SIGFOX_DEVICE_LENGTH, val, val_len);
+            break;
+
+        case FIELD_TIMESTAMP:
+            status          = numparse_integer(val, val_len, 0, LLONG_MAX, &integer);
+            raws->timestamp = integer;
+            code            = 2;
+            break;
+
+        case FIELD_DUPLICATE:
+            raws->duplicate = (val_len >= 4) && (memcmp(val, "true", 4) == 0);
+            break;
+
+        case FIELD_SNR:
+            status      = numparse_decimal(val, val_len, &raws->snr);
+            code        = 4;
+            break;
+
+        case FIELD_STATION:
+            copy_field(raws->station, SIGFOX_STATION_LENGTH, val, val_len);
+            break;
+
+        case FIELD_DATA_STR:
+            copy_field(raws->data_str, SIGFOX_DATA_STR_LENGTH, val, val_len);
+            break;
+
+        case FIELD_AVG_SIGNAL:
+            status  = (is_not_available(val, val_len) ) ? NUMPARSE_OK : numparse_decimal(val, val_len, &raws->avg_signal);
+            code    = 7;
+            break;
+
+        case FIELD_LATITUDE:
+            status          = numparse_integer(val, val_len, -90, 90, &integer);
+            raws->latitude  = integer;
+            code            = SIGFOX_JSON_ERR_COORDINATES;
+            break;
+
+        case FIELD_LONGITUDE:
+            status          = numparse_integer(val, val_len, -180, 180, &integer);
+            raws->longitude = integer;
+            code            = SIGFOX_JSON_ERR_COORDINATES;
+            break;
+
+        case FIELD_RSSI:
+            status  = (is_not_available(val, val_len) ) ? NUMPARSE_OK : numparse_decimal(val, val_len, &raws->rssi);
+            code    = 7;
+            break;
+
+        case FIELD_SEQ_NUMBER:
+            status              = numparse_integer(val, val_len, 0, UINT_MAX, &integer);
+            raws->seq_number    = integer;
+            code                = 8;
+            break;
+
+        case FIELD_ACK:
+            raws->ack = (val_len >= 4) && (memcmp(val, "true", 4) == 0);
+            break;
+
+        case FIELD_LONG_POLLING:
+            raws->long_polling = (val_len >= 4) && (memcmp(val, "true", 4) == 0);
+            break;
+
+        default:
+            break;
+    }
+
+    *seen |= 1U << field;
+
+
+    // A number that is not one or is out of range invalidates the frame, unless a field is missing
+    if ( (status != NUMPARSE_OK) && (*invalid == 0) )
+    {
+        *invalid = code;
+    }
+}
+
+
+
+unsigned char sigfox_json_error(unsigned int    seen,
+                                unsigned char   invalid
+                                )
+{
+    unsigned int        i       = 0;
+
+    // Required fields and the error returned when they are missing (the latitude, longitude and ack are optional)
+    static const struct {
+        sigfox_field_t field;
+        unsigned char error;
+    } required[] =
+    {
+        {FIELD_ID_MODEM, 1}, {FIELD_TIMESTAMP, 2}, {FIELD_DUPLICATE, 3}, {FIELD_SNR, 4}, {FIELD_STATION, 5},
+        {FIELD_DATA_STR, SIGFOX_JSON_ERR_DATA}, {FIELD_AVG_SIGNAL, 7}, {FIELD_RSSI, 7}, {FIELD_SEQ_NUMBER, 8}, {FIELD_LONG_POLLING, 10}
+    };
+
+
+    for ( i = 0; i < sizeof(required) / sizeof(required[0]); ++i )
+    {
+        if ( ! (seen & (1U << required[i].field) ) )
+        {
+            return (required[i].error);
+        }
+    }
+
+    return (invalid);
+}
+
+
+
+static sigfox_field_t field_from_key(const char *key,
+                                     size_t     len
+                                     )
+{
+    switch ( len )
+    {
+        case 3:
+
+            if ( (key[0] == 's') && KEY_IS(key, len, SQL_COL_SNR) )
+            {
+                return (FIELD_SNR);
+            }
+            else if ( (key[0] == 'a') && KEY_IS(key, len, SQL_COL_ACK) )
+            {
+                return (FIELD_ACK);
+            }
+
+            break;
+
+        case 4:
+
+            if ( (key[0] == 'r') && KEY_IS(key, len, SQL_COL_RSSI) )
+            {
+                return (FIELD_RSSI);
+            }
+
+            break;
+
+        case 7:
+
+            if ( (key[0] == 's') && KEY_IS(key, len, SQL_COL_STATION) )
+            {
+                return (FIELD_STATION);
+            }
+
+            break;
+
+        case 8:
+
+            if ( (key[0] == 'i') && KEY_IS(key, len, SQL_COL_ID_MODEM) )
+            {
+                return (FIELD_ID_MODEM);
+            }
+            else if ( (key[0] == 'd') && KEY_IS(key, len, SQL_COL_DATA_STR) )
+            {
+                return (FIELD_DATA_STR);
+            }
+            else if ( (key[0] == 'l') && KEY_IS(key, len, SQL_COL_LATITUDE) )
+            {
+                return (FIELD_LATITUDE);
+            }
+
+            break;
+
+        case 9:
+
+            if ( (key[0] == 't') && KEY_IS(key, len, SQL_COL_TIMESTAMP) )
+            {
+                return (FIELD_TIMESTAMP);
+            }
+            else if ( (key[0] == 'd') && KEY_IS(key, len, SQL_COL_DUPLICATE) )
+            {
+                return (FIELD_DUPLICATE);
+            }
+            else if ( (key[0] == 'l') && KEY_IS(key, len, SQL_COL_LONGITUDE) )
+            {
+                return (FIELD_LONGITUDE);
+            }
+
+            break;
+
+        case 10:
+
+            if ( (key[0] == 'a') && KEY_IS(key, len, SQL_COL_AVG_SIGNAL) )
+            {
+                return (FIELD_AVG_SIGNAL);
+            }
+            else if ( (key[0] == 's') && KEY_IS(key, len, SQL_COL_SEQ_NUMBER) )
+            {
+                return (FIELD_SEQ_NUMBER);
+            }
+
+            break;
+
+        case 12:
+
+            if ( (key[0] == 'l') && KEY_IS(key, len, SQL_COL_LONG_POLLING) )
+            {
+                return (FIELD_LONG_POLLING);
+            }
+
+            break;
+
+        default:
+            break;
+    }
+
+    return (FIELD_UNKNOWN);
+}
+
+
+
+static const char* skip_ws(const char   *p,
+                           const char   *end
+                           )
+{
+    while ( (p < end) && ( (*p == ' ') || (*p == '\t') || (*p == '\n') || (*p == '\r') ) )
+    {
+        p++;
+    }
+
+    return (p);
+}
+
+
+
+static const char* scan_string(const char   *p,
+                               const char   *end,
+                               size_t       *len
+                               )
+{
+    const char     *start = ++p;
+
+
+    for ( ; p < end; ++p )
+    {
+        if ( *p == '\\' )
+        {
+            p++;
+        }
+        else if ( *p == '"' )
+        {
+            *len = p - start;
+
+            return (p + 1);
+        }
+    }
+
+    return (NULL);
+}
+
+
+
+static const char* scan_value(const char    *p,
+                              const char    *end,
+                              const char    **val,
+                              size_t        *len
+                              )
+{
+    unsigned int     depth = 0;
+
+
+    if ( p >= end )
+    {
+        return (NULL);
+    }
+
+    *val = p;
+
+    if ( *p == '"' )
+    {
+        *val = p + 1;
+
+        return (scan_string(p, end, len) );
+    }
+
+    if ( (*p == '{') || (*p == '[') )
+    {
+        // Nested values are only skipped, the strings are scanned so their brackets are ignored
+        for ( ; p < end; )
+        {
+            if ( *p == '"' )
+            {
+                p = scan_string(p, end, len);
+
+                if ( ! p )
+                {
+                    return (NULL);
+                }
+
+                continue;
+            }
+
+            if ( (*p == '{') || (*p == '[') )
+            {
+                depth++;
+            }
+            else if ( ( (*p == '}') || (*p == ']') ) && (--depth == 0) )
+            {
+                *len = p + 1 - *val;
+
+                return (p + 1);
+            }
+
+            p++;
+        }
+
+        return (NULL);
+    }
+
+
+    // Literal: number, true, false or null
+    while ( (p < end) && (*p != ',') && (*p != '}') && (*p != ']') && (*p != ' ') && (*p != '\t') &&
+            (*p != '\n') && (*p != '\r') )
+    {
+        p++;
+    }
+
+    *len = p - *val;
+
+    return ( (*len > 0) ? p : NULL);
+}
+
+
+
+static int is_not_available(const char  *val,
+                            size_t      len
+                            )
+{
+    return ( ( (len == 4) && (memcmp(val, "null", 4) == 0) ) || ( (len == 3) && (memcmp(val, "N/A", 3) == 0) ) );
+}
+
+
+
+static void copy_field(unsigned char    *dst,
+                       size_t           max,
+                       const char       *val,
+                       size_t           len
+                       )
+{
+    len = (len > max) ? max : len;
+    memcpy(dst, val, len);
+    dst[len] = '\0';
+}
+
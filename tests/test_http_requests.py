@@ -7,11 +7,60 @@ import requests
 import os
 import signal
 import json
+import socket
+import sqlite3
+import struct
+import threading
+import time
 
 PORT = 8000
+BINARY_PORT = 8001
 PROCESS_ID = 0
 
 
+def cbor_decode(data, i=0):
+    """Decode the CBOR item at data[i:] (the types of the reads only), return it and the index after it."""
+    major, info = data[i] >> 5, data[i] & 0x1F
+    i += 1
+    if major == 7:
+        if info in (20, 21):
+            return (info == 21), i
+        fmt, size = {26: ('>f', 4), 27: ('>d', 8)}[info]
+        return struct.unpack(fmt, data[i:i + size])[0], i + size
+    if info == 31:
+        items = []
+        while data[i] != 0xFF:
+            item, i = cbor_decode(data, i)
+            items.append(item)
+        return items, i + 1
+    if info < 24:
+        value = info
+    else:
+        size = 1 << (info - 24)
+        value, i = int.from_bytes(data[i:i + size], 'big'), i + size
+    if major == 0:
+        return value, i
+    if major == 1:
+        return -1 - value, i
+    if major == 3:
+        return data[i:i + value].decode(), i + value
+    pairs = {}
+    for _ in range(value):
+        key, i = cbor_decode(data, i)
+        pairs[key], i = cbor_decode(data, i)
+    return pairs, i
+
+
+def slow_export():
+    """Open a full-table export whose client does not read: the read waits between two slices."""
+    slow = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    slow.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)
+    slow.connect(('127.0.0.1', PORT))
+    slow.sendall(b'GET /api?limit=100000 HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n')
+    time.sleep(0.5)
+    return slow
+
+
 class TestingHTTPRequests:
 
     def test_get(self):
@@ -326,3 +375,1107 @@ class TestingHTTPRequests:
             r = requests.post(url=d['url'], data=json.dumps(d['data']))
             print(d)
             assert (r.status_code == d['status_code'])
+
+    def test_post_numeric_fields(self):
+        frame = {
+            'id_modem': "BEF",
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 12 ,
+            'ack': False,
+            'long_polling': False,
+        }
+
+        l = [
+            {
+                'data': json.dumps(dict(frame, rssi=None, avg_signal="N/A")),
+                'status_code': 204,
+            },
+            {
+                'data': json.dumps(dict(frame, snr=-10.5, rssi=-120)),
+                'status_code': 204,
+            },
+            {
+                'data': json.dumps(frame).replace('123456', '99999999999999999999'),
+                'status_code': 400,
+            },
+            {
+                'data': json.dumps(dict(frame, snr="10.2x")),
+                'status_code': 400,
+            },
+            {
+                'data': json.dumps(dict(frame, seq_number=-1)),
+                'status_code': 400,
+            },
+            {
+                'data': json.dumps(dict(frame, latitude=91)),
+                'status_code': 400,
+            }
+        ]
+
+        for d in l:
+            r = requests.post(url='http://127.0.0.1:{}/api'.format(PORT), data=d['data'])
+            print(d)
+            assert (r.status_code == d['status_code'])
+
+    def test_post_form(self):
+        frame = {
+            'id_modem': "F0A",
+            'timestamp': 123456,
+            'duplicate': "false",
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': "N/A",
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': -120.5,
+            'seq_number': 1,
+            'ack': "false",
+            'long_polling': "false",
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+
+        # application/x-www-form-urlencoded body, POST and GET query strings
+        r = requests.post(url=url, data=frame)
+        assert (r.status_code == 204)
+        r = requests.post(url=url, params=dict(frame, seq_number=2))
+        assert (r.status_code == 204)
+        r = requests.get(url=url, params=dict(frame, seq_number=3))
+        assert (r.status_code == 204)
+
+        r = requests.post(url=url, data=dict(frame, seq_number=4, ack="true"))
+        assert (r.status_code == 201)
+        assert (r.json()['F0A']['downlinkData'] == "26f0000000000000")
+
+        r = requests.post(url=url, data=dict(frame, seq_number=5, snr="10.2x"))
+        assert (r.status_code == 400)
+        r = requests.post(url=url, data='id_modem=F0A&timestamp=%zz', headers={'Content-Type': "application/x-www-form-urlencoded"})
+        assert (r.status_code == 400)
+
+        # The same body sent as JSON by its Content-Type
+        r = requests.post(url=url, data=json.dumps(dict(frame, seq_number=6, duplicate=False, ack=False, long_polling=False)))
+        assert (r.status_code == 204)
+
+        stored = [f for f in requests.get(url=url).json() if f['id_modem'] == "F0A"]
+        assert (sorted(f['seq_number'] for f in stored) == [1, 2, 3, 4, 6])
+        assert (all(f['snr'] == 10.23 and f['data_str'] == frame['data_str'] for f in stored))
+
+    def test_binary_records(self):
+        def record(id_modem, seq_number, ack=False, latitude=43, version=1):
+            data = bytes.fromhex("16f000000000000000000000")
+            return struct.pack('<HBB8s4sqiiiIhhB12s', 57, version, 0x02 if ack else 0x00, id_modem, b"0F3B", 123456,
+                               1023, -2 ** 31, -12050, seq_number, latitude, 1, len(data), data)
+
+        try:
+            tcp = socket.create_connection(('127.0.0.1', BINARY_PORT), timeout=2)
+        except OSError:
+            pytest.skip("the server does not listen for binary records (-B {})".format(BINARY_PORT))
+
+        # A stream of records, the last one split across two segments; only the ack and the refused ones are answered
+        invalid = record(b"B1", 3, latitude=95)
+        tcp.sendall(record(b"B1", 1) + record(b"B1", 2, ack=True) + invalid[:30])
+        time.sleep(0.05)
+        tcp.sendall(invalid[30:])
+        replies = b""
+        while len(replies) < 48:
+            replies += tcp.recv(48 - len(replies))
+        tcp.close()
+
+        length, version, status, id_modem, seq_number, downlink = struct.unpack('<HBB8sI8s', replies[:24])
+        assert ((length, version, status, id_modem, seq_number) == (24, 1, 0, b"B1".ljust(8, b"\0"), 2))
+        assert (downlink.hex() == "26f0000000000000")
+        assert (struct.unpack('<HBB8sI8s', replies[24:])[2:4] == (9, b"B1".ljust(8, b"\0")))
+
+        # Several records in one datagram
+        udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        udp.settimeout(2)
+        udp.sendto(record(b"U1", 1) + record(b"U1", 2, ack=True), ('127.0.0.1', BINARY_PORT))
+        assert (struct.unpack('<HBB8sI8s', udp.recvfrom(64)[0])[2:5] == (0, b"U1".ljust(8, b"\0"), 2))
+        udp.sendto(record(b"U1", 3, version=2), ('127.0.0.1', BINARY_PORT))
+        assert (struct.unpack('<HBB8sI8s', udp.recvfrom(64)[0])[2] == 0xFD)
+        udp.close()
+
+        time.sleep(0.1)
+        stored = [f for f in requests.get(url='http://127.0.0.1:{}/api'.format(PORT)).json() if f['id_modem'] in ("B1", "U1")]
+        assert (sorted((f['id_modem'], f['seq_number']) for f in stored) == [("B1", 1), ("B1", 2), ("U1", 1), ("U1", 2)])
+        assert (all(f['snr'] == 10.23 and f['rssi'] == -120.5 and f['avg_signal'] == 0 for f in stored))
+
+    def test_stats_dedup(self):
+        frame = {
+            'id_modem': "DEDUP",
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': os.getpid() % 4096,
+            'ack': False,
+            'long_polling': False,
+        }
+
+        r = requests.get(url='http://127.0.0.1:{}/api/stats'.format(PORT))
+        assert (r.status_code == 200)
+        before = r.json()['dedup']
+
+        # The same message received by two base stations
+        for station in ["FED", "0F3B"]:
+            r = requests.post(url='http://127.0.0.1:{}/api'.format(PORT), data=json.dumps(dict(frame, station=station)))
+            assert (r.status_code == 204)
+
+        after = requests.get(url='http://127.0.0.1:{}/api/stats'.format(PORT)).json()['dedup']
+
+        if before['mode'] == 'off':
+            assert (after['hits'] == 0 and after['misses'] == 0)
+        else:
+            assert (after['misses'] - before['misses'] == 1)
+            assert (after['hits'] - before['hits'] == 1)
+
+    def test_downlink(self):
+        url = 'http://127.0.0.1:{}/api/devices/DB10/downlink'.format(PORT)
+        frame = {
+            'id_modem': "DB10",
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 1,
+            'ack': True,
+            'long_polling': False,
+        }
+
+        for body in ["", "{}", '{"downlinkData": "0123"}', '{"downlinkData": "0123456789abcdeg"}']:
+            r = requests.post(url=url, data=body)
+            assert (r.status_code == 400)
+
+        r = requests.post(url=url, data=json.dumps({'downlinkData': "0123456789abcdef"}))
+        assert (r.status_code == 204)
+        r = requests.get(url=url)
+        assert (r.status_code == 200)
+        assert (r.json() == {'DB10': {'downlinkData': "0123456789abcdef"}})
+
+        before = requests.get(url='http://127.0.0.1:{}/api/stats'.format(PORT)).json()['ack_latency_us']
+        r = requests.post(url='http://127.0.0.1:{}/api'.format(PORT), data=json.dumps(frame))
+        assert (r.status_code == 201)
+        assert (r.json() == {'DB10': {'downlinkData': "0123456789abcdef"}})
+        after = requests.get(url='http://127.0.0.1:{}/api/stats'.format(PORT)).json()['ack_latency_us']
+        assert (after['count'] - before['count'] == 1)
+        assert (sum(after['buckets']) == after['count'])
+        assert (after['p50'] <= after['p99'] <= after['max'])
+
+        # Without a payload set, the one computed from the frame is answered again
+        r = requests.delete(url=url)
+        assert (r.status_code == 204)
+        r = requests.delete(url=url)
+        assert (r.status_code == 404)
+        r = requests.get(url=url)
+        assert (r.status_code == 404)
+        r = requests.post(url='http://127.0.0.1:{}/api'.format(PORT), data=json.dumps(dict(frame, seq_number=2)))
+        assert (r.status_code == 201)
+        assert (r.json() == {'DB10': {'downlinkData': "26f0000000000000"}})
+
+    def test_downlink_queue(self):
+        url = 'http://127.0.0.1:{}/api/devices/DB11/downlinks'.format(PORT)
+        frame = {
+            'id_modem': "DB11",
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 1,
+            'ack': True,
+            'long_polling': False,
+        }
+
+        r = requests.post(url=url, data='{"downlinkData": "0123"}')
+        assert (r.status_code == 400)
+
+        ids = []
+
+        for data in ["0000000000000001", "0000000000000002"]:
+            r = requests.post(url=url, data=json.dumps({'downlinkData': data}))
+            assert (r.status_code == 201)
+            assert (r.json()['downlinkData'] == data)
+            ids.append(r.json()['id'])
+
+        assert (ids[0] < ids[1])
+        r = requests.get(url=url)
+        assert (r.status_code == 200)
+        assert (r.json() == [{'id': ids[0], 'downlinkData': "0000000000000001"},
+                             {'id': ids[1], 'downlinkData': "0000000000000002"}])
+
+        # Each payload is answered once, in order, and a copy of a message does not take one
+        expected = [(1, False, "0000000000000001"), (1, True, "26f0000000000000"), (2, False, "0000000000000002"),
+                    (3, False, "26f0000000000000")]
+
+        for (seq_number, duplicate, data) in expected:
+            r = requests.post(url='http://127.0.0.1:{}/api'.format(PORT),
+                              data=json.dumps(dict(frame, seq_number=seq_number, duplicate=duplicate)))
+            assert (r.status_code == 201)
+            assert (r.json() == {'DB11': {'downlinkData': data}})
+
+        r = requests.get(url=url)
+        assert (r.json() == [])
+
+    def test_downlink_queue_failed(self):
+        device = "{:08X}".format(os.getpid() * 32452843 % 0xFFFFFFFF)
+        url = 'http://127.0.0.1:{}/api/devices/{}/downlinks'.format(PORT, device)
+        frame = {
+            'id_modem': device,
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 1,
+            'ack': True,
+            'long_polling': False,
+        }
+        if not os.path.exists('api_server.db'):
+            pytest.skip("the database of the server is not in the working directory")
+
+        # The insertion of the payload fails, so it is not answered to the frames
+        db = sqlite3.connect('api_server.db', timeout=5)
+        db.execute("CREATE TRIGGER refuse_downlink BEFORE INSERT ON downlinks WHEN NEW.id_modem = '{}'"
+                   " BEGIN SELECT RAISE(ABORT, 'refused'); END;".format(device))
+        db.commit()
+        try:
+            r = requests.post(url=url, data=json.dumps({'downlinkData': "0000000000000001"}))
+        finally:
+            db.execute("DROP TRIGGER refuse_downlink;")
+            db.commit()
+            db.close()
+
+        assert (r.status_code == 500)
+        assert (requests.get(url=url).json() == [])
+        r = requests.post(url='http://127.0.0.1:{}/api'.format(PORT), data=json.dumps(frame))
+        assert (r.status_code == 201)
+        assert (r.json() == {device: {'downlinkData': "26f0000000000000"}})
+
+    def test_stats_admission(self):
+        admission = requests.get(url='http://127.0.0.1:{}/api/stats'.format(PORT)).json()['admission']
+
+        assert (0 < admission['high_watermark'] <= admission['queue_capacity'])
+        assert (admission['low_watermark'] < admission['high_watermark'])
+        assert (admission['queue_depth'] <= admission['queue_capacity'])
+        assert (admission['overloaded'] in [True, False])
+
+        # An idle queue admits every class
+        r = requests.get(url='http://127.0.0.1:{}/api'.format(PORT))
+        assert (r.status_code == 200)
+        after = requests.get(url='http://127.0.0.1:{}/api/stats'.format(PORT)).json()['admission']
+        assert (after['shed_queries'] == admission['shed_queries'])
+
+    def test_get_views(self):
+        frame = {
+            'id_modem': "VIEW",
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': os.getpid() % 4096,
+            'ack': False,
+            'long_polling': False,
+        }
+
+        # The same message received by two base stations
+        for station in ["FED", "0F3B"]:
+            r = requests.post(url='http://127.0.0.1:{}/api'.format(PORT), data=json.dumps(dict(frame, station=station)))
+            assert (r.status_code == 204)
+
+        mode = requests.get(url='http://127.0.0.1:{}/api/stats'.format(PORT)).json()['dedup']['mode']
+        stations = ["FED"] if mode == 'drop' else ["FED", "0F3B"]
+
+        r = requests.get(url='http://127.0.0.1:{}/api'.format(PORT))
+        assert (r.status_code == 200)
+        flat = [f for f in r.json() if f['id_modem'] == "VIEW" and f['seq_number'] == frame['seq_number']]
+        assert ([f['station'] for f in flat] == stations)
+
+        r = requests.get(url='http://127.0.0.1:{}/api?view=merged'.format(PORT))
+        assert (r.status_code == 200)
+        merged = [f for f in r.json() if f['id_modem'] == "VIEW" and f['seq_number'] == frame['seq_number']]
+        assert (len(merged) == 1)
+        assert ([c['station'] for c in merged[0]['receptions']] == stations)
+
+    def test_get_pages(self):
+        frame = {
+            'id_modem': "PAGE",
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+
+        for i in range(25):
+            r = requests.post(url=url, data=json.dumps(dict(frame, seq_number=i)))
+            assert (r.status_code == 204)
+
+        # Following the next cursor walks the whole table once, in order
+        everything = requests.get(url=url, params={'view': "merged", 'limit': 100000}).json()
+        pages = []
+        r = requests.get(url=url, params={'view': "merged", 'limit': 10})
+        while True:
+            assert (r.status_code == 200)
+            assert (len(r.json()) <= 10)
+            pages += r.json()
+            if 'next' not in r.links:
+                break
+            assert (len(r.json()) == 10)
+            r = requests.get(url='http://127.0.0.1:{}{}'.format(PORT, r.links['next']['url']))
+        assert (pages == everything)
+        assert ([f['seq_number'] for f in pages if f['id_modem'] == "PAGE"] == list(range(25)))
+
+        # ?before_id= pages backward from the end of the table, each page in order
+        r = requests.get(url=url, params={'view': "merged", 'limit': 10, 'before_id': 2 ** 62})
+        assert (r.json() == everything[-10:])
+        r = requests.get(url='http://127.0.0.1:{}{}'.format(PORT, r.links['next']['url']))
+        assert (r.json() == everything[-20:-10])
+
+        for params in [{'limit': 0}, {'limit': "ten"}, {'after_id': -1}, {'before_id': ""}, {'limit': "1" * 30},
+                       {'limit': 100001}]:
+            r = requests.get(url=url, params=params)
+            assert (r.status_code == 400)
+
+        # The largest page is accepted
+        r = requests.get(url=url, params={'view': "merged", 'limit': 100000, 'before_id': 2 ** 62})
+        assert (r.status_code == 200 and r.json() == everything[-100000:])
+
+    def test_get_escaped_chunks(self):
+        frame = {
+            'id_modem': 'E"\\\x01',
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': -0.5,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+
+        # A url-encoded field can hold any character, it has to be escaped in the JSON list
+        r = requests.post(url=url, data=frame)
+        assert (r.status_code == 204)
+        r = requests.get(url=url, params={'before_id': 2 ** 62, 'limit': 1})
+        assert (r.status_code == 200)
+        assert ([(f['id_modem'], f['snr'], f['avg_signal']) for f in r.json()] == [('E"\\\x01', -0.5, 10.23)])
+
+        # The decimals are written with the shortest text that reads back to them
+        assert ('"snr": -0.5, ' in r.text and '"rssi": 23.45, ' in r.text)
+
+        # The rows are sent in chunks of 16 KB, not one per row
+        before = requests.get(url=url + '/stats').json()['exports']
+        r = requests.get(url=url, params={'limit': 100000})
+        after = requests.get(url=url + '/stats').json()['exports']
+        assert (after['bytes'] - before['bytes'] == len(r.content))
+        assert (after['chunks'] - before['chunks'] == (len(r.content) + 16 * 1024 - 1) // (16 * 1024))
+
+    def test_get_cached(self):
+        frame = {
+            'id_modem': "CAC4E",
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+        r = requests.post(url=url, data=json.dumps(frame))
+        assert (r.status_code == 204)
+
+        # The second read is served from the cache, whatever the order of the parameters
+        before = requests.get(url=url + '/stats').json()['cache']
+        first = requests.get(url='{}?view=merged&limit=3&before_id={}&unused=1'.format(url, 2 ** 62))
+        second = requests.get(url='{}?before_id={}&limit=3&view=merged'.format(url, 2 ** 62))
+        after = requests.get(url=url + '/stats').json()['cache']
+        assert (first.status_code == 200 and second.status_code == 200)
+        assert (first.headers['Transfer-Encoding'] == "chunked")
+        assert (int(second.headers['Content-Length']) == len(second.content))
+        assert (second.content == first.content and second.links == first.links)
+        assert (second.headers['ETag'] == first.headers['ETag'])
+        assert (after['hits'] - before['hits'] == 1 and after['misses'] - before['misses'] == 1)
+        assert (0 < after['bytes'] and 0 <= after['hit_ratio'] <= 1)
+
+        # The client that has the current reply gets 304, until a write changes the data version
+        etag = second.headers['ETag']
+        r = requests.get(url='{}?before_id={}&limit=3&view=merged'.format(url, 2 ** 62),
+                         headers={'If-None-Match': 'W/"other", ' + etag})
+        assert (r.status_code == 304 and r.content == b'')
+        assert (requests.get(url=url + '/stats').json()['cache']['not_modified'] == after['not_modified'] + 1)
+
+        r = requests.post(url=url, data=json.dumps(dict(frame, seq_number=1)))
+        assert (r.status_code == 204)
+        r = requests.get(url='{}?before_id={}&limit=3&view=merged'.format(url, 2 ** 62), headers={'If-None-Match': etag})
+        assert (r.status_code == 200 and r.headers['ETag'] != etag)
+        assert (r.json()[-1]['id_modem'] == "CAC4E" and r.json()[-1]['seq_number'] == 1)
+
+    def test_get_compressed(self):
+        device = "{:08X}".format(os.getpid() * 104729 % 0xFFFFFFFF)
+        frame = {
+            'id_modem': device,
+            'timestamp': 0,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "C0DE",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+        for i in range(32):
+            r = requests.post(url=url, data=json.dumps(dict(frame, timestamp=1000 + i, seq_number=i)))
+            assert (r.status_code == 204)
+
+        # The reply is compressed with the encoding the client prefers, and decodes to the identity one
+        before = requests.get(url=url + '/stats').json()['compression']
+        frames = '{}/devices/{}/frames'.format(url, device)
+        plain = requests.get(url=frames, headers={'Accept-Encoding': 'identity'})
+        assert (plain.status_code == 200 and 'Content-Encoding' not in plain.headers)
+        assert (plain.headers['Vary'] == "Accept-Encoding" and len(plain.json()) == 32)
+
+        for accept, encoding in [('gzip, deflate', 'gzip'), ('gzip;q=0, deflate', 'deflate'), ('*', 'gzip')]:
+            r = requests.get(url=frames, headers={'Accept-Encoding': accept}, stream=True)
+            raw = r.raw.read(decode_content=False)
+            assert (r.status_code == 200 and r.headers['Content-Encoding'] == encoding)
+            assert (len(raw) < len(plain.content))
+            assert (requests.get(url=frames, headers={'Accept-Encoding': accept}).content == plain.content)
+            assert (r.headers['ETag'] != plain.headers['ETag'])
+
+        after = requests.get(url=url + '/stats').json()['compression']
+        assert (after['replies'] > before['replies'] and after['bytes_out'] < after['bytes_in'])
+
+        # A reply smaller than the threshold is sent as it is
+        r = requests.get(url=frames + '?limit=1', headers={'Accept-Encoding': 'gzip'})
+        assert (r.status_code == 200 and 'Content-Encoding' not in r.headers and len(r.json()) == 1)
+
+        # The static files are compressed once and served from memory
+        with open(os.path.join(os.path.dirname(__file__), '..', 'web_root', 'index.html'), 'rb') as f:
+            index = f.read()
+        root = 'http://127.0.0.1:{}/'.format(PORT)
+        r = requests.get(url=root, headers={'Accept-Encoding': 'gzip'})
+        assert (r.status_code == 200 and r.headers['Content-Encoding'] == "gzip" and r.content == index)
+        assert (int(r.headers['Content-Length']) < len(index))
+        r = requests.get(url=root, headers={'Accept-Encoding': 'gzip', 'If-None-Match': r.headers['ETag']})
+        assert (r.status_code == 304)
+        r = requests.get(url=root, headers={'Accept-Encoding': 'identity'})
+        assert (r.status_code == 200 and 'Content-Encoding' not in r.headers and r.content == index)
+
+    def test_get_formats(self):
+        device = "{:08X}".format(os.getpid() * 15485863 % 0xFFFFFFFF)
+        frame = {
+            'id_modem': device,
+            'timestamp': 0,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "F0E1",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': -3,
+            'rssi': -120.5,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+        for i in range(3):
+            for station in ["F0E1", "F0E2"]:
+                r = requests.post(url=url, data=json.dumps(dict(frame, timestamp=2000 + i, seq_number=i, station=station)))
+                assert (r.status_code == 204)
+
+        frames = '{}/devices/{}/frames'.format(url, device)
+        rows = requests.get(url=frames).json()
+        merged = requests.get(url=frames + '?view=merged').json()
+
+        # NDJSON: the objects of the JSON list, one per line
+        for accept, query in [('application/x-ndjson', ''), ('*/*', '?format=ndjson')]:
+            r = requests.get(url=frames + query, headers={'Accept': accept})
+            assert (r.status_code == 200 and r.headers['Content-Type'] == "application/x-ndjson")
+            assert (r.text.endswith('\n') and [json.loads(l) for l in r.text.splitlines()] == rows)
+        r = requests.get(url=frames + '?view=merged&format=ndjson')
+        assert ([json.loads(l) for l in r.text.splitlines()] == merged)
+
+        # CSV: a header line, then one record per reception
+        r = requests.get(url=frames, headers={'Accept': 'text/html, text/csv;q=0.9'})
+        assert (r.status_code == 200 and r.headers['Content-Type'].startswith("text/csv"))
+        lines = r.text.split('\r\n')
+        assert (lines[0] == "timestamp,id_modem,ack,data_str,duplicate,avg_signal,seq_number,station,snr,rssi,latitude,"
+                            "longitude")
+        assert (lines[-1] == '' and len(lines) == len(rows) + 2)
+        assert (lines[1] == '{},{},false,16f000000000000000000000,{},10.23,0,{},10.23,-120.5,2,-3'.format(
+            rows[0]['timestamp'], device, 'true' if rows[0]['duplicate'] else 'false', rows[0]['station']))
+
+        # A field with a comma, a quote or a line break is quoted
+        r = requests.post(url=url, data=dict(frame, id_modem='C,"V\n', timestamp=1, seq_number=7))
+        assert (r.status_code == 204)
+        r = requests.get(url=url + '?format=csv&before_id={}&limit=1'.format(2 ** 62))
+        assert (',"C,""V\n",' in r.text)
+
+        # CBOR: an array of maps, with the values of the JSON list
+        r = requests.get(url=frames, headers={'Accept': 'application/cbor'})
+        assert (r.status_code == 200 and r.headers['Content-Type'] == "application/cbor")
+        assert (cbor_decode(r.content) == (rows, len(r.content)))
+        r = requests.get(url=frames + '?view=merged&format=cbor')
+        assert (cbor_decode(r.content) == (merged, len(r.content)))
+
+        # The cursor of the next page keeps the format
+        r = requests.get(url=frames + '?format=csv&limit=1')
+        assert ('format=csv' in r.links['next']['url'])
+        assert (len(r.text.split('\r\n')) == len(requests.get(url=frames + '?limit=1').json()) + 2)
+        assert (requests.get(url=frames + '?format=xml').status_code == 400)
+
+    def test_device_stats(self):
+        device = "{:08X}".format(os.getpid() * 2750159 % 0xFFFFFFFF)
+        frame = {
+            'id_modem': device,
+            'timestamp': 0,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "C0DE",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+        assert (requests.get(url='{}/devices/{}/stats'.format(url, device)).status_code == 404)
+
+        for i, (snr, rssi, avg_signal) in enumerate([(10.5, -120.25, 12.0), (-2.0, -99.5, 13.5), (7.25, -130.0, 9.0)]):
+            r = requests.post(url=url, data=json.dumps(dict(frame, timestamp=2000 - i * 10, seq_number=i, snr=snr,
+                                                            rssi=rssi, avg_signal=avg_signal)))
+            assert (r.status_code == 204)
+
+        # A copy from another base station is a reception of the same message (dropped with -d drop)
+        r = requests.post(url=url, data=json.dumps(dict(frame, timestamp=2000, seq_number=0, snr=30.0, rssi=-80.0,
+                                                        station="BEEF", duplicate=True, avg_signal=12.0)))
+        assert (r.status_code == 204)
+
+        # The statistics are the ones computed from the stored frames
+        rows = requests.get(url='{}/devices/{}/frames'.format(url, device)).json()
+        messages = {(row['timestamp'], row['seq_number']): row['avg_signal'] for row in rows}
+        stats = requests.get(url='{}/devices/{}/stats'.format(url, device))
+        assert (stats.status_code == 200)
+        stats = stats.json()
+        assert (stats['id_modem'] == device and stats['messages'] == 3 and stats['receptions'] == len(rows))
+        assert (stats['first_seen'] == 1980 and stats['last_seen'] == 2000)
+        assert (stats['avg_signal'] == pytest.approx(sum(messages.values()) / 3))
+        for name in ['snr', 'rssi']:
+            values = [row[name] for row in rows]
+            assert (stats[name]['min'] == min(values) and stats[name]['max'] == max(values))
+            assert (stats[name]['avg'] == pytest.approx(sum(values) / len(values)))
+
+        everything = requests.get(url=url + '/devices/stats')
+        assert (everything.status_code == 200)
+        assert ([entry for entry in everything.json() if entry['id_modem'] == device] == [stats])
+        assert (requests.post(url='{}/devices/{}/stats'.format(url, device)).status_code == 501)
+
+    def test_rollups(self):
+        device = "{:08X}".format(os.getpid() * 1299709 % 0xFFFFFFFF)
+        frame = {
+            'id_modem': device,
+            'timestamp': 0,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "C0DE",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+        rollups_url = '{}/devices/{}/rollups'.format(url, device)
+
+        # Ten messages 50 seconds apart, from the first second of the second day, and a copy of the first one
+        for i in range(10):
+            r = requests.post(url=url, data=json.dumps(dict(frame, timestamp=86400 + i * 50, seq_number=i,
+                                                            snr=float(i), rssi=-100.0 - i, avg_signal=float(i))))
+            assert (r.status_code == 204)
+        r = requests.post(url=url, data=json.dumps(dict(frame, timestamp=86400, seq_number=0, snr=20.0, rssi=-80.0,
+                                                        station="BEEF", duplicate=True, avg_signal=0.0)))
+        assert (r.status_code == 204)
+
+        # The buckets are the ones computed from the stored frames
+        rows = requests.get(url='{}/devices/{}/frames'.format(url, device)).json()
+        for granularity, seconds in [('minute', 60), ('hour', 3600), ('day', 86400)]:
+            r = requests.get(url=rollups_url, params={'granularity': granularity})
+            assert (r.status_code == 200 and 'Link' not in r.headers)
+            buckets = r.json()
+            assert ([b['bucket'] for b in buckets] == sorted({row['timestamp'] // seconds * seconds for row in rows}))
+            for b in buckets:
+                received = [row for row in rows if row['timestamp'] // seconds * seconds == b['bucket']]
+                messages = {(row['timestamp'], row['seq_number']): row['avg_signal'] for row in received}
+                assert (b['messages'] == len(messages) and b['receptions'] == len(received))
+                assert (b['avg_signal'] == pytest.approx(sum(messages.values()) / len(messages)))
+                for name in ['snr', 'rssi']:
+                    values = [row[name] for row in received]
+                    assert (b[name]['min'] == min(values) and b[name]['max'] == max(values))
+                    assert (b[name]['avg'] == pytest.approx(sum(values) / len(values)))
+
+        # The pages follow each other through the Link header
+        r = requests.get(url=rollups_url, params={'granularity': 'minute', 'limit': 3, 'from': 86400})
+        assert (r.status_code == 200 and len(r.json()) == 3)
+        assert (r.links['next']['url'] == '/api/devices/{}/rollups?granularity=minute&from=86580&limit=3'.format(device))
+        r = requests.get(url=rollups_url, params={'granularity': 'minute', 'from': 86460, 'to': 86519})
+        assert ([b['bucket'] for b in r.json()] == [86460])
+
+        assert (requests.get(url=rollups_url, params={'granularity': 'week'}).status_code == 400)
+        assert (requests.get(url=rollups_url, params={'limit': 10001}).status_code == 400)
+        assert (requests.get(url=rollups_url, params={'limit': 10000}).status_code == 200)
+        assert (requests.post(url=rollups_url).status_code == 501)
+
+    def test_device_station_frames(self):
+        device = "{:08X}".format(os.getpid() * 7919 % 0xFFFFFFFF)
+        stations = ["{:04X}".format(os.getpid() % 0xFFFF), "{:04X}".format(os.getpid() % 0xFFFF ^ 0x8000)]
+        frame = {
+            'id_modem': device,
+            'timestamp': 0,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': stations[0],
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+        copies = 1 if requests.get(url=url + '/stats').json()['dedup']['mode'] == 'drop' else 2
+
+        # Two messages per timestamp, posted from the last timestamp to the first: every message is received by the
+        # first station and the even ones by the second
+        for i in [2 * t + j for t in reversed(range(15)) for j in range(2)]:
+            r = requests.post(url=url, data=json.dumps(dict(frame, timestamp=1000 + i // 2, seq_number=i)))
+            assert (r.status_code == 204)
+            if i % 2 == 0:
+                r = requests.post(url=url, data=json.dumps(dict(frame, timestamp=1000 + i // 2, seq_number=i,
+                                                                station=stations[1], snr=1.5)))
+                assert (r.status_code == 204)
+
+        device_url = '{}/devices/{}/frames'.format(url, device)
+        r = requests.get(url=device_url, params={'view': "merged"})
+        assert (r.status_code == 200)
+        assert ([f['seq_number'] for f in r.json()] == list(range(30)))
+        assert ([len(f['receptions']) for f in r.json()] == [copies - i % 2 * (copies - 1) for i in range(30)])
+        assert ('next' not in r.links)
+
+        r = requests.get(url=device_url, params={'from': 1005, 'to': 1009})
+        assert ([f['seq_number'] for f in r.json()] == [i for i in range(10, 20) for _ in range(copies - i % 2 * (copies - 1))])
+
+        # Only the reception of the station is given
+        r = requests.get(url='{}/stations/{}/frames'.format(url, stations[1]), params={'from': 1000, 'to': 1014})
+        assert ([(f['seq_number'], f['station'], f['snr']) for f in r.json()] ==
+                [(i, stations[1], 1.5) for i in range(0, 30, 2) if copies == 2])
+
+        # Following the next cursor, with messages of the same timestamp on both sides of a page
+        pages = []
+        r = requests.get(url=device_url, params={'view': "merged", 'limit': 7, 'to': 1012})
+        while True:
+            assert (r.status_code == 200)
+            pages += r.json()
+            if 'next' not in r.links:
+                break
+            assert (len(r.json()) == 7)
+            r = requests.get(url='http://127.0.0.1:{}{}'.format(PORT, r.links['next']['url']))
+        assert ([f['seq_number'] for f in pages] == list(range(26)))
+
+        r = requests.get(url='{}/devices/{}/frames'.format(url, "0" * 8))
+        assert (r.status_code == 200 and r.json() == [])
+
+        for params in [{'from': -1}, {'to': "now"}, {'limit': 0}, {'limit': 100001}]:
+            r = requests.get(url=device_url, params=params)
+            assert (r.status_code == 400)
+        assert (requests.get(url=device_url, params={'limit': 100000}).status_code == 200)
+
+        assert (requests.post(url=device_url, data="{}").status_code == 501)
+        assert (requests.get(url='{}/stations/{}/frame'.format(url, stations[0])).status_code == 404)
+
+    def test_post_batch(self):
+        frame = {
+            'id_modem': "BEF",
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 12 ,
+            'ack': False,
+            'long_polling': False,
+        }
+        frame_ack = dict(frame, ack=True)
+        frame_invalid = dict(frame)
+        del frame_invalid['timestamp']
+        frame_bad_hex = dict(frame, data_str="16f0zz")
+        frames = [frame, frame_ack, frame_invalid, frame_bad_hex]
+
+        l = [
+            {
+                'data': json.dumps(frames),
+            },
+            {
+                'data': '\n'.join(json.dumps(f) for f in frames) + '\n',
+            }
+        ]
+
+        for d in l:
+            r = requests.post(url='http://127.0.0.1:{}/api/batch'.format(PORT), data=d['data'])
+            print(d)
+            assert (r.status_code == 200)
+            statuses = r.json()
+            assert ([s['status'] for s in statuses] == [204, 201, 400, 400])
+            assert (statuses[3]['error'] == 6)
+            assert (statuses[1]['BEF']['downlinkData'] == "26f0000000000000")
+
+        for data in ['', '[]', '[{']:
+            r = requests.post(url='http://127.0.0.1:{}/api/batch'.format(PORT), data=data)
+            assert (r.status_code == 400)
+
+    def test_post_batch_failed_frame(self):
+        device = "{:08X}".format(os.getpid() * 86028121 % 0xFFFFFFFF)
+        frame = {
+            'id_modem': device,
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+        if not os.path.exists('api_server.db'):
+            pytest.skip("the database of the server is not in the working directory")
+
+        # The reception of the second frame is refused once its message is inserted
+        db = sqlite3.connect('api_server.db', timeout=5)
+        db.execute("CREATE TRIGGER refuse_fa11 BEFORE INSERT ON receptions WHEN NEW.station = 'FA11'"
+                   " BEGIN SELECT RAISE(ABORT, 'refused'); END;")
+        db.commit()
+        try:
+            data = '\n'.join(json.dumps(dict(frame, seq_number=i, station=station))
+                              for i, station in enumerate(["FED", "FA11", "FED"]))
+            r = requests.post(url=url + '/batch', data=data)
+        finally:
+            db.execute("DROP TRIGGER refuse_fa11;")
+            db.commit()
+            db.close()
+
+        # Nothing of the failed frame is committed, so it can be sent again
+        assert (r.status_code == 200)
+        assert ([s['status'] for s in r.json()] == [204, 500, 204])
+        rows = requests.get(url='{}/devices/{}/frames'.format(url, device)).json()
+        assert ([row['seq_number'] for row in rows] == [0, 2])
+        r = requests.post(url=url, data=json.dumps(dict(frame, seq_number=1, station="FA11")))
+        assert (r.status_code == 204)
+        rows = requests.get(url='{}/devices/{}/frames'.format(url, device)).json()
+        assert (sorted((row['seq_number'], row['station']) for row in rows) == [(0, "FED"), (1, "FA11"), (2, "FED")])
+
+    def test_ack_under_export(self):
+        frame = {
+            'id_modem': "E4F",
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+
+        # A table of a few dozen slices, so an export sent at once would hold the event loop for a while
+        for b in range(5):
+            data = '\n'.join(json.dumps(dict(frame, seq_number=b * 2000 + i)) for i in range(2000))
+            r = requests.post(url=url + '/batch', data=data)
+            assert (r.status_code == 200)
+
+        def ack_p99(first):
+            latencies = []
+            s = requests.Session()
+            for i in range(100):
+                start = time.time()
+                r = s.post(url=url, data=json.dumps(dict(frame, ack=True, seq_number=first + i)))
+                latencies.append(time.time() - start)
+                assert (r.status_code == 201)
+                time.sleep(0.01)
+            return sorted(latencies)[98]
+
+        # The references are measured in the same run, on the same machine
+        start = time.time()
+        assert (requests.get(url=url + '?limit=100000').status_code == 200)
+        single = time.time() - start
+        baseline = ack_p99(50000)
+
+        stop = threading.Event()
+        exports = []
+
+        def export():
+            s = requests.Session()
+            while not stop.is_set():
+                # The whole table in one page, the default limit is far below
+                r = s.get(url=url + '?limit=100000')
+                exports.append(r)
+
+        threads = [threading.Thread(target=export) for i in range(2)]
+        for t in threads:
+            t.start()
+        time.sleep(0.2)
+
+        loaded = ack_p99(60000)
+
+        stop.set()
+        for t in threads:
+            t.join()
+
+        # The exports are sent a slice at a time, they do not hold the acknowledged frames back for a whole export
+        assert (loaded < baseline + single)
+        assert (len(exports) > 0)
+        assert (all(e.status_code == 200 for e in exports))
+
+        # Parsed once the latencies are measured, it holds the interpreter
+        assert (len(exports[-1].json()) >= 10000)
+
+    def test_export_snapshot(self):
+        device = "{:08X}".format(os.getpid() * 611953 % 0xFFFFFFFF)
+        frame = {
+            'id_modem': device,
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+        for b in range(5):
+            data = '\n'.join(json.dumps(dict(frame, seq_number=b * 2000 + i)) for i in range(2000))
+            assert (requests.post(url=url + '/batch', data=data).status_code == 200)
+
+        slow = slow_export()
+
+        try:
+            assert (requests.get(url=url + '/stats').json()['exports']['active'] >= 1)
+
+            # A frame committed meanwhile is seen by the other reads
+            r = requests.post(url=url, data=json.dumps(dict(frame, seq_number=20000, timestamp=123457)))
+            assert (r.status_code == 204)
+            rows = requests.get(url='{}/devices/{}/frames'.format(url, device), params={'from': 123457}).json()
+            assert ([row['seq_number'] for row in rows] == [20000])
+        finally:
+            slow.close()
+
+    def test_get_cached_under_export(self):
+        device = "{:08X}".format(os.getpid() * 49979687 % 0xFFFFFFFF)
+        frame = {
+            'id_modem': device,
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+        for b in range(5):
+            data = '\n'.join(json.dumps(dict(frame, seq_number=b * 2000 + i)) for i in range(2000))
+            assert (requests.post(url=url + '/batch', data=data).status_code == 200)
+
+        page = '{}/devices/{}/frames?from=123457'.format(url, device)
+        first = requests.get(url=page)
+        assert (first.status_code == 200 and first.json() == [])
+        slow = slow_export()
+
+        # The data version follows the commits made while another export is open
+        try:
+            assert (requests.get(url=url + '/stats').json()['exports']['active'] >= 1)
+            r = requests.post(url=url, data=json.dumps(dict(frame, seq_number=20000, timestamp=123457)))
+            assert (r.status_code == 204)
+            r = requests.get(url=page, headers={'If-None-Match': first.headers['ETag']})
+            assert (r.status_code == 200 and r.headers['ETag'] != first.headers['ETag'])
+            assert ([row['seq_number'] for row in r.json()] == [20000])
+        finally:
+            slow.close()
+
+    def test_steady_state_allocations(self):
+        frame = {
+            'id_modem': "A110C",
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        s = requests.Session()
+
+        # The buffers of the connection grow on the first requests (the reply of the stats is the longest)
+        for i in range(20):
+            r = s.post(url='http://127.0.0.1:{}/api'.format(PORT), data=json.dumps(dict(frame, seq_number=i, ack=(i % 2 == 0))))
+            assert (r.status_code in [201, 204])
+        s.get(url='http://127.0.0.1:{}/api/stats'.format(PORT))
+        before = s.get(url='http://127.0.0.1:{}/api/stats'.format(PORT)).json()['allocations']
+
+        for i in range(20, 220):
+            r = s.post(url='http://127.0.0.1:{}/api'.format(PORT), data=json.dumps(dict(frame, seq_number=i, ack=(i % 2 == 0))))
+            assert (r.status_code in [201, 204])
+        after = s.get(url='http://127.0.0.1:{}/api/stats'.format(PORT)).json()['allocations']
+
+        # Then the frames are read into pooled buffers and answered from the arena
+        assert (after['requests'] - before['requests'] == 201)
+        assert (after['heap'] == before['heap'])
+        assert (after['requests_allocating'] == before['requests_allocating'])
+        assert (after['pooled'] > before['pooled'])
+        assert (after['arena_overflows'] == before['arena_overflows'])
+
+    def test_delete_then_ack(self):
+        device = "{:08X}".format(os.getpid() * 67867967 % 0xFFFFFFFF)
+        frame = {
+            'id_modem': device,
+            'timestamp': 123456,
+            'duplicate': False,
+            'snr': 10.23,
+            'station': "FED",
+            'data_str': "16f000000000000000000000",
+            'avg_signal': 10.23,
+            'latitude': 2,
+            'longitude': 2,
+            'rssi': 23.45,
+            'seq_number': 0,
+            'ack': False,
+            'long_polling': False,
+        }
+        url = 'http://127.0.0.1:{}/api'.format(PORT)
+
+        def send(request):
+            client = socket.create_connection(('127.0.0.1', PORT), timeout=10)
+            client.sendall(request)
+            return client
+
+        def status(client):
+            reply = b''
+            while b'\r\n' not in reply:
+                reply += client.recv(4096)
+            client.close()
+            return reply.split(b' ')[1]
+
+        # The deletion waits behind a batch that keeps the writer busy, then a frame is acknowledged
+        batch = '\n'.join(json.dumps(dict(frame, seq_number=i)) for i in range(10000)).encode()
+        writes = send(b'POST /api/batch HTTP/1.1\r\nContent-Length: %d\r\n\r\n%s' % (len(batch), batch))
+        time.sleep(0.05)
+        deletion = send(b'DELETE /api HTTP/1.1\r\nContent-Length: 0\r\n\r\n')
+        for i in range(100):
+            admission = requests.get(url=url + '/stats').json()['admission']
+            if admission['queue_depth'] + admission['ack_queue_depth'] > 0:
+                break
+            time.sleep(0.001)
+        r = requests.post(url=url, data=json.dumps(dict(frame, seq_number=20000, ack=True)))
+        assert (r.status_code == 201)
+        assert (status(writes) == b'200' and status(deletion) == b'200')
+
+        # The frames are written in the order they were acknowledged, so the one after the deletion is kept (it is
+        # acknowledged before its commit)
+        for i in range(100):
+            rows = requests.get(url='{}/devices/{}/frames'.format(url, device)).json()
+            if rows:
+                break
+            time.sleep(0.01)
+        assert ([row['seq_number'] for row in rows] == [20000])